@@ -74,6 +74,11 @@ android {
         }
     }
 
+    androidResources {
+        // Packed asset archive is mmap'ed at runtime, it must not be deflated
+        noCompress += "kpak"
+    }
+
     buildFeatures {
         viewBinding = true
     }
@@ -6,10 +6,11 @@ layout(location = 1) in vec3 inNormal;   // unused
 layout(location = 2) in vec2 inUV;
 
 layout(set = 0, binding = 0) uniform UBO {
-    // Display rotation from Android (0 = 0, 1 = 90, 2 = 180, 3 = 270).
-    // The camera image is always landscape; this rotates the UVs so the
-    // image is correctly oriented for the current device orientation.
-    int displayRotation;
+    // Where the screen corners land in the uploaded camera image, as UVs:
+    // (top-left, top-right) and (bottom-left, bottom-right). Covers display
+    // rotation, aspect-fill cropping and the region ARCameraImage uploaded.
+    vec4 cornersTop;
+    vec4 cornersBottom;
 } ubo;
 
 layout(location = 0) out vec2 fragUV;
@@ -19,30 +20,10 @@ void main()
     // Fullscreen quad: position is already in NDC [-1,1], depth at max
     gl_Position = vec4(inPosition.xy, 1.0, 1.0);
 
-    // Rotate UV around center (0.5, 0.5) based on display rotation.
-    // Camera sensor is landscape; we rotate to match screen orientation.
-    vec2 uv = inUV;
-    vec2 centered = uv - 0.5;
-    vec2 rotated;
-
-    // Android Surface.ROTATION_* values:
-    //  0 = portrait (camera needs 90 CW rotation)
-    //  1 = landscape (no rotation needed)
-    //  2 = reverse portrait (camera needs 270 CW rotation)
-    //  3 = reverse landscape (camera needs 180 rotation)
-    if (ubo.displayRotation == 0) {
-        // 90 degrees CW: (x,y) -> (y, -x)
-        rotated = vec2(centered.y, -centered.x);
-    } else if (ubo.displayRotation == 1) {
-        // no rotation
-        rotated = centered;
-    } else if (ubo.displayRotation == 2) {
-        // 270 degrees CW (= 90 CCW): (x,y) -> (-y, x)
-        rotated = vec2(-centered.y, centered.x);
-    } else {
-        // 180 degrees: (x,y) -> (-x, -y)
-        rotated = vec2(-centered.x, -centered.y);
-    }
-
-    fragUV = rotated + 0.5;
+    // inUV (0,0) is the top-left of the screen. The corners map the screen
+    // onto the image through a rotation + scale, so a bilinear blend of
+    // them is exact.
+    vec2 top    = mix(ubo.cornersTop.xy,    ubo.cornersTop.zw,    inUV.x);
+    vec2 bottom = mix(ubo.cornersBottom.xy, ubo.cornersBottom.zw, inUV.x);
+    fragUV = mix(top, bottom, inUV.y);
 }
@@ -0,0 +1,15 @@
+#version 450
+// Compile: glslangValidator -V camera_bg_ycbcr.frag.glsl -o camera_bg_ycbcr.frag.spv
+
+layout(location = 0) in vec2 fragUV;
+
+// G8_B8R8_2PLANE_420 behind an immutable VkSamplerYcbcrConversion
+// (BT.601 full range): the sampler returns RGB, chroma upsampling included.
+layout(set = 0, binding = 1) uniform sampler2D cameraTexture;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    outColor = vec4(texture(cameraTexture, fragUV).rgb, 1.0);
+}
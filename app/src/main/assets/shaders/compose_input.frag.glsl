@@ -0,0 +1,13 @@
+#version 450
+// Compile: glslangValidator -V compose_input.frag.glsl -o compose_input.frag.spv
+// compose.frag for a compose subpass in the offscreen render pass: the
+// offscreen color is read as an input attachment, at this pixel only.
+
+layout(input_attachment_index = 0, set = 0, binding = 0) uniform subpassInput offscreenColor;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    outColor = subpassLoad(offscreenColor);
+}
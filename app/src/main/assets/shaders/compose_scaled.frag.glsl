@@ -0,0 +1,20 @@
+#version 450
+// Compile: glslangValidator -V compose_scaled.frag.glsl -o compose_scaled.frag.spv
+// compose.frag for dynamic resolution: the offscreen layer covers only the
+// top-left uvScale of its image, stretched over the screen.
+
+layout(location = 0) in vec2 fragUV;
+
+layout(set = 0, binding = 0) uniform sampler2D offscreenTexture;
+
+layout(push_constant) uniform Push {
+    vec2 uvScale;   // render area / image size
+    vec2 uvMax;     // last texel centers of the render area
+} push;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    outColor = texture(offscreenTexture, min(fragUV * push.uvScale, push.uvMax));
+}
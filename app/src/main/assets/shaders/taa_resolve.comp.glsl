@@ -0,0 +1,62 @@
+#version 450
+// Compile: glslangValidator -V taa_resolve.comp.glsl -o taa_resolve.comp.spv
+// Temporal upscaling (TemporalUpscaler): this frame's jittered, lower
+// resolution layer blended into the reprojected full-resolution history.
+
+// Must match TemporalUpscaler::LOCAL_SIZE
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(set = 0, binding = 0) uniform sampler2D layerTexture;     // render area in the top-left
+layout(set = 0, binding = 1) uniform sampler2D historyTexture;   // previous output, same size as outImage
+layout(set = 0, binding = 2, rgba8) uniform writeonly image2D outImage;
+
+// Must match TemporalUpscaler::PushConstants
+layout(push_constant) uniform Push {
+    mat4 reprojection;        // this frame's NDC -> previous frame's clip space
+    vec2 jitterUV;            // this frame's jitter in screen UV
+    vec2 uvScale;             // render area / layer size
+    vec2 uvMax;               // last texel centers of the render area
+    vec2 texelSize;           // 1 / layer size
+    float reprojectionDepth;  // NDC depth every pixel is reprojected at
+    float historyWeight;      // 0 without history
+} push;
+
+vec4 SampleLayer(vec2 screenUV)
+{
+    return textureLod(layerTexture, min(screenUV * push.uvScale, push.uvMax), 0.0);
+}
+
+void main()
+{
+    ivec2 size = imageSize(outImage);
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (pixel.x >= size.x || pixel.y >= size.y)
+        return;
+
+    // The layer was rendered shifted by the jitter: read it back in place
+    vec2 uv = (vec2(pixel) + 0.5) / vec2(size);
+    vec2 layerUV = uv + push.jitterUV;
+    vec4 current = SampleLayer(layerUV);
+
+    // Range of this frame's 3x3 layer texels around the pixel
+    vec2 texel = push.texelSize / push.uvScale;   // one layer texel, in screen UV
+    vec4 lo = current;
+    vec4 hi = current;
+    for (int y = -1; y <= 1; ++y) {
+        for (int x = -1; x <= 1; ++x) {
+            vec4 neighbor = SampleLayer(layerUV + vec2(x, y) * texel);
+            lo = min(lo, neighbor);
+            hi = max(hi, neighbor);
+        }
+    }
+
+    vec4 previous = push.reprojection * vec4(uv * 2.0 - 1.0, push.reprojectionDepth, 1.0);
+    vec2 historyUV = previous.xy / previous.w * 0.5 + 0.5;
+    float weight = push.historyWeight;
+    if (previous.w <= 0.0 || any(lessThan(historyUV, vec2(0.0))) || any(greaterThan(historyUV, vec2(1.0))))
+        weight = 0.0;   // off screen last frame: nothing to accumulate
+
+    // History outside the neighborhood's range is something that moved or was uncovered
+    vec4 history = clamp(textureLod(historyTexture, historyUV, 0.0), lo, hi);
+    imageStore(outImage, pixel, mix(current, history, weight));
+}
@@ -2,8 +2,12 @@
 #include "vk_debug.h"
 #include "android_log.h"
 #include "concatenate.h"
+#include "yuv_convert.h"
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstring>
+#include <vector>
 
 using namespace graphics;
 
@@ -11,13 +15,125 @@ using namespace graphics;
 // Construction / destruction
 // ============================================================
 
-ARCameraImage::ARCameraImage(VkDevice device, VmaAllocator allocator)
-        : device(device), allocator(allocator) {
-    LOGI("ARCameraImage created (no resources yet — waiting for first camera frame)");
+namespace {
+    // NV12 layout: plane 0 = Y, plane 1 = interleaved CbCr (B8R8 -> Cb first)
+    constexpr VkFormat YCBCR_FORMAT = VK_FORMAT_G8_B8R8_2PLANE_420_UNORM;
+
+    const char* UploadPathName(ARCameraImage::UploadPath path) {
+        switch (path) {
+            case ARCameraImage::UploadPath::HostImageCopy: return "host image copy";
+            case ARCameraImage::UploadPath::LinearImage:   return "linear image";
+            case ARCameraImage::UploadPath::Staging:       return "staging";
+        }
+        return "?";
+    }
+
+    /// Optimal tiling, sampled, and writable by host image copies.
+    bool SupportsHostImageCopy(VkPhysicalDevice physicalDevice, VkFormat format) {
+        VkFormatProperties3 props3{};
+        props3.sType = VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_3;
+        VkFormatProperties2 props2{};
+        props2.sType = VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_2;
+        props2.pNext = &props3;
+        vkGetPhysicalDeviceFormatProperties2(physicalDevice, format, &props2);
+        const VkFormatFeatureFlags2 needed = VK_FORMAT_FEATURE_2_HOST_IMAGE_TRANSFER_BIT_EXT |
+                                             VK_FORMAT_FEATURE_2_SAMPLED_IMAGE_BIT;
+        return (props3.optimalTilingFeatures & needed) == needed;
+    }
+
+    /// Linear tiling, sampled with linear filtering.
+    bool SupportsLinearSampling(VkPhysicalDevice physicalDevice, VkFormat format) {
+        VkFormatProperties props{};
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
+        const VkFormatFeatureFlags needed = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT |
+                                            VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        return (props.linearTilingFeatures & needed) == needed;
+    }
+
+    /// The chroma planes of a frame, as the yuv_convert kernels take them.
+    utils::ChromaPlanes ChromaOf(const ar::CameraFrame& frame) {
+        utils::ChromaPlanes planes;
+        planes.u           = frame.uvPlane;
+        planes.v           = frame.vPlane;
+        planes.uRowStride  = frame.uvRowStride;
+        planes.vRowStride  = frame.vRowStride;
+        planes.pixelStride = frame.uvPixelStride;
+        planes.layout      = frame.chromaLayout;
+        return planes;
+    }
+
+    /// Same, starting at chroma row `row`.
+    utils::ChromaPlanes ChromaRows(const ar::CameraFrame& frame, uint32_t row) {
+        utils::ChromaPlanes planes = ChromaOf(frame);
+        planes.u += static_cast<size_t>(row) * frame.uvRowStride;
+        planes.v += static_cast<size_t>(row) * frame.vRowStride;
+        return planes;
+    }
+
+    /**
+     * Rows [begin, end) of a plane copied at the same pitch on both sides,
+     * as one memcpy: the padding between rows goes along, except after the
+     * plane's last row, which the camera doesn't pad.
+     */
+    void CopyRowSpan(uint8_t* dst, const uint8_t* src, size_t stride, size_t rowBytes,
+                     uint32_t begin, uint32_t end, uint32_t rows) {
+        if (begin >= end) {
+            return;
+        }
+        const size_t first = begin * stride;
+        const size_t last  = end == rows ? (end - 1) * stride + rowBytes : end * stride;
+        memcpy(dst + first, src + first, last - first);
+    }
+}
+
+ARCameraImage::ARCameraImage(VkDevice device, VkPhysicalDevice physicalDevice, VmaAllocator allocator,
+                             const DeviceCapabilities& capabilities, bool allowYcbcr)
+        : device(device), physicalDevice(physicalDevice), allocator(allocator) {
+    if (allowYcbcr && capabilities.samplerYcbcrConversion) {
+        CreateYcbcrSampler();
+    }
+
+    // Pick the cheapest upload path the device supports for the image format(s).
+    // Multi-planar images can't be linear, so YCbCr mode is host copy or staging.
+    const bool hostCopyFormats = UsesYcbcr()
+            ? SupportsHostImageCopy(physicalDevice, YCBCR_FORMAT)
+            : SupportsHostImageCopy(physicalDevice, VK_FORMAT_R8_UNORM) &&
+              SupportsHostImageCopy(physicalDevice, VK_FORMAT_R8G8_UNORM);
+    if (capabilities.hostImageCopy && hostCopyFormats && LoadHostImageCopy()) {
+        uploadPath = UploadPath::HostImageCopy;
+        sampledLayout = capabilities.hostImageCopyToShaderReadOnly
+                        ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+                        : VK_IMAGE_LAYOUT_GENERAL;
+    }
+    if (uploadPath == UploadPath::Staging && !UsesYcbcr() &&
+        SupportsLinearSampling(physicalDevice, VK_FORMAT_R8_UNORM) &&
+        SupportsLinearSampling(physicalDevice, VK_FORMAT_R8G8_UNORM)) {
+        // Host access to a linear image is only defined in GENERAL (or PREINITIALIZED)
+        uploadPath = UploadPath::LinearImage;
+        sampledLayout = VK_IMAGE_LAYOUT_GENERAL;
+    }
+    LOGI("ARCameraImage: upload path %s%s", UploadPathName(uploadPath),
+         UsesYcbcr() ? ", YCbCr sampling" : "");
+
+    if (capabilities.externalMemoryHost) {
+        getHostPointerProperties = reinterpret_cast<PFN_vkGetMemoryHostPointerPropertiesEXT>(
+                vkGetDeviceProcAddr(device, "vkGetMemoryHostPointerPropertiesEXT"));
+        if (getHostPointerProperties) {
+            importAlignment = capabilities.minImportedHostPointerAlignment;
+        }
+    }
+    LOGI("ARCameraImage created (no resources yet — waiting for first camera frame), host import %s",
+         importAlignment ? "available" : "unavailable");
 }
 
 ARCameraImage::~ARCameraImage() {
     DestroyResources();
+    if (ycbcrSampler != VK_NULL_HANDLE) {
+        vkDestroySampler(device, ycbcrSampler, nullptr);
+    }
+    if (ycbcrConversion != VK_NULL_HANDLE) {
+        vkDestroySamplerYcbcrConversion(device, ycbcrConversion, nullptr);
+    }
     LOGI("ARCameraImage destroyed");
 }
 
@@ -25,134 +141,784 @@ ARCameraImage::~ARCameraImage() {
 // Ring buffer advancement
 // ============================================================
 
-void ARCameraImage::AdvanceFrame() {
-    frameResources.Next();
+void ARCameraImage::AdvanceFrame(uint64_t frame, uint64_t completedFrame) {
+    if (pending.active) {
+        // Begun but never recorded (the frame was dropped): the slot simply isn't used
+        WaitForBands();
+        pending = {};
+    }
+    frameNumber = frame;
+    this->completedFrame = completedFrame;
+    // The current slot is sampled again this frame, unless Update replaces it
+    auto& current = frameResources[currentSlot];
+    currentSlotPreviousUse  = current.lastSampledFrame;
+    current.lastSampledFrame = frameNumber;
+
+    // Uploads whose frame has completed no longer need the camera memory
+    for (uint32_t i = 0; i < frameResources.Size(); ++i) {
+        auto& res = frameResources[i];
+        if (res.importedImage && res.uploadFrame <= completedFrame) {
+            ReleaseImports(res);
+        }
+    }
+    // Images replaced by a resize that no frame in flight uses any more
+    for (size_t i = 0; i < retired.size();) {
+        if (retired[i].lastUse <= completedFrame) {
+            DestroySlot(retired[i].res);
+            retired.erase(retired.begin() + static_cast<ptrdiff_t>(i));
+        } else {
+            ++i;
+        }
+    }
+}
+
+uint32_t ARCameraImage::PickWriteSlot() const {
+    uint32_t best = UINT32_MAX;
+    for (uint32_t i = 0; i < frameResources.Size(); ++i) {
+        const uint64_t used = frameResources[i].lastSampledFrame;
+        if (used != 0 && used > completedFrame) {
+            continue;   // a frame still in flight may read it
+        }
+        if (best == UINT32_MAX || used < frameResources[best].lastSampledFrame) {
+            best = i;
+        }
+    }
+    return best;
 }
 
 // ============================================================
-// Per-frame update: memcpy Y+UV planes, GPU upload
+// Per-frame update: CPU copy in row bands, then transfer commands
 // ============================================================
 
-void ARCameraImage::Update(VkCommandBuffer cmd, const ar::CameraFrame& frame) {
-    if (!frame.valid || !frame.yPlane || !frame.uvPlane) {
+void ARCameraImage::BeginUpload(const ar::CameraFrame& camera) {
+    if (pending.active) {
+        // Begun again without an Update in between: drop the earlier upload
+        WaitForBands();
+        pending = {};
+    }
+    beganFrame = frameNumber;
+    if (!camera.valid || !camera.yPlane || !camera.uvPlane || !camera.vPlane) {
+        return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+
+    // Same camera image and crop as last time: the current slot already holds it
+    const Region region = ComputeRegion(camera);
+    if (valid && camera.timestamp != 0 && camera.timestamp == uploadedTimestamp &&
+        region == uploadedRegion) {
+        RecordSavings(static_cast<uint64_t>(width) * height * 3 / 2);
         return;
     }
+    RecordSavings(0);
+    if (!(region == uploadedRegion)) {
+        LOGI("ARCameraImage: display region %ux%u at (%u,%u) of %dx%d%s",
+             region.width, region.height, region.x, region.y, camera.width, camera.height,
+             region.halve ? ", halved" : "");
+    }
+    const ar::CameraFrame crop = CropFrame(camera, region);
+    const ar::CameraFrame frame = region.halve ? HalvedFrame(crop) : crop;
 
     uint32_t camW = static_cast<uint32_t>(frame.width);
     uint32_t camH = static_cast<uint32_t>(frame.height);
+    uint32_t yStride  = static_cast<uint32_t>(frame.yRowStride);
+    // NV12 goes up as the camera laid it out; anything else is normalized
+    // into tightly packed NV12 rows on the way in.
+    const bool nv12 = frame.chromaLayout == utils::ChromaLayout::NV12;
+    uint32_t uvStride = nv12 ? static_cast<uint32_t>(frame.uvRowStride) : camW;
 
-    // Recreate if the camera resolution changed (or first frame).
-    if (camW != width || camH != height) {
-        LOGI("ARCameraImage: camera resolution %ux%u (was %ux%u), (re)creating resources",
-             camW, camH, width, height);
-        DestroyResources();
-        CreateResources(camW, camH);
+    // Recreate if the camera resolution or layout changed (or first frame).
+    if (camW != width || camH != height || yStride != yRowStride || uvStride != uvRowStride ||
+        frame.chromaLayout != chromaLayout) {
+        LOGI("ARCameraImage: camera resolution %ux%u strides %u/%u (was %ux%u), (re)creating resources",
+             camW, camH, yStride, uvStride, width, height);
+        RetireResources();
+        CreateResources(camW, camH, yStride, uvStride);
+        chromaLayout = frame.chromaLayout;
     }
 
-    auto& res = frameResources.Current();
+    // With 1 slot sampled per frame, one of MAX_FRAMES_IN_FLIGHT slots is always free
+    const uint32_t slot = PickWriteSlot();
+    if (slot == UINT32_MAX) {
+        LOGE("ARCameraImage: no free slot, keeping the previous camera image");
+        return;
+    }
+    auto& res = frameResources[slot];
+    ReleaseImports(res);
+    res.uploadFrame      = frameNumber;
+    res.lastSampledFrame = frameNumber;
 
-    // ── 1. CPU: memcpy Y plane (row-by-row to strip padding) ──
-    {
-        auto* dst = static_cast<uint8_t*>(res.yMappedData);
-        const uint8_t* src = frame.yPlane;
-        if (frame.yRowStride == static_cast<int32_t>(width)) {
-            memcpy(dst, src, width * height);
-        } else {
-            for (uint32_t row = 0; row < height; ++row) {
-                memcpy(dst + row * width, src + row * frame.yRowStride, width);
-            }
+    pending.active = true;
+    pending.slot   = slot;
+    pending.region = region;
+    pending.crop   = crop;
+    pending.frame  = frame;
+
+    // Everything the bands touch is sized here, before any of them starts
+    if (uploadPath == UploadPath::HostImageCopy && !nv12) {
+        chromaScratch.resize(static_cast<size_t>(uvRowStride) * (height / 2));
+    }
+    if (region.halve && crop.chromaLayout != utils::ChromaLayout::NV12) {
+        halveInput.resize(static_cast<size_t>(crop.width) * (crop.height / 2));
+    }
+    if (uploadPath == UploadPath::Staging) {
+        ImportPlanes(res);
+    }
+
+    // Split on chroma rows so every band holds whole 2x2 blocks
+    const uint32_t chromaRows = height / 2;
+    const uint64_t frameBytes = static_cast<uint64_t>(width) * height * 3 / 2;
+    uint32_t bands = 1;
+    if (workers) {
+        bands = static_cast<uint32_t>(std::clamp<uint64_t>(frameBytes / MIN_BAND_BYTES, 1, workers->Size()));
+    }
+    if (bands == 1) {
+        CopyBand(0, height);
+    } else {
+        bandsDone.Reset(bands);
+        for (uint32_t band = 0; band < bands; ++band) {
+            const uint32_t rowBegin = 2 * (chromaRows * band / bands);
+            const uint32_t rowEnd   = band + 1 == bands ? height : 2 * (chromaRows * (band + 1) / bands);
+            workers->Submit([this, rowBegin, rowEnd] {
+                CopyBand(rowBegin, rowEnd);
+                bandsDone.CountDown();
+            });
         }
     }
+    pending.beginTime = std::chrono::steady_clock::now() - start;
+}
 
-    // ── 2. CPU: memcpy UV plane (interleaved NV12, half res) ──
-    {
-        const uint32_t uvW = width;      // bytes per row = width (width/2 RG pairs * 2 bytes)
-        const uint32_t uvH = height / 2;
-        auto* dst = static_cast<uint8_t*>(res.uvMappedData);
-        const uint8_t* src = frame.uvPlane;
-        if (frame.uvRowStride == static_cast<int32_t>(uvW)) {
-            memcpy(dst, src, uvW * uvH);
-        } else {
-            for (uint32_t row = 0; row < uvH; ++row) {
-                memcpy(dst + row * uvW, src + row * frame.uvRowStride, uvW);
-            }
+void ARCameraImage::Update(VkCommandBuffer cmd, const ar::CameraFrame& frame) {
+    if (beganFrame != frameNumber) {
+        BeginUpload(frame);
+    }
+    if (!pending.active) {
+        return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+
+    // The only point the render thread waits for the copy
+    WaitForBands();
+    auto& res = frameResources[pending.slot];
+    switch (uploadPath) {
+        case UploadPath::HostImageCopy: break;   // the bands wrote the images
+        case UploadPath::LinearImage:   RecordLinear(cmd, res);  break;
+        case UploadPath::Staging:       RecordStaging(cmd, res); break;
+    }
+
+    if (pending.slot != currentSlot) {
+        // The old slot isn't sampled this frame after all
+        frameResources[currentSlot].lastSampledFrame = currentSlotPreviousUse;
+        currentSlot = pending.slot;
+    }
+    std::copy(pending.region.uvs, pending.region.uvs + 8, res.displayUVs);
+    valid = true;
+    uploadedTimestamp = pending.frame.timestamp;
+    uploadedRegion = pending.region;
+    const auto blocked = pending.beginTime + (std::chrono::steady_clock::now() - start);
+    pending = {};
+    RecordTiming(blocked);
+}
+
+void ARCameraImage::WaitForBands() {
+    bandsDone.Wait();
+}
+
+void ARCameraImage::ReleaseCameraMemory() {
+    vkDeviceWaitIdle(device);
+    if (pending.active) {
+        // The bands still read the frame's planes; the slot keeps its old contents.
+        WaitForBands();
+        pending = {};
+    }
+    for (uint32_t i = 0; i < frameResources.Size(); ++i) {
+        ReleaseImports(frameResources[i]);
+    }
+    // Nothing is in flight any more: the retired slots can go now.
+    for (auto& old : retired) {
+        DestroySlot(old.res);
+    }
+    retired.clear();
+}
+
+// ============================================================
+// Display-matched region
+// ============================================================
+
+bool ARCameraImage::Region::operator==(const Region& other) const {
+    return x == other.x && y == other.y && width == other.width && height == other.height &&
+           halve == other.halve && std::equal(uvs, uvs + 8, other.uvs);
+}
+
+ARCameraImage::Region ARCameraImage::ComputeRegion(const ar::CameraFrame& frame) const {
+    const auto camW = static_cast<uint32_t>(frame.width);
+    const auto camH = static_cast<uint32_t>(frame.height);
+    Region region;
+    region.width  = camW;
+    region.height = camH;
+
+    // Until the display geometry is known, show the whole image unrotated
+    float corners[8] = {0.0f, 0.0f, float(camW), 0.0f, 0.0f, float(camH), float(camW), float(camH)};
+    if (frame.hasDisplayCorners) {
+        std::copy(frame.displayCorners, frame.displayCorners + 8, corners);
+    }
+
+    if (regionOfInterest && frame.hasDisplayCorners) {
+        float minX = float(camW), minY = float(camH), maxX = 0.0f, maxY = 0.0f;
+        for (int i = 0; i < 4; ++i) {
+            minX = std::min(minX, corners[2 * i]);
+            maxX = std::max(maxX, corners[2 * i]);
+            minY = std::min(minY, corners[2 * i + 1]);
+            maxY = std::max(maxY, corners[2 * i + 1]);
+        }
+        // Even edges keep whole 2x2 chroma blocks, so chroma crops cleanly
+        const uint32_t x0 = static_cast<uint32_t>(std::clamp(std::floor(minX), 0.0f, float(camW))) & ~1u;
+        const uint32_t y0 = static_cast<uint32_t>(std::clamp(std::floor(minY), 0.0f, float(camH))) & ~1u;
+        const uint32_t x1 = std::min(camW, (static_cast<uint32_t>(std::clamp(std::ceil(maxX), 0.0f, float(camW))) + 1) & ~1u);
+        const uint32_t y1 = std::min(camH, (static_cast<uint32_t>(std::clamp(std::ceil(maxY), 0.0f, float(camH))) + 1) & ~1u);
+        if (x1 >= x0 + 16 && y1 >= y0 + 16) {
+            region.x      = x0;
+            region.y      = y0;
+            region.width  = x1 - x0;
+            region.height = y1 - y0;
         }
     }
 
-    // ── 3. GPU: transition both images UNDEFINED → TRANSFER_DST ──
-    VkImageMemoryBarrier toTransferDst[2]{};
-    for (int i = 0; i < 2; ++i) {
-        toTransferDst[i].sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        toTransferDst[i].srcAccessMask       = 0;
-        toTransferDst[i].dstAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
-        toTransferDst[i].oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
-        toTransferDst[i].newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        toTransferDst[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        toTransferDst[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        toTransferDst[i].subresourceRange    = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
-    }
-    toTransferDst[0].image = res.yImage;
-    toTransferDst[1].image = res.uvImage;
-
-    vkCmdPipelineBarrier(cmd,
-                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                         VK_PIPELINE_STAGE_TRANSFER_BIT,
-                         0,
-                         0, nullptr,
-                         0, nullptr,
-                         2, toTransferDst);
+    // Twice the display's resolution in both directions or more: the
+    // sampler would skip texels anyway, so halve before uploading
+    const uint64_t displayPixels = static_cast<uint64_t>(std::max(frame.displayWidth, 0)) *
+                                   static_cast<uint64_t>(std::max(frame.displayHeight, 0));
+    if (downsample && displayPixels != 0 &&
+        static_cast<uint64_t>(region.width) * region.height >= 4 * displayPixels) {
+        // Halved chroma must still be whole CbCr pairs
+        region.width  &= ~3u;
+        region.height &= ~3u;
+        region.halve = true;
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        region.uvs[2 * i]     = (corners[2 * i]     - float(region.x)) / float(region.width);
+        region.uvs[2 * i + 1] = (corners[2 * i + 1] - float(region.y)) / float(region.height);
+    }
+    return region;
+}
+
+
+ar::CameraFrame ARCameraImage::CropFrame(const ar::CameraFrame& frame, const Region& region) const {
+    ar::CameraFrame out = frame;
+    // Move each plane to the region's top-left; the camera's strides still apply
+    const size_t yOffset  = static_cast<size_t>(region.y) * frame.yRowStride + region.x;
+    const size_t uOffset  = static_cast<size_t>(region.y / 2) * frame.uvRowStride +
+                            static_cast<size_t>(region.x / 2) * frame.uvPixelStride;
+    const size_t vOffset  = static_cast<size_t>(region.y / 2) * frame.vRowStride +
+                            static_cast<size_t>(region.x / 2) * frame.uvPixelStride;
+    out.yPlane   += yOffset;
+    out.uvPlane  += uOffset;
+    out.vPlane   += vOffset;
+    out.yLength  -= static_cast<int32_t>(yOffset);
+    out.uvLength -= static_cast<int32_t>(uOffset);
+    out.vLength  -= static_cast<int32_t>(vOffset);
+    out.width    = static_cast<int32_t>(region.width);
+    out.height   = static_cast<int32_t>(region.height);
+    return out;
+}
+
+ar::CameraFrame ARCameraImage::HalvedFrame(const ar::CameraFrame& crop) {
+    // Tightly packed NV12 planes; HalveBand fills them
+    const uint32_t halfW = static_cast<uint32_t>(crop.width) / 2;
+    const uint32_t halfH = static_cast<uint32_t>(crop.height) / 2;
+    const size_t ySize = static_cast<size_t>(halfW) * halfH;
+    halvedPlanes.resize(ySize + ySize / 2);
+
+    ar::CameraFrame out = crop;
+    out.yPlane        = halvedPlanes.data();
+    out.uvPlane       = halvedPlanes.data() + ySize;
+    out.vPlane        = out.uvPlane + 1;
+    out.yRowStride    = static_cast<int32_t>(halfW);
+    out.uvRowStride   = static_cast<int32_t>(halfW);
+    out.vRowStride    = static_cast<int32_t>(halfW);
+    out.uvPixelStride = 2;
+    out.yLength       = static_cast<int32_t>(ySize);
+    out.uvLength      = static_cast<int32_t>(ySize / 2);
+    out.vLength       = static_cast<int32_t>(ySize / 2 - 1);
+    out.chromaLayout  = utils::ChromaLayout::NV12;
+    out.width         = static_cast<int32_t>(halfW);
+    out.height        = static_cast<int32_t>(halfH);
+    out.image         = nullptr;   // our memory, nothing to import
+    return out;
+}
+
+void ARCameraImage::HalveBand(uint32_t rowBegin, uint32_t rowEnd) {
+    const ar::CameraFrame& crop = pending.crop;
+    const ar::CameraFrame& out  = pending.frame;
+    const uint32_t halfW = static_cast<uint32_t>(out.width);
+    uint8_t* y  = const_cast<uint8_t*>(out.yPlane);
+    uint8_t* uv = const_cast<uint8_t*>(out.uvPlane);
+    utils::Downsample2xLuma(y + static_cast<size_t>(rowBegin) * halfW, halfW,
+                            crop.yPlane + static_cast<size_t>(rowBegin) * 2 * crop.yRowStride, crop.yRowStride,
+                            halfW, rowEnd - rowBegin);
+
+    // Output chroma rows [chromaBegin, chromaEnd) come from twice as many NV12 rows
+    const uint32_t chromaBegin = rowBegin / 2;
+    const uint32_t chromaEnd   = rowEnd / 2;
+    const uint8_t* nv12 = crop.uvPlane + static_cast<size_t>(chromaBegin) * 2 * crop.uvRowStride;
+    size_t nv12Stride = crop.uvRowStride;
+    if (crop.chromaLayout != utils::ChromaLayout::NV12) {
+        uint8_t* normalized = halveInput.data() + static_cast<size_t>(chromaBegin) * 2 * crop.width;
+        utils::ConvertChromaToNv12(normalized, crop.width, ChromaRows(crop, chromaBegin * 2),
+                                   crop.width / 2, (chromaEnd - chromaBegin) * 2);
+        nv12 = normalized;
+        nv12Stride = crop.width;
+    }
+    utils::Downsample2xChroma(uv + static_cast<size_t>(chromaBegin) * halfW, halfW, nv12, nv12Stride,
+                              halfW / 2, chromaEnd - chromaBegin);
+}
+
+// ============================================================
+// Band copies (worker threads): rows [rowBegin, rowEnd) of the frame
+// ============================================================
+
+void ARCameraImage::CopyBand(uint32_t rowBegin, uint32_t rowEnd) {
+    if (rowBegin >= rowEnd) {
+        return;
+    }
+    if (pending.region.halve) {
+        HalveBand(rowBegin, rowEnd);
+    }
+    FrameResources& res = frameResources[pending.slot];
+    switch (uploadPath) {
+        case UploadPath::HostImageCopy: HostCopyBand(res, rowBegin, rowEnd);    break;
+        case UploadPath::LinearImage:   LinearCopyBand(res, rowBegin, rowEnd);  break;
+        case UploadPath::Staging:       StagingCopyBand(res, rowBegin, rowEnd); break;
+    }
+}
+
+// ── Host image copy: CPU → optimal image, nothing recorded ──
+// PickWriteSlot only hands out a slot whose lastSampledFrame <= completedFrame (the
+// frame timeline's completed value), so the GPU no longer reads these images.
+// Bands write disjoint rows, so they can copy into the same image at once.
+void ARCameraImage::HostCopyBand(FrameResources& res, uint32_t rowBegin, uint32_t rowEnd) {
+    const ar::CameraFrame& frame = pending.frame;
+    VkMemoryToImageCopyEXT yRegion{};
+    yRegion.sType             = VK_STRUCTURE_TYPE_MEMORY_TO_IMAGE_COPY_EXT;
+    yRegion.pHostPointer      = frame.yPlane + static_cast<size_t>(rowBegin) * yRowStride;
+    yRegion.memoryRowLength   = yRowStride;   // R8: texels == bytes
+    yRegion.memoryImageHeight = 0;
+    yRegion.imageSubresource  = {PlaneAspect(0), 0, 0, 1};
+    yRegion.imageOffset       = {0, static_cast<int32_t>(rowBegin), 0};
+    yRegion.imageExtent       = {width, rowEnd - rowBegin, 1};
+
+    VkCopyMemoryToImageInfoEXT yCopy{};
+    yCopy.sType          = VK_STRUCTURE_TYPE_COPY_MEMORY_TO_IMAGE_INFO_EXT;
+    yCopy.dstImage       = PlaneImage(res, 0);
+    yCopy.dstImageLayout = sampledLayout;
+    yCopy.regionCount    = 1;
+    yCopy.pRegions       = &yRegion;
+    VkResult result = copyMemoryToImage(device, &yCopy);
+    assert(result == VK_SUCCESS);
+
+    // UV: one region if the stride is a whole number of RG8 texels, else one per row
+    const uint32_t uvBegin = rowBegin / 2;
+    const uint32_t uvRows  = rowEnd / 2 - uvBegin;
+    const uint8_t* uvSource = frame.uvPlane + static_cast<size_t>(uvBegin) * uvRowStride;
+    if (chromaLayout != utils::ChromaLayout::NV12) {
+        uint8_t* normalized = chromaScratch.data() + static_cast<size_t>(uvBegin) * uvRowStride;
+        utils::ConvertChromaToNv12(normalized, uvRowStride, ChromaRows(frame, uvBegin), width / 2, uvRows);
+        uvSource = normalized;
+    }
+    std::vector<VkMemoryToImageCopyEXT> uvRegions(uvRowStride % 2 == 0 ? 1 : uvRows);
+    for (uint32_t i = 0; i < uvRegions.size(); ++i) {
+        auto& region = uvRegions[i];
+        const bool perRow = uvRegions.size() > 1;
+        region.sType             = VK_STRUCTURE_TYPE_MEMORY_TO_IMAGE_COPY_EXT;
+        region.pHostPointer      = uvSource + static_cast<size_t>(i) * uvRowStride;
+        region.memoryRowLength   = perRow ? 0 : uvRowStride / 2;
+        region.memoryImageHeight = 0;
+        region.imageSubresource  = {PlaneAspect(1), 0, 0, 1};
+        region.imageOffset       = {0, static_cast<int32_t>(uvBegin + i), 0};
+        region.imageExtent       = {width / 2, perRow ? 1 : uvRows, 1};
+    }
+    VkCopyMemoryToImageInfoEXT uvCopy{};
+    uvCopy.sType          = VK_STRUCTURE_TYPE_COPY_MEMORY_TO_IMAGE_INFO_EXT;
+    uvCopy.dstImage       = PlaneImage(res, 1);
+    uvCopy.dstImageLayout = sampledLayout;
+    uvCopy.regionCount    = static_cast<uint32_t>(uvRegions.size());
+    uvCopy.pRegions       = uvRegions.data();
+    result = copyMemoryToImage(device, &uvCopy);
+    assert(result == VK_SUCCESS);
+}
+
+// ── Linear images: CPU rows → mapped image memory, sampled in GENERAL ──
+void ARCameraImage::LinearCopyBand(FrameResources& res, uint32_t rowBegin, uint32_t rowEnd) {
+    const ar::CameraFrame& frame = pending.frame;
+    auto* y  = static_cast<uint8_t*>(res.yMappedData) + res.yLayout.offset;
+    auto* uv = static_cast<uint8_t*>(res.uvMappedData) + res.uvLayout.offset;
+    const uint32_t uvBegin = rowBegin / 2;
+    utils::CopyPlane(y + rowBegin * res.yLayout.rowPitch, res.yLayout.rowPitch,
+                     frame.yPlane + static_cast<size_t>(rowBegin) * yRowStride, yRowStride,
+                     width, rowEnd - rowBegin);
+    utils::ConvertChromaToNv12(uv + uvBegin * res.uvLayout.rowPitch, res.uvLayout.rowPitch,
+                               ChromaRows(frame, uvBegin), width / 2, rowEnd / 2 - uvBegin);
+}
+
+// ── Staging: bulk memcpy (or imported camera memory); commands in RecordStaging ──
+void ARCameraImage::StagingCopyBand(FrameResources& res, uint32_t rowBegin, uint32_t rowEnd) {
+    const ar::CameraFrame& frame = pending.frame;
+    const uint32_t uvW = width;      // bytes per row = width (width/2 RG pairs * 2 bytes)
+    const uint32_t uvH = height / 2;
+    const uint32_t uvBegin = rowBegin / 2;
+    const uint32_t uvEnd   = rowEnd / 2;
+    auto* uv = static_cast<uint8_t*>(res.uvMappedData);
+
+    // Y plane: the band's bytes in one memcpy, padding included
+    if (res.yImport.buffer == VK_NULL_HANDLE) {
+        CopyRowSpan(static_cast<uint8_t*>(res.yMappedData), frame.yPlane, yRowStride, width,
+                    rowBegin, rowEnd, height);
+    }
+
+    // UV plane (interleaved NV12, half res), same
+    if (res.uvImport.buffer != VK_NULL_HANDLE) {
+        return;
+    }
+    if (chromaLayout != utils::ChromaLayout::NV12) {
+        // NV21 / I420 / strided: SIMD-normalized straight into the staging buffer
+        utils::ConvertChromaToNv12(uv + static_cast<size_t>(uvBegin) * uvRowStride, uvRowStride,
+                                   ChromaRows(frame, uvBegin), uvW / 2, uvEnd - uvBegin);
+    } else if (uvRowStride % 2 != 0) {
+        // Can't express an odd byte stride in RG8 texels: strip the padding
+        utils::CopyPlane(uv + static_cast<size_t>(uvBegin) * uvW, uvW,
+                         frame.uvPlane + static_cast<size_t>(uvBegin) * uvRowStride, uvRowStride,
+                         uvW, uvEnd - uvBegin);
+    } else {
+        CopyRowSpan(uv, frame.uvPlane, uvRowStride, uvW, uvBegin, uvEnd, uvH);
+    }
+}
+
+// ============================================================
+// Render thread: imports and transfer commands
+// ============================================================
+
+void ARCameraImage::ImportPlanes(FrameResources& res) {
+    const ar::CameraFrame& frame = pending.frame;
+    if (!importAlignment || !frame.image) {
+        return;   // nothing to import, or our own (halved) memory
+    }
+    // Bytes each plane spans: every row at its stride, except the last one,
+    // which only needs its pixels (the camera doesn't pad the final row).
+    const uint32_t uvH = height / 2;
+    const VkDeviceSize ySpan  = static_cast<VkDeviceSize>(height - 1) * yRowStride + width;
+    const VkDeviceSize uvSpan = static_cast<VkDeviceSize>(uvH - 1) * uvRowStride + width;
+
+    if (yImportable && !ImportPlane(frame.yPlane, ySpan, 1, res.yImport)) {
+        yImportable = false;
+    }
+    // Only NV12 with a whole number of RG8 texels per row goes up untouched
+    if (uvImportable && chromaLayout == utils::ChromaLayout::NV12 && uvRowStride % 2 == 0 &&
+        !ImportPlane(frame.uvPlane, uvSpan, 2, res.uvImport)) {
+        uvImportable = false;
+    }
+    if (res.yImport.buffer != VK_NULL_HANDLE || res.uvImport.buffer != VK_NULL_HANDLE) {
+        res.importedImage = frame.image;
+        importedPlanes += (res.yImport.buffer != VK_NULL_HANDLE) + (res.uvImport.buffer != VK_NULL_HANDLE);
+    }
+}
+
+void ARCameraImage::RecordLinear(VkCommandBuffer cmd, FrameResources& res) {
+    vmaFlushAllocation(allocator, res.yImageAllocation, 0, VK_WHOLE_SIZE);
+    vmaFlushAllocation(allocator, res.uvImageAllocation, 0, VK_WHOLE_SIZE);
+
+    // The first upload into this slot moves PREINITIALIZED → GENERAL, keeping the
+    // texels just written; after that the queue submit makes the host writes visible
+    const VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    barriers.UseImage(res.yImage, range, res.yState, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                      VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_GENERAL);
+    barriers.UseImage(res.uvImage, range, res.uvState, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                      VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_GENERAL);
+    barriers.Flush(cmd);
+}
+
+void ARCameraImage::RecordStaging(VkCommandBuffer cmd, FrameResources& res) {
+    const bool yImported  = res.yImport.buffer  != VK_NULL_HANDLE;
+    const bool uvImported = res.uvImport.buffer != VK_NULL_HANDLE;
+    const VkBuffer     yBuffer  = yImported  ? res.yImport.buffer  : res.yStagingBuffer;
+    const VkDeviceSize yOffset  = yImported  ? res.yImport.offset  : 0;
+    const VkBuffer     uvBuffer = uvImported ? res.uvImport.buffer : res.uvStagingBuffer;
+    const VkDeviceSize uvOffset = uvImported ? res.uvImport.offset : 0;
+    // Padding stripped on the CPU for odd NV12 strides (see StagingCopyBand)
+    const uint32_t uvRowLength = chromaLayout == utils::ChromaLayout::NV12 && uvRowStride % 2 != 0
+                                 ? width / 2 : uvRowStride / 2;
+
+    // ── 3. GPU: transition both images (or the one multi-planar image) to TRANSFER_DST ──
+    // Old contents are discarded; the copy still waits for the slot's last readers
+    const bool twoImages = !UsesYcbcr();
+    const VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    barriers.UseImage(res.yImage, range, res.yState, VK_PIPELINE_STAGE_2_COPY_BIT,
+                      VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true);
+    if (twoImages) {
+        barriers.UseImage(res.uvImage, range, res.uvState, VK_PIPELINE_STAGE_2_COPY_BIT,
+                          VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true);
+    }
+    barriers.Flush(cmd);
 
     // ── 4. GPU: copy staging buffers → images ──
     VkBufferImageCopy yRegion{};
-    yRegion.bufferOffset      = 0;
-    yRegion.bufferRowLength   = 0;   // tightly packed
+    yRegion.bufferOffset      = yOffset;
+    yRegion.bufferRowLength   = yRowStride;   // R8: texels == bytes
     yRegion.bufferImageHeight = 0;
-    yRegion.imageSubresource  = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    yRegion.imageSubresource  = {PlaneAspect(0), 0, 0, 1};
     yRegion.imageOffset       = {0, 0, 0};
     yRegion.imageExtent       = {width, height, 1};
 
     vkCmdCopyBufferToImage(cmd,
-                           res.yStagingBuffer, res.yImage,
+                           yBuffer, PlaneImage(res, 0),
                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                            1, &yRegion);
 
     VkBufferImageCopy uvRegion{};
-    uvRegion.bufferOffset      = 0;
-    uvRegion.bufferRowLength   = 0;   // tightly packed
+    uvRegion.bufferOffset      = uvOffset;
+    uvRegion.bufferRowLength   = uvRowLength;
     uvRegion.bufferImageHeight = 0;
-    uvRegion.imageSubresource  = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    uvRegion.imageSubresource  = {PlaneAspect(1), 0, 0, 1};
     uvRegion.imageOffset       = {0, 0, 0};
     uvRegion.imageExtent       = {width / 2, height / 2, 1};
 
     vkCmdCopyBufferToImage(cmd,
-                           res.uvStagingBuffer, res.uvImage,
+                           uvBuffer, PlaneImage(res, 1),
                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                            1, &uvRegion);
 
-    // ── 5. GPU: transition both images TRANSFER_DST → SHADER_READ_ONLY ──
-    VkImageMemoryBarrier toShaderRead[2]{};
-    for (int i = 0; i < 2; ++i) {
-        toShaderRead[i].sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        toShaderRead[i].srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
-        toShaderRead[i].dstAccessMask       = VK_ACCESS_SHADER_READ_BIT;
-        toShaderRead[i].oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        toShaderRead[i].newLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        toShaderRead[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        toShaderRead[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        toShaderRead[i].subresourceRange    = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
-    }
-    toShaderRead[0].image = res.yImage;
-    toShaderRead[1].image = res.uvImage;
-
-    vkCmdPipelineBarrier(cmd,
-                         VK_PIPELINE_STAGE_TRANSFER_BIT,
-                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                         0,
-                         0, nullptr,
-                         0, nullptr,
-                         2, toShaderRead);
+    // ── 5. GPU: transition both images TRANSFER_DST → SHADER_READ_ONLY for the camera background ──
+    barriers.UseImage(res.yImage, range, res.yState, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                      VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    if (twoImages) {
+        barriers.UseImage(res.uvImage, range, res.uvState, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                          VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+    barriers.Flush(cmd);
+}
 
-    valid = true;
+void ARCameraImage::RecordTiming(std::chrono::steady_clock::duration elapsed) {
+    uploadTime += elapsed;
+    uploadTimeMax = std::max(uploadTimeMax, elapsed);
+    if (++uploadCount < TIMING_WINDOW) {
+        return;
+    }
+    using Ms = std::chrono::duration<float, std::milli>;
+    averageUploadMs = Ms(uploadTime).count() / static_cast<float>(uploadCount);
+    LOGI("ARCameraImage: %ux%u %s upload CPU %.3f ms avg, %.3f ms max (%u of %u planes imported)",
+         width, height, UploadPathName(uploadPath), averageUploadMs, Ms(uploadTimeMax).count(), importedPlanes, uploadCount * 2);
+    uploadTime = {};
+    uploadTimeMax = {};
+    uploadCount = 0;
+    importedPlanes = 0;
+}
+
+void ARCameraImage::RecordSavings(uint64_t bytes) {
+    const auto now = std::chrono::steady_clock::now();
+    if (savingsWindowStart == std::chrono::steady_clock::time_point{}) {
+        savingsWindowStart = now;
+    }
+    skippedBytes += bytes;
+    skippedUploads += bytes != 0;
+    const std::chrono::duration<float> elapsed = now - savingsWindowStart;
+    if (elapsed < SAVINGS_WINDOW) {
+        return;
+    }
+    bytesSavedPerSecond = static_cast<float>(skippedBytes) / elapsed.count();
+    LOGI("ARCameraImage: skipped %u repeated camera frames, %.2f MB/s of uploads saved",
+         skippedUploads, bytesSavedPerSecond / (1024.0f * 1024.0f));
+    savingsWindowStart = now;
+    skippedBytes   = 0;
+    skippedUploads = 0;
+}
+
+// ============================================================
+// Path / mode setup
+// ============================================================
+
+bool ARCameraImage::LoadHostImageCopy() {
+    copyMemoryToImage = reinterpret_cast<PFN_vkCopyMemoryToImageEXT>(
+            vkGetDeviceProcAddr(device, "vkCopyMemoryToImageEXT"));
+    transitionImageLayout = reinterpret_cast<PFN_vkTransitionImageLayoutEXT>(
+            vkGetDeviceProcAddr(device, "vkTransitionImageLayoutEXT"));
+    return copyMemoryToImage && transitionImageLayout;
+}
+
+bool ARCameraImage::CreateYcbcrSampler() {
+    VkFormatProperties props{};
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, YCBCR_FORMAT, &props);
+    const VkFormatFeatureFlags features = props.optimalTilingFeatures;
+    const bool midpoint = features & VK_FORMAT_FEATURE_MIDPOINT_CHROMA_SAMPLES_BIT;
+    const bool cosited  = features & VK_FORMAT_FEATURE_COSITED_CHROMA_SAMPLES_BIT;
+    if (!(features & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) ||
+        !(features & VK_FORMAT_FEATURE_TRANSFER_DST_BIT) || !(midpoint || cosited)) {
+        LOGI("ARCameraImage: G8_B8R8_2PLANE_420 not sampleable through a YCbCr conversion");
+        return false;
+    }
+    // Without the separate reconstruction filter bit, min/mag must match the chroma filter
+    const VkFilter filter =
+            (features & VK_FORMAT_FEATURE_SAMPLED_IMAGE_YCBCR_CONVERSION_LINEAR_FILTER_BIT)
+            ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+
+    // Same maths camera_bg.frag does by hand: BT.601, full range
+    VkSamplerYcbcrConversionCreateInfo conversionInfo{};
+    conversionInfo.sType         = VK_STRUCTURE_TYPE_SAMPLER_YCBCR_CONVERSION_CREATE_INFO;
+    conversionInfo.format        = YCBCR_FORMAT;
+    conversionInfo.ycbcrModel    = VK_SAMPLER_YCBCR_MODEL_CONVERSION_YCBCR_601;
+    conversionInfo.ycbcrRange    = VK_SAMPLER_YCBCR_RANGE_ITU_FULL;
+    conversionInfo.components    = {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
+                                    VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY};
+    conversionInfo.xChromaOffset = midpoint ? VK_CHROMA_LOCATION_MIDPOINT : VK_CHROMA_LOCATION_COSITED_EVEN;
+    conversionInfo.yChromaOffset = conversionInfo.xChromaOffset;
+    conversionInfo.chromaFilter  = filter;
+    conversionInfo.forceExplicitReconstruction = VK_FALSE;
+    if (vkCreateSamplerYcbcrConversion(device, &conversionInfo, nullptr, &ycbcrConversion) != VK_SUCCESS) {
+        ycbcrConversion = VK_NULL_HANDLE;
+        return false;
+    }
+
+    VkSamplerYcbcrConversionInfo conversionRef{};
+    conversionRef.sType      = VK_STRUCTURE_TYPE_SAMPLER_YCBCR_CONVERSION_INFO;
+    conversionRef.conversion = ycbcrConversion;
+
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.pNext        = &conversionRef;
+    samplerInfo.magFilter    = filter;
+    samplerInfo.minFilter    = filter;
+    samplerInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    VkResult result = vkCreateSampler(device, &samplerInfo, nullptr, &ycbcrSampler);
+    assert(result == VK_SUCCESS);
+
+    // A YCbCr combined image sampler may take more than one descriptor from the pool
+    VkSamplerYcbcrConversionImageFormatProperties ycbcrProps{};
+    ycbcrProps.sType = VK_STRUCTURE_TYPE_SAMPLER_YCBCR_CONVERSION_IMAGE_FORMAT_PROPERTIES;
+    VkImageFormatProperties2 formatProps{};
+    formatProps.sType = VK_STRUCTURE_TYPE_IMAGE_FORMAT_PROPERTIES_2;
+    formatProps.pNext = &ycbcrProps;
+    VkPhysicalDeviceImageFormatInfo2 formatInfo{};
+    formatInfo.sType  = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_FORMAT_INFO_2;
+    formatInfo.format = YCBCR_FORMAT;
+    formatInfo.type   = VK_IMAGE_TYPE_2D;
+    formatInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    formatInfo.usage  = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    if (vkGetPhysicalDeviceImageFormatProperties2(physicalDevice, &formatInfo, &formatProps) == VK_SUCCESS) {
+        ycbcrDescriptorCount = std::max(1u, ycbcrProps.combinedImageSamplerDescriptorCount);
+    }
+    LOGI("ARCameraImage: YCbCr conversion created (%s chroma, %s filter, %u descriptor(s))",
+         midpoint ? "midpoint" : "cosited", filter == VK_FILTER_LINEAR ? "linear" : "nearest",
+         ycbcrDescriptorCount);
+    return true;
+}
+
+VkImage ARCameraImage::PlaneImage(const FrameResources& res, uint32_t plane) const {
+    return (plane == 0 || UsesYcbcr()) ? res.yImage : res.uvImage;
+}
+
+VkImageAspectFlags ARCameraImage::PlaneAspect(uint32_t plane) const {
+    if (!UsesYcbcr()) {
+        return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+    return plane == 0 ? VK_IMAGE_ASPECT_PLANE_0_BIT : VK_IMAGE_ASPECT_PLANE_1_BIT;
+}
+
+// ============================================================
+// Host memory import (VK_EXT_external_memory_host)
+// ============================================================
+
+bool ARCameraImage::ImportPlane(const uint8_t* data, VkDeviceSize size, uint32_t texelSize,
+                                ImportedPlane& out) {
+    // The import must start and end on the alignment; the copy starts at the
+    // plane's offset inside that range, which must be a whole texel.
+    const uintptr_t address = reinterpret_cast<uintptr_t>(data);
+    const uintptr_t base = address & ~static_cast<uintptr_t>(importAlignment - 1);
+    const VkDeviceSize offset = address - base;
+    if (offset % texelSize != 0) {
+        return false;
+    }
+    const VkDeviceSize importSize = (offset + size + importAlignment - 1) & ~(importAlignment - 1);
+    void* hostPointer = reinterpret_cast<void*>(base);
+
+    // Camera buffers are gralloc mappings (foreign memory); some drivers only
+    // accept them as plain host allocations.
+    const VkExternalMemoryHandleTypeFlagBits handleTypes[] = {
+            VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_MAPPED_FOREIGN_MEMORY_BIT_EXT,
+            VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT
+    };
+    for (VkExternalMemoryHandleTypeFlagBits handleType : handleTypes) {
+        VkMemoryHostPointerPropertiesEXT pointerProps{};
+        pointerProps.sType = VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT;
+        if (getHostPointerProperties(device, handleType, hostPointer, &pointerProps) != VK_SUCCESS ||
+            pointerProps.memoryTypeBits == 0) {
+            continue;
+        }
+
+        VkExternalMemoryBufferCreateInfo externalInfo{};
+        externalInfo.sType       = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO;
+        externalInfo.handleTypes = handleType;
+
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.pNext       = &externalInfo;
+        bufferInfo.size        = importSize;
+        bufferInfo.usage       = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VkBuffer buffer = VK_NULL_HANDLE;
+        if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+            continue;
+        }
+        VkMemoryRequirements requirements{};
+        vkGetBufferMemoryRequirements(device, buffer, &requirements);
+        const uint32_t typeBits = requirements.memoryTypeBits & pointerProps.memoryTypeBits;
+        if (typeBits == 0 || requirements.size > importSize) {
+            vkDestroyBuffer(device, buffer, nullptr);
+            continue;
+        }
+
+        VkImportMemoryHostPointerInfoEXT importInfo{};
+        importInfo.sType        = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT;
+        importInfo.handleType   = handleType;
+        importInfo.pHostPointer = hostPointer;
+
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.pNext           = &importInfo;
+        allocInfo.allocationSize  = importSize;
+        allocInfo.memoryTypeIndex = static_cast<uint32_t>(__builtin_ctz(typeBits));
+
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+            vkDestroyBuffer(device, buffer, nullptr);
+            continue;
+        }
+        VkResult result = vkBindBufferMemory(device, buffer, memory, 0);
+        assert(result == VK_SUCCESS);
+
+        out.buffer = buffer;
+        out.memory = memory;
+        out.offset = offset;
+        return true;
+    }
+    LOGI("ARCameraImage: driver won't import camera plane %p (+%llu bytes), using staging",
+         data, (unsigned long long)size);
+    return false;
+}
+
+void ARCameraImage::ReleaseImports(FrameResources& res) {
+    for (ImportedPlane* plane : {&res.yImport, &res.uvImport}) {
+        if (plane->buffer != VK_NULL_HANDLE) {
+            vkDestroyBuffer(device, plane->buffer, nullptr);
+        }
+        if (plane->memory != VK_NULL_HANDLE) {
+            vkFreeMemory(device, plane->memory, nullptr);
+        }
+        *plane = {};
+    }
+    // Only after the imports are gone may the camera memory be returned.
+    res.importedImage = nullptr;
 }
 
 // ============================================================
@@ -160,11 +926,15 @@ void ARCameraImage::Update(VkCommandBuffer cmd, const ar::CameraFrame& frame) {
 // ============================================================
 
 VkImageView ARCameraImage::GetCurrentYImageView() const {
-    return frameResources.Current().yImageView;
+    return frameResources[currentSlot].yImageView;
 }
 
 VkImageView ARCameraImage::GetCurrentUVImageView() const {
-    return frameResources.Current().uvImageView;
+    return frameResources[currentSlot].uvImageView;
+}
+
+VkImageView ARCameraImage::GetCurrentYcbcrImageView() const {
+    return frameResources[currentSlot].yImageView;
 }
 
 VkImageView ARCameraImage::GetYImageView(uint32_t index) const {
@@ -179,15 +949,49 @@ VkImageView ARCameraImage::GetUVImageView(uint32_t index) const {
 // Resource creation / destruction
 // ============================================================
 
-/// Helper: create one image + view + staging buffer for a given format and size.
-static void CreatePlaneResources(
-        VkDevice device, VmaAllocator allocator,
+/// Helper: host-visible, persistently mapped buffer a plane is memcpy'd into.
+static void CreateStagingBuffer(VkDevice device, VmaAllocator allocator, VkDeviceSize size,
+                                VkBuffer& outStaging, VmaAllocation& outStagingAlloc, void*& outMapped,
+                                const char* debugName, uint32_t slotIndex)
+{
+    // Use VMA_MEMORY_USAGE_AUTO + HOST_ACCESS_SEQUENTIAL_WRITE so VMA
+    // picks device-local host-visible memory on unified-memory mobile GPUs.
+    // Sized with the camera's row stride so planes go in with one memcpy.
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size  = size;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+    VmaAllocationCreateInfo stagingAllocInfo{};
+    stagingAllocInfo.usage = VMA_MEMORY_USAGE_AUTO;
+    stagingAllocInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
+                             VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    VmaAllocationInfo allocInfoOut{};
+    VkResult result = vmaCreateBuffer(allocator, &bufferInfo, &stagingAllocInfo,
+                                      &outStaging, &outStagingAlloc, &allocInfoOut);
+    assert(result == VK_SUCCESS);
+    outMapped = allocInfoOut.pMappedData;
+    assert(outMapped != nullptr);
+    debug::SetBufferName(device, outStaging,
+                         Concatenate(debugName, "Staging[", slotIndex, "]"));
+}
+
+/// Helper: create one image + view (+ staging buffer on the staging path)
+/// for a given format and size. Only the linear image allocation may fail.
+static bool CreatePlaneResources(
+        VkDevice device, VmaAllocator allocator, ARCameraImage::UploadPath path,
         uint32_t w, uint32_t h, VkFormat format,
         VkImage& outImage, VmaAllocation& outImageAlloc, VkImageView& outView,
+        VkDeviceSize stagingSize,
         VkBuffer& outStaging, VmaAllocation& outStagingAlloc, void*& outMapped,
+        VkSubresourceLayout& outLayout,
         const char* debugName, uint32_t slotIndex)
 {
-    // ── GPU image (TRANSFER_DST + SAMPLED) ──
+    using UploadPath = ARCameraImage::UploadPath;
+    const bool linear = path == UploadPath::LinearImage;
+
+    // ── GPU image (SAMPLED + whatever the upload path writes it with) ──
     VkImageCreateInfo imageInfo{};
     imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     imageInfo.imageType     = VK_IMAGE_TYPE_2D;
@@ -196,17 +1000,32 @@ static void CreatePlaneResources(
     imageInfo.mipLevels     = 1;
     imageInfo.arrayLayers   = 1;
     imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
-    imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
-    imageInfo.usage         = VK_IMAGE_USAGE_TRANSFER_DST_BIT |
-                              VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.tiling        = linear ? VK_IMAGE_TILING_LINEAR : VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage         = VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (path == UploadPath::Staging)       imageInfo.usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    if (path == UploadPath::HostImageCopy) imageInfo.usage |= VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT;
     imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
-    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.initialLayout = linear ? VK_IMAGE_LAYOUT_PREINITIALIZED : VK_IMAGE_LAYOUT_UNDEFINED;
 
     VmaAllocationCreateInfo imageAllocInfo{};
-    imageAllocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+    if (linear) {
+        // The CPU writes texels in place: host-visible, persistently mapped
+        imageAllocInfo.usage         = VMA_MEMORY_USAGE_AUTO;
+        imageAllocInfo.flags         = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
+                                       VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        imageAllocInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    } else {
+        imageAllocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+    }
 
+    VmaAllocationInfo imageAllocOut{};
     VkResult result = vmaCreateImage(allocator, &imageInfo, &imageAllocInfo,
-                                     &outImage, &outImageAlloc, nullptr);
+                                     &outImage, &outImageAlloc, &imageAllocOut);
+    if (linear && result != VK_SUCCESS) {
+        outImage = VK_NULL_HANDLE;
+        outImageAlloc = VK_NULL_HANDLE;
+        return false;
+    }
     assert(result == VK_SUCCESS);
     debug::SetImageName(device, outImage,
                         Concatenate(debugName, "Image[", slotIndex, "]"));
@@ -224,97 +1043,290 @@ static void CreatePlaneResources(
     debug::SetImageViewName(device, outView,
                             Concatenate(debugName, "View[", slotIndex, "]"));
 
+    if (linear) {
+        VkImageSubresource subresource{VK_IMAGE_ASPECT_COLOR_BIT, 0, 0};
+        vkGetImageSubresourceLayout(device, outImage, &subresource, &outLayout);
+        outMapped = imageAllocOut.pMappedData;
+        assert(outMapped != nullptr);
+        return true;
+    }
+    if (path != UploadPath::Staging) {
+        return true;
+    }
+
     // ── Staging buffer (host-visible, persistently mapped) ──
-    // Use VMA_MEMORY_USAGE_AUTO + HOST_ACCESS_SEQUENTIAL_WRITE so VMA
-    // picks device-local host-visible memory on unified-memory mobile GPUs.
-    uint32_t bytesPerPixel = (format == VK_FORMAT_R8_UNORM) ? 1 : 2;
-    VkDeviceSize stagingSize = static_cast<VkDeviceSize>(w) * h * bytesPerPixel;
+    CreateStagingBuffer(device, allocator, stagingSize, outStaging, outStagingAlloc, outMapped,
+                        debugName, slotIndex);
+    return true;
+}
 
-    VkBufferCreateInfo bufferInfo{};
-    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    bufferInfo.size  = stagingSize;
-    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+void ARCameraImage::CreateYcbcrImage(FrameResources& res, uint32_t slotIndex) {
+    // One multi-planar image; the two planes are written through PLANE_0/PLANE_1
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType     = VK_IMAGE_TYPE_2D;
+    imageInfo.format        = YCBCR_FORMAT;
+    imageInfo.extent        = {width, height, 1};
+    imageInfo.mipLevels     = 1;
+    imageInfo.arrayLayers   = 1;
+    imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage         = VK_IMAGE_USAGE_SAMPLED_BIT |
+                              (uploadPath == UploadPath::HostImageCopy ? VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT
+                                                                       : VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+    imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
-    VmaAllocationCreateInfo stagingAllocInfo{};
-    stagingAllocInfo.usage = VMA_MEMORY_USAGE_AUTO;
-    stagingAllocInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
-                             VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    VmaAllocationCreateInfo imageAllocInfo{};
+    imageAllocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+    VkResult result = vmaCreateImage(allocator, &imageInfo, &imageAllocInfo,
+                                     &res.yImage, &res.yImageAllocation, nullptr);
+    assert(result == VK_SUCCESS);
+    debug::SetImageName(device, res.yImage, Concatenate("CamYCbCr_Image[", slotIndex, "]"));
 
-    VmaAllocationInfo allocInfoOut{};
-    result = vmaCreateBuffer(allocator, &bufferInfo, &stagingAllocInfo,
-                             &outStaging, &outStagingAlloc, &allocInfoOut);
+    // The view must carry the same conversion as the immutable sampler
+    VkSamplerYcbcrConversionInfo conversionRef{};
+    conversionRef.sType      = VK_STRUCTURE_TYPE_SAMPLER_YCBCR_CONVERSION_INFO;
+    conversionRef.conversion = ycbcrConversion;
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType    = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.pNext    = &conversionRef;
+    viewInfo.image    = res.yImage;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format   = YCBCR_FORMAT;
+    viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    result = vkCreateImageView(device, &viewInfo, nullptr, &res.yImageView);
     assert(result == VK_SUCCESS);
-    outMapped = allocInfoOut.pMappedData;
-    assert(outMapped != nullptr);
-    debug::SetBufferName(device, outStaging,
-                         Concatenate(debugName, "Staging[", slotIndex, "]"));
+    debug::SetImageViewName(device, res.yImageView, Concatenate("CamYCbCr_View[", slotIndex, "]"));
+
+    if (uploadPath == UploadPath::Staging) {
+        CreateStagingBuffer(device, allocator, static_cast<VkDeviceSize>(yRowStride) * height,
+                            res.yStagingBuffer, res.yStagingAllocation, res.yMappedData, "CamY_", slotIndex);
+        CreateStagingBuffer(device, allocator, static_cast<VkDeviceSize>(uvRowStride) * (height / 2),
+                            res.uvStagingBuffer, res.uvStagingAllocation, res.uvMappedData, "CamUV_", slotIndex);
+    }
 }
 
-void ARCameraImage::CreateResources(uint32_t w, uint32_t h) {
+bool ARCameraImage::CanUsePath(UploadPath path, uint32_t w, uint32_t h) const {
+    if (path == UploadPath::Staging) {
+        return true;
+    }
+    // Linear images in particular may have a small max extent
+    const VkImageTiling tiling = path == UploadPath::LinearImage ? VK_IMAGE_TILING_LINEAR
+                                                                 : VK_IMAGE_TILING_OPTIMAL;
+    const VkImageUsageFlags usage = path == UploadPath::HostImageCopy
+            ? VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT
+            : VK_IMAGE_USAGE_SAMPLED_BIT;
+    const std::vector<VkFormat> formats = UsesYcbcr()
+            ? std::vector<VkFormat>{YCBCR_FORMAT}
+            : std::vector<VkFormat>{VK_FORMAT_R8_UNORM, VK_FORMAT_R8G8_UNORM};
+    for (VkFormat format : formats) {
+        VkHostImageCopyDevicePerformanceQueryEXT perfQuery{};
+        perfQuery.sType = VK_STRUCTURE_TYPE_HOST_IMAGE_COPY_DEVICE_PERFORMANCE_QUERY_EXT;
+        VkImageFormatProperties2 props{};
+        props.sType = VK_STRUCTURE_TYPE_IMAGE_FORMAT_PROPERTIES_2;
+        props.pNext = path == UploadPath::HostImageCopy ? &perfQuery : nullptr;
+
+        VkPhysicalDeviceImageFormatInfo2 info{};
+        info.sType  = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_FORMAT_INFO_2;
+        info.format = format;
+        info.type   = VK_IMAGE_TYPE_2D;
+        info.tiling = tiling;
+        info.usage  = usage;
+        if (vkGetPhysicalDeviceImageFormatProperties2(physicalDevice, &info, &props) != VK_SUCCESS ||
+            props.imageFormatProperties.maxExtent.width < w ||
+            props.imageFormatProperties.maxExtent.height < h) {
+            return false;
+        }
+        if (path == UploadPath::HostImageCopy && !perfQuery.optimalDeviceAccess) {
+            // Still a win over a GPU copy on unified memory, but worth knowing
+            LOGI("ARCameraImage: host-transfer images of format %d are not optimal for device access",
+                 format);
+        }
+    }
+    return true;
+}
+
+void ARCameraImage::FallBackToStaging(const char* reason) {
+    LOGE("ARCameraImage: %s upload unavailable (%s), falling back to staging",
+         UploadPathName(uploadPath), reason);
+    uploadPath    = UploadPath::Staging;
+    sampledLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+}
+
+void ARCameraImage::CreateResources(uint32_t w, uint32_t h, uint32_t yStride, uint32_t uvStride) {
     width  = w;
     height = h;
+    yRowStride  = yStride;
+    uvRowStride = uvStride;
+    yImportable  = true;
+    uvImportable = true;
+    // A recreated view may reuse a freed one's handle value
+    resourceGeneration++;
 
     const uint32_t uvW = w / 2;
     const uint32_t uvH = h / 2;
 
+    if (!CanUsePath(uploadPath, w, h)) {
+        FallBackToStaging("resolution or usage not supported");
+    }
+
     for (uint32_t i = 0; i < frameResources.Size(); ++i) {
         auto& res = frameResources[i];
 
-        CreatePlaneResources(device, allocator, w, h, VK_FORMAT_R8_UNORM,
-                             res.yImage, res.yImageAllocation, res.yImageView,
-                             res.yStagingBuffer, res.yStagingAllocation, res.yMappedData,
-                             "CamY_", i);
+        if (UsesYcbcr()) {
+            CreateYcbcrImage(res, i);
+            if (uploadPath == UploadPath::HostImageCopy) {
+                VkHostImageLayoutTransitionInfoEXT transition{};
+                transition.sType            = VK_STRUCTURE_TYPE_HOST_IMAGE_LAYOUT_TRANSITION_INFO_EXT;
+                transition.image            = res.yImage;
+                transition.oldLayout        = VK_IMAGE_LAYOUT_UNDEFINED;
+                transition.newLayout        = sampledLayout;
+                transition.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+                VkResult result = transitionImageLayout(device, 1, &transition);
+                assert(result == VK_SUCCESS);
+            }
+            LOGI("ARCameraImage: frame resources [%u] created (%ux%u G8_B8R8_2PLANE_420, %s)",
+                 i, w, h, UploadPathName(uploadPath));
+            continue;
+        }
 
-        CreatePlaneResources(device, allocator, uvW, uvH, VK_FORMAT_R8G8_UNORM,
-                             res.uvImage, res.uvImageAllocation, res.uvImageView,
-                             res.uvStagingBuffer, res.uvStagingAllocation, res.uvMappedData,
-                             "CamUV_", i);
+        bool created =
+                CreatePlaneResources(device, allocator, uploadPath, w, h, VK_FORMAT_R8_UNORM,
+                                     res.yImage, res.yImageAllocation, res.yImageView,
+                                     static_cast<VkDeviceSize>(yStride) * h,
+                                     res.yStagingBuffer, res.yStagingAllocation, res.yMappedData,
+                                     res.yLayout, "CamY_", i) &&
+                CreatePlaneResources(device, allocator, uploadPath, uvW, uvH, VK_FORMAT_R8G8_UNORM,
+                                     res.uvImage, res.uvImageAllocation, res.uvImageView,
+                                     static_cast<VkDeviceSize>(uvStride) * uvH,
+                                     res.uvStagingBuffer, res.uvStagingAllocation, res.uvMappedData,
+                                     res.uvLayout, "CamUV_", i);
+        if (!created) {
+            // No host-visible memory type takes linear images: start over with staging.
+            // Nothing used the new slots yet; retired ones stay retired.
+            for (uint32_t j = 0; j <= i; ++j) {
+                DestroySlot(frameResources[j]);
+            }
+            FallBackToStaging("no host-visible memory for linear images");
+            CreateResources(w, h, yStride, uvStride);
+            return;
+        }
+        res.yState = {};
+        res.uvState = {};
+        if (uploadPath == UploadPath::LinearImage) {
+            res.yState.layout = res.uvState.layout = VK_IMAGE_LAYOUT_PREINITIALIZED;
+            res.yState.writeStage  = res.uvState.writeStage  = VK_PIPELINE_STAGE_2_HOST_BIT;
+            res.yState.writeAccess = res.uvState.writeAccess = VK_ACCESS_2_HOST_WRITE_BIT;
+        }
 
-        LOGI("ARCameraImage: frame resources [%u] created (Y %ux%u R8, UV %ux%u RG8)",
-             i, w, h, uvW, uvH);
+        if (uploadPath == UploadPath::HostImageCopy) {
+            // Layouts are set on the host too; the images stay in sampledLayout
+            VkHostImageLayoutTransitionInfoEXT transitions[2]{};
+            for (int t = 0; t < 2; ++t) {
+                transitions[t].sType            = VK_STRUCTURE_TYPE_HOST_IMAGE_LAYOUT_TRANSITION_INFO_EXT;
+                transitions[t].oldLayout        = VK_IMAGE_LAYOUT_UNDEFINED;
+                transitions[t].newLayout        = sampledLayout;
+                transitions[t].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+            }
+            transitions[0].image = res.yImage;
+            transitions[1].image = res.uvImage;
+            VkResult result = transitionImageLayout(device, 2, transitions);
+            assert(result == VK_SUCCESS);
+        }
+
+        LOGI("ARCameraImage: frame resources [%u] created (Y %ux%u R8, UV %ux%u RG8, %s)",
+             i, w, h, uvW, uvH, UploadPathName(uploadPath));
     }
 }
 
 void ARCameraImage::DestroyResources() {
+    WaitForBands();
+    pending = {};
     for (uint32_t i = 0; i < frameResources.Size(); ++i) {
-        auto& res = frameResources[i];
+        DestroySlot(frameResources[i]);
+    }
+    for (auto& old : retired) {
+        DestroySlot(old.res);
+    }
+    retired.clear();
 
-        // Y plane
-        if (res.yImageView != VK_NULL_HANDLE) {
-            vkDestroyImageView(device, res.yImageView, nullptr);
-            res.yImageView = VK_NULL_HANDLE;
-        }
-        if (res.yImage != VK_NULL_HANDLE) {
-            vmaDestroyImage(allocator, res.yImage, res.yImageAllocation);
-            res.yImage = VK_NULL_HANDLE;
-            res.yImageAllocation = VK_NULL_HANDLE;
-        }
-        if (res.yStagingBuffer != VK_NULL_HANDLE) {
-            vmaDestroyBuffer(allocator, res.yStagingBuffer, res.yStagingAllocation);
-            res.yStagingBuffer = VK_NULL_HANDLE;
-            res.yStagingAllocation = VK_NULL_HANDLE;
-            res.yMappedData = nullptr;
-        }
+    width  = 0;
+    height = 0;
+    yRowStride  = 0;
+    uvRowStride = 0;
+    valid  = false;
+    uploadedTimestamp = 0;
+    uploadedRegion = {};
+}
 
-        // UV plane
-        if (res.uvImageView != VK_NULL_HANDLE) {
-            vkDestroyImageView(device, res.uvImageView, nullptr);
-            res.uvImageView = VK_NULL_HANDLE;
-        }
-        if (res.uvImage != VK_NULL_HANDLE) {
-            vmaDestroyImage(allocator, res.uvImage, res.uvImageAllocation);
-            res.uvImage = VK_NULL_HANDLE;
-            res.uvImageAllocation = VK_NULL_HANDLE;
-        }
-        if (res.uvStagingBuffer != VK_NULL_HANDLE) {
-            vmaDestroyBuffer(allocator, res.uvStagingBuffer, res.uvStagingAllocation);
-            res.uvStagingBuffer = VK_NULL_HANDLE;
-            res.uvStagingAllocation = VK_NULL_HANDLE;
-            res.uvMappedData = nullptr;
+void ARCameraImage::RetireResources() {
+    WaitForBands();
+    pending = {};
+    for (uint32_t i = 0; i < frameResources.Size(); ++i) {
+        auto& res = frameResources[i];
+        // The current slot is marked sampled this frame; imports are read by the upload frame
+        const uint64_t lastUse = std::max(res.lastSampledFrame, res.uploadFrame);
+        if (lastUse > completedFrame) {
+            retired.push_back({res, lastUse});
+        } else {
+            DestroySlot(res);
         }
+        res = FrameResources{};
     }
+    currentSlotPreviousUse = 0;
+    LOGI("ARCameraImage: %zu slot(s) retired until their frames complete", retired.size());
 
     width  = 0;
     height = 0;
+    yRowStride  = 0;
+    uvRowStride = 0;
     valid  = false;
+    uploadedTimestamp = 0;
+    uploadedRegion = {};
+}
+
+void ARCameraImage::DestroySlot(FrameResources& res) {
+    ReleaseImports(res);
+
+    // Y plane
+    if (res.yImageView != VK_NULL_HANDLE) {
+        vkDestroyImageView(device, res.yImageView, nullptr);
+        res.yImageView = VK_NULL_HANDLE;
+    }
+    if (res.yImage != VK_NULL_HANDLE) {
+        vmaDestroyImage(allocator, res.yImage, res.yImageAllocation);
+        res.yImage = VK_NULL_HANDLE;
+        res.yImageAllocation = VK_NULL_HANDLE;
+        res.yMappedData = nullptr;   // linear images are mapped directly
+    }
+    if (res.yStagingBuffer != VK_NULL_HANDLE) {
+        vmaDestroyBuffer(allocator, res.yStagingBuffer, res.yStagingAllocation);
+        res.yStagingBuffer = VK_NULL_HANDLE;
+        res.yStagingAllocation = VK_NULL_HANDLE;
+        res.yMappedData = nullptr;
+    }
+
+    // UV plane
+    if (res.uvImageView != VK_NULL_HANDLE) {
+        vkDestroyImageView(device, res.uvImageView, nullptr);
+        res.uvImageView = VK_NULL_HANDLE;
+    }
+    if (res.uvImage != VK_NULL_HANDLE) {
+        vmaDestroyImage(allocator, res.uvImage, res.uvImageAllocation);
+        res.uvImage = VK_NULL_HANDLE;
+        res.uvImageAllocation = VK_NULL_HANDLE;
+        res.uvMappedData = nullptr;
+    }
+    res.yState = {};
+    res.uvState = {};
+    if (res.uvStagingBuffer != VK_NULL_HANDLE) {
+        vmaDestroyBuffer(allocator, res.uvStagingBuffer, res.uvStagingAllocation);
+        res.uvStagingBuffer = VK_NULL_HANDLE;
+        res.uvStagingAllocation = VK_NULL_HANDLE;
+        res.uvMappedData = nullptr;
+    }
+    res.uploadFrame      = 0;
+    res.lastSampledFrame = 0;
 }
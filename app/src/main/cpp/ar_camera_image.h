@@ -5,6 +5,12 @@
 #include "vk_mem_alloc.h"
 #include "ring_buffer.h"
 #include "ar_manager.h"
+#include "vk_context.h"
+#include "thread_pool.h"
+#include "barrier_batch.h"
+#include <chrono>
+#include <memory>
+#include <vector>
 
 namespace graphics {
 
@@ -15,50 +21,195 @@ namespace graphics {
      * directly into staging buffers (no CPU-side colour conversion) and then
      * copied to GPU-optimal images.  The fragment shader converts YUV -> RGB.
      *
+     * The upload path is picked once, best first:
+     *  - HostImageCopy (VK_EXT_host_image_copy): the CPU writes the planes
+     *    straight into the optimal-tiled images. No staging, no transfer
+     *    commands, no layout transitions on the command buffer.
+     *  - LinearImage: host-visible linear images the shader samples directly,
+     *    kept in GENERAL; the CPU writes rows into their mapped memory.
+     *  - Staging: the last resort, described below.
+     *
+     * YCbCr mode (picked when the device samples G8_B8R8_2PLANE_420_UNORM
+     * through a VkSamplerYcbcrConversion and the caller allows it): each slot
+     * has one multi-planar image instead of the Y and UV images; the planes
+     * are written to its PLANE_0/PLANE_1 aspects by the host copy or staging
+     * path, and the texture unit does the YUV -> RGB conversion. The sampler
+     * must be baked into the descriptor set layout as an immutable sampler.
+     *
+     * Staging: each plane goes over in one memcpy, row padding included: the staging
+     * buffers use the camera's row strides and the copy's bufferRowLength
+     * skips the padding on the GPU side.
+     *
+     * Chroma always reaches the GPU as NV12 (interleaved Cb,Cr). NV12 camera
+     * frames go up as-is; NV21, I420 and oddly strided ones are converted by
+     * the SIMD kernels in yuv_convert.h straight into the destination memory
+     * (staging buffer, linear image, or a scratch buffer for host copies).
+     *
+     * With VK_EXT_external_memory_host the camera planes are imported as
+     * VkBuffers and copied from directly, skipping the memcpy too. The slot
+     * holds a reference to the ArImage until its fence comes around, so the
+     * camera memory outlives the GPU copy. Planes the driver won't import
+     * (alignment) fall back to the staging path.
+     *
      * Staging buffers use VMA_MEMORY_USAGE_AUTO + HOST_ACCESS_SEQUENTIAL_WRITE
      * so that on mobile unified-memory GPUs VMA places them in device-local,
      * host-visible memory, avoiding an extra DMA copy.
      *
+     * The camera runs at 30 fps while we render at 60-120 Hz, so most frames
+     * bring no new image. Update() compares the frame timestamp with the last
+     * upload's and, if unchanged, does nothing: the shader keeps sampling the
+     * slot that holds it. New images go to the least recently sampled slot
+     * that no in-flight frame can still read, so the ring stays safe even
+     * though slots are no longer used round robin. A new upload size (camera
+     * resolution, or the display region after a rotation) recreates the
+     * slots; the old images are kept until the frames using them complete.
+     *
+     * Only what the screen shows is uploaded: the bounding box of the screen
+     * corners in the camera image (ar::CameraFrame::displayCorners). The
+     * plane pointers are moved to the box's top-left and every upload path
+     * copies the box as if it were the whole image. When the box still has
+     * 4x the display's pixels or more, it is halved first with the 2x2 box
+     * filter kernels. GetDisplayUVs() tells the background shader where the
+     * screen corners land in what was uploaded.
+     *
+     * The CPU side runs on worker threads, in row bands: BeginUpload() is
+     * called as soon as ARCore hands over the image and submits the bands;
+     * the render thread carries on (plane updates, command recording) and
+     * only waits for them in Update(), right before recording the transfer.
+     *
      * Usage:
-     *   cameraImage.AdvanceFrame();
+     *   cameraImage.SetWorkerPool(&pool);
+     *   cameraImage.AdvanceFrame(frame, frameSync.GetCompletedFrame());
+     *   cameraImage.BeginUpload(frame);      // from ARSessionManager's camera frame callback
+     *   ...
      *   cameraImage.Update(cmd, arSessionManager.getCameraFrame());
      *   VkImageView yView  = cameraImage.GetCurrentYImageView();
      *   VkImageView uvView = cameraImage.GetCurrentUVImageView();
      */
     class ARCameraImage {
     public:
-        ARCameraImage(VkDevice device, VmaAllocator allocator);
+        /**
+         * @param allowYcbcr  use YCbCr mode if the device supports it; the caller
+         *                    must then have the YCbCr camera shader available
+         */
+        ARCameraImage(VkDevice device, VkPhysicalDevice physicalDevice, VmaAllocator allocator,
+                      const DeviceCapabilities& capabilities = {},
+                      bool allowYcbcr = false);
         ~ARCameraImage();
 
         ARCameraImage(const ARCameraImage&) = delete;
         ARCameraImage& operator=(const ARCameraImage&) = delete;
 
-        /// Advance to the next ring-buffer slot. Call once per frame, before Update.
-        void AdvanceFrame();
+        /**
+         * Start a new frame. Call once per frame, after FrameSync::BeginFrame
+         * and before Update.
+         * @param frame           FrameSync's number for the frame being recorded
+         * @param completedFrame  last frame the GPU finished: slots sampled up to
+         *                        it can be rewritten, their imports released
+         */
+        void AdvanceFrame(uint64_t frame, uint64_t completedFrame);
+
+        /// How camera planes reach the Y/UV images.
+        enum class UploadPath {
+            HostImageCopy,
+            LinearImage,
+            Staging
+        };
+
+        /**
+         * Start the CPU side of an upload: crop, pick a free slot, and copy
+         * the planes into it in row bands on the worker pool (or right here
+         * without one). A frame whose timestamp matches the last upload is
+         * skipped: no CPU copy, no GPU transfer. The frame's planes must stay
+         * valid until Update(); its ArImage reference keeps them alive.
+         */
+        void BeginUpload(const ar::CameraFrame& frame);
 
         /**
-         * Memcpy Y and UV planes into staging, record barrier + copy commands.
-         * After this call both images are in SHADER_READ_ONLY_OPTIMAL layout.
+         * Wait for the band copies and make the slot current, recording
+         * whatever barrier + copy commands the upload path needs (none for
+         * HostImageCopy). After this call the current images are in
+         * GetSampledLayout(). Begins the upload itself if BeginUpload wasn't
+         * called this frame.
          */
         void Update(VkCommandBuffer cmd, const ar::CameraFrame& frame);
 
+        /**
+         * Drop every reference to camera memory: waits for the GPU and the
+         * band copies, abandons a pending upload and frees the host imports
+         * (and their ArImages) of all slots, retired ones included. The
+         * current images stay valid. ARCore won't pause or resume a session
+         * while its images are open, so call this first.
+         */
+        void ReleaseCameraMemory();
+
+        /// Worker threads for the band copies; nullptr (default) copies on the calling thread.
+        void SetWorkerPool(utils::ThreadPool* pool) { workers = pool; }
+
         VkImageView   GetCurrentYImageView()  const;
         VkImageView   GetCurrentUVImageView() const;
         VkImageView   GetYImageView(uint32_t index)  const;
         VkImageView   GetUVImageView(uint32_t index) const;
+        /// Bumped each time the slot images are recreated: views cached by handle are stale after it.
+        uint64_t      GetResourceGeneration() const { return resourceGeneration; }
         uint32_t      GetWidth()  const { return width; }
         uint32_t      GetHeight() const { return height; }
         bool          IsValid()   const { return valid; }
 
+        UploadPath    GetUploadPath() const { return uploadPath; }
+
+        bool          UsesYcbcr() const { return ycbcrConversion != VK_NULL_HANDLE; }
+        /// Immutable sampler for the descriptor set layout (YCbCr mode).
+        const VkSampler* GetYcbcrSampler() const { return &ycbcrSampler; }
+        /// Descriptors one YCbCr combined image sampler consumes from a pool.
+        uint32_t      GetYcbcrDescriptorCount() const { return ycbcrDescriptorCount; }
+        /// View of the current slot's multi-planar image (YCbCr mode).
+        VkImageView   GetCurrentYcbcrImageView() const;
+        /// Layout the images are in when the shader samples them.
+        VkImageLayout GetSampledLayout() const { return sampledLayout; }
+
+        /// Average render-thread time BeginUpload() + Update() took over the last reporting window.
+        float         GetAverageUploadMs() const { return averageUploadMs; }
+        /// Upload bytes (CPU copy + GPU transfer) skipped per second, for repeated camera frames.
+        float         GetUploadBytesSavedPerSecond() const { return bytesSavedPerSecond; }
+
+        /**
+         * Screen corners as UVs into the current images, x,y pairs in the order
+         * top-left, top-right, bottom-left, bottom-right.
+         */
+        const float*  GetDisplayUVs() const { return frameResources[currentSlot].displayUVs; }
+        /// Upload only the part of the camera image the screen shows (default on).
+        void          SetRegionOfInterest(bool enabled) { regionOfInterest = enabled; }
+        /// Halve oversized regions with a 2x2 box filter before upload (default on).
+        void          SetDownsample(bool enabled) { downsample = enabled; }
+
     private:
+        /// Camera memory imported as a transfer source buffer.
+        struct ImportedPlane {
+            VkBuffer       buffer = VK_NULL_HANDLE;
+            VkDeviceMemory memory = VK_NULL_HANDLE;
+            VkDeviceSize   offset = 0;   // where the plane starts inside buffer
+        };
+
+        /// The part of the camera image that gets uploaded, in camera pixels.
+        struct Region {
+            uint32_t x = 0, y = 0;
+            uint32_t width = 0, height = 0;
+            bool     halve = false;   // 2x2 box filtered to width/2 x height/2
+            float    uvs[8] = {0, 0, 1, 0, 0, 1, 1, 1};   // screen corners, see GetDisplayUVs
+            bool operator==(const Region& other) const;
+        };
+
         struct FrameResources {
-            // Y plane (R8_UNORM, full resolution)
+            // Y plane (R8_UNORM, full resolution).
+            // In YCbCr mode: the multi-planar image holding both planes.
             VkImage        yImage            = VK_NULL_HANDLE;
             VmaAllocation  yImageAllocation  = VK_NULL_HANDLE;
             VkImageView    yImageView        = VK_NULL_HANDLE;
             VkBuffer       yStagingBuffer    = VK_NULL_HANDLE;
             VmaAllocation  yStagingAllocation= VK_NULL_HANDLE;
-            void*          yMappedData       = nullptr;
+            void*          yMappedData       = nullptr;   // staging buffer, or the linear image
+            VkSubresourceLayout yLayout{};                 // linear image row pitch
 
             // UV plane (R8G8_UNORM, half resolution)
             VkImage        uvImage            = VK_NULL_HANDLE;
@@ -67,19 +218,143 @@ namespace graphics {
             VkBuffer       uvStagingBuffer    = VK_NULL_HANDLE;
             VmaAllocation  uvStagingAllocation= VK_NULL_HANDLE;
             void*          uvMappedData       = nullptr;
+            VkSubresourceLayout uvLayout{};
+
+            // GPU-side use of the images, for the upload barriers. Linear images
+            // start PREINITIALIZED with the host as writer, moved to GENERAL once.
+            ResourceState  yState;
+            ResourceState  uvState;
+
+            // Host memory imports for this slot's copy, and the camera image
+            // they point into. Freed once the upload frame's fence has passed.
+            ImportedPlane  yImport;
+            ImportedPlane  uvImport;
+            std::shared_ptr<ArImage> importedImage;
+
+            uint64_t       uploadFrame        = 0;   // frame that wrote the images
+            uint64_t       lastSampledFrame   = 0;   // last frame that read them
+            float          displayUVs[8]      = {0, 0, 1, 0, 0, 1, 1, 1};   // of the region it holds
         };
 
-        VkDevice     device    = VK_NULL_HANDLE;
-        VmaAllocator allocator = VK_NULL_HANDLE;
+        VkDevice         device         = VK_NULL_HANDLE;
+        VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+        VmaAllocator     allocator      = VK_NULL_HANDLE;
+
+        UploadPath    uploadPath    = UploadPath::Staging;
+        VkImageLayout sampledLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        PFN_vkCopyMemoryToImageEXT      copyMemoryToImage      = nullptr;
+        PFN_vkTransitionImageLayoutEXT  transitionImageLayout  = nullptr;
+        BarrierBatch  barriers;   // kept to reuse its storage
+
+        VkSamplerYcbcrConversion ycbcrConversion = VK_NULL_HANDLE;
+        VkSampler                ycbcrSampler    = VK_NULL_HANDLE;
+        uint32_t                 ycbcrDescriptorCount = 1;
 
         uint32_t width  = 0;
         uint32_t height = 0;
+        uint64_t resourceGeneration = 0;
+        uint32_t yRowStride  = 0;   // staging buffers are laid out with these
+        uint32_t uvRowStride = 0;   // the camera's for NV12, the image width once normalized
+        utils::ChromaLayout chromaLayout = utils::ChromaLayout::NV12;
+        std::vector<uint8_t> chromaScratch;   // normalized NV12 for host image copies
         bool     valid  = false;
 
+        // Display-matched upload
+        bool     regionOfInterest = true;
+        bool     downsample       = true;
+        Region   uploadedRegion;
+        std::vector<uint8_t> halvedPlanes;    // Y then NV12 chroma of a halved region
+        std::vector<uint8_t> halveInput;      // non-NV12 chroma normalized before halving
+
+        /// An upload between BeginUpload and Update. The bands only read it.
+        struct PendingUpload {
+            bool            active = false;
+            uint32_t        slot   = 0;
+            Region          region;
+            ar::CameraFrame crop;    // the region, in camera memory
+            ar::CameraFrame frame;   // what gets uploaded: the crop, or its halved planes
+            std::chrono::steady_clock::duration beginTime{};
+        };
+        PendingUpload pending;
+        uint64_t      beganFrame = 0;   // frameNumber of the last BeginUpload
+
+        // Band copies: at most one band per worker, none smaller than MIN_BAND_BYTES
+        static constexpr uint64_t MIN_BAND_BYTES = 256 * 1024;
+        utils::ThreadPool* workers = nullptr;
+        utils::Latch       bandsDone;
+
+        // Slot bookkeeping: frames are numbered from 1, 0 = never
+        uint64_t frameNumber  = 0;
+        uint64_t completedFrame = 0;   // last frame the GPU finished, as of AdvanceFrame
+        uint32_t currentSlot  = 0;   // holds the newest upload; what the shader samples
+        uint64_t currentSlotPreviousUse = 0;   // its lastSampledFrame before this frame
+        int64_t  uploadedTimestamp = 0;
+
+        // Cleared after a plane fails to import; retried when the camera config changes
+        bool yImportable  = true;
+        bool uvImportable = true;
+        VkDeviceSize importAlignment = 0;   // 0 = host import unavailable/disabled
+        PFN_vkGetMemoryHostPointerPropertiesEXT getHostPointerProperties = nullptr;
+
+        // Upload timing, logged every TIMING_WINDOW uploads
+        static constexpr uint32_t TIMING_WINDOW = 120;
+        std::chrono::steady_clock::duration uploadTime{};
+        std::chrono::steady_clock::duration uploadTimeMax{};
+        uint32_t uploadCount = 0;
+        uint32_t importedPlanes = 0;
+        float    averageUploadMs = 0.0f;
+
+        // Skipped re-uploads, reported every SAVINGS_WINDOW
+        static constexpr std::chrono::seconds SAVINGS_WINDOW{2};
+        std::chrono::steady_clock::time_point savingsWindowStart{};
+        uint64_t skippedBytes   = 0;
+        uint32_t skippedUploads = 0;
+        float    bytesSavedPerSecond = 0.0f;
+
         utils::RingBuffer<FrameResources> frameResources{MAX_FRAMES_IN_FLIGHT};
 
-        void CreateResources(uint32_t w, uint32_t h);
+        /// Slots replaced by a resize while frames in flight may still sample or write them
+        struct RetiredResources {
+            FrameResources res;
+            uint64_t       lastUse = 0;   // freed once this frame has completed
+        };
+        std::vector<RetiredResources> retired;
+
+        Region ComputeRegion(const ar::CameraFrame& frame) const;
+        /// The frame cut down to the region, still in camera memory.
+        ar::CameraFrame CropFrame(const ar::CameraFrame& frame, const Region& region) const;
+        /// Sizes halvedPlanes and describes them as a tightly packed NV12 frame.
+        ar::CameraFrame HalvedFrame(const ar::CameraFrame& crop);
+        void CreateResources(uint32_t w, uint32_t h, uint32_t yStride, uint32_t uvStride);
+        /// Frees the slots' resources now. Only when no frame in flight can use them.
         void DestroyResources();
+        /// Moves the slots' resources to `retired`, freed once their last frame has completed.
+        void RetireResources();
+        void DestroySlot(FrameResources& res);
+        bool CanUsePath(UploadPath path, uint32_t w, uint32_t h) const;
+        bool LoadHostImageCopy();
+        bool CreateYcbcrSampler();
+        void CreateYcbcrImage(FrameResources& res, uint32_t slotIndex);
+        /// Where plane 0 (Y) / 1 (UV) is written: its own image, or an aspect of the YCbCr image.
+        VkImage            PlaneImage(const FrameResources& res, uint32_t plane) const;
+        VkImageAspectFlags PlaneAspect(uint32_t plane) const;
+        void FallBackToStaging(const char* reason);
+        void WaitForBands();
+        /// Rows [rowBegin, rowEnd) of the pending frame (even bounds); runs on a worker.
+        void CopyBand(uint32_t rowBegin, uint32_t rowEnd);
+        void HalveBand(uint32_t rowBegin, uint32_t rowEnd);
+        void HostCopyBand(FrameResources& res, uint32_t rowBegin, uint32_t rowEnd);
+        void LinearCopyBand(FrameResources& res, uint32_t rowBegin, uint32_t rowEnd);
+        void StagingCopyBand(FrameResources& res, uint32_t rowBegin, uint32_t rowEnd);
+        void ImportPlanes(FrameResources& res);
+        void RecordLinear(VkCommandBuffer cmd, FrameResources& res);
+        void RecordStaging(VkCommandBuffer cmd, FrameResources& res);
+        bool ImportPlane(const uint8_t* data, VkDeviceSize size, uint32_t texelSize, ImportedPlane& out);
+        void ReleaseImports(FrameResources& res);
+        void RecordTiming(std::chrono::steady_clock::duration elapsed);
+        void RecordSavings(uint64_t bytes);
+        /// Least recently sampled slot no in-flight frame can read, or UINT32_MAX.
+        uint32_t PickWriteSlot() const;
     };
 
 } // namespace graphics
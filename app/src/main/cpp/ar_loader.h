@@ -166,11 +166,12 @@ namespace ar {
         // ── Frame ──
         ArStatus (*ArFrame_create)(const ArSession* session, ArFrame** out_frame) = nullptr;
         void (*ArFrame_destroy)(ArFrame* frame) = nullptr;
-        int64_t (*ArFrame_getTimestamp)(const ArSession* session, const ArFrame* frame) = nullptr;
-        ArStatus (*ArFrame_transformCoordinates2d)(const ArSession* session, const ArFrame* frame,
-                                                   ArCoordinates2dType input_type, int32_t number_of_vertices,
-                                                   const float* vertices_2d, ArCoordinates2dType output_type,
-                                                   float* out_vertices_2d) = nullptr;
+        void (*ArFrame_getTimestamp)(const ArSession* session, const ArFrame* frame,
+                                     int64_t* out_timestamp_ns) = nullptr;
+        void (*ArFrame_transformCoordinates2d)(const ArSession* session, const ArFrame* frame,
+                                               ArCoordinates2dType input_type, int32_t number_of_vertices,
+                                               const float* vertices_2d, ArCoordinates2dType output_type,
+                                               float* out_vertices_2d) = nullptr;
         void (*ArFrame_acquireCamera)(const ArSession* session, const ArFrame* frame,
                                       ArCamera** out_camera) = nullptr;
         ArStatus (*ArFrame_acquireCameraImage)(const ArSession* session, const ArFrame* frame,
@@ -113,6 +113,13 @@ namespace ar {
             return;
         }
 
+        // ── Acquire CPU camera image ──
+        // First thing after the update: the upload it triggers overlaps
+        // with the rest of this function and with command recording.
+        if (acquireCameraFrame() && m_cameraFrameCallback) {
+            m_cameraFrameCallback(m_cameraFrame);
+        }
+
         // Check tracking state
         ArCamera* camera = nullptr;
         m_loader.ArFrame_acquireCamera(m_session, m_frame, &camera);
@@ -143,62 +150,104 @@ namespace ar {
                 AR_TRACKABLE_PLANE,
                 m_planeList
         );
+    }
 
-        // ── Acquire CPU camera image ──
-        status = m_loader.ArFrame_acquireCameraImage(m_session, m_frame, &m_cameraImage);
+    bool ARSessionManager::acquireCameraFrame() {
+        ArImage* acquired = nullptr;
+        const ArStatus status = m_loader.ArFrame_acquireCameraImage(m_session, m_frame, &acquired);
         if (status != AR_SUCCESS) {
-            // This can fail if the frame doesn't have an image yet (e.g. first frames)
+            // This can fail if the frame doesn't have an image yet (e.g. first frames),
+            // or with RESOURCE_EXHAUSTED if consumers still hold too many older images.
             m_cameraFrame = {};
-            return;
+            return false;
         }
+        m_cameraImage = std::shared_ptr<ArImage>(acquired, [](ArImage* image) {
+            ar::ARCoreLoader::getInstance().ArImage_release(image);
+        });
+        m_cameraFrame.image = m_cameraImage;
+        m_loader.ArFrame_getTimestamp(m_session, m_frame, &m_cameraFrame.timestamp);
 
         // Extract image dimensions
-        m_loader.ArImage_getWidth(m_session, m_cameraImage, &m_cameraFrame.width);
-        m_loader.ArImage_getHeight(m_session, m_cameraImage, &m_cameraFrame.height);
+        m_loader.ArImage_getWidth(m_session, m_cameraImage.get(), &m_cameraFrame.width);
+        m_loader.ArImage_getHeight(m_session, m_cameraImage.get(), &m_cameraFrame.height);
 
         // Y plane (index 0)
-        int32_t yLength = 0;
         m_loader.ArImage_getPlaneData(
-                m_session, m_cameraImage,
+                m_session, m_cameraImage.get(),
                 0,  // Y plane
                 &m_cameraFrame.yPlane,
-                &yLength
+                &m_cameraFrame.yLength
         );
         m_loader.ArImage_getPlaneRowStride(
-                m_session, m_cameraImage,
+                m_session, m_cameraImage.get(),
                 0,
                 &m_cameraFrame.yRowStride
         );
 
-        // UV plane (index 2 for NV21 interleaved — ARCore typically gives NV21)
-        // Plane index 1 = U, index 2 = V, but with NV21 the pixel stride is 2
-        // meaning they're interleaved. We grab plane 1 (U) which covers both.
-        int32_t uvLength = 0;
+        // Chroma: plane 1 = U, plane 2 = V. With pixel stride 2 they are one
+        // interleaved plane (NV12 if U comes first, NV21 if V does), with
+        // pixel stride 1 two separate planes (I420). The layout is worked out
+        // from the pointers; ARCameraImage normalizes all of them to NV12.
         m_loader.ArImage_getPlaneData(
-                m_session, m_cameraImage,
-                1,  // U plane (interleaved with V when pixelStride == 2)
+                m_session, m_cameraImage.get(),
+                1,  // U plane
                 &m_cameraFrame.uvPlane,
-                &uvLength
+                &m_cameraFrame.uvLength
         );
         m_loader.ArImage_getPlaneRowStride(
-                m_session, m_cameraImage,
+                m_session, m_cameraImage.get(),
                 1,
                 &m_cameraFrame.uvRowStride
         );
         m_loader.ArImage_getPlanePixelStride(
-                m_session, m_cameraImage,
+                m_session, m_cameraImage.get(),
                 1,
                 &m_cameraFrame.uvPixelStride
         );
+        m_loader.ArImage_getPlaneData(
+                m_session, m_cameraImage.get(),
+                2,  // V plane
+                &m_cameraFrame.vPlane,
+                &m_cameraFrame.vLength
+        );
+        m_loader.ArImage_getPlaneRowStride(
+                m_session, m_cameraImage.get(),
+                2,
+                &m_cameraFrame.vRowStride
+        );
+        const utils::ChromaLayout layout = utils::DetectChromaLayout(
+                m_cameraFrame.uvPlane, m_cameraFrame.vPlane, m_cameraFrame.uvPixelStride);
+        if (!m_chromaLayoutKnown || layout != m_chromaLayout) {
+            LOGI("ARSessionManager: camera chroma layout %s (pixel stride %d)",
+                 utils::ChromaLayoutName(layout), m_cameraFrame.uvPixelStride);
+            m_chromaLayout = layout;
+            m_chromaLayoutKnown = true;
+        }
+        m_cameraFrame.chromaLayout = layout;
+
+        // Visible part of the image: the screen corners (GL NDC, y up) mapped
+        // into CPU image pixels. Follows rotation and aspect-fill cropping.
+        if (m_displayWidth > 0 && m_displayHeight > 0) {
+            const float ndcCorners[8] = {
+                    -1.0f,  1.0f,    1.0f,  1.0f,   // top-left, top-right
+                    -1.0f, -1.0f,    1.0f, -1.0f    // bottom-left, bottom-right
+            };
+            m_loader.ArFrame_transformCoordinates2d(
+                    m_session, m_frame,
+                    AR_COORDINATES_2D_OPENGL_NORMALIZED_DEVICE_COORDINATES, 4, ndcCorners,
+                    AR_COORDINATES_2D_IMAGE_PIXELS, m_cameraFrame.displayCorners);
+            m_cameraFrame.hasDisplayCorners = true;
+            m_cameraFrame.displayWidth = m_displayWidth;
+            m_cameraFrame.displayHeight = m_displayHeight;
+        }
 
         m_cameraFrame.valid = true;
+        return true;
     }
 
     void ARSessionManager::releaseCameraImage() {
-        if (m_cameraImage) {
-            m_loader.ArImage_release(m_cameraImage);
-            m_cameraImage = nullptr;
-        }
+        // Drops our reference; ArImage_release runs once no consumer holds it
+        m_cameraImage = nullptr;
         m_cameraFrame = {};
     }
 
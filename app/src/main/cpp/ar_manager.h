@@ -1,22 +1,47 @@
 #ifndef KRAKATOA_AR_MANAGER_H
 #define KRAKATOA_AR_MANAGER_H
 #include "ar_loader.h"
+#include "yuv_convert.h"
 #include <jni.h>
 #include <functional>
 #include <cstdint>
 #include <vector>
+#include <memory>
 
 namespace ar {
 
     /// Raw YUV camera frame data (CPU-side, no GL_TEXTURE_EXTERNAL_OES)
     struct CameraFrame {
         const uint8_t* yPlane = nullptr;
-        const uint8_t* uvPlane = nullptr;  // interleaved UV (NV21/NV12)
+        const uint8_t* uvPlane = nullptr;  // U plane; the interleaved CbCr plane when NV12
+        const uint8_t* vPlane = nullptr;   // V plane; the interleaved CrCb plane when NV21
         int32_t width = 0;
         int32_t height = 0;
         int32_t yRowStride = 0;
         int32_t uvRowStride = 0;
-        int32_t uvPixelStride = 0;         // 1 = NV21/NV12, 2 = planar
+        int32_t vRowStride = 0;
+        int32_t uvPixelStride = 0;         // 2 = NV21/NV12, 1 = planar (I420)
+        int32_t yLength = 0;               // bytes ARCore reports for each plane
+        int32_t uvLength = 0;
+        int32_t vLength = 0;
+        /// ArFrame timestamp (ns). Unchanged between calls = same camera image.
+        int64_t timestamp = 0;
+        /// How U and V sit in memory; see utils::ConvertChromaToNv12.
+        utils::ChromaLayout chromaLayout = utils::ChromaLayout::NV12;
+        /// Where the screen's top-left, top-right, bottom-left and bottom-right
+        /// corners land in this image, in image pixels (x, y pairs). ARCore
+        /// works them out from the display rotation, the display aspect and
+        /// the camera intrinsics; everything outside is never shown.
+        float displayCorners[8] = {};
+        bool hasDisplayCorners = false;
+        /// Surface size in pixels, as last given to onSurfaceChanged
+        int32_t displayWidth = 0;
+        int32_t displayHeight = 0;
+        /// Owns the ArImage the planes point into. Consumers that read the
+        /// planes after the next onDrawFrame (e.g. a GPU copy straight from the
+        /// camera memory) keep a copy of this; the image is released when the
+        /// last copy goes away.
+        std::shared_ptr<ArImage> image;
         bool valid = false;
     };
 
@@ -56,6 +81,12 @@ namespace ar {
         /// Access the latest camera frame (valid until next onDrawFrame call)
         const CameraFrame& getCameraFrame() const { return m_cameraFrame; }
 
+        /// Called from onDrawFrame the moment a new camera image is acquired,
+        /// before planes and light estimate are read, so its upload can start early.
+        void setCameraFrameCallback(std::function<void(const CameraFrame&)> callback) {
+            m_cameraFrameCallback = std::move(callback);
+        }
+
         /// Access the latest light estimate
         const LightEstimate& getLightEstimate() const { return m_lightData; }
 
@@ -71,6 +102,8 @@ namespace ar {
 
         /// Switch to a different resolution at runtime.
         /// Pauses the session, sets the config, and resumes.
+        /// Consumers must have dropped their CameraFrame::image copies first,
+        /// ArSession_resume fails while old images are still open.
         /// Returns true on success.
         bool setResolution(int32_t index);
 
@@ -88,15 +121,20 @@ namespace ar {
     private:
         void queryAvailableResolutions();
         void releaseCameraImage();
+        /// Fills m_cameraFrame from this frame's CPU image; false if there is none yet.
+        bool acquireCameraFrame();
 
         ar::ARCoreLoader& m_loader = ar::ARCoreLoader::getInstance();
         ArTrackableList* m_planeList = nullptr;
         ArSession* m_session = nullptr;
         ArFrame* m_frame = nullptr;
         ArConfig* m_config = nullptr;
-        ArImage* m_cameraImage = nullptr;   // current frame's CPU image
+        std::shared_ptr<ArImage> m_cameraImage;   // current frame's CPU image
+        utils::ChromaLayout m_chromaLayout = utils::ChromaLayout::NV12;   // last one logged
+        bool m_chromaLayoutKnown = false;
 
         CameraFrame m_cameraFrame{};
+        std::function<void(const CameraFrame&)> m_cameraFrameCallback;
         ArLightEstimate* m_arLightEstimate = nullptr;
         LightEstimate m_lightData{};
 
@@ -0,0 +1,173 @@
+#include "asset_archive.h"
+#include "android_log.h"
+#include <cstring>
+#include <vector>
+
+namespace io {
+    namespace {
+        static_assert(sizeof(AssetArchive::Header) == 64, "archive header must be 64 bytes");
+        static_assert(sizeof(AssetArchive::Entry) == 40, "archive entry must be 40 bytes");
+
+        const uint32_t ARCHIVE_VERSION = 1;
+
+        /// Heap buffer for decompressed entries.
+        struct OwnedBacking : AssetView::Backing {
+            std::vector<uint8_t> bytes;
+        };
+
+        /// offset..offset+size lies within limit, written so crafted values can't wrap
+        bool InBounds(uint64_t offset, uint64_t size, uint64_t limit) {
+            return offset <= limit && size <= limit - offset;
+        }
+    }
+
+    bool AssetArchive::open(AssetView view) {
+        blob = {};
+        if (view.size() < sizeof(Header)) {
+            LOGE("AssetArchive: blob too small");
+            return false;
+        }
+        memcpy(&header, view.data(), sizeof(Header));
+        if (memcmp(header.magic, "KPAK", 4) != 0 || header.version != ARCHIVE_VERSION) {
+            LOGE("AssetArchive: bad magic or version %u", header.version);
+            return false;
+        }
+        if (header.bucketCount == 0 || (header.bucketCount & (header.bucketCount - 1)) != 0 ||
+            !InBounds(header.bucketsOffset, uint64_t(header.bucketCount) * sizeof(uint32_t), view.size()) ||
+            !InBounds(header.entriesOffset, uint64_t(header.entryCount) * sizeof(Entry), view.size()) ||
+            !InBounds(header.namesOffset, header.namesSize, view.size())) {
+            LOGE("AssetArchive: corrupt tables");
+            return false;
+        }
+        blob = std::move(view);
+        LOGI("AssetArchive: %u entries, %zu bytes", header.entryCount, blob.size());
+        return true;
+    }
+
+    bool AssetArchive::lookup(const std::string &path, Entry &entry) const {
+        if (blob.empty()) {
+            return false;
+        }
+        const uint64_t hash = Fnv1a64(path.data(), path.size());
+        const uint32_t mask = header.bucketCount - 1;
+        const uint8_t *buckets = blob.data() + header.bucketsOffset;
+        const uint8_t *entries = blob.data() + header.entriesOffset;
+        const char *names = reinterpret_cast<const char *>(blob.data() + header.namesOffset);
+
+        for (uint32_t probe = 0, slot = hash & mask; probe < header.bucketCount;
+             probe++, slot = (slot + 1) & mask) {
+            uint32_t index;
+            memcpy(&index, buckets + slot * sizeof(uint32_t), sizeof(index));
+            if (index == 0 || index > header.entryCount) {
+                return false;
+            }
+            memcpy(&entry, entries + (index - 1) * sizeof(Entry), sizeof(Entry));
+            if (entry.hash == hash && entry.nameLength == path.size() &&
+                InBounds(entry.nameOffset, entry.nameLength, header.namesSize) &&
+                memcmp(names + entry.nameOffset, path.data(), path.size()) == 0) {
+                return InBounds(entry.offset, entry.storedSize, blob.size());
+            }
+        }
+        return false;
+    }
+
+    bool AssetArchive::contains(const std::string &path) const {
+        Entry entry{};
+        return lookup(path, entry);
+    }
+
+    AssetView AssetArchive::find(const std::string &path) const {
+        Entry entry{};
+        if (!lookup(path, entry)) {
+            return {};
+        }
+        if (entry.compression == COMPRESSION_NONE) {
+            return blob.slice(entry.offset, entry.storedSize);
+        }
+        if (entry.compression != COMPRESSION_LZ4) {
+            LOGE("AssetArchive: %s has unknown compression %u", path.c_str(), entry.compression);
+            return {};
+        }
+        auto backing = std::make_shared<OwnedBacking>();
+        backing->bytes.resize(entry.size);
+        if (!Lz4DecompressBlock(blob.data() + entry.offset, entry.storedSize,
+                                backing->bytes.data(), backing->bytes.size())) {
+            LOGE("AssetArchive: %s failed to decompress", path.c_str());
+            return {};
+        }
+        const uint8_t *data = backing->bytes.data();
+        return AssetView(backing, data, entry.size);
+    }
+
+    uint64_t Fnv1a64(const void *data, size_t size) {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        uint64_t h = 0xCBF29CE484222325ull;
+        for (size_t i = 0; i < size; i++) {
+            h ^= bytes[i];
+            h *= 0x100000001B3ull;
+        }
+        return h;
+    }
+
+    bool Lz4DecompressBlock(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstSize) {
+        const uint8_t *ip = src;
+        const uint8_t *const ipEnd = src + srcSize;
+        uint8_t *op = dst;
+        uint8_t *const opEnd = dst + dstSize;
+
+        auto readLength = [&](size_t length) -> size_t {
+            if (length != 15) {
+                return length;
+            }
+            uint8_t b;
+            do {
+                if (ip >= ipEnd) {
+                    return SIZE_MAX;
+                }
+                b = *ip++;
+                length += b;
+            } while (b == 255);
+            return length;
+        };
+
+        while (ip < ipEnd) {
+            const uint8_t token = *ip++;
+
+            const size_t literals = readLength(token >> 4);
+            if (literals == SIZE_MAX || literals > static_cast<size_t>(ipEnd - ip) ||
+                literals > static_cast<size_t>(opEnd - op)) {
+                return false;
+            }
+            memcpy(op, ip, literals);
+            ip += literals;
+            op += literals;
+            if (ip == ipEnd) {
+                break; // the last sequence has no match
+            }
+
+            if (ipEnd - ip < 2) {
+                return false;
+            }
+            const size_t offset = ip[0] | (ip[1] << 8);
+            ip += 2;
+            if (offset == 0 || offset > static_cast<size_t>(op - dst)) {
+                return false;
+            }
+            size_t matchLength = readLength(token & 15);
+            if (matchLength == SIZE_MAX) {
+                return false;
+            }
+            matchLength += 4;
+            if (matchLength > static_cast<size_t>(opEnd - op)) {
+                return false;
+            }
+            // Byte copy: matches may overlap their own output (offset < length).
+            const uint8_t *match = op - offset;
+            for (size_t i = 0; i < matchLength; i++) {
+                op[i] = match[i];
+            }
+            op += matchLength;
+        }
+        return op == opEnd;
+    }
+}
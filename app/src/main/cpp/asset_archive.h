@@ -0,0 +1,81 @@
+#ifndef KRAKATOA_ASSET_ARCHIVE_H
+#define KRAKATOA_ASSET_ARCHIVE_H
+#include <string>
+#include <cstdint>
+#include "asset_view.h"
+namespace io {
+    /**
+     * Read-only view over a packed asset archive (assets.kpak, written by
+     * pack_assets.py in the repo root).
+     *
+     * The archive is mapped once; a lookup hashes the path (FNV-1a 64) and
+     * probes an open addressing table, so finding an asset costs no syscalls.
+     * Uncompressed entries come back as slices of the mapping (zero copy),
+     * LZ4 entries are decompressed into a buffer owned by the returned view.
+     *
+     * Usage:
+     *   io::AssetArchive archive;
+     *   if (archive.open(io::AssetLoader::openView("assets.kpak"))) {
+     *       io::AssetView spv = archive.find("shaders/compose.vert.spv");
+     *   }
+     */
+    class AssetArchive {
+    public:
+        /// Validates the header and tables. The view keeps the mapping alive.
+        bool open(AssetView blob);
+
+        bool isOpen() const { return !blob.empty(); }
+
+        /// @return the asset's bytes, or an empty view if it's not in the archive
+        AssetView find(const std::string &path) const;
+
+        bool contains(const std::string &path) const;
+
+        uint32_t entryCount() const { return header.entryCount; }
+
+        struct Header {
+            char     magic[4];
+            uint32_t version;
+            uint32_t entryCount;
+            uint32_t bucketCount;
+            uint64_t bucketsOffset;
+            uint64_t entriesOffset;
+            uint64_t namesOffset;
+            uint64_t namesSize;
+            uint8_t  reserved[16];
+        };
+
+        struct Entry {
+            uint64_t hash;
+            uint64_t offset;
+            uint64_t storedSize;
+            uint64_t size;
+            uint32_t nameOffset;
+            uint16_t nameLength;
+            uint8_t  compression;
+            uint8_t  pad;
+        };
+
+        enum Compression : uint8_t {
+            COMPRESSION_NONE = 0,
+            COMPRESSION_LZ4  = 1
+        };
+
+    private:
+        /// Probes the table for path; fills entry and returns true if found.
+        bool lookup(const std::string &path, Entry &entry) const;
+
+        AssetView blob;
+        Header header{};
+    };
+
+    /// FNV-1a 64 of a byte range; the archive's path hash, also handy as a content hash.
+    uint64_t Fnv1a64(const void *data, size_t size);
+
+    /**
+     * Decodes one LZ4 block (no frame header) into dst.
+     * @return false if the block is malformed or doesn't fill dst exactly
+     */
+    bool Lz4DecompressBlock(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstSize);
+}
+#endif //KRAKATOA_ASSET_ARCHIVE_H
@@ -1,8 +1,59 @@
 #include "asset_loader.h"
 #include "android_log.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 namespace  io {
     AAssetManager *AssetLoader::s_assetManager = nullptr;
     std::string AssetLoader::s_externalStoragePath;
+    AssetArchive AssetLoader::s_archive;
+
+    namespace {
+        /// A read-only mmap, either of a whole file or of an asset's range inside the APK.
+        struct MappedBacking : AssetView::Backing {
+            void* base = MAP_FAILED;
+            size_t length = 0;
+            ~MappedBacking() override {
+                if (base != MAP_FAILED) {
+                    munmap(base, length);
+                }
+            }
+        };
+
+        /// A compressed asset: AAsset_getBuffer's memory lives as long as the AAsset.
+        struct AAssetBacking : AssetView::Backing {
+            AAsset* asset = nullptr;
+            ~AAssetBacking() override {
+                if (asset) {
+                    AAsset_close(asset);
+                }
+            }
+        };
+
+        /// Maps [offset, offset + length) of fd. mmap wants a page aligned
+        /// offset, so we map from the page start and point past the slack.
+        AssetView MapRange(int fd, off64_t offset, size_t length) {
+            const off64_t pageSize = sysconf(_SC_PAGESIZE);
+            const off64_t pageStart = offset & ~(pageSize - 1);
+            const size_t slack = static_cast<size_t>(offset - pageStart);
+            auto backing = std::make_shared<MappedBacking>();
+            backing->length = length + slack;
+            backing->base = mmap64(nullptr, backing->length, PROT_READ, MAP_PRIVATE, fd, pageStart);
+            if (backing->base == MAP_FAILED) {
+                return {};
+            }
+            const uint8_t* data = static_cast<const uint8_t*>(backing->base) + slack;
+            return AssetView(backing, data, length);
+        }
+
+        /// Directory listings of the APK, so exists() doesn't open the asset.
+        std::mutex s_listingMutex;
+        std::unordered_map<std::string, std::unordered_set<std::string>> s_listings;
+    }
 
     void AssetLoader::initialize(AAssetManager *assetManager) {
         s_assetManager = assetManager;
@@ -13,63 +64,134 @@ namespace  io {
         return s_assetManager != nullptr;
     }
 
-    std::vector<uint8_t> AssetLoader::loadFile(const std::string &path) {
+    bool AssetLoader::mountArchive(const std::string &path) {
+        if (!s_assetManager) {
+            LOGE("AssetManager not initialized! Call initialize() first.");
+            return false;
+        }
+        return s_archive.open(openApkAsset(path));
+    }
+
+    AssetView AssetLoader::openView(const std::string &path) {
+        if (!s_externalStoragePath.empty()) {
+            AssetView view = openExternal(path);
+            if (view) {
+                return view;
+            }
+        }
+        if (s_archive.isOpen()) {
+            AssetView view = s_archive.find(path);
+            if (view) {
+                return view;
+            }
+        }
         if (!s_assetManager) {
             LOGE("AssetManager not initialized! Call initialize() first.");
             return {};
         }
+        return openApkAsset(path);
+    }
 
-        // Open asset
+    AssetView AssetLoader::openExternal(const std::string &path) {
+        const std::string fullPath = s_externalStoragePath + "/" + path;
+        int fd = open(fullPath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return {};
+        }
+        struct stat st{};
+        AssetView view;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            view = MapRange(fd, 0, static_cast<size_t>(st.st_size));
+        }
+        close(fd); // the mapping keeps the file alive
+        if (view) {
+            LOGI("Mapped file: %s (%zu bytes)", fullPath.c_str(), view.size());
+        }
+        return view;
+    }
+
+    AssetView AssetLoader::openApkAsset(const std::string &path) {
         AAsset *asset = AAssetManager_open(s_assetManager, path.c_str(), AASSET_MODE_BUFFER);
         if (!asset) {
             LOGE("Failed to open asset: %s", path.c_str());
             return {};
         }
-
-        // Get file size
-        off_t size = AAsset_getLength(asset);
+        off64_t size = AAsset_getLength64(asset);
         if (size <= 0) {
-            LOGE("Asset has invalid size: %s (size: %ld)", path.c_str(), size);
+            LOGE("Asset has invalid size: %s (size: %lld)", path.c_str(), (long long)size);
             AAsset_close(asset);
             return {};
         }
 
-        // Read file contents
-        std::vector<uint8_t> buffer(size);
-        int bytesRead = AAsset_read(asset, buffer.data(), size);
-        AAsset_close(asset);
+        // Uncompressed assets: map their range of the APK directly.
+        off64_t start = 0;
+        off64_t length = 0;
+        int fd = AAsset_openFileDescriptor64(asset, &start, &length);
+        if (fd >= 0) {
+            AssetView view = MapRange(fd, start, static_cast<size_t>(length));
+            close(fd);
+            if (view) {
+                AAsset_close(asset);
+                LOGI("Mapped asset: %s (%zu bytes)", path.c_str(), view.size());
+                return view;
+            }
+        }
 
-        if (bytesRead != size) {
-            LOGE("Failed to read full asset: %s (read %d of %ld bytes)", path.c_str(), bytesRead,
-                 size);
+        // Compressed assets: the asset manager inflates into its own buffer.
+        const void* buffer = AAsset_getBuffer(asset);
+        if (!buffer) {
+            LOGE("Failed to read asset: %s", path.c_str());
+            AAsset_close(asset);
             return {};
         }
+        auto backing = std::make_shared<AAssetBacking>();
+        backing->asset = asset;
+        LOGI("Loaded asset: %s (%lld bytes)", path.c_str(), (long long)size);
+        return AssetView(backing, static_cast<const uint8_t*>(buffer), static_cast<size_t>(size));
+    }
 
-        LOGI("Loaded asset: %s (%ld bytes)", path.c_str(), size);
-        return buffer;
+    std::vector<uint8_t> AssetLoader::loadFile(const std::string &path) {
+        AssetView view = openView(path);
+        return std::vector<uint8_t>(view.begin(), view.end());
     }
 
     std::string AssetLoader::loadTextFile(const std::string &path) {
-        std::vector<uint8_t> data = loadFile(path);
-        if (data.empty()) {
-            return "";
-        }
-
-        return std::string(data.begin(), data.end());
+        AssetView view = openView(path);
+        return std::string(view.begin(), view.end());
     }
 
     bool AssetLoader::exists(const std::string &path) {
+        if (!s_externalStoragePath.empty()) {
+            struct stat st{};
+            if (stat((s_externalStoragePath + "/" + path).c_str(), &st) == 0) {
+                return true;
+            }
+        }
+        if (s_archive.contains(path)) {
+            return true;
+        }
         if (!s_assetManager) {
             return false;
         }
 
-        AAsset *asset = AAssetManager_open(s_assetManager, path.c_str(), AASSET_MODE_BUFFER);
-        if (asset) {
-            AAsset_close(asset);
-            return true;
-        }
+        const size_t slash = path.rfind('/');
+        const std::string dir = slash == std::string::npos ? "" : path.substr(0, slash);
+        const std::string file = slash == std::string::npos ? path : path.substr(slash + 1);
 
-        return false;
+        std::lock_guard<std::mutex> lock(s_listingMutex);
+        auto it = s_listings.find(dir);
+        if (it == s_listings.end()) {
+            std::unordered_set<std::string> names;
+            AAssetDir *assetDir = AAssetManager_openDir(s_assetManager, dir.c_str());
+            if (assetDir) {
+                while (const char *name = AAssetDir_getNextFileName(assetDir)) {
+                    names.insert(name);
+                }
+                AAssetDir_close(assetDir);
+            }
+            it = s_listings.emplace(dir, std::move(names)).first;
+        }
+        return it->second.count(file) != 0;
     }
 
     void AssetLoader::setExternalStoragePath(const std::string &path) {
@@ -80,4 +202,4 @@ namespace  io {
     std::string AssetLoader::getExternalStoragePath() {
         return s_externalStoragePath;
     }
-}
\ No newline at end of file
+}
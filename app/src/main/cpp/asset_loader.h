@@ -5,11 +5,19 @@
 #include <vector>
 #include <string>
 #include <cstdint>
+#include "asset_view.h"
+#include "asset_archive.h"
 /**
  * AssetLoader - Load files from Android APK assets using AAssetManager
  *
  * Android apps can't access files directly - assets are packaged in the APK.
  * This class wraps AAssetManager to load shaders, models, etc.
+ *
+ * If an external storage path is set, files found under it take precedence
+ * over the APK (plain filesystem backend, mmap'ed). That lets you push
+ * assets with adb during development without rebuilding the APK.
+ *
+ * Lookup order: external storage, mounted archive, loose APK asset.
  */
 namespace io {
     class AssetLoader {
@@ -26,7 +34,24 @@ namespace io {
         static bool isInitialized();
 
         /**
-         * Load entire file into memory
+         * Map a packed archive (see pack_assets.py) from the APK. Assets in it
+         * are then served from the mapping with a hash lookup instead of one
+         * AAssetManager_open per file. Store it uncompressed in the APK.
+         * @param path Archive path relative to assets/ folder (e.g. "assets.kpak")
+         * @return true if the archive was mapped and is valid
+         */
+        static bool mountArchive(const std::string &path);
+
+        /**
+         * Map an asset read-only, without copying it. Prefer this over loadFile
+         * when the consumer can parse in place.
+         * @param path Path relative to assets/ folder (e.g. "shaders/hello.vert.spv")
+         * @return A view of the contents, or an empty view if failed
+         */
+        static AssetView openView(const std::string &path);
+
+        /**
+         * Load entire file into memory (a copy of openView's bytes)
          * @param path Path relative to assets/ folder (e.g. "shaders/hello.vert.spv")
          * @return File contents, or empty vector if failed
          */
@@ -47,8 +72,8 @@ namespace io {
         static bool exists(const std::string &path);
 
         /**
-         * Set external storage path for DICOM data
-         * Used for loading data from external storage instead of APK assets
+         * Set external storage path
+         * Files under it override APK assets with the same relative path
          * @param path Absolute path to external storage directory
          */
         static void setExternalStoragePath(const std::string &path);
@@ -60,7 +85,11 @@ namespace io {
         static std::string getExternalStoragePath();
 
     private:
+        static AssetView openExternal(const std::string &path);
+        static AssetView openApkAsset(const std::string &path);
+
         static AAssetManager *s_assetManager;
+        static AssetArchive s_archive;
         static std::string s_externalStoragePath;
     };
 
@@ -0,0 +1,52 @@
+#ifndef KRAKATOA_ASSET_VIEW_H
+#define KRAKATOA_ASSET_VIEW_H
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+namespace io {
+    /**
+     * Read-only view of an asset's bytes, without copying them.
+     *
+     * The bytes live in whatever backs the asset: an mmap of the APK region
+     * (uncompressed assets), the buffer AAsset_getBuffer hands out (compressed
+     * assets), an mmap of a plain file (filesystem backend) or, as a last
+     * resort, a heap buffer. The backing is reference counted, so copies of the
+     * view are cheap and the bytes stay valid until the last copy goes away.
+     *
+     * Usage:
+     *   io::AssetView spv = io::AssetLoader::openView("shaders/foo.vert.spv");
+     *   if (spv) {
+     *       Parse(spv.data(), spv.size());
+     *   }
+     */
+    class AssetView {
+    public:
+        /// Owns the memory the view points into. Released with the last view.
+        struct Backing {
+            virtual ~Backing() = default;
+        };
+
+        AssetView() = default;
+        AssetView(std::shared_ptr<const Backing> backing, const uint8_t* data, size_t size)
+                : backing(std::move(backing)), ptr(data), length(size) {}
+
+        const uint8_t* data() const { return ptr; }
+        size_t size() const { return length; }
+        bool empty() const { return length == 0; }
+        explicit operator bool() const { return length != 0; }
+
+        const uint8_t* begin() const { return ptr; }
+        const uint8_t* end() const { return ptr + length; }
+
+        /// A view of [offset, offset + size) sharing this view's backing.
+        AssetView slice(size_t offset, size_t size) const {
+            return AssetView(backing, ptr + offset, size);
+        }
+
+    private:
+        std::shared_ptr<const Backing> backing;
+        const uint8_t* ptr = nullptr;
+        size_t length = 0;
+    };
+}
+#endif //KRAKATOA_ASSET_VIEW_H
@@ -0,0 +1,280 @@
+#include "barrier_batch.h"
+#include "android_log.h"
+#include <cassert>
+using namespace graphics;
+
+static PFN_vkCmdPipelineBarrier2 pfnCmdPipelineBarrier2 = nullptr;
+
+void BarrierBatch::Initialize(VkDevice device, bool synchronization2) {
+    pfnCmdPipelineBarrier2 = nullptr;
+    if (synchronization2) {
+        // Core name on 1.3, extension name on older devices with VK_KHR_synchronization2
+        pfnCmdPipelineBarrier2 = reinterpret_cast<PFN_vkCmdPipelineBarrier2>(
+                vkGetDeviceProcAddr(device, "vkCmdPipelineBarrier2"));
+        if (pfnCmdPipelineBarrier2 == nullptr) {
+            pfnCmdPipelineBarrier2 = reinterpret_cast<PFN_vkCmdPipelineBarrier2>(
+                    vkGetDeviceProcAddr(device, "vkCmdPipelineBarrier2KHR"));
+        }
+    }
+    if (pfnCmdPipelineBarrier2) {
+        LOGI("BarrierBatch: using vkCmdPipelineBarrier2");
+    } else {
+        LOGW("BarrierBatch: synchronization2 not available, merging into vkCmdPipelineBarrier");
+    }
+}
+
+bool BarrierBatch::UsesSynchronization2() {
+    return pfnCmdPipelineBarrier2 != nullptr;
+}
+
+// ============================================================
+// State → barrier
+// ============================================================
+
+/// Fills the synchronization part of a barrier for the next use and updates `state`.
+/// Returns false when the use needs no barrier at all.
+template<typename Barrier>
+static bool Transition(Barrier& barrier, ResourceState& state,
+                       VkPipelineStageFlags2 stage, VkAccessFlags2 access, bool layoutChange) {
+    const VkAccessFlags2 writes = access & BarrierBatch::WRITE_ACCESS;
+    if (writes == VK_ACCESS_2_NONE && !layoutChange) {
+        // Read: the last write must be visible to this stage/access
+        const bool covered = (stage & ~state.readStages) == 0 && (access & ~state.readAccess) == 0;
+        const bool nothingWritten = state.writeStage == VK_PIPELINE_STAGE_2_NONE;
+        state.readStages |= stage;
+        state.readAccess |= access;
+        if (covered || nothingWritten) {
+            return false;
+        }
+        barrier.srcStageMask  = state.writeStage;
+        barrier.srcAccessMask = state.writeAccess;
+        barrier.dstStageMask  = stage;
+        barrier.dstAccessMask = access;
+        return true;
+    }
+    // Write or layout transition: wait for the last write and every read since
+    barrier.srcStageMask  = state.writeStage | state.readStages;
+    barrier.srcAccessMask = state.writeAccess;
+    barrier.dstStageMask  = stage;
+    barrier.dstAccessMask = access;
+    // A transition for readers is visible to them from here on: later readers chain off it
+    state.writeStage  = stage;
+    state.writeAccess = writes;
+    state.readStages  = writes == VK_ACCESS_2_NONE ? stage : VK_PIPELINE_STAGE_2_NONE;
+    state.readAccess  = writes == VK_ACCESS_2_NONE ? access : VK_ACCESS_2_NONE;
+    return true;
+}
+
+static VkImageMemoryBarrier2 MakeImageBarrier(VkImage image, const VkImageSubresourceRange& range) {
+    VkImageMemoryBarrier2 barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = range;
+    return barrier;
+}
+
+static VkBufferMemoryBarrier2 MakeBufferBarrier(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size) {
+    VkBufferMemoryBarrier2 barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = buffer;
+    barrier.offset = offset;
+    barrier.size = size;
+    return barrier;
+}
+
+#ifndef NDEBUG
+template<typename Barrier, typename Handle>
+static bool Contains(const std::vector<Barrier>& barriers, Handle handle, Handle Barrier::*member) {
+    for (const Barrier& b : barriers) {
+        if (b.*member == handle) return true;
+    }
+    return false;
+}
+#endif
+
+void BarrierBatch::UseImage(VkImage image, const VkImageSubresourceRange& range, ResourceState& state,
+                            VkPipelineStageFlags2 stage, VkAccessFlags2 access, VkImageLayout layout,
+                            bool discard) {
+    assert(!Contains(imageBarriers, image, &VkImageMemoryBarrier2::image) && "image used twice in one batch");
+    VkImageMemoryBarrier2 barrier = MakeImageBarrier(image, range);
+    barrier.oldLayout = discard ? VK_IMAGE_LAYOUT_UNDEFINED : state.layout;
+    barrier.newLayout = layout;
+    if (Transition(barrier, state, stage, access, discard || state.layout != layout)) {
+        imageBarriers.push_back(barrier);
+    }
+    state.layout = layout;
+}
+
+void BarrierBatch::UseBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, ResourceState& state,
+                             VkPipelineStageFlags2 stage, VkAccessFlags2 access) {
+    assert(!Contains(bufferBarriers, buffer, &VkBufferMemoryBarrier2::buffer) && "buffer used twice in one batch");
+    VkBufferMemoryBarrier2 barrier = MakeBufferBarrier(buffer, offset, size);
+    if (Transition(barrier, state, stage, access, false)) {
+        bufferBarriers.push_back(barrier);
+    }
+}
+
+// ============================================================
+// Queue family ownership transfers
+// ============================================================
+
+void BarrierBatch::ReleaseImage(VkImage image, const VkImageSubresourceRange& range, ResourceState& state,
+                                uint32_t srcFamily, uint32_t dstFamily, VkImageLayout layout) {
+    VkImageMemoryBarrier2 barrier = MakeImageBarrier(image, range);
+    barrier.srcStageMask  = state.writeStage | state.readStages;
+    barrier.srcAccessMask = state.writeAccess;
+    // dst scope is ignored in a release: the semaphore orders the acquire
+    barrier.srcQueueFamilyIndex = srcFamily;
+    barrier.dstQueueFamilyIndex = dstFamily;
+    barrier.oldLayout = state.layout;
+    barrier.newLayout = layout;
+    imageBarriers.push_back(barrier);
+    // The acquire repeats the same transition
+    state = {};
+    state.releasedLayout = barrier.oldLayout;
+    state.layout = layout;
+}
+
+void BarrierBatch::ReleaseBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, ResourceState& state,
+                                 uint32_t srcFamily, uint32_t dstFamily) {
+    VkBufferMemoryBarrier2 barrier = MakeBufferBarrier(buffer, offset, size);
+    barrier.srcStageMask  = state.writeStage | state.readStages;
+    barrier.srcAccessMask = state.writeAccess;
+    barrier.srcQueueFamilyIndex = srcFamily;
+    barrier.dstQueueFamilyIndex = dstFamily;
+    bufferBarriers.push_back(barrier);
+    state = {};
+}
+
+void BarrierBatch::AcquireImage(VkImage image, const VkImageSubresourceRange& range, ResourceState& state,
+                                uint32_t srcFamily, uint32_t dstFamily,
+                                VkPipelineStageFlags2 stage, VkAccessFlags2 access) {
+    VkImageMemoryBarrier2 barrier = MakeImageBarrier(image, range);
+    // src scope is ignored in an acquire
+    barrier.dstStageMask  = stage;
+    barrier.dstAccessMask = access;
+    barrier.srcQueueFamilyIndex = srcFamily;
+    barrier.dstQueueFamilyIndex = dstFamily;
+    barrier.oldLayout = state.releasedLayout;
+    barrier.newLayout = state.layout;
+    imageBarriers.push_back(barrier);
+    state.releasedLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    state.writeStage  = stage;
+    state.writeAccess = access & WRITE_ACCESS;
+    state.readStages  = stage;
+    state.readAccess  = access & ~WRITE_ACCESS;
+}
+
+void BarrierBatch::AcquireBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, ResourceState& state,
+                                 uint32_t srcFamily, uint32_t dstFamily,
+                                 VkPipelineStageFlags2 stage, VkAccessFlags2 access) {
+    VkBufferMemoryBarrier2 barrier = MakeBufferBarrier(buffer, offset, size);
+    barrier.dstStageMask  = stage;
+    barrier.dstAccessMask = access;
+    barrier.srcQueueFamilyIndex = srcFamily;
+    barrier.dstQueueFamilyIndex = dstFamily;
+    bufferBarriers.push_back(barrier);
+    state.writeStage  = stage;
+    state.writeAccess = access & WRITE_ACCESS;
+    state.readStages  = stage;
+    state.readAccess  = access & ~WRITE_ACCESS;
+}
+
+// ============================================================
+// Flush
+// ============================================================
+
+void BarrierBatch::Flush(VkCommandBuffer cmd) {
+    if (Empty()) {
+        return;
+    }
+    if (pfnCmdPipelineBarrier2 == nullptr) {
+        FlushLegacy(cmd);
+    } else {
+        VkDependencyInfo dependency{};
+        dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        dependency.bufferMemoryBarrierCount = static_cast<uint32_t>(bufferBarriers.size());
+        dependency.pBufferMemoryBarriers = bufferBarriers.data();
+        dependency.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size());
+        dependency.pImageMemoryBarriers = imageBarriers.data();
+        pfnCmdPipelineBarrier2(cmd, &dependency);
+    }
+    imageBarriers.clear();
+    bufferBarriers.clear();
+}
+
+// The synchronization2-only bits fold into the 1.0 bits that cover them
+VkPipelineStageFlags BarrierBatch::LegacyStages(VkPipelineStageFlags2 stages) {
+    auto legacy = static_cast<VkPipelineStageFlags>(stages & 0x1FFFFull);   // same values in both enums
+    if (stages & (VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT |
+                  VK_PIPELINE_STAGE_2_RESOLVE_BIT | VK_PIPELINE_STAGE_2_CLEAR_BIT)) {
+        legacy |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+    }
+    if (stages & (VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT | VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT)) {
+        legacy |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+    }
+    if (stages & VK_PIPELINE_STAGE_2_PRE_RASTERIZATION_SHADERS_BIT) {
+        legacy |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+    }
+    return legacy;
+}
+
+VkAccessFlags BarrierBatch::LegacyAccess(VkAccessFlags2 access) {
+    auto legacy = static_cast<VkAccessFlags>(access & 0x1FFFFull);
+    if (access & (VK_ACCESS_2_SHADER_SAMPLED_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT)) {
+        legacy |= VK_ACCESS_SHADER_READ_BIT;
+    }
+    if (access & VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT) {
+        legacy |= VK_ACCESS_SHADER_WRITE_BIT;
+    }
+    return legacy;
+}
+
+void BarrierBatch::FlushLegacy(VkCommandBuffer cmd) {
+    VkPipelineStageFlags srcStages = 0;
+    VkPipelineStageFlags dstStages = 0;
+
+    std::vector<VkImageMemoryBarrier> images(imageBarriers.size());
+    for (size_t i = 0; i < imageBarriers.size(); ++i) {
+        const VkImageMemoryBarrier2& b = imageBarriers[i];
+        VkImageMemoryBarrier& legacy = images[i];
+        legacy.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        legacy.srcAccessMask = LegacyAccess(b.srcAccessMask);
+        legacy.dstAccessMask = LegacyAccess(b.dstAccessMask);
+        legacy.oldLayout = b.oldLayout;
+        legacy.newLayout = b.newLayout;
+        legacy.srcQueueFamilyIndex = b.srcQueueFamilyIndex;
+        legacy.dstQueueFamilyIndex = b.dstQueueFamilyIndex;
+        legacy.image = b.image;
+        legacy.subresourceRange = b.subresourceRange;
+        srcStages |= LegacyStages(b.srcStageMask);
+        dstStages |= LegacyStages(b.dstStageMask);
+    }
+    std::vector<VkBufferMemoryBarrier> buffers(bufferBarriers.size());
+    for (size_t i = 0; i < bufferBarriers.size(); ++i) {
+        const VkBufferMemoryBarrier2& b = bufferBarriers[i];
+        VkBufferMemoryBarrier& legacy = buffers[i];
+        legacy.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        legacy.srcAccessMask = LegacyAccess(b.srcAccessMask);
+        legacy.dstAccessMask = LegacyAccess(b.dstAccessMask);
+        legacy.srcQueueFamilyIndex = b.srcQueueFamilyIndex;
+        legacy.dstQueueFamilyIndex = b.dstQueueFamilyIndex;
+        legacy.buffer = b.buffer;
+        legacy.offset = b.offset;
+        legacy.size = b.size;
+        srcStages |= LegacyStages(b.srcStageMask);
+        dstStages |= LegacyStages(b.dstStageMask);
+    }
+    // NONE has no 1.0 spelling: the empty scopes are TOP (src) and BOTTOM (dst)
+    vkCmdPipelineBarrier(cmd,
+                         srcStages != 0 ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         dstStages != 0 ? dstStages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                         0,
+                         0, nullptr,
+                         static_cast<uint32_t>(buffers.size()), buffers.data(),
+                         static_cast<uint32_t>(images.size()), images.data());
+}
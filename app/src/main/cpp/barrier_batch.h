@@ -0,0 +1,114 @@
+#ifndef KRAKATOA_BARRIER_BATCH_H
+#define KRAKATOA_BARRIER_BATCH_H
+#include <vulkan/vulkan.h>
+#include <vector>
+namespace graphics {
+
+    /**
+     * Last known use of an image or buffer, in synchronization2 terms. Lives
+     * with the resource (next to its VkImage/VkBuffer) and is updated by
+     * BarrierBatch every time a use is declared.
+     *
+     * `write*` is the last write (or layout transition) and `read*` the reads
+     * it was made visible to since: the next write waits for all of them, a
+     * read in a stage not listed yet needs a barrier from the write.
+     * A default state means "never used, contents undefined".
+     */
+    struct ResourceState {
+        VkPipelineStageFlags2 writeStage  = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2        writeAccess = VK_ACCESS_2_NONE;
+        VkPipelineStageFlags2 readStages  = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2        readAccess  = VK_ACCESS_2_NONE;
+        VkImageLayout         layout = VK_IMAGE_LAYOUT_UNDEFINED;           // images only
+        VkImageLayout         releasedLayout = VK_IMAGE_LAYOUT_UNDEFINED;   // between release and acquire
+    };
+
+    /**
+     * Collects the barriers of one sync point and emits them with a single
+     * vkCmdPipelineBarrier2.
+     *
+     * Each Use*() call names the next access to a resource; the batch works
+     * out the minimal barrier from its ResourceState: none for a read the last
+     * write is already visible to, the writer's stage/access as source for a
+     * new reader, and the writer plus every reader since for a write or a
+     * layout transition.
+     * Stages are per barrier, so a transfer→fragment and a host→compute
+     * transition in the same batch don't widen each other.
+     *
+     * Without synchronization2 (Vulkan 1.1/1.2 drivers lacking
+     * VK_KHR_synchronization2) Flush() falls back to one vkCmdPipelineBarrier
+     * with the stages merged and the 2-only bits mapped to their legacy
+     * equivalents.
+     *
+     * A resource may appear once per batch: two uses need a Flush() between them.
+     *
+     * Usage:
+     *   BarrierBatch barriers;
+     *   barriers.UseImage(image, range, imageState, VK_PIPELINE_STAGE_2_COPY_BIT,
+     *                     VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+     *                     true);   // old contents not needed
+     *   barriers.Flush(cmd);
+     *   vkCmdCopyBufferToImage(cmd, ...);
+     *   barriers.UseImage(image, range, imageState, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+     *                     VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+     *   barriers.Flush(cmd);
+     */
+    class BarrierBatch {
+    public:
+        /// Load vkCmdPipelineBarrier2. Call once after vkCreateDevice.
+        static void Initialize(VkDevice device, bool synchronization2);
+        static bool UsesSynchronization2();
+
+        /// Access bits that write memory
+        static constexpr VkAccessFlags2 WRITE_ACCESS =
+                VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT |
+                VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_HOST_WRITE_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+        /**
+         * Next use of an image: `stage`/`access` in `layout`.
+         * @param discard  previous contents aren't needed (transition from UNDEFINED)
+         */
+        void UseImage(VkImage image, const VkImageSubresourceRange& range, ResourceState& state,
+                      VkPipelineStageFlags2 stage, VkAccessFlags2 access, VkImageLayout layout,
+                      bool discard = false);
+
+        /// Next use of a buffer range.
+        void UseBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, ResourceState& state,
+                       VkPipelineStageFlags2 stage, VkAccessFlags2 access);
+
+        /**
+         * Queue family ownership transfer, release half (on the source queue).
+         * The layout changes to `layout` as part of the transfer; `state` then
+         * describes the resource as the acquire will find it.
+         */
+        void ReleaseImage(VkImage image, const VkImageSubresourceRange& range, ResourceState& state,
+                          uint32_t srcFamily, uint32_t dstFamily, VkImageLayout layout);
+        void ReleaseBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, ResourceState& state,
+                           uint32_t srcFamily, uint32_t dstFamily);
+
+        /// Acquire half, on the destination queue: same families and layout as the release.
+        void AcquireImage(VkImage image, const VkImageSubresourceRange& range, ResourceState& state,
+                          uint32_t srcFamily, uint32_t dstFamily,
+                          VkPipelineStageFlags2 stage, VkAccessFlags2 access);
+        void AcquireBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, ResourceState& state,
+                           uint32_t srcFamily, uint32_t dstFamily,
+                           VkPipelineStageFlags2 stage, VkAccessFlags2 access);
+
+        /// 1.0 equivalents of synchronization2 masks, for the non-2 submit and barrier paths
+        static VkPipelineStageFlags LegacyStages(VkPipelineStageFlags2 stages);
+        static VkAccessFlags LegacyAccess(VkAccessFlags2 access);
+
+        bool Empty() const { return imageBarriers.empty() && bufferBarriers.empty(); }
+
+        /// Record every pending barrier in one call, then start a new batch. No-op when empty.
+        void Flush(VkCommandBuffer cmd);
+
+    private:
+        std::vector<VkImageMemoryBarrier2>  imageBarriers;
+        std::vector<VkBufferMemoryBarrier2> bufferBarriers;
+
+        void FlushLegacy(VkCommandBuffer cmd);
+    };
+}
+#endif //KRAKATOA_BARRIER_BATCH_H
@@ -0,0 +1,24 @@
+// Host stand-in for the NDK's <android/log.h>, so the benches can link code
+// that logs (thread_pool.cpp). Messages go to stderr.
+#ifndef KRAKATOA_BENCH_ANDROID_LOG_H
+#define KRAKATOA_BENCH_ANDROID_LOG_H
+#include <cstdarg>
+#include <cstdio>
+
+enum {
+    ANDROID_LOG_DEBUG = 3,
+    ANDROID_LOG_INFO  = 4,
+    ANDROID_LOG_WARN  = 5,
+    ANDROID_LOG_ERROR = 6
+};
+
+inline int __android_log_print(int priority, const char* tag, const char* format, ...) {
+    std::fprintf(stderr, "%d %s: ", priority, tag);
+    va_list args;
+    va_start(args, format);
+    const int written = std::vfprintf(stderr, format, args);
+    va_end(args);
+    std::fputc('\n', stderr);
+    return written;
+}
+#endif //KRAKATOA_BENCH_ANDROID_LOG_H
@@ -0,0 +1,110 @@
+// Cost of building the camera Y pyramid (luma_pyramid.h) from 720p to 4K.
+// Every kernel set is first checked level by level against the scalar
+// reference, then timed building all four levels (1/2 .. 1/16).
+//
+// Usage: pyramid_bench
+#include "luma_pyramid.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+using namespace utils;
+
+namespace {
+    struct Resolution {
+        const char* name;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    const char* FilterName(PyramidFilter filter) {
+        return filter == PyramidFilter::Box ? "box" : "binomial";
+    }
+
+    bool SameLevels(const LumaPyramid& a, const LumaPyramid& b) {
+        if (a.LevelCount() != b.LevelCount()) {
+            return false;
+        }
+        for (uint32_t i = 0; i < a.LevelCount(); ++i) {
+            const PlaneView& la = a.Level(i);
+            const PlaneView& lb = b.Level(i);
+            for (uint32_t row = 0; row < la.height; ++row) {
+                if (std::memcmp(la.Row(row), lb.Row(row), la.width) != 0) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+int main() {
+    const Resolution resolutions[] = {
+            {"720p",  1280,  720},
+            {"1080p", 1920, 1080},
+            {"1440p", 2560, 1440},
+            {"4K",    3840, 2160},
+    };
+    const int iterations = 100;
+    std::mt19937 rng(99);
+    bool ok = true;
+
+    std::printf("%-6s %-9s %-8s %10s %10s\n", "frame", "filter", "kernels", "ms", "MPix/s");
+    for (const Resolution& res : resolutions) {
+        // Camera-like padded rows
+        const size_t stride = res.width + 64;
+        std::vector<uint8_t> y(stride * res.height);
+        for (auto& v : y) {
+            v = static_cast<uint8_t>(rng());
+        }
+
+        for (PyramidFilter filter : {PyramidFilter::Box, PyramidFilter::Binomial}) {
+            LumaPyramidBuilder reference(LumaPyramidBuilder::MAX_LEVELS, filter, ScalarYuvKernels());
+            const auto expected = reference.Build(y.data(), stride, res.width, res.height, 1);
+
+            for (const YuvRowKernels* kernels : AvailableYuvKernels()) {
+                LumaPyramidBuilder builder(LumaPyramidBuilder::MAX_LEVELS, filter, *kernels);
+                if (!SameLevels(*builder.Build(y.data(), stride, res.width, res.height, 1), *expected)) {
+                    std::printf("%-6s %-9s %-8s MISMATCH against scalar\n", res.name, FilterName(filter), kernels->name);
+                    ok = false;
+                    continue;
+                }
+                const auto start = std::chrono::steady_clock::now();
+                for (int i = 0; i < iterations; ++i) {
+                    builder.Build(y.data(), stride, res.width, res.height, i);
+                }
+                const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                const double seconds = elapsed.count() / iterations;
+                std::printf("%-6s %-9s %-8s %10.3f %10.1f\n", res.name, FilterName(filter), kernels->name,
+                            seconds * 1e3, static_cast<double>(res.width) * res.height / seconds / 1e6);
+                // Nothing outside holds the old pyramids: the pool reuses them
+                if (builder.PoolSize() > 2) {
+                    std::printf("%-6s %-9s %-8s pool grew to %u\n", res.name, FilterName(filter), kernels->name,
+                                builder.PoolSize());
+                    ok = false;
+                }
+            }
+        }
+    }
+
+    // Odd sizes exercise the edge taps and every kernel's scalar tail
+    for (uint32_t size = 2; size < 70; size += 3) {
+        std::vector<uint8_t> y(static_cast<size_t>(size) * (size + 1));
+        for (auto& v : y) {
+            v = static_cast<uint8_t>(rng());
+        }
+        for (PyramidFilter filter : {PyramidFilter::Box, PyramidFilter::Binomial}) {
+            LumaPyramidBuilder reference(LumaPyramidBuilder::MAX_LEVELS, filter, ScalarYuvKernels());
+            const auto expected = reference.Build(y.data(), size, size, size + 1, 0);
+            for (const YuvRowKernels* kernels : AvailableYuvKernels()) {
+                LumaPyramidBuilder builder(LumaPyramidBuilder::MAX_LEVELS, filter, *kernels);
+                if (!SameLevels(*builder.Build(y.data(), size, size, size + 1, 0), *expected)) {
+                    std::printf("%ux%u %s %s: MISMATCH\n", size, size + 1, FilterName(filter), kernels->name);
+                    ok = false;
+                }
+            }
+        }
+    }
+    return ok ? 0 : 1;
+}
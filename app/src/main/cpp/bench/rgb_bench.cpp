@@ -0,0 +1,265 @@
+// YUV -> RGB conversion for CPU consumers (yuv_rgb.h). Checks, in order:
+//  - the scalar kernels against a double-precision BT.601/BT.709 reference (off by at most 1),
+//  - every kernel set against scalar, byte for byte, over every layout, format,
+//    matrix, range, downscale and rotation on an awkwardly sized frame,
+//  - banded multithreaded output against single-threaded output,
+// then times the common cases on a full frame.
+//
+// Usage: rgb_bench [width height]   (default 3840 2160)
+#include "thread_pool.h"
+#include "yuv_rgb.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+using namespace utils;
+
+namespace {
+    /// A camera-like frame: padded Y rows and chroma in the given layout.
+    struct Frame {
+        std::vector<uint8_t> luma;
+        std::vector<uint8_t> chroma;
+        YuvImage image;
+    };
+
+    Frame MakeFrame(ChromaLayout layout, uint32_t width, uint32_t height, std::mt19937& rng) {
+        const uint32_t cw = (width + 1) / 2;
+        const uint32_t ch = (height + 1) / 2;
+        Frame f;
+        f.image.width = width;
+        f.image.height = height;
+        f.image.yRowStride = static_cast<int32_t>(width + 40);
+        f.luma.resize(static_cast<size_t>(f.image.yRowStride) * height);
+        f.image.y = f.luma.data();
+        ChromaPlanes& planes = f.image.chroma;
+        if (layout == ChromaLayout::I420) {
+            const int32_t stride = static_cast<int32_t>(cw + 13);
+            f.chroma.resize(static_cast<size_t>(stride) * ch * 2);
+            planes.u = f.chroma.data();
+            planes.v = f.chroma.data() + static_cast<size_t>(stride) * ch;
+            planes.uRowStride = planes.vRowStride = stride;
+            planes.pixelStride = 1;
+        } else {
+            const int32_t stride = static_cast<int32_t>(cw * 2 + 24);
+            f.chroma.resize(static_cast<size_t>(stride) * ch + 1);
+            planes.u = layout == ChromaLayout::NV12 ? f.chroma.data() : f.chroma.data() + 1;
+            planes.v = layout == ChromaLayout::NV12 ? f.chroma.data() + 1 : f.chroma.data();
+            planes.uRowStride = planes.vRowStride = stride;
+            planes.pixelStride = 2;
+        }
+        planes.layout = layout;
+        for (auto& v : f.luma) {
+            v = static_cast<uint8_t>(rng());
+        }
+        for (auto& v : f.chroma) {
+            v = static_cast<uint8_t>(rng());
+        }
+        return f;
+    }
+
+    std::vector<uint8_t> Convert(const Frame& f, const RgbConvertOptions& options, ThreadPool* pool,
+                                 const YuvRowKernels& kernels, size_t& stride) {
+        uint32_t w, h;
+        RgbOutputSize(f.image.width, f.image.height, options, w, h);
+        stride = static_cast<size_t>(w) * BytesPerPixel(options.format) + 8;   // padded on purpose
+        std::vector<uint8_t> out(stride * h, 0);
+        ConvertYuvToRgb(out.data(), stride, f.image, options, pool, kernels);
+        return out;
+    }
+
+    /// Worst channel error of a full-size conversion against the textbook formulas in doubles.
+    int ReferenceError(const Frame& f, const RgbConvertOptions& options) {
+        size_t stride;
+        const std::vector<uint8_t> out = Convert(f, options, nullptr, ScalarYuvKernels(), stride);
+        const double kr = options.matrix == YuvMatrix::BT601 ? 0.299 : 0.2126;
+        const double kb = options.matrix == YuvMatrix::BT601 ? 0.114 : 0.0722;
+        const double kg = 1.0 - kr - kb;
+        const bool full = options.range == YuvRange::Full;
+        const ChromaPlanes& c = f.image.chroma;
+        int worst = 0;
+        for (uint32_t y = 0; y < f.image.height; ++y) {
+            for (uint32_t x = 0; x < f.image.width; ++x) {
+                const size_t ci = static_cast<size_t>(x / 2) * c.pixelStride;
+                double luma = f.luma[static_cast<size_t>(y) * f.image.yRowStride + x];
+                double cb = c.u[static_cast<size_t>(y / 2) * c.uRowStride + ci] - 128.0;
+                double cr = c.v[static_cast<size_t>(y / 2) * c.vRowStride + ci] - 128.0;
+                if (!full) {
+                    luma = (luma - 16.0) * 255.0 / 219.0;
+                    cb *= 255.0 / 224.0;
+                    cr *= 255.0 / 224.0;
+                }
+                const double rgb[3] = {luma + 2.0 * (1.0 - kr) * cr,
+                                       luma - 2.0 * kb * (1.0 - kb) / kg * cb - 2.0 * kr * (1.0 - kr) / kg * cr,
+                                       luma + 2.0 * (1.0 - kb) * cb};
+                const uint8_t* px = out.data() + y * stride + x * 4;
+                for (int ch = 0; ch < 3; ++ch) {
+                    const int expected = static_cast<int>(std::lround(std::clamp(rgb[ch], 0.0, 255.0)));
+                    worst = std::max(worst, std::abs(expected - px[ch]));
+                }
+            }
+        }
+        return worst;
+    }
+
+    double BenchSeconds(const std::function<void()>& fn, int iterations) {
+        fn();
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            fn();
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / iterations;
+    }
+
+    const char* FormatName(RgbFormat format) {
+        switch (format) {
+            case RgbFormat::RGBA8: return "RGBA8";
+            case RgbFormat::BGRA8: return "BGRA8";
+            case RgbFormat::RGB8:  return "RGB8";
+        }
+        return "?";
+    }
+
+    const char* RotationName(ImageRotation rotation) {
+        switch (rotation) {
+            case ImageRotation::None:  return "0";
+            case ImageRotation::Cw90:  return "90";
+            case ImageRotation::Cw180: return "180";
+            case ImageRotation::Cw270: return "270";
+        }
+        return "?";
+    }
+}
+
+int main(int argc, char** argv) {
+    uint32_t width  = 3840;
+    uint32_t height = 2160;
+    if (argc == 3) {
+        width  = static_cast<uint32_t>(std::atoi(argv[1])) & ~1u;
+        height = static_cast<uint32_t>(std::atoi(argv[2])) & ~1u;
+    }
+    std::mt19937 rng(4242);
+    ThreadPool pool(ThreadPool::DefaultThreadCount(), "rgb-bench");
+    bool ok = true;
+
+    // Fixed-point coefficients against the exact formulas
+    {
+        const Frame f = MakeFrame(ChromaLayout::NV12, 256, 64, rng);
+        for (YuvMatrix matrix : {YuvMatrix::BT601, YuvMatrix::BT709}) {
+            for (YuvRange range : {YuvRange::Full, YuvRange::Limited}) {
+                RgbConvertOptions options;
+                options.matrix = matrix;
+                options.range = range;
+                const int error = ReferenceError(f, options);
+                if (error > 1) {
+                    std::printf("%s %s: off by %d from the double-precision reference\n",
+                                matrix == YuvMatrix::BT601 ? "BT.601" : "BT.709",
+                                range == YuvRange::Full ? "full" : "limited", error);
+                    ok = false;
+                }
+            }
+        }
+    }
+
+    // Every option against scalar, on a size that leaves a tail for every vector width
+    for (ChromaLayout layout : {ChromaLayout::NV12, ChromaLayout::NV21, ChromaLayout::I420}) {
+        const Frame f = MakeFrame(layout, 246, 78, rng);
+        for (RgbFormat format : {RgbFormat::RGBA8, RgbFormat::BGRA8, RgbFormat::RGB8}) {
+            for (YuvMatrix matrix : {YuvMatrix::BT601, YuvMatrix::BT709}) {
+                for (YuvRange range : {YuvRange::Full, YuvRange::Limited}) {
+                    for (uint32_t downscale : {1u, 2u, 4u, 8u}) {
+                        for (ImageRotation rotation : {ImageRotation::None, ImageRotation::Cw90,
+                                                       ImageRotation::Cw180, ImageRotation::Cw270}) {
+                            const RgbConvertOptions options{format, matrix, range, downscale, rotation};
+                            size_t stride;
+                            const std::vector<uint8_t> ref = Convert(f, options, nullptr, ScalarYuvKernels(), stride);
+                            for (const YuvRowKernels* kernels : AvailableYuvKernels()) {
+                                if (Convert(f, options, &pool, *kernels, stride) != ref) {
+                                    std::printf("%s %s %s /%u rot %s: MISMATCH against scalar\n",
+                                                ChromaLayoutName(layout), FormatName(format), kernels->name,
+                                                downscale, RotationName(rotation));
+                                    ok = false;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Rotations against each other: rotating by 90 then reading back must give the unrotated pixel
+    {
+        const Frame f = MakeFrame(ChromaLayout::NV12, 64, 32, rng);
+        RgbConvertOptions options;
+        size_t plainStride, rotatedStride;
+        const std::vector<uint8_t> plain = Convert(f, options, nullptr, BestYuvKernels(), plainStride);
+        options.rotation = ImageRotation::Cw90;
+        const std::vector<uint8_t> rotated = Convert(f, options, nullptr, BestYuvKernels(), rotatedStride);
+        for (uint32_t y = 0; y < 32; ++y) {
+            for (uint32_t x = 0; x < 64; ++x) {
+                // (x, y) -> (h - 1 - y, x)
+                if (std::memcmp(plain.data() + y * plainStride + x * 4,
+                                rotated.data() + x * rotatedStride + (31 - y) * 4, 4) != 0) {
+                    std::printf("Cw90 moved pixel (%u, %u) to the wrong place\n", x, y);
+                    ok = false;
+                    y = 32;
+                    break;
+                }
+            }
+        }
+    }
+
+    std::printf("%ux%u -> RGB, %u worker threads (+ the caller)\n", width, height, pool.Size());
+    std::printf("%-6s %-6s %-4s %-4s %-8s %10s %10s %10s\n",
+                "layout", "format", "down", "rot", "kernels", "1 thr ms", "pool ms", "MPix/s");
+    struct Case {
+        ChromaLayout layout;
+        RgbFormat format;
+        uint32_t downscale;
+        ImageRotation rotation;
+    };
+    const Case cases[] = {
+            {ChromaLayout::NV12, RgbFormat::RGBA8, 1, ImageRotation::None},
+            {ChromaLayout::NV21, RgbFormat::RGBA8, 1, ImageRotation::None},
+            {ChromaLayout::I420, RgbFormat::RGBA8, 1, ImageRotation::None},
+            {ChromaLayout::NV21, RgbFormat::RGB8,  1, ImageRotation::None},
+            {ChromaLayout::NV21, RgbFormat::RGBA8, 1, ImageRotation::Cw90},
+            {ChromaLayout::NV21, RgbFormat::RGBA8, 2, ImageRotation::None},
+            {ChromaLayout::NV21, RgbFormat::RGB8,  4, ImageRotation::Cw90},
+            {ChromaLayout::NV21, RgbFormat::RGBA8, 8, ImageRotation::None},
+    };
+    const int iterations = 20;
+    for (const Case& c : cases) {
+        const Frame f = MakeFrame(c.layout, width, height, rng);
+        RgbConvertOptions options;
+        options.format = c.format;
+        options.downscale = c.downscale;
+        options.rotation = c.rotation;
+        size_t stride;
+        const std::vector<uint8_t> single = Convert(f, options, nullptr, BestYuvKernels(), stride);
+        if (Convert(f, options, &pool, BestYuvKernels(), stride) != single) {
+            std::printf("%s: banded output differs from single-threaded\n", ChromaLayoutName(c.layout));
+            ok = false;
+        }
+        std::vector<uint8_t> out(single.size());
+        for (const YuvRowKernels* kernels : AvailableYuvKernels()) {
+            const double one = BenchSeconds([&] {
+                ConvertYuvToRgb(out.data(), stride, f.image, options, nullptr, *kernels);
+            }, iterations);
+            const double many = BenchSeconds([&] {
+                ConvertYuvToRgb(out.data(), stride, f.image, options, &pool, *kernels);
+            }, iterations);
+            std::printf("%-6s %-6s %-4u %-4s %-8s %10.3f %10.3f %10.1f\n",
+                        ChromaLayoutName(c.layout), FormatName(c.format), c.downscale, RotationName(c.rotation),
+                        kernels->name, one * 1e3, many * 1e3,
+                        static_cast<double>(width) * height / many / 1e6);
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,197 @@
+// Throughput of the camera chroma normalization and 2x downsample kernels
+// (yuv_convert.h). Every kernel is first checked byte for byte against the
+// scalar reference, then timed on a full frame with padded source strides.
+//
+// Usage: yuv_bench [width height]   (default 1920 1080)
+#include "yuv_convert.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+using namespace utils;
+
+namespace {
+    /// A camera-like chroma source: planes with padded rows, in the given layout.
+    struct Source {
+        std::vector<uint8_t> memory;
+        ChromaPlanes planes;
+    };
+
+    Source MakeSource(ChromaLayout layout, uint32_t cw, uint32_t ch, std::mt19937& rng) {
+        // Odd padding on purpose: strides are rarely a multiple of the vector width
+        const int32_t interleavedStride = static_cast<int32_t>(cw * 2 + 36);
+        const int32_t planarStride      = static_cast<int32_t>(cw + 19);
+        Source s;
+        switch (layout) {
+            case ChromaLayout::NV12:
+            case ChromaLayout::NV21: {
+                s.memory.resize(static_cast<size_t>(interleavedStride) * ch);
+                const uint8_t* base = s.memory.data();
+                s.planes.u = layout == ChromaLayout::NV12 ? base : base + 1;
+                s.planes.v = layout == ChromaLayout::NV12 ? base + 1 : base;
+                s.planes.uRowStride = s.planes.vRowStride = interleavedStride;
+                s.planes.pixelStride = 2;
+                break;
+            }
+            case ChromaLayout::I420:
+                s.memory.resize(static_cast<size_t>(planarStride) * ch * 2);
+                s.planes.u = s.memory.data();
+                s.planes.v = s.memory.data() + static_cast<size_t>(planarStride) * ch;
+                s.planes.uRowStride = s.planes.vRowStride = planarStride;
+                s.planes.pixelStride = 1;
+                break;
+            case ChromaLayout::Strided: {
+                // Pixel stride 4: e.g. a camera that pads chroma to 32-bit samples
+                const int32_t stride = static_cast<int32_t>(cw * 4 + 8);
+                s.memory.resize(static_cast<size_t>(stride) * ch);
+                s.planes.u = s.memory.data();
+                s.planes.v = s.memory.data() + 2;
+                s.planes.uRowStride = s.planes.vRowStride = stride;
+                s.planes.pixelStride = 4;
+                break;
+            }
+        }
+        s.planes.layout = layout;
+        for (auto& b : s.memory) {
+            b = static_cast<uint8_t>(rng());
+        }
+        return s;
+    }
+
+    double BenchSeconds(const std::function<void()>& fn, int iterations) {
+        fn(); // warm caches and page in the destination
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            fn();
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / iterations;
+    }
+}
+
+int main(int argc, char** argv) {
+    uint32_t width  = 1920;
+    uint32_t height = 1080;
+    if (argc == 3) {
+        width  = static_cast<uint32_t>(std::atoi(argv[1])) & ~1u;
+        height = static_cast<uint32_t>(std::atoi(argv[2])) & ~1u;
+    }
+    const uint32_t cw = width / 2;
+    const uint32_t ch = height / 2;
+    const size_t dstStride = static_cast<size_t>(cw) * 2;
+    const int iterations = 200;
+
+    std::mt19937 rng(1234);
+    std::vector<uint8_t> reference(dstStride * ch);
+    std::vector<uint8_t> dst(dstStride * ch);
+
+    std::printf("chroma of %ux%u -> NV12 (%zu bytes out), %d iterations\n",
+                width, height, dst.size(), iterations);
+    std::printf("%-8s %-8s %10s %10s\n", "layout", "kernels", "ms", "GB/s out");
+
+    bool ok = true;
+    for (ChromaLayout layout : {ChromaLayout::NV12, ChromaLayout::NV21,
+                                ChromaLayout::I420, ChromaLayout::Strided}) {
+        const Source src = MakeSource(layout, cw, ch, rng);
+        ConvertChromaToNv12(reference.data(), dstStride, src.planes, cw, ch, ScalarYuvKernels());
+
+        for (const YuvRowKernels* kernels : AvailableYuvKernels()) {
+            if (layout == ChromaLayout::Strided && kernels != &ScalarYuvKernels()) {
+                continue;   // gathered sample by sample whatever the kernels
+            }
+            std::fill(dst.begin(), dst.end(), 0);
+            ConvertChromaToNv12(dst.data(), dstStride, src.planes, cw, ch, *kernels);
+            if (dst != reference) {
+                std::printf("%-8s %-8s MISMATCH against scalar\n", ChromaLayoutName(layout), kernels->name);
+                ok = false;
+                continue;
+            }
+            const double seconds = BenchSeconds([&] {
+                ConvertChromaToNv12(dst.data(), dstStride, src.planes, cw, ch, *kernels);
+            }, iterations);
+            std::printf("%-8s %-8s %10.3f %10.2f\n", ChromaLayoutName(layout), kernels->name,
+                        seconds * 1e3, static_cast<double>(dst.size()) / seconds / 1e9);
+        }
+    }
+
+    // 2x box downsample of a full frame, as the display-matched upload does it
+    {
+        const uint32_t srcStride = width + 24;
+        std::vector<uint8_t> luma(static_cast<size_t>(srcStride) * height);
+        for (auto& v : luma) {
+            v = static_cast<uint8_t>(rng());
+        }
+        const uint32_t dw = width / 2;
+        const uint32_t dh = height / 2;
+        std::vector<uint8_t> ref(static_cast<size_t>(dw) * dh), out(ref.size());
+        std::printf("\n2x box filter of %ux%u (luma plane, then NV12 chroma)\n", width, height);
+        std::printf("%-8s %-8s %10s %10s\n", "plane", "kernels", "ms", "GB/s in");
+        for (bool chroma : {false, true}) {
+            // Chroma rows hold width bytes of CbCr pairs, half as many rows
+            const uint32_t pw = chroma ? dw / 2 : dw;
+            const uint32_t ph = chroma ? dh / 2 : dh;
+            auto run = [&](std::vector<uint8_t>& dst, const YuvRowKernels& k) {
+                if (chroma) {
+                    Downsample2xChroma(dst.data(), dw, luma.data(), srcStride, pw, ph, k);
+                } else {
+                    Downsample2xLuma(dst.data(), dw, luma.data(), srcStride, pw, ph, k);
+                }
+            };
+            std::fill(ref.begin(), ref.end(), 0);
+            run(ref, ScalarYuvKernels());
+            for (const YuvRowKernels* kernels : AvailableYuvKernels()) {
+                std::fill(out.begin(), out.end(), 0);
+                run(out, *kernels);
+                const char* plane = chroma ? "chroma" : "luma";
+                if (out != ref) {
+                    std::printf("%-8s %-8s MISMATCH against scalar\n", plane, kernels->name);
+                    ok = false;
+                    continue;
+                }
+                const double seconds = BenchSeconds([&] { run(out, *kernels); }, iterations);
+                const double bytesIn = static_cast<double>(width) * (chroma ? height / 2 : height);
+                std::printf("%-8s %-8s %10.3f %10.2f\n", plane, kernels->name,
+                            seconds * 1e3, bytesIn / seconds / 1e9);
+            }
+        }
+        for (uint32_t tail = 1; tail < 40; ++tail) {
+            std::vector<uint8_t> small(static_cast<size_t>(tail) * 4 * 4);
+            for (auto& v : small) {
+                v = static_cast<uint8_t>(rng());
+            }
+            // Luma: 2 rows of 2 * tail bytes, then chroma: 2 rows of tail pairs
+            std::vector<uint8_t> sref(tail * 2 * 2 * 2), sout(sref.size());
+            Downsample2xLuma(sref.data(), tail * 2, small.data(), tail * 4, tail * 2, 2, ScalarYuvKernels());
+            Downsample2xChroma(sref.data() + tail * 4, tail * 2, small.data(), tail * 4, tail, 2, ScalarYuvKernels());
+            for (const YuvRowKernels* kernels : AvailableYuvKernels()) {
+                Downsample2xLuma(sout.data(), tail * 2, small.data(), tail * 4, tail * 2, 2, *kernels);
+                Downsample2xChroma(sout.data() + tail * 4, tail * 2, small.data(), tail * 4, tail, 2, *kernels);
+                if (sout != sref) {
+                    std::printf("downsample %s: tail of %u MISMATCH\n", kernels->name, tail);
+                    ok = false;
+                }
+            }
+        }
+    }
+
+    // Odd widths exercise every kernel's scalar tail
+    for (uint32_t tail = 1; tail < 40; ++tail) {
+        for (ChromaLayout layout : {ChromaLayout::NV21, ChromaLayout::I420}) {
+            const Source src = MakeSource(layout, tail, 3, rng);
+            std::vector<uint8_t> ref(tail * 2 * 3), out(tail * 2 * 3);
+            ConvertChromaToNv12(ref.data(), tail * 2, src.planes, tail, 3, ScalarYuvKernels());
+            for (const YuvRowKernels* kernels : AvailableYuvKernels()) {
+                ConvertChromaToNv12(out.data(), tail * 2, src.planes, tail, 3, *kernels);
+                if (out != ref) {
+                    std::printf("%s %s: tail of %u samples MISMATCH\n",
+                                ChromaLayoutName(layout), kernels->name, tail);
+                    ok = false;
+                }
+            }
+        }
+    }
+    return ok ? 0 : 1;
+}
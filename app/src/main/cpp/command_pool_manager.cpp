@@ -1,5 +1,7 @@
 #include "command_pool_manager.h"
+#include "barrier_batch.h"
 #include "android_log.h"
+#include "concatenate.h"
 #include <cassert>
 #include <set>
 using namespace graphics;
@@ -16,7 +18,8 @@ CommandPoolManager::CommandPoolManager(VkDevice device,
           graphicsFamilyIndex(queueFamilies.graphicsFamily.value()),
           computeFamilyIndex(queueFamilies.computeFamily.value()),
           transferFamilyIndex(queueFamilies.transferFamily.value()),
-          frameCommandBuffers(MAX_FRAMES_IN_FLIGHT) {
+          frameCommandBuffers(MAX_FRAMES_IN_FLIGHT),
+          recordingPools(MAX_FRAMES_IN_FLIGHT) {
 
     // Graphics pool: RESET_COMMAND_BUFFER because frame buffers are reused
     graphicsPool = CreatePool(graphicsFamilyIndex,
@@ -33,11 +36,12 @@ CommandPoolManager::CommandPoolManager(VkDevice device,
         LOGI("Compute shares graphics command pool (family %u)", computeFamilyIndex);
     }
 
-    // Transfer pool: TRANSIENT for short-lived one-shot buffers
+    // Transfer pool: TRANSIENT for short-lived one-shot buffers, reset and reused
     if (transferFamilyIndex != graphicsFamilyIndex &&
         transferFamilyIndex != computeFamilyIndex) {
         transferPool = CreatePool(transferFamilyIndex,
-                                  VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+                                  VK_COMMAND_POOL_CREATE_TRANSIENT_BIT |
+                                  VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
         LOGI("Transfer command pool created (family %u)", transferFamilyIndex);
     } else if (transferFamilyIndex == computeFamilyIndex && computePool != graphicsPool) {
         transferPool = computePool;
@@ -48,12 +52,18 @@ CommandPoolManager::CommandPoolManager(VkDevice device,
     }
 
     AllocateFrameCommandBuffers();
+    CreateOneShotQueues();
 
     LOGI("CommandPoolManager created (%u frame cmd buffers, dedicated transfer: %s)",
          MAX_FRAMES_IN_FLIGHT, HasDedicatedTransfer() ? "YES" : "NO");
 }
 
 CommandPoolManager::~CommandPoolManager() {
+    // Pending callbacks typically free staging memory: let them run
+    for (size_t i = 0; i < oneShotQueues.size(); ++i) {
+        Wait({static_cast<QueueType>(i), oneShotQueues[i].lastSubmitted});
+    }
+
     std::set<VkCommandPool> uniquePools;
     if (graphicsPool != VK_NULL_HANDLE) uniquePools.insert(graphicsPool);
     if (computePool != VK_NULL_HANDLE) uniquePools.insert(computePool);
@@ -62,6 +72,11 @@ CommandPoolManager::~CommandPoolManager() {
     for (auto pool : uniquePools) {
         vkDestroyCommandPool(device, pool, nullptr);
     }
+    for (uint32_t f = 0; f < recordingPools.Size(); f++) {
+        for (auto& recording : recordingPools[f]) {
+            vkDestroyCommandPool(device, recording.pool, nullptr);
+        }
+    }
 
     LOGI("CommandPoolManager destroyed");
 }
@@ -101,12 +116,41 @@ void CommandPoolManager::AllocateFrameCommandBuffers() {
     LOGI("Allocated %u frame command buffers", frameCommandBuffers.Size());
 }
 
+void CommandPoolManager::CreateOneShotQueues() {
+    static const char* names[] = {"Graphics", "Compute", "Transfer"};
+    for (size_t i = 0; i < oneShotQueues.size(); ++i) {
+        oneShotQueues[i].timeline = std::make_unique<TimelineSemaphore>(
+                device, Concatenate(names[i], "OneShotTimeline"));
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = GetPool(static_cast<QueueType>(i));
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = INITIAL_ONE_SHOT_SLOTS;
+
+        std::vector<VkCommandBuffer> buffers(INITIAL_ONE_SHOT_SLOTS);
+        VkResult result = vkAllocateCommandBuffers(device, &allocInfo, buffers.data());
+        assert(result == VK_SUCCESS);
+        for (VkCommandBuffer cmd : buffers) {
+            oneShotQueues[i].slots.push_back({cmd, 0});
+        }
+    }
+}
+
 // ============================================================
 // Frame command buffers
 // ============================================================
 
 void CommandPoolManager::AdvanceFrame() {
     frameCommandBuffers.Next();
+    // This slot's last frame is done (FrameSync::BeginFrame waited for it)
+    for (auto& recording : recordingPools.Next()) {
+        if (recording.used > 0) {
+            vkResetCommandPool(device, recording.pool, 0);
+            recording.used = 0;
+        }
+    }
+    CollectCompletedOneShots();
 }
 
 VkCommandBuffer CommandPoolManager::GetCurrentCommandBuffer() const {
@@ -132,23 +176,87 @@ void CommandPoolManager::EndFrame() {
 }
 
 // ============================================================
-// One-shot commands
+// Secondary command buffers (multithreaded recording)
 // ============================================================
 
-void CommandPoolManager::SubmitOneShot(QueueType queueType,
-                                       const std::function<void(VkCommandBuffer)>& recordFunc) {
-    VkCommandPool pool = GetPool(queueType);
-    VkQueue queue = GetQueue(queueType);
+void CommandPoolManager::CreateRecordingPools(uint32_t count) {
+    assert(recordingPools.Current().empty() && "recording pools already created");
+    for (uint32_t f = 0; f < recordingPools.Size(); f++) {
+        recordingPools[f].resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            // TRANSIENT: re-recorded every frame; reset as a whole, not per buffer
+            recordingPools[f][i].pool = CreatePool(graphicsFamilyIndex,
+                                                   VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+        }
+    }
+    LOGI("Created %u recording command pools per frame in flight", count);
+}
 
+VkCommandBuffer CommandPoolManager::BeginSecondary(uint32_t poolIndex,
+                                                   const VkCommandBufferInheritanceInfo& inheritance) {
+    assert(poolIndex < recordingPools.Current().size());
+    RecordingPool& recording = recordingPools.Current()[poolIndex];
+    if (recording.used == recording.secondaries.size()) {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = recording.pool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer cmd;
+        VkResult result = vkAllocateCommandBuffers(device, &allocInfo, &cmd);
+        assert(result == VK_SUCCESS);
+        recording.secondaries.push_back(cmd);
+    }
+    VkCommandBuffer cmd = recording.secondaries[recording.used++];
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                      VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritance;
+
+    VkResult result = vkBeginCommandBuffer(cmd, &beginInfo);
+    assert(result == VK_SUCCESS);
+    return cmd;
+}
+
+// ============================================================
+// One-shot commands
+// ============================================================
+
+uint32_t CommandPoolManager::AcquireOneShotSlot(QueueType type) {
+    OneShotQueue& queue = GetOneShotQueue(type);
+    for (uint32_t i = 0; i < queue.slots.size(); ++i) {
+        if (queue.timeline->IsReached(queue.slots[i].value)) {
+            vkResetCommandBuffer(queue.slots[i].cmd, 0);
+            return i;
+        }
+    }
+    // Everything in flight: grow. The pool keeps its high-water mark.
     VkCommandBufferAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = pool;
+    allocInfo.commandPool = GetPool(type);
     allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
     allocInfo.commandBufferCount = 1;
 
     VkCommandBuffer cmd;
     VkResult result = vkAllocateCommandBuffers(device, &allocInfo, &cmd);
     assert(result == VK_SUCCESS);
+    queue.slots.push_back({cmd, 0});
+    LOGI("One-shot pool for queue type %d grown to %zu command buffers",
+         static_cast<int>(type), queue.slots.size());
+    return static_cast<uint32_t>(queue.slots.size() - 1);
+}
+
+CommandPoolManager::OneShotHandle CommandPoolManager::SubmitOneShotAsync(
+        QueueType queueType,
+        const std::function<void(VkCommandBuffer)>& recordFunc,
+        std::function<void()> onComplete,
+        OneShotHandle waitFor) {
+    OneShotQueue& queue = GetOneShotQueue(queueType);
+    const uint32_t slot = AcquireOneShotSlot(queueType);
+    VkCommandBuffer cmd = queue.slots[slot].cmd;
 
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -158,201 +266,190 @@ void CommandPoolManager::SubmitOneShot(QueueType queueType,
     recordFunc(cmd);
     vkEndCommandBuffer(cmd);
 
+    const uint64_t value = ++queue.lastSubmitted;
+    VkSemaphore signalSemaphore = queue.timeline->Get();
+
+    VkSemaphore waitSemaphore = VK_NULL_HANDLE;
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    const bool hasWait = waitFor.value != 0;
+    if (hasWait) {
+        waitSemaphore = GetOneShotQueue(waitFor.queue).timeline->Get();
+    }
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount = hasWait ? 1 : 0;
+    timelineInfo.pWaitSemaphoreValues = &waitFor.value;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &value;
+
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.waitSemaphoreCount = hasWait ? 1 : 0;
+    submitInfo.pWaitSemaphores = &waitSemaphore;
+    submitInfo.pWaitDstStageMask = &waitStage;
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &cmd;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &signalSemaphore;
+
+    VkResult result = vkQueueSubmit(GetQueue(queueType), 1, &submitInfo, VK_NULL_HANDLE);
+    if (result != VK_SUCCESS) {
+        LOGE("One-shot submit failed: %d", result);
+    }
+
+    queue.slots[slot].value = value;
+    if (onComplete) {
+        queue.callbacks.emplace_back(value, std::move(onComplete));
+    }
+    return {queueType, value};
+}
+
+void CommandPoolManager::SubmitOneShot(QueueType queueType,
+                                       const std::function<void(VkCommandBuffer)>& recordFunc) {
+    Wait(SubmitOneShotAsync(queueType, recordFunc));
+}
 
-    vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(queue);
+bool CommandPoolManager::IsComplete(OneShotHandle handle) {
+    return GetOneShotQueue(handle.queue).timeline->IsReached(handle.value);
+}
 
-    vkFreeCommandBuffers(device, pool, 1, &cmd);
+void CommandPoolManager::Wait(OneShotHandle handle) {
+    GetOneShotQueue(handle.queue).timeline->Wait(handle.value);
+    CollectCompletedOneShots();
+}
+
+void CommandPoolManager::CollectCompletedOneShots() {
+    for (auto& queue : oneShotQueues) {
+        RunCallbacks(queue);
+    }
+}
+
+void CommandPoolManager::RunCallbacks(OneShotQueue& queue) {
+    if (queue.callbacks.empty()) {
+        return;
+    }
+    const uint64_t completed = queue.timeline->GetCompletedValue();
+    while (!queue.callbacks.empty() && queue.callbacks.front().first <= completed) {
+        // Pop first: the callback may submit another one-shot
+        auto callback = std::move(queue.callbacks.front().second);
+        queue.callbacks.pop_front();
+        callback();
+    }
 }
 
 // ============================================================
 // Upload with queue family ownership transfer
 // ============================================================
 
-void CommandPoolManager::UploadBuffer(VkBuffer srcBuffer,
-                                      VkBuffer dstBuffer,
-                                      VkDeviceSize size,
-                                      VkPipelineStageFlags dstStage,
-                                      VkAccessFlags dstAccess) {
+CommandPoolManager::OneShotHandle CommandPoolManager::UploadBuffer(VkBuffer srcBuffer,
+                                                                  VkBuffer dstBuffer,
+                                                                  VkDeviceSize size,
+                                                                  VkPipelineStageFlags dstStage,
+                                                                  VkAccessFlags dstAccess,
+                                                                  std::function<void()> onComplete) {
     bool needsOwnershipTransfer = HasDedicatedTransfer();
+    // Fresh buffer: the copy is its first use. Shared by the two one-shots below,
+    // which are recorded here, in order.
+    ResourceState state;
 
     // Step 1: Copy on transfer queue + release (if needed)
-    SubmitOneShot(QueueType::Transfer, [&](VkCommandBuffer cmd) {
-        // Copy
+    OneShotHandle copied = SubmitOneShotAsync(QueueType::Transfer, [&](VkCommandBuffer cmd) {
+        BarrierBatch barriers;
+        barriers.UseBuffer(dstBuffer, 0, size, state, VK_PIPELINE_STAGE_2_COPY_BIT,
+                           VK_ACCESS_2_TRANSFER_WRITE_BIT);
         VkBufferCopy region{};
         region.size = size;
         vkCmdCopyBuffer(cmd, srcBuffer, dstBuffer, 1, &region);
 
         if (needsOwnershipTransfer) {
-            // Release barrier: transfer queue releases ownership
-            VkBufferMemoryBarrier releaseBarrier{};
-            releaseBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-            releaseBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            releaseBarrier.dstAccessMask = 0; // dst is ignored in release
-            releaseBarrier.srcQueueFamilyIndex = transferFamilyIndex;
-            releaseBarrier.dstQueueFamilyIndex = graphicsFamilyIndex;
-            releaseBarrier.buffer = dstBuffer;
-            releaseBarrier.offset = 0;
-            releaseBarrier.size = size;
-
-            vkCmdPipelineBarrier(cmd,
-                                 VK_PIPELINE_STAGE_TRANSFER_BIT,
-                                 VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-                                 0,
-                                 0, nullptr,
-                                 1, &releaseBarrier,
-                                 0, nullptr);
+            barriers.ReleaseBuffer(dstBuffer, 0, size, state, transferFamilyIndex, graphicsFamilyIndex);
+            barriers.Flush(cmd);
         }
     });
 
-    if (needsOwnershipTransfer) {
-        // Step 2: Acquire on graphics queue
-        SubmitOneShot(QueueType::Graphics, [&](VkCommandBuffer cmd) {
-            VkBufferMemoryBarrier acquireBarrier{};
-            acquireBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-            acquireBarrier.srcAccessMask = 0; // src is ignored in acquire
-            acquireBarrier.dstAccessMask = dstAccess;
-            acquireBarrier.srcQueueFamilyIndex = transferFamilyIndex;
-            acquireBarrier.dstQueueFamilyIndex = graphicsFamilyIndex;
-            acquireBarrier.buffer = dstBuffer;
-            acquireBarrier.offset = 0;
-            acquireBarrier.size = size;
-
-            vkCmdPipelineBarrier(cmd,
-                                 VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                                 dstStage,
-                                 0,
-                                 0, nullptr,
-                                 1, &acquireBarrier,
-                                 0, nullptr);
-        });
-    }
+    // Step 2, on the graphics queue once the copy is done: acquire, or on a shared
+    // family make the write visible to the consumer (the copy may be on another queue)
+    return SubmitOneShotAsync(QueueType::Graphics, [&](VkCommandBuffer cmd) {
+        BarrierBatch barriers;
+        if (needsOwnershipTransfer) {
+            barriers.AcquireBuffer(dstBuffer, 0, size, state, transferFamilyIndex, graphicsFamilyIndex,
+                                   dstStage, dstAccess);
+        } else {
+            barriers.UseBuffer(dstBuffer, 0, size, state, dstStage, dstAccess);
+        }
+        barriers.Flush(cmd);
+    }, std::move(onComplete), copied);
+}
+
+CommandPoolManager::OneShotHandle CommandPoolManager::UploadImage(VkBuffer srcBuffer,
+                                                                 VkImage dstImage,
+                                                                 uint32_t width,
+                                                                 uint32_t height,
+                                                                 VkImageLayout finalLayout,
+                                                                 std::function<void()> onComplete) {
+    VkBufferImageCopy region{};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;   // tightly packed
+    region.bufferImageHeight = 0; // tightly packed
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {width, height, 1};
+    return UploadImage(srcBuffer, dstImage, std::vector<VkBufferImageCopy>{region}, 1, finalLayout,
+                       std::move(onComplete));
 }
 
-void CommandPoolManager::UploadImage(VkBuffer srcBuffer,
-                                     VkImage dstImage,
-                                     uint32_t width,
-                                     uint32_t height,
-                                     VkImageLayout finalLayout) {
+CommandPoolManager::OneShotHandle CommandPoolManager::UploadImage(VkBuffer srcBuffer,
+                                                                 VkImage dstImage,
+                                                                 const std::vector<VkBufferImageCopy>& regions,
+                                                                 uint32_t mipLevels,
+                                                                 VkImageLayout finalLayout,
+                                                                 std::function<void()> onComplete) {
     bool needsOwnershipTransfer = HasDedicatedTransfer();
 
     VkImageSubresourceRange subresourceRange{};
     subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     subresourceRange.baseMipLevel = 0;
-    subresourceRange.levelCount = 1;
+    subresourceRange.levelCount = mipLevels;
     subresourceRange.baseArrayLayer = 0;
     subresourceRange.layerCount = 1;
+    ResourceState state;   // fresh image, see UploadBuffer
 
     // Step 1: Transition to TRANSFER_DST, copy, release (on transfer queue)
-    SubmitOneShot(QueueType::Transfer, [&](VkCommandBuffer cmd) {
-        // Transition UNDEFINED -> TRANSFER_DST_OPTIMAL
-        VkImageMemoryBarrier toTransferDst{};
-        toTransferDst.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        toTransferDst.srcAccessMask = 0;
-        toTransferDst.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        toTransferDst.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        toTransferDst.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        toTransferDst.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        toTransferDst.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        toTransferDst.image = dstImage;
-        toTransferDst.subresourceRange = subresourceRange;
-
-        vkCmdPipelineBarrier(cmd,
-                             VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                             VK_PIPELINE_STAGE_TRANSFER_BIT,
-                             0,
-                             0, nullptr,
-                             0, nullptr,
-                             1, &toTransferDst);
-
-        // Copy buffer to image
-        VkBufferImageCopy region{};
-        region.bufferOffset = 0;
-        region.bufferRowLength = 0;   // tightly packed
-        region.bufferImageHeight = 0; // tightly packed
-        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.imageSubresource.mipLevel = 0;
-        region.imageSubresource.baseArrayLayer = 0;
-        region.imageSubresource.layerCount = 1;
-        region.imageOffset = {0, 0, 0};
-        region.imageExtent = {width, height, 1};
+    OneShotHandle copied = SubmitOneShotAsync(QueueType::Transfer, [&](VkCommandBuffer cmd) {
+        BarrierBatch barriers;
+        barriers.UseImage(dstImage, subresourceRange, state, VK_PIPELINE_STAGE_2_COPY_BIT,
+                          VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true);
+        barriers.Flush(cmd);
 
         vkCmdCopyBufferToImage(cmd, srcBuffer, dstImage,
-                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               static_cast<uint32_t>(regions.size()), regions.data());
 
         if (needsOwnershipTransfer) {
-            // Release: transfer queue gives up ownership
-            // Layout stays TRANSFER_DST_OPTIMAL — graphics side will transition
-            VkImageMemoryBarrier releaseBarrier{};
-            releaseBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-            releaseBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            releaseBarrier.dstAccessMask = 0;
-            releaseBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-            releaseBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-            releaseBarrier.srcQueueFamilyIndex = transferFamilyIndex;
-            releaseBarrier.dstQueueFamilyIndex = graphicsFamilyIndex;
-            releaseBarrier.image = dstImage;
-            releaseBarrier.subresourceRange = subresourceRange;
-
-            vkCmdPipelineBarrier(cmd,
-                                 VK_PIPELINE_STAGE_TRANSFER_BIT,
-                                 VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-                                 0,
-                                 0, nullptr,
-                                 0, nullptr,
-                                 1, &releaseBarrier);
+            // The layout change to finalLayout is part of the transfer: both halves name it
+            barriers.ReleaseImage(dstImage, subresourceRange, state,
+                                  transferFamilyIndex, graphicsFamilyIndex, finalLayout);
+            barriers.Flush(cmd);
         }
     });
 
-    // Step 2: Acquire on graphics queue + transition to final layout
-    if (needsOwnershipTransfer) {
-        SubmitOneShot(QueueType::Graphics, [&](VkCommandBuffer cmd) {
-            VkImageMemoryBarrier acquireBarrier{};
-            acquireBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-            acquireBarrier.srcAccessMask = 0;
-            acquireBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-            acquireBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-            acquireBarrier.newLayout = finalLayout;
-            acquireBarrier.srcQueueFamilyIndex = transferFamilyIndex;
-            acquireBarrier.dstQueueFamilyIndex = graphicsFamilyIndex;
-            acquireBarrier.image = dstImage;
-            acquireBarrier.subresourceRange = subresourceRange;
-
-            vkCmdPipelineBarrier(cmd,
-                                 VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                                 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                                 0,
-                                 0, nullptr,
-                                 0, nullptr,
-                                 1, &acquireBarrier);
-        });
-    } else {
-        // Same family: just transition layout
-        SubmitOneShot(QueueType::Graphics, [&](VkCommandBuffer cmd) {
-            VkImageMemoryBarrier toFinal{};
-            toFinal.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-            toFinal.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            toFinal.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-            toFinal.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-            toFinal.newLayout = finalLayout;
-            toFinal.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-            toFinal.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-            toFinal.image = dstImage;
-            toFinal.subresourceRange = subresourceRange;
-
-            vkCmdPipelineBarrier(cmd,
-                                 VK_PIPELINE_STAGE_TRANSFER_BIT,
-                                 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                                 0,
-                                 0, nullptr,
-                                 0, nullptr,
-                                 1, &toFinal);
-        });
-    }
+    // Step 2: Acquire on graphics queue, or just transition to the final layout after the copy
+    return SubmitOneShotAsync(QueueType::Graphics, [&](VkCommandBuffer cmd) {
+        BarrierBatch barriers;
+        if (needsOwnershipTransfer) {
+            barriers.AcquireImage(dstImage, subresourceRange, state, transferFamilyIndex, graphicsFamilyIndex,
+                                  VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT);
+        } else {
+            barriers.UseImage(dstImage, subresourceRange, state, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                              VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, finalLayout);
+        }
+        barriers.Flush(cmd);
+    }, std::move(onComplete), copied);
 }
 
 // ============================================================
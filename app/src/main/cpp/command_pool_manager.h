@@ -1,9 +1,14 @@
 #ifndef KRAKATOA_COMMAND_POOL_MANAGER_H
 #define KRAKATOA_COMMAND_POOL_MANAGER_H
 #include <vulkan/vulkan.h>
+#include <array>
+#include <deque>
 #include <functional>
+#include <memory>
+#include <vector>
 #include "ring_buffer.h"
 #include "queue_family_indices.h"
+#include "timeline_semaphore.h"
 namespace graphics {
 
     /**
@@ -14,6 +19,21 @@ namespace graphics {
      * - One-shot command buffer execution on any queue
      * - Buffer/image upload with automatic queue family ownership transfer
      *
+     * One-shots run on pre-allocated command buffers, a few per queue type,
+     * reset and reused once the GPU is done with them; steady-state uploads
+     * allocate nothing. Each queue type has a timeline semaphore and every
+     * one-shot signals the next value on it: the returned OneShotHandle is
+     * that value. Nothing idles the queue. Completion callbacks run on the
+     * calling thread, from AdvanceFrame() (or any Wait) once the value is
+     * seen reached, in submission order. The slot pool only grows when more
+     * one-shots are in flight than ever before.
+     *
+     * Secondary command buffers for multithreaded recording come from
+     * separate "recording pools", a set per frame in flight: pool i of the
+     * current frame belongs to whichever thread records chunk i, and the
+     * whole set is reset with one vkResetCommandPool each when its frame
+     * slot comes round again.
+     *
      * Usage (frame):
      *   cmdManager.AdvanceFrame();
      *   cmdManager.BeginFrame();
@@ -22,13 +42,16 @@ namespace graphics {
      *   cmdManager.EndFrame();
      *
      * Usage (one-shot):
-     *   cmdManager.SubmitOneShot(QueueType::Transfer, [&](VkCommandBuffer cmd) {
+     *   auto handle = cmdManager.SubmitOneShotAsync(QueueType::Transfer, [&](VkCommandBuffer cmd) {
      *       vkCmdCopyBuffer(cmd, src, dst, 1, &region);
-     *   });
+     *   }, [=] { vmaDestroyBuffer(allocator, src, srcAlloc); });
+     *   ...
+     *   cmdManager.Wait(handle);        // only if the CPU needs the result now
      *
-     * Usage (buffer upload with ownership transfer):
+     * Usage (buffer upload with ownership transfer, staging freed on completion):
      *   cmdManager.UploadBuffer(staging, gpu, size,
-     *       VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+     *       VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+     *       [=] { vmaDestroyBuffer(allocator, staging, stagingAlloc); });
      *
      * Usage (image upload with ownership transfer + layout transition):
      *   cmdManager.UploadImage(staging, image, width, height,
@@ -42,6 +65,12 @@ namespace graphics {
             Transfer
         };
 
+        /// A submitted one-shot: the value its queue type's timeline reaches when it is done.
+        struct OneShotHandle {
+            QueueType queue = QueueType::Graphics;
+            uint64_t  value = 0;   // 0 = nothing submitted, always complete
+        };
+
         CommandPoolManager(VkDevice device,
                            const QueueFamilyIndices& queueFamilies,
                            VkQueue graphicsQueue,
@@ -52,7 +81,7 @@ namespace graphics {
         CommandPoolManager(const CommandPoolManager&) = delete;
         CommandPoolManager& operator=(const CommandPoolManager&) = delete;
 
-        /// Advance to next frame's command buffer.
+        /// Advance to next frame's command buffer. Also runs finished one-shots' callbacks.
         void AdvanceFrame();
 
         /// Get the current frame's command buffer (graphics queue).
@@ -64,10 +93,47 @@ namespace graphics {
         /// End recording the current frame's command buffer.
         void EndFrame();
 
-        /// Execute a one-shot command on the specified queue. Blocking.
+        /**
+         * Create `count` graphics recording pools per frame in flight, for
+         * recording secondaries on that many threads. Call once at startup.
+         */
+        void CreateRecordingPools(uint32_t count);
+        uint32_t GetRecordingPoolCount() const { return static_cast<uint32_t>(recordingPools.Current().size()); }
+
+        /**
+         * A secondary command buffer from the current frame's recording pool
+         * `poolIndex`, begun to continue the render pass in `inheritance`.
+         * End it with vkEndCommandBuffer. Different pools may be used from
+         * different threads at the same time; one pool from one thread only.
+         */
+        VkCommandBuffer BeginSecondary(uint32_t poolIndex,
+                                       const VkCommandBufferInheritanceInfo& inheritance);
+
+        /**
+         * Record and submit a one-shot command buffer on the specified queue.
+         * Returns right after the submit.
+         *
+         * @param onComplete  runs on this thread once the GPU finished it (see AdvanceFrame)
+         * @param waitFor     an earlier one-shot, possibly on another queue, this one
+         *                    must wait for on the GPU (e.g. an ownership acquire)
+         */
+        OneShotHandle SubmitOneShotAsync(QueueType queueType,
+                                         const std::function<void(VkCommandBuffer)>& recordFunc,
+                                         std::function<void()> onComplete = nullptr,
+                                         OneShotHandle waitFor = {});
+
+        /// Execute a one-shot command on the specified queue. Blocks until it is done.
         void SubmitOneShot(QueueType queueType,
                            const std::function<void(VkCommandBuffer)>& recordFunc);
 
+        bool IsComplete(OneShotHandle handle);
+
+        /// Blocks until `handle` is done, then runs the callbacks that are due.
+        void Wait(OneShotHandle handle);
+
+        /// Runs the callbacks of every one-shot found finished. Non-blocking.
+        void CollectCompletedOneShots();
+
         /**
          * Upload a buffer from staging to GPU via transfer queue.
          * Handles queue family ownership transfer if transfer and graphics
@@ -76,31 +142,53 @@ namespace graphics {
          * @param srcBuffer  Staging buffer (host visible)
          * @param dstBuffer  GPU buffer
          * @param size       Bytes to copy
+         * Non-blocking: graphics queue work submitted afterwards sees the data.
+         *
          * @param dstStage   Pipeline stage where the buffer will be consumed
          * @param dstAccess  Access mask for the destination usage
+         * @param onComplete Runs once the upload finished, e.g. to free the staging buffer
+         * @return the last submission of the upload
          */
-        void UploadBuffer(VkBuffer srcBuffer,
-                          VkBuffer dstBuffer,
-                          VkDeviceSize size,
-                          VkPipelineStageFlags dstStage,
-                          VkAccessFlags dstAccess);
+        OneShotHandle UploadBuffer(VkBuffer srcBuffer,
+                                   VkBuffer dstBuffer,
+                                   VkDeviceSize size,
+                                   VkPipelineStageFlags dstStage,
+                                   VkAccessFlags dstAccess,
+                                   std::function<void()> onComplete = nullptr);
 
         /**
          * Upload an image from staging buffer to GPU image via transfer queue.
          * Handles layout transitions and queue family ownership transfer.
          * Image ends in finalLayout, ready for use on the graphics queue.
+         * Non-blocking, like UploadBuffer.
          *
          * @param srcBuffer   Staging buffer with pixel data
          * @param dstImage    GPU image
          * @param width       Image width
          * @param height      Image height
          * @param finalLayout Layout the image should be in after upload
+         * @param onComplete  Runs once the upload finished
          */
-        void UploadImage(VkBuffer srcBuffer,
-                         VkImage dstImage,
-                         uint32_t width,
-                         uint32_t height,
-                         VkImageLayout finalLayout);
+        OneShotHandle UploadImage(VkBuffer srcBuffer,
+                                  VkImage dstImage,
+                                  uint32_t width,
+                                  uint32_t height,
+                                  VkImageLayout finalLayout,
+                                  std::function<void()> onComplete = nullptr);
+
+        /**
+         * Same as above, but with explicit copy regions so a whole mip chain
+         * (or a block-compressed image) can be uploaded in one go.
+         *
+         * @param regions     One copy per mip level
+         * @param mipLevels   Number of mip levels in dstImage
+         */
+        OneShotHandle UploadImage(VkBuffer srcBuffer,
+                                  VkImage dstImage,
+                                  const std::vector<VkBufferImageCopy>& regions,
+                                  uint32_t mipLevels,
+                                  VkImageLayout finalLayout,
+                                  std::function<void()> onComplete = nullptr);
 
         VkCommandPool GetCommandPool(QueueType queueType) const;
 
@@ -123,8 +211,34 @@ namespace graphics {
 
         utils::RingBuffer<VkCommandBuffer> frameCommandBuffers;
 
+        // Secondary recording, per frame in flight x recording thread
+        struct RecordingPool {
+            VkCommandPool pool = VK_NULL_HANDLE;
+            std::vector<VkCommandBuffer> secondaries;   // allocated on demand, kept
+            uint32_t used = 0;                          // handed out this frame
+        };
+        utils::RingBuffer<std::vector<RecordingPool>> recordingPools;
+
+        // One-shot command buffers, per queue type
+        static constexpr uint32_t INITIAL_ONE_SHOT_SLOTS = 4;
+        struct OneShotSlot {
+            VkCommandBuffer cmd   = VK_NULL_HANDLE;
+            uint64_t        value = 0;   // timeline value of its last submit, 0 = never used
+        };
+        struct OneShotQueue {
+            std::unique_ptr<TimelineSemaphore> timeline;
+            uint64_t lastSubmitted = 0;
+            std::vector<OneShotSlot> slots;
+            std::deque<std::pair<uint64_t, std::function<void()>>> callbacks;   // by value
+        };
+        std::array<OneShotQueue, 3> oneShotQueues;
+
         VkCommandPool CreatePool(uint32_t queueFamilyIndex, VkCommandPoolCreateFlags flags);
         void AllocateFrameCommandBuffers();
+        void CreateOneShotQueues();
+        OneShotQueue& GetOneShotQueue(QueueType type) { return oneShotQueues[static_cast<size_t>(type)]; }
+        uint32_t AcquireOneShotSlot(QueueType type);   // a slot the GPU is done with, reset
+        void RunCallbacks(OneShotQueue& queue);
 
         VkQueue GetQueue(QueueType type) const;
         VkCommandPool GetPool(QueueType type) const;
@@ -0,0 +1,61 @@
+#include "damage_region.h"
+#include <algorithm>
+#include <cmath>
+using namespace graphics;
+
+void DamageRegion::Clear() {
+    empty = true;
+    ndcMin = ndcMax = glm::vec2(0.0f);
+}
+
+void DamageRegion::AddBox(const glm::mat4& modelViewProj, const glm::vec3& min, const glm::vec3& max) {
+    glm::vec2 boxMin(1.0f);
+    glm::vec2 boxMax(-1.0f);
+    bool behind = false;
+    for (uint32_t corner = 0; corner < 8; ++corner) {
+        const glm::vec4 position((corner & 1) ? max.x : min.x,
+                                 (corner & 2) ? max.y : min.y,
+                                 (corner & 4) ? max.z : min.z, 1.0f);
+        const glm::vec4 clip = modelViewProj * position;
+        if (clip.w <= 1e-5f) {
+            behind = true;
+            break;
+        }
+        const glm::vec2 ndc = glm::vec2(clip) / clip.w;
+        boxMin = corner == 0 ? ndc : glm::min(boxMin, ndc);
+        boxMax = corner == 0 ? ndc : glm::max(boxMax, ndc);
+    }
+    if (behind) {
+        // Crosses the camera plane: its projection is unbounded
+        boxMin = glm::vec2(-1.0f);
+        boxMax = glm::vec2(1.0f);
+    }
+    boxMin = glm::max(boxMin, glm::vec2(-1.0f));
+    boxMax = glm::min(boxMax, glm::vec2(1.0f));
+    if (boxMin.x >= boxMax.x || boxMin.y >= boxMax.y) return;   // off screen
+
+    ndcMin = empty ? boxMin : glm::min(ndcMin, boxMin);
+    ndcMax = empty ? boxMax : glm::max(ndcMax, boxMax);
+    empty = false;
+}
+
+float DamageRegion::GetCoverage() const {
+    if (empty) return 0.0f;
+    const glm::vec2 size = (ndcMax - ndcMin) * 0.5f;
+    return size.x * size.y;
+}
+
+VkRect2D DamageRegion::GetRect(VkExtent2D extent, uint32_t padding) const {
+    if (empty) return {{0, 0}, {0, 0}};
+    // Same mapping as the viewport: NDC -1..1 onto 0..extent
+    auto toPixels = [padding](float ndc, uint32_t size, bool upper) {
+        const float pixel = (ndc * 0.5f + 0.5f) * static_cast<float>(size);
+        const float padded = upper ? std::ceil(pixel) + padding : std::floor(pixel) - padding;
+        return static_cast<int32_t>(std::clamp(padded, 0.0f, static_cast<float>(size)));
+    };
+    const int32_t x0 = toPixels(ndcMin.x, extent.width, false);
+    const int32_t y0 = toPixels(ndcMin.y, extent.height, false);
+    const int32_t x1 = toPixels(ndcMax.x, extent.width, true);
+    const int32_t y1 = toPixels(ndcMax.y, extent.height, true);
+    return {{x0, y0}, {static_cast<uint32_t>(x1 - x0), static_cast<uint32_t>(y1 - y0)}};
+}
@@ -0,0 +1,48 @@
+#ifndef KRAKATOA_DAMAGE_REGION_H
+#define KRAKATOA_DAMAGE_REGION_H
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+namespace graphics {
+
+    /**
+     * Screen-space bounds of a frame's draws, from their model-space boxes.
+     *
+     * Each box's corners are projected and the region grows to the
+     * rectangle around them, kept in NDC so it maps onto targets of any size
+     * (a layer at a reduced render scale, the backbuffer). A box reaching
+     * behind the camera can't be projected: it takes the whole screen.
+     * Boxes entirely off screen add nothing.
+     *
+     * Usage:
+     *   DamageRegion damage;
+     *   damage.Clear();
+     *   for (draw : draws) damage.AddBox(proj * view * draw.model, draw.boundsMin, draw.boundsMax);
+     *   if (damage.IsEmpty()) ... skip the layer
+     *   else graph.SetScissor(pass, damage.GetRect(graph.GetRenderArea(pass), 2));
+     */
+    class DamageRegion {
+    public:
+        /// Starts a frame: nothing drawn
+        void Clear();
+
+        /// Grows the region by the box min..max, drawn with `modelViewProj`.
+        void AddBox(const glm::mat4& modelViewProj, const glm::vec3& min, const glm::vec3& max);
+
+        bool IsEmpty() const { return empty; }
+        /// Fraction of the screen covered, 0..1
+        float GetCoverage() const;
+
+        /**
+         * The region in pixels of a target that covers the screen with
+         * `extent`, grown by `padding` pixels each way (filtering, jitter,
+         * rasterization rounding) and clipped to the target.
+         */
+        VkRect2D GetRect(VkExtent2D extent, uint32_t padding) const;
+
+    private:
+        glm::vec2 ndcMin{0.0f};
+        glm::vec2 ndcMax{0.0f};
+        bool empty = true;
+    };
+}
+#endif //KRAKATOA_DAMAGE_REGION_H
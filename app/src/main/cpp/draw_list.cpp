@@ -0,0 +1,75 @@
+#include "draw_list.h"
+#include "command_pool_manager.h"
+#include "render_pass.h"
+#include <algorithm>
+#include <cassert>
+using namespace graphics;
+
+void DrawList::Add(Pipeline* pipeline, RDO* rdo, Renderable* renderable, uint32_t frameIndex) {
+    assert(pipeline->CanPrepare() && "DrawList needs a pipeline with a prepareCallback");
+    Item item{pipeline, {}};
+    if (pipeline->Prepare(rdo, renderable, frameIndex, item.draw)) {
+        draws.push_back(item);
+    }
+}
+
+void DrawList::RecordRange(VkCommandBuffer cmd, size_t begin, size_t end) const {
+    const Pipeline* bound = nullptr;
+    for (size_t i = begin; i < end; ++i) {
+        const Item& item = draws[i];
+        if (item.pipeline != bound) {
+            item.pipeline->Bind(cmd);
+            bound = item.pipeline;
+        }
+        item.pipeline->Record(cmd, item.draw);
+    }
+}
+
+void DrawList::Record(RenderGraph::PassContext& ctx,
+                      CommandPoolManager& cmdManager, utils::ThreadPool* workers) {
+    const VkCommandBuffer primary = ctx.GetCommandBuffer();
+    const VkExtent2D extent = ctx.GetExtent();
+    const VkRect2D scissor = ctx.GetScissor();
+    const size_t count = draws.size();
+    uint32_t chunks = 1;
+    if (workers != nullptr) {
+        const uint32_t threads = std::min(workers->Size() + 1, cmdManager.GetRecordingPoolCount());
+        chunks = static_cast<uint32_t>(std::clamp<size_t>(count / MIN_DRAWS_PER_CHUNK, 1, threads));
+    }
+
+    if (chunks <= 1) {
+        ctx.Begin();
+        RecordRange(primary, 0, count);
+        return;
+    }
+
+    VkCommandBufferInheritanceInfo inheritance{};
+    inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance.renderPass = ctx.GetRenderPass();
+    inheritance.subpass = ctx.GetSubpass();
+    inheritance.framebuffer = ctx.GetFramebuffer();
+
+    secondaries.assign(chunks, VK_NULL_HANDLE);
+    auto recordChunk = [&](uint32_t chunk) {
+        VkCommandBuffer cmd = cmdManager.BeginSecondary(chunk, inheritance);
+        // Dynamic state is not inherited from the primary
+        RenderPass::SetViewportAndScissor(cmd, extent, scissor);
+        RecordRange(cmd, count * chunk / chunks, count * (chunk + 1) / chunks);
+        VkResult result = vkEndCommandBuffer(cmd);
+        assert(result == VK_SUCCESS);
+        secondaries[chunk] = cmd;
+    };
+
+    chunksDone.Reset(chunks - 1);
+    for (uint32_t chunk = 1; chunk < chunks; ++chunk) {
+        workers->Submit([&, chunk] {
+            recordChunk(chunk);
+            chunksDone.CountDown();
+        });
+    }
+    recordChunk(0);
+    chunksDone.Wait();
+
+    ctx.Begin(VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    vkCmdExecuteCommands(primary, chunks, secondaries.data());
+}
@@ -0,0 +1,67 @@
+#ifndef KRAKATOA_DRAW_LIST_H
+#define KRAKATOA_DRAW_LIST_H
+#include <vulkan/vulkan.h>
+#include <vector>
+#include "pipeline.h"
+#include "thread_pool.h"
+#include "render_graph.h"
+namespace graphics {
+    class CommandPoolManager;
+
+    /**
+     * The draws of one render pass, recorded in the order they were added.
+     *
+     * Add() runs the pipeline's prepare step right away on the render thread
+     * (uniforms, descriptor sets, cache lookups), so what is left for Record()
+     * is pure command recording. With enough draws Record() splits the list
+     * into contiguous chunks, records each into a secondary command buffer
+     * from its own recording pool (chunk 0 on the calling thread, the rest on
+     * the workers) and executes them in order, so blending order is kept.
+     * Short lists are recorded inline: a secondary costs more than it saves.
+     *
+     * Only pipelines with a prepareCallback can be added.
+     *
+     * Usage:
+     *   drawList.Clear();
+     *   for (auto& obj : objects) drawList.Add(pipeline, &rdo, obj, frameIndex);
+     *   // in the pass's RenderGraph callback
+     *   drawList.Record(ctx, cmdManager, &workerPool);
+     */
+    class DrawList {
+    public:
+        DrawList() = default;
+        DrawList(const DrawList&) = delete;
+        DrawList& operator=(const DrawList&) = delete;
+
+        void Clear() { draws.clear(); }
+        size_t Size() const { return draws.size(); }
+
+        /// Prepares the draw now; skipped if the pipeline has nothing to draw for it.
+        void Add(Pipeline* pipeline, RDO* rdo, Renderable* renderable, uint32_t frameIndex);
+
+        /**
+         * Begins the subpass of the graph pass `ctx` belongs to (inline or for
+         * secondaries) and records every draw into it.
+         * Returns once all chunks are recorded.
+         *
+         * @param workers  may be null: everything is then recorded inline
+         */
+        void Record(RenderGraph::PassContext& ctx,
+                    CommandPoolManager& cmdManager, utils::ThreadPool* workers);
+
+    private:
+        /// Fewer draws per chunk and the secondary's overhead wins
+        static constexpr size_t MIN_DRAWS_PER_CHUNK = 64;
+
+        struct Item {
+            const Pipeline* pipeline;
+            DrawCommand     draw;
+        };
+        std::vector<Item> draws;
+        std::vector<VkCommandBuffer> secondaries;
+        utils::Latch chunksDone;
+
+        void RecordRange(VkCommandBuffer cmd, size_t begin, size_t end) const;
+    };
+}
+#endif //KRAKATOA_DRAW_LIST_H
@@ -0,0 +1,59 @@
+#include "dynamic_resolution.h"
+#include "android_log.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+using namespace graphics;
+
+DynamicResolution::DynamicResolution()
+        : DynamicResolution(Settings{}) {
+}
+
+DynamicResolution::DynamicResolution(const Settings& settings)
+        : settings(settings) {
+    assert(settings.minScale > 0.0f && settings.minScale <= settings.maxScale);
+    assert(settings.alignment > 0);
+    metrics.scale = settings.maxScale;
+}
+
+void DynamicResolution::Update(float gpuMs) {
+    metrics.lastMs = gpuMs;
+    metrics.smoothedMs = hasSample ? metrics.smoothedMs + (gpuMs - metrics.smoothedMs) * settings.smoothing
+                                   : gpuMs;
+    hasSample = true;
+    metrics.lastDecision = Decision::Hold;
+    if (++metrics.framesSinceChange < settings.settleFrames) return;
+
+    const float high = settings.targetMs * (1.0f + settings.hysteresis);
+    const float low = settings.targetMs * (1.0f - settings.hysteresis);
+    // The layer's cost goes with its pixel count, the square of the scale
+    const float ideal = metrics.scale * std::sqrt(settings.targetMs / std::max(metrics.smoothedMs, 0.01f));
+    float scale = metrics.scale;
+    if (metrics.smoothedMs > high) {
+        scale = std::max(ideal, metrics.scale - settings.maxStep);
+    } else if (metrics.smoothedMs < low) {
+        scale = std::min(ideal, metrics.scale + settings.maxStep * 0.5f);
+    }
+    scale = std::clamp(scale, settings.minScale, settings.maxScale);
+    if (std::fabs(scale - metrics.scale) < 0.01f) return;   // at a bound, or too small to matter
+
+    metrics.lastDecision = scale < metrics.scale ? Decision::Lower : Decision::Raise;
+    (metrics.lastDecision == Decision::Lower ? metrics.lowered : metrics.raised)++;
+    LOGI("DynamicResolution: %s %.2f -> %.2f (GPU %.2f ms smoothed, target %.2f ms, %u down / %u up)",
+         metrics.lastDecision == Decision::Lower ? "lower" : "raise", metrics.scale, scale,
+         metrics.smoothedMs, settings.targetMs, metrics.lowered, metrics.raised);
+    metrics.scale = scale;
+    metrics.framesSinceChange = 0;
+    // The old measurements are of the old scale
+    hasSample = false;
+    metrics.smoothedMs = 0.0f;
+}
+
+VkExtent2D DynamicResolution::GetRenderExtent(VkExtent2D maxExtent) const {
+    auto scaled = [this](uint32_t size) {
+        const auto aligned = static_cast<uint32_t>(std::ceil(size * metrics.scale / settings.alignment)) *
+                             settings.alignment;
+        return std::clamp(aligned, 1u, size);
+    };
+    return {scaled(maxExtent.width), scaled(maxExtent.height)};
+}
@@ -0,0 +1,72 @@
+#ifndef KRAKATOA_DYNAMIC_RESOLUTION_H
+#define KRAKATOA_DYNAMIC_RESOLUTION_H
+#include <vulkan/vulkan.h>
+#include <cstdint>
+namespace graphics {
+
+    /**
+     * Picks the render scale of a layer from the measured GPU frame time.
+     *
+     * The measurements are smoothed; the scale only moves when the smoothed
+     * time leaves a band of ±hysteresis around the target, and not again
+     * before `settleFrames` new measurements (timestamp results lag by the
+     * frames in flight). Going down it jumps by the pixel ratio the time
+     * asks for (sqrt(target/measured)), going up it creeps, both limited to
+     * `maxStep`: dropping fast avoids missed frames, rising slowly avoids
+     * oscillating around the target.
+     *
+     * The scaled layer is rendered into the top-left GetRenderExtent() part
+     * of a target allocated at the maximum size, so scale changes never
+     * reallocate anything.
+     *
+     * Usage:
+     *   DynamicResolution resolution({0.5f, 1.0f, 12.0f});
+     *   // per frame
+     *   if (gpuTimer.HasNewResults()) resolution.Update(gpuTimer.GetTotalMs());
+     *   graph.SetRenderArea(offscreenPass, resolution.GetRenderExtent(graph.GetExtent()));
+     */
+    class DynamicResolution {
+    public:
+        struct Settings {
+            float minScale = 0.5f;        // per axis
+            float maxScale = 1.0f;
+            float targetMs = 12.0f;       // GPU time per frame to hold
+            float hysteresis = 0.1f;      // fraction of targetMs where nothing changes
+            float maxStep = 0.1f;         // largest scale change per decision
+            uint32_t settleFrames = 12;   // measurements between decisions
+            float smoothing = 0.15f;      // weight of a new measurement
+            uint32_t alignment = 8;       // render extent in multiples of this many pixels
+        };
+
+        enum class Decision { Hold, Lower, Raise };
+
+        /// What the controller saw and did, for logging and overlays
+        struct Metrics {
+            float scale = 1.0f;
+            float smoothedMs = 0.0f;      // 0 until the first measurement after a change
+            float lastMs = 0.0f;
+            Decision lastDecision = Decision::Hold;
+            uint32_t lowered = 0;         // decisions since creation
+            uint32_t raised = 0;
+            uint32_t framesSinceChange = 0;
+        };
+
+        DynamicResolution();
+        explicit DynamicResolution(const Settings& settings);
+
+        /// Feeds one frame's GPU time; may change the scale.
+        void Update(float gpuMs);
+
+        float GetScale() const { return metrics.scale; }
+        /// The scaled size within `maxExtent`, aligned and never above it
+        VkExtent2D GetRenderExtent(VkExtent2D maxExtent) const;
+        const Metrics& GetMetrics() const { return metrics; }
+        const Settings& GetSettings() const { return settings; }
+
+    private:
+        Settings settings;
+        Metrics metrics;
+        bool hasSample = false;
+    };
+}
+#endif //KRAKATOA_DYNAMIC_RESOLUTION_H
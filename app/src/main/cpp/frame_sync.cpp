@@ -5,32 +5,14 @@
 using namespace graphics;
 
 FrameSync::FrameSync(VkDevice device, uint32_t swapchainImageCount)
-        : device(device),
-          inFlightFences(MAX_FRAMES_IN_FLIGHT) {
-
-    VkFenceCreateInfo fenceInfo{};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        VkResult result = vkCreateFence(device, &fenceInfo, nullptr,
-                                        &inFlightFences[i]);
-        assert(result == VK_SUCCESS);
-        debug::SetFenceName(device, inFlightFences[i],
-                             Concatenate("InFlightFence[", i, "]"));
-    }
-
+        : device(device), timeline(device, "FrameTimeline") {
     CreatePerImageSyncObjects(swapchainImageCount);
 
-    LOGI("FrameSync created (%u frames in flight, %u swapchain images)",
+    LOGI("FrameSync created (%u frames in flight, %u swapchain images, timeline semaphore)",
          MAX_FRAMES_IN_FLIGHT, swapchainImageCount);
 }
 
 FrameSync::~FrameSync() {
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        vkDestroyFence(device, inFlightFences[i], nullptr);
-    }
-
     DestroyPerImageSyncObjects();
 
     LOGI("FrameSync destroyed");
@@ -42,7 +24,6 @@ void FrameSync::CreatePerImageSyncObjects(uint32_t count) {
 
     acquireSemaphores.resize(count);
     renderFinishedSemaphores.resize(count);
-    imagesInFlight.resize(count, VK_NULL_HANDLE);
     acquireSemaphoreIndex = 0;
 
     for (uint32_t i = 0; i < count; i++) {
@@ -71,7 +52,6 @@ void FrameSync::DestroyPerImageSyncObjects() {
     }
     acquireSemaphores.clear();
     renderFinishedSemaphores.clear();
-    imagesInFlight.clear();
 }
 
 void FrameSync::RecreateForSwapchain(uint32_t newSwapchainImageCount) {
@@ -80,17 +60,17 @@ void FrameSync::RecreateForSwapchain(uint32_t newSwapchainImageCount) {
     LOGI("FrameSync recreated for %u swapchain images", newSwapchainImageCount);
 }
 
-void FrameSync::AdvanceFrame() {
-    inFlightFences.Next();
-}
-
-void FrameSync::WaitForCurrentFrame() {
-    vkWaitForFences(device, 1, &inFlightFences.Current(),
-                    VK_TRUE, UINT64_MAX);
+uint64_t FrameSync::BeginFrame() {
+    currentFrame++;
+    if (currentFrame > MAX_FRAMES_IN_FLIGHT) {
+        WaitForFrame(currentFrame - MAX_FRAMES_IN_FLIGHT);
+    }
+    return currentFrame;
 }
 
-void FrameSync::ResetCurrentFence() {
-    vkResetFences(device, 1, &inFlightFences.Current());
+void FrameSync::WaitForFrame(uint64_t frame) {
+    assert(frame <= currentFrame && "waiting for a frame that was never submitted");
+    timeline.Wait(frame);
 }
 
 VkSemaphore FrameSync::GetNextAcquireSemaphore() {
@@ -100,13 +80,56 @@ VkSemaphore FrameSync::GetNextAcquireSemaphore() {
     return sem;
 }
 
-void FrameSync::WaitForImage(uint32_t imageIndex) {
-    if (imagesInFlight[imageIndex] != VK_NULL_HANDLE) {
-        vkWaitForFences(device, 1, &imagesInFlight[imageIndex],
-                        VK_TRUE, UINT64_MAX);
+bool FrameSync::SubmitFrame(VkQueue queue, VkCommandBuffer cmd,
+                            VkSemaphore acquireSem, VkSemaphore renderFinishedSem) {
+    VkResult result = Submit(queue, cmd, acquireSem, renderFinishedSem);
+    if (result != VK_SUCCESS) {
+        LOGE("Frame %llu submit failed: %d", (unsigned long long)currentFrame, result);
+        // Still consumes the acquire semaphore, so it can be acquired with again
+        SignalWithoutWork(queue, acquireSem);
+    }
+    return result == VK_SUCCESS;
+}
+
+void FrameSync::SkipFrame(VkQueue queue) {
+    SignalWithoutWork(queue, VK_NULL_HANDLE);
+}
+
+void FrameSync::SignalWithoutWork(VkQueue queue, VkSemaphore waitSem) {
+    VkResult result = Submit(queue, VK_NULL_HANDLE, waitSem, VK_NULL_HANDLE);
+    if (result != VK_SUCCESS) {
+        LOGE("Frame %llu: empty submit failed too (%d), signalling from the host",
+             (unsigned long long)currentFrame, result);
+        timeline.Signal(currentFrame);
     }
 }
 
-void FrameSync::SetImageFence(uint32_t imageIndex, VkFence fence) {
-    imagesInFlight[imageIndex] = fence;
-}
\ No newline at end of file
+VkResult FrameSync::Submit(VkQueue queue, VkCommandBuffer cmd,
+                           VkSemaphore waitSem, VkSemaphore renderFinishedSem) {
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+    // The timeline last, so it's the only signal when there's no renderFinishedSem.
+    // Binary semaphores ignore their value.
+    VkSemaphore signalSemaphores[] = {renderFinishedSem, timeline.Get()};
+    uint64_t signalValues[] = {0, currentFrame};
+    const uint32_t signalCount = renderFinishedSem != VK_NULL_HANDLE ? 2 : 1;
+    const uint32_t firstSignal = 2 - signalCount;
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.signalSemaphoreValueCount = signalCount;
+    timelineInfo.pSignalSemaphoreValues = signalValues + firstSignal;
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.waitSemaphoreCount = waitSem != VK_NULL_HANDLE ? 1 : 0;
+    submitInfo.pWaitSemaphores = &waitSem;
+    submitInfo.pWaitDstStageMask = &waitStage;
+    submitInfo.commandBufferCount = cmd != VK_NULL_HANDLE ? 1 : 0;
+    submitInfo.pCommandBuffers = &cmd;
+    submitInfo.signalSemaphoreCount = signalCount;
+    submitInfo.pSignalSemaphores = signalSemaphores + firstSignal;
+
+    return vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+}
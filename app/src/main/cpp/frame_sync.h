@@ -2,39 +2,43 @@
 #define KRAKATOA_FRAME_SYNC_H
 #include <vulkan/vulkan.h>
 #include <vector>
-#include "ring_buffer.h"
+#include "timeline_semaphore.h"
 namespace graphics {
 
     /**
      * Manages per-frame synchronization primitives.
      *
-     * Fences: per frame in flight (ring buffered). Controls CPU-GPU sync.
+     * GPU timeline: one timeline semaphore on the graphics queue. Frame N's
+     * submit signals value N, so "has the GPU finished frame X" is a single
+     * counter comparison for every subsystem (ring buffers, uploads, deferred
+     * deletion). BeginFrame() waits for frame N - MAX_FRAMES_IN_FLIGHT, the
+     * last one that used the ring slots frame N is about to reuse. Nothing is
+     * reset, and there is no second wait per swapchain image.
      *
-     * Semaphores (acquire + renderFinished): per swapchain image.
+     * Semaphores (acquire + renderFinished): binary, per swapchain image.
      * This avoids the reuse hazard when frames_in_flight < swapchain_image_count.
      * The acquire semaphore is cycled with its own counter (we don't know
      * the image index before acquire). The renderFinished semaphore is indexed
-     * by the acquired image index.
-     *
-     * Additionally, imagesInFlight tracks which fence is associated with each
-     * swapchain image, so we can wait if a specific image is still in use.
+     * by the acquired image index: acquiring an image again means its last
+     * present, and so its wait on that semaphore, is done.
      *
      * Usage:
-     *   frameSync.AdvanceFrame();
-     *   frameSync.WaitForCurrentFrame();
+     *   const uint64_t frame = frameSync.BeginFrame();
+     *   const uint64_t done  = frameSync.GetCompletedFrame();   // >= frame - MAX_FRAMES_IN_FLIGHT
      *
      *   VkSemaphore acquireSem = frameSync.GetNextAcquireSemaphore();
      *   vkAcquireNextImageKHR(..., acquireSem, VK_NULL_HANDLE, &imageIndex);
      *
-     *   frameSync.WaitForImage(imageIndex);
-     *   frameSync.SetImageFence(imageIndex, frameSync.GetInFlightFence());
-     *   frameSync.ResetCurrentFence();
-     *
      *   // record commands...
      *
      *   VkSemaphore renderSem = frameSync.GetRenderFinishedSemaphore(imageIndex);
-     *   // submit: wait acquireSem, signal renderSem, signal inFlightFence
-     *   // present: wait renderSem
+     *   if (frameSync.SubmitFrame(queue, cmd, acquireSem, renderSem)) {   // signals `frame`
+     *       // present: wait renderSem
+     *   }
+     *
+     * Every frame number gets signalled, or a later BeginFrame() waits for it
+     * forever: a frame given up on (the acquire failed) ends with SkipFrame()
+     * instead of SubmitFrame().
      */
     class FrameSync {
     public:
@@ -46,9 +50,26 @@ namespace graphics {
 
         void RecreateForSwapchain(uint32_t newSwapchainImageCount);
 
-        void AdvanceFrame();
-        void WaitForCurrentFrame();
-        void ResetCurrentFence();
+        /**
+         * Start the next frame: blocks until the GPU finished frame
+         * N - MAX_FRAMES_IN_FLIGHT.
+         * @return the new frame's number (1, 2, ...), the value its submit signals
+         */
+        uint64_t BeginFrame();
+
+        /// The frame being recorded (the last BeginFrame's result)
+        uint64_t GetCurrentFrame() const { return currentFrame; }
+
+        /// Latest frame the GPU has finished. Queries the semaphore, so it may move on between calls.
+        uint64_t GetCompletedFrame() { return timeline.GetCompletedValue(); }
+
+        bool IsFrameComplete(uint64_t frame) { return timeline.IsReached(frame); }
+
+        /// Blocks until the GPU finished `frame`. Only for frames already submitted.
+        void WaitForFrame(uint64_t frame);
+
+        /// The graphics timeline, for other queues' submits to wait on a frame value
+        VkSemaphore GetTimelineSemaphore() const { return timeline.Get(); }
 
         /// Get the next acquire semaphore (cycled independently of image index)
         VkSemaphore GetNextAcquireSemaphore();
@@ -58,27 +79,39 @@ namespace graphics {
             return renderFinishedSemaphores[imageIndex];
         }
 
-        VkFence GetInFlightFence() const {
-            return inFlightFences.Current();
-        }
+        /**
+         * Submit the current frame's command buffer: waits for acquireSem at
+         * color attachment output, signals renderFinishedSem and the timeline
+         * value GetCurrentFrame().
+         * @return false if the submit failed. The timeline value is signalled
+         *         anyway, but renderFinishedSem isn't: don't present.
+         */
+        bool SubmitFrame(VkQueue queue, VkCommandBuffer cmd,
+                         VkSemaphore acquireSem, VkSemaphore renderFinishedSem);
 
-        void WaitForImage(uint32_t imageIndex);
-        void SetImageFence(uint32_t imageIndex, VkFence fence);
+        /// End the current frame without a command buffer: signals its timeline value.
+        void SkipFrame(VkQueue queue);
 
     private:
         VkDevice device;
 
-        // Per frame in flight
-        utils::RingBuffer<VkFence> inFlightFences;
+        // Graphics queue timeline: value N = frame N finished
+        TimelineSemaphore timeline;
+        uint64_t currentFrame = 0;
 
         // Per swapchain image
         std::vector<VkSemaphore> acquireSemaphores;
         std::vector<VkSemaphore> renderFinishedSemaphores;
-        std::vector<VkFence> imagesInFlight;
         uint32_t acquireSemaphoreIndex = 0;
 
+        /// One submit signalling the current frame (and renderFinishedSem if not null)
+        VkResult Submit(VkQueue queue, VkCommandBuffer cmd,
+                        VkSemaphore waitSem, VkSemaphore renderFinishedSem);
+        /// Signals the current frame with no command buffer, from the host if even that submit fails
+        void SignalWithoutWork(VkQueue queue, VkSemaphore waitSem);
+
         void CreatePerImageSyncObjects(uint32_t count);
         void DestroyPerImageSyncObjects();
     };
 }
-#endif //KRAKATOA_FRAME_SYNC_H
\ No newline at end of file
+#endif //KRAKATOA_FRAME_SYNC_H
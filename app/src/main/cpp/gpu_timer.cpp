@@ -0,0 +1,86 @@
+#include "gpu_timer.h"
+#include "vk_debug.h"
+#include "android_log.h"
+#include <cassert>
+using namespace graphics;
+
+GpuTimer::GpuTimer(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamily)
+        : device(device) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+    assert(queueFamily < familyCount);
+
+    const uint32_t validBits = families[queueFamily].timestampValidBits;
+    if (validBits == 0) {
+        LOGI("GpuTimer: queue family %u has no timestamps, GPU timing disabled", queueFamily);
+        return;
+    }
+    validMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+    nsPerTick = properties.limits.timestampPeriod;
+
+    // Per slot: the first timestamp plus one per split
+    VkQueryPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = slots.Size() * (MAX_SPLITS + 1);
+    VkResult result = vkCreateQueryPool(device, &poolInfo, nullptr, &queryPool);
+    assert(result == VK_SUCCESS);
+    debug::SetObjectName(device, reinterpret_cast<uint64_t>(queryPool),
+                         VK_OBJECT_TYPE_QUERY_POOL, "GpuTimerQueries");
+    LOGI("GpuTimer created (%.2f ns per tick, %u valid bits)", nsPerTick, validBits);
+}
+
+GpuTimer::~GpuTimer() {
+    if (queryPool != VK_NULL_HANDLE) vkDestroyQueryPool(device, queryPool, nullptr);
+    LOGI("GpuTimer destroyed");
+}
+
+uint32_t GpuTimer::FirstQuery() const {
+    return slots.CurrentIndex() * (MAX_SPLITS + 1);
+}
+
+void GpuTimer::BeginFrame(VkCommandBuffer cmd) {
+    newResults = false;
+    if (!IsSupported()) return;
+    slots.Next();
+    Collect();
+    slots.Current().names.clear();
+    vkCmdResetQueryPool(cmd, queryPool, FirstQuery(), MAX_SPLITS + 1);
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, FirstQuery());
+}
+
+void GpuTimer::Split(VkCommandBuffer cmd, const std::string& name) {
+    if (!IsSupported()) return;
+    Slot& slot = slots.Current();
+    if (slot.names.size() == MAX_SPLITS) return;
+    // Everything recorded so far has finished: the interval's end
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool,
+                        FirstQuery() + 1 + static_cast<uint32_t>(slot.names.size()));
+    slot.names.push_back(name);
+}
+
+void GpuTimer::Collect() {
+    const Slot& slot = slots.Current();
+    if (slot.names.empty()) return;   // never used, or nothing split
+
+    uint64_t ticks[MAX_SPLITS + 1];
+    const auto count = static_cast<uint32_t>(slot.names.size() + 1);
+    VkResult result = vkGetQueryPoolResults(device, queryPool, FirstQuery(), count,
+                                            sizeof(ticks), ticks, sizeof(uint64_t),
+                                            VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS) return;   // VK_NOT_READY: keep the previous results
+
+    intervals.resize(slot.names.size());
+    totalMs = 0.0f;
+    for (size_t i = 0; i < slot.names.size(); ++i) {
+        const uint64_t delta = (ticks[i + 1] - ticks[i]) & validMask;
+        intervals[i].name = slot.names[i];
+        intervals[i].ms = static_cast<float>(delta * static_cast<double>(nsPerTick) * 1e-6);
+        totalMs += intervals[i].ms;
+    }
+    newResults = true;
+}
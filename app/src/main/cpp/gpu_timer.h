@@ -0,0 +1,85 @@
+#ifndef KRAKATOA_GPU_TIMER_H
+#define KRAKATOA_GPU_TIMER_H
+#include <vulkan/vulkan.h>
+#include <string>
+#include <vector>
+#include "ring_buffer.h"
+namespace graphics {
+
+    /**
+     * GPU time of the parts of a frame, from timestamp queries.
+     *
+     * Every frame writes a timestamp at BeginFrame() and one per Split(); the
+     * time between two consecutive ones is the named interval. Results are
+     * read without waiting when the frame's query slot comes around again,
+     * MAX_FRAMES_IN_FLIGHT frames later, so they lag by that much.
+     *
+     * Timestamps go between render passes: on tilers a timestamp inside one
+     * only says when the commands were binned.
+     *
+     * Usage:
+     *   GpuTimer timer(device, physicalDevice, graphicsFamily);
+     *   // per frame, after FrameSync::BeginFrame
+     *   timer.BeginFrame(cmd);
+     *   ... offscreen pass
+     *   timer.Split(cmd, "Offscreen");
+     *   ... compose pass
+     *   timer.Split(cmd, "Compose");
+     *   float ms = timer.GetTotalMs();   // of an earlier frame
+     */
+    class GpuTimer {
+    public:
+        /// Intervals per frame
+        static constexpr uint32_t MAX_SPLITS = 16;
+
+        struct Interval {
+            std::string name;
+            float ms = 0.0f;
+        };
+
+        GpuTimer(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamily);
+        ~GpuTimer();
+
+        GpuTimer(const GpuTimer&) = delete;
+        GpuTimer& operator=(const GpuTimer&) = delete;
+
+        /// Whether the queue writes timestamps at all. When not, every call is a no-op.
+        bool IsSupported() const { return queryPool != VK_NULL_HANDLE; }
+
+        /**
+         * Collects the results of the frame that used this slot last (it
+         * has finished: call after FrameSync::BeginFrame), resets the slot's
+         * queries and writes the frame's first timestamp. Outside render passes.
+         */
+        void BeginFrame(VkCommandBuffer cmd);
+
+        /// Ends interval `name`, started by the previous Split() or BeginFrame(). Outside render passes.
+        void Split(VkCommandBuffer cmd, const std::string& name);
+
+        /// Intervals of the latest completed frame measured; empty before the first one.
+        const std::vector<Interval>& GetIntervals() const { return intervals; }
+        /// Their sum
+        float GetTotalMs() const { return totalMs; }
+        /// Whether GetIntervals() changed in the last BeginFrame()
+        bool HasNewResults() const { return newResults; }
+
+    private:
+        struct Slot {
+            std::vector<std::string> names;   // one per Split, query i + 1 ends names[i]
+        };
+
+        VkDevice device;
+        VkQueryPool queryPool = VK_NULL_HANDLE;
+        float nsPerTick = 1.0f;
+        uint64_t validMask = ~0ull;
+        utils::RingBuffer<Slot> slots;
+
+        std::vector<Interval> intervals;
+        float totalMs = 0.0f;
+        bool newResults = false;
+
+        uint32_t FirstQuery() const;
+        void Collect();
+    };
+}
+#endif //KRAKATOA_GPU_TIMER_H
@@ -7,7 +7,7 @@ namespace io {
     void LoadImage(const std::string& path, std::vector<uint8_t>& output, VkFormat& format, int& width, int& height)
     {
         //TODO: Load the bytes using asset loader
-        std::vector<uint8_t> bytes = io::AssetLoader::loadFile(path);
+        io::AssetView bytes = io::AssetLoader::openView(path);
         int channelsInFile = -1;
         //TODO: Read with stb
         unsigned char* data = stbi_load_from_memory(bytes.data(),bytes.size(), &width, &height, &channelsInFile, 4);
@@ -0,0 +1,275 @@
+#include "ktx2_loader.h"
+#include "texture_transcoder.h"
+#include "asset_loader.h"
+#include "android_log.h"
+#include <cstring>
+#include <algorithm>
+
+namespace io {
+    namespace {
+        const uint8_t KTX2_IDENTIFIER[12] = {
+            0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'
+        };
+
+        struct Ktx2Header {
+            uint8_t  identifier[12];
+            uint32_t vkFormat;
+            uint32_t typeSize;
+            uint32_t pixelWidth;
+            uint32_t pixelHeight;
+            uint32_t pixelDepth;
+            uint32_t layerCount;
+            uint32_t faceCount;
+            uint32_t levelCount;
+            uint32_t supercompressionScheme;
+            uint32_t dfdByteOffset;
+            uint32_t dfdByteLength;
+            uint32_t kvdByteOffset;
+            uint32_t kvdByteLength;
+            uint64_t sgdByteOffset;
+            uint64_t sgdByteLength;
+        };
+        static_assert(sizeof(Ktx2Header) == 80, "KTX2 header must be 80 bytes");
+
+        struct Ktx2LevelIndex {
+            uint64_t byteOffset;
+            uint64_t byteLength;
+            uint64_t uncompressedByteLength;
+        };
+
+        /// Texel block of a format: 1x1 for the uncompressed ones
+        struct BlockInfo {
+            uint32_t width;
+            uint32_t height;
+            uint32_t bytes;   // 0 = format not known
+        };
+
+        BlockInfo GetBlockInfo(VkFormat format) {
+            switch (format) {
+                case VK_FORMAT_R8_UNORM:
+                case VK_FORMAT_R8_SRGB:                   return {1, 1, 1};
+                case VK_FORMAT_R8G8_UNORM:
+                case VK_FORMAT_R8G8_SRGB:
+                case VK_FORMAT_R16_UNORM:
+                case VK_FORMAT_R16_SFLOAT:                return {1, 1, 2};
+                case VK_FORMAT_R8G8B8_UNORM:
+                case VK_FORMAT_R8G8B8_SRGB:
+                case VK_FORMAT_B8G8R8_UNORM:
+                case VK_FORMAT_B8G8R8_SRGB:               return {1, 1, 3};
+                case VK_FORMAT_R8G8B8A8_UNORM:
+                case VK_FORMAT_R8G8B8A8_SRGB:
+                case VK_FORMAT_B8G8R8A8_UNORM:
+                case VK_FORMAT_B8G8R8A8_SRGB:
+                case VK_FORMAT_R16G16_UNORM:
+                case VK_FORMAT_R16G16_SFLOAT:
+                case VK_FORMAT_R32_SFLOAT:                return {1, 1, 4};
+                case VK_FORMAT_R16G16B16_SFLOAT:          return {1, 1, 6};
+                case VK_FORMAT_R16G16B16A16_UNORM:
+                case VK_FORMAT_R16G16B16A16_SFLOAT:
+                case VK_FORMAT_R32G32_SFLOAT:             return {1, 1, 8};
+                case VK_FORMAT_R32G32B32_SFLOAT:          return {1, 1, 12};
+                case VK_FORMAT_R32G32B32A32_SFLOAT:       return {1, 1, 16};
+                case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+                case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+                case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+                case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+                case VK_FORMAT_BC4_UNORM_BLOCK:
+                case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+                case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+                case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+                case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+                case VK_FORMAT_EAC_R11_UNORM_BLOCK:       return {4, 4, 8};
+                case VK_FORMAT_BC2_UNORM_BLOCK:
+                case VK_FORMAT_BC2_SRGB_BLOCK:
+                case VK_FORMAT_BC3_UNORM_BLOCK:
+                case VK_FORMAT_BC3_SRGB_BLOCK:
+                case VK_FORMAT_BC5_UNORM_BLOCK:
+                case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+                case VK_FORMAT_BC7_UNORM_BLOCK:
+                case VK_FORMAT_BC7_SRGB_BLOCK:
+                case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+                case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+                case VK_FORMAT_EAC_R11G11_UNORM_BLOCK:    return {4, 4, 16};
+                // ASTC: always 16 bytes, the block footprint varies
+                case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+                case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:       return {4, 4, 16};
+                case VK_FORMAT_ASTC_5x5_UNORM_BLOCK:
+                case VK_FORMAT_ASTC_5x5_SRGB_BLOCK:       return {5, 5, 16};
+                case VK_FORMAT_ASTC_6x6_UNORM_BLOCK:
+                case VK_FORMAT_ASTC_6x6_SRGB_BLOCK:       return {6, 6, 16};
+                case VK_FORMAT_ASTC_8x8_UNORM_BLOCK:
+                case VK_FORMAT_ASTC_8x8_SRGB_BLOCK:       return {8, 8, 16};
+                case VK_FORMAT_ASTC_10x10_UNORM_BLOCK:
+                case VK_FORMAT_ASTC_10x10_SRGB_BLOCK:     return {10, 10, 16};
+                case VK_FORMAT_ASTC_12x12_UNORM_BLOCK:
+                case VK_FORMAT_ASTC_12x12_SRGB_BLOCK:     return {12, 12, 16};
+                default:                                  return {1, 1, 0};
+            }
+        }
+
+        /// Buffer offsets for vkCmdCopyBufferToImage must be a multiple of the
+        /// texel block size and of 4: the least common multiple of the two
+        size_t LevelAlignment(const BlockInfo& block) {
+            size_t alignment = block.bytes;
+            while (alignment % 4 != 0) alignment += block.bytes;
+            return alignment;
+        }
+
+        size_t AlignUp(size_t value, size_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    }
+
+    bool LoadKtx2(const std::string& path, Ktx2Texture& out) {
+        AssetView bytes = AssetLoader::openView(path);
+        if (bytes.size() < sizeof(Ktx2Header)) {
+            LOGE("KTX2: %s is missing or truncated", path.c_str());
+            return false;
+        }
+        Ktx2Header header;
+        memcpy(&header, bytes.data(), sizeof(header));
+        if (memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) {
+            LOGE("KTX2: %s has a bad identifier", path.c_str());
+            return false;
+        }
+        if (header.supercompressionScheme != 0) {
+            LOGE("KTX2: %s uses supercompression scheme %u, not supported",
+                 path.c_str(), header.supercompressionScheme);
+            return false;
+        }
+        if (header.vkFormat == VK_FORMAT_UNDEFINED) {
+            LOGE("KTX2: %s has no vkFormat (Basis payload?), not supported", path.c_str());
+            return false;
+        }
+        if (header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1 ||
+            header.pixelWidth == 0 || header.pixelHeight == 0) {
+            LOGE("KTX2: %s is not a plain 2D texture", path.c_str());
+            return false;
+        }
+
+        const BlockInfo block = GetBlockInfo(static_cast<VkFormat>(header.vkFormat));
+        if (block.bytes == 0) {
+            LOGE("KTX2: %s has vkFormat %u, whose texel size is not known", path.c_str(), header.vkFormat);
+            return false;
+        }
+        // levelCount 0 means "generate mips at load time"; we just use the base.
+        const uint32_t levelCount = std::max(1u, header.levelCount);
+        uint32_t maxLevels = 1;
+        while ((std::max(header.pixelWidth, header.pixelHeight) >> maxLevels) > 0) maxLevels++;
+        if (levelCount > maxLevels) {
+            LOGE("KTX2: %s has %u levels, a %ux%u chain has %u", path.c_str(), levelCount,
+                 header.pixelWidth, header.pixelHeight, maxLevels);
+            return false;
+        }
+        const size_t indexEnd = sizeof(Ktx2Header) + levelCount * sizeof(Ktx2LevelIndex);
+        if (bytes.size() < indexEnd) {
+            LOGE("KTX2: %s level index is truncated", path.c_str());
+            return false;
+        }
+        std::vector<Ktx2LevelIndex> index(levelCount);
+        memcpy(index.data(), bytes.data() + sizeof(Ktx2Header),
+               levelCount * sizeof(Ktx2LevelIndex));
+
+        // Repack: KTX2 stores the smallest mip first, we want the largest first
+        // and every level aligned for the buffer-to-image copy.
+        // Each level must hold exactly its blocks: the transcoder reads them without checking.
+        const size_t alignment = LevelAlignment(block);
+        size_t total = 0;
+        for (uint32_t i = 0; i < levelCount; i++) {
+            const Ktx2LevelIndex& level = index[i];
+            if (level.byteOffset > bytes.size() || level.byteLength > bytes.size() - level.byteOffset) {
+                LOGE("KTX2: %s level data out of bounds", path.c_str());
+                return false;
+            }
+            const uint64_t blocksX = (std::max(1u, header.pixelWidth >> i) + block.width - 1) / block.width;
+            const uint64_t blocksY = (std::max(1u, header.pixelHeight >> i) + block.height - 1) / block.height;
+            if (level.byteLength != blocksX * blocksY * block.bytes) {
+                LOGE("KTX2: %s level %u is %llu bytes, expected %llu", path.c_str(), i,
+                     static_cast<unsigned long long>(level.byteLength),
+                     static_cast<unsigned long long>(blocksX * blocksY * block.bytes));
+                return false;
+            }
+            total = AlignUp(total, alignment);
+            total += level.byteLength;
+        }
+
+        out.format = static_cast<VkFormat>(header.vkFormat);
+        out.width  = header.pixelWidth;
+        out.height = header.pixelHeight;
+        out.data.assign(total, 0);
+        out.levels.clear();
+        size_t offset = 0;
+        for (uint32_t i = 0; i < levelCount; i++) {
+            offset = AlignUp(offset, alignment);
+            memcpy(out.data.data() + offset, bytes.data() + index[i].byteOffset, index[i].byteLength);
+            graphics::MipLevel level{};
+            level.offset = offset;
+            level.width  = std::max(1u, header.pixelWidth >> i);
+            level.height = std::max(1u, header.pixelHeight >> i);
+            out.levels.push_back(level);
+            offset += index[i].byteLength;
+        }
+        LOGI("KTX2: loaded %s %ux%u format=%d levels=%u (%zu bytes)",
+             path.c_str(), out.width, out.height, out.format, levelCount, out.data.size());
+        return true;
+    }
+
+    bool PeekKtx2Format(const std::string& path, VkFormat& format) {
+        AssetView bytes = AssetLoader::openView(path);
+        if (bytes.size() < sizeof(Ktx2Header)) {
+            return false;
+        }
+        Ktx2Header header;
+        memcpy(&header, bytes.data(), sizeof(header));
+        if (memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0 ||
+            header.supercompressionScheme != 0) {
+            return false;
+        }
+        format = static_cast<VkFormat>(header.vkFormat);
+        return format != VK_FORMAT_UNDEFINED;
+    }
+
+    bool IsFormatSampleable(VkPhysicalDevice physicalDevice, VkFormat format) {
+        VkFormatProperties props{};
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
+        const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT |
+                                              VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT |
+                                              VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+        return (props.optimalTilingFeatures & required) == required;
+    }
+
+    bool LoadKtx2Texture(VkPhysicalDevice physicalDevice,
+                         const std::vector<std::string>& candidates,
+                         Ktx2Texture& out) {
+        // First pass: a format the GPU samples natively.
+        for (const auto& path : candidates) {
+            if (!AssetLoader::exists(path)) {
+                continue;
+            }
+            Ktx2Texture texture;
+            if (!LoadKtx2(path, texture)) {
+                continue;
+            }
+            if (IsFormatSampleable(physicalDevice, texture.format)) {
+                out = std::move(texture);
+                return true;
+            }
+            LOGI("KTX2: format %d of %s not supported by the device", texture.format, path.c_str());
+        }
+        // Second pass: expand something we can decode on the CPU.
+        for (const auto& path : candidates) {
+            if (!AssetLoader::exists(path)) {
+                continue;
+            }
+            Ktx2Texture texture;
+            if (!LoadKtx2(path, texture) || !CanTranscodeToRGBA8(texture.format)) {
+                continue;
+            }
+            if (TranscodeToRGBA8(texture, out)) {
+                LOGW("KTX2: %s decoded on the CPU to format %d", path.c_str(), out.format);
+                return true;
+            }
+        }
+        return false;
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef KRAKATOA_KTX2_LOADER_H
+#define KRAKATOA_KTX2_LOADER_H
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "texture2d.h"
+namespace io {
+    /**
+     * A KTX2 texture read into memory: the vkFormat from the header plus the
+     * whole mip chain packed in one blob, largest level first. Level offsets are
+     * aligned so the blob can be uploaded as-is with one staging buffer.
+     */
+    struct Ktx2Texture {
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        uint32_t width  = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> data;
+        std::vector<graphics::MipLevel> levels;
+    };
+
+    /**
+     * Parses a KTX2 file from the assets. Only 2D, single layer, single face
+     * textures without supercompression are accepted (BasisLZ/UASTC payloads
+     * need a Basis transcoder, which we don't ship).
+     * @return false (and logs why) if the file is missing or not supported
+     */
+    bool LoadKtx2(const std::string& path, Ktx2Texture& out);
+
+    /// Reads only the header's vkFormat. @return false if not a usable KTX2
+    bool PeekKtx2Format(const std::string& path, VkFormat& format);
+
+    /**
+     * Whether the device can sample the format with linear filtering and
+     * copy into it, which is all Texture2D needs.
+     */
+    bool IsFormatSampleable(VkPhysicalDevice physicalDevice, VkFormat format);
+
+    /**
+     * Picks the first candidate file whose block format the device supports.
+     * The candidates are usually the same texture encoded for different GPU
+     * families, in order of preference, e.g.
+     *   {"textures/grid.astc.ktx2", "textures/grid.etc2.ktx2", "textures/grid.bc3.ktx2"}
+     * If the device supports none of them the first one the CPU transcoder knows
+     * how to decode is expanded to RGBA8, so the texture still loads (just
+     * without the memory savings).
+     * @return false if no candidate could be loaded at all
+     */
+    bool LoadKtx2Texture(VkPhysicalDevice physicalDevice,
+                         const std::vector<std::string>& candidates,
+                         Ktx2Texture& out);
+}
+#endif //KRAKATOA_KTX2_LOADER_H
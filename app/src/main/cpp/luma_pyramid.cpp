@@ -0,0 +1,117 @@
+#include "luma_pyramid.h"
+#include <algorithm>
+#include <cassert>
+using namespace utils;
+
+namespace {
+    size_t AlignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+LumaPyramidBuilder::LumaPyramidBuilder(uint32_t levelCount, PyramidFilter filter, const YuvRowKernels& kernels)
+        : levelCount(std::clamp(levelCount, 1u, MAX_LEVELS)), filter(filter), kernels(kernels) {
+}
+
+// ============================================================
+// Pool
+// ============================================================
+
+std::shared_ptr<LumaPyramid> LumaPyramidBuilder::Acquire(uint32_t width, uint32_t height) {
+    std::shared_ptr<LumaPyramid> pyramid;
+    for (auto& candidate : pool) {
+        // Only the pool holds it: no consumer is reading, and it isn't Latest()
+        if (candidate.use_count() == 1) {
+            pyramid = candidate;
+            break;
+        }
+    }
+    if (!pyramid) {
+        pyramid = std::make_shared<LumaPyramid>();
+        pool.push_back(pyramid);
+    }
+
+    // Lay the levels out again only if the frame size changed
+    const bool sameLayout = !pyramid->levels.empty() &&
+                            pyramid->levels[0].width == width / 2 && pyramid->levels[0].height == height / 2;
+    if (!sameLayout) {
+        pyramid->levels.clear();
+        std::vector<size_t> offsets;
+        size_t total = 0;
+        uint32_t w = width;
+        uint32_t h = height;
+        for (uint32_t i = 0; i < levelCount && w >= 2 && h >= 2; ++i) {
+            w /= 2;
+            h /= 2;
+            PlaneView level;
+            level.width  = w;
+            level.height = h;
+            level.stride = AlignUp(w, ROW_ALIGNMENT);
+            offsets.push_back(total);
+            total += level.stride * h;
+            pyramid->levels.push_back(level);
+        }
+        pyramid->memory.assign(total, 0);
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            pyramid->levels[i].data = pyramid->memory.data() + offsets[i];
+        }
+    }
+    return pyramid;
+}
+
+std::shared_ptr<const LumaPyramid> LumaPyramidBuilder::Latest() const {
+    std::lock_guard<std::mutex> lock(latestMutex);
+    return latest;
+}
+
+// ============================================================
+// Build
+// ============================================================
+
+std::shared_ptr<const LumaPyramid> LumaPyramidBuilder::Build(const uint8_t* y, size_t stride,
+                                                               uint32_t width, uint32_t height,
+                                                               int64_t timestamp) {
+    assert(y != nullptr);
+    std::shared_ptr<LumaPyramid> pyramid = Acquire(width, height);
+    pyramid->timestamp = timestamp;
+    pyramid->filter    = filter;
+
+    PlaneView source;
+    source.data   = y;
+    source.width  = width;
+    source.height = height;
+    source.stride = stride;
+    for (const PlaneView& level : pyramid->levels) {
+        Downsample(source, level);
+        source = level;
+    }
+
+    std::lock_guard<std::mutex> lock(latestMutex);
+    latest = pyramid;
+    return pyramid;
+}
+
+void LumaPyramidBuilder::Downsample(const PlaneView& src, const PlaneView& dst) {
+    auto* out = const_cast<uint8_t*>(dst.data);   // the builder owns the memory
+    if (filter == PyramidFilter::Box) {
+        Downsample2xLuma(out, dst.stride, src.data, src.stride, dst.width, dst.height, kernels);
+        return;
+    }
+
+    // Binomial: vertical [1 3 3 1] into a u16 row, then the horizontal pass
+    // halves it. Taps past the edges repeat the edge row / column.
+    columnSums.resize(static_cast<size_t>(src.width) + 2);
+    uint16_t* sums = columnSums.data() + 1;   // sums[-1] and sums[width] are the padding
+    const uint32_t lastRow = src.height - 1;
+    for (uint32_t row = 0; row < dst.height; ++row) {
+        const uint32_t center = 2 * row;
+        const uint8_t* r0 = src.Row(center == 0 ? 0 : center - 1);
+        const uint8_t* r1 = src.Row(center);
+        const uint8_t* r2 = src.Row(std::min(center + 1, lastRow));
+        const uint8_t* r3 = src.Row(std::min(center + 2, lastRow));
+        kernels.binomialColumns(sums, r0, r1, r2, r3, src.width);
+        sums[-1]        = sums[0];
+        sums[src.width] = sums[src.width - 1];
+        kernels.binomialRow(out + row * dst.stride, sums, dst.width);
+    }
+}
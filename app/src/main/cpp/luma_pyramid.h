@@ -0,0 +1,100 @@
+#ifndef KRAKATOA_LUMA_PYRAMID_H
+#define KRAKATOA_LUMA_PYRAMID_H
+#include "yuv_convert.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+namespace utils {
+    /// How each level is made from the one above.
+    enum class PyramidFilter : uint8_t {
+        Box,        ///< 2x2 average: cheapest, slight aliasing
+        Binomial    ///< separable [1 3 3 1] / 8: Gaussian-like, what detectors expect
+    };
+
+    /// A read-only R8 image inside someone else's memory.
+    struct PlaneView {
+        const uint8_t* data   = nullptr;
+        uint32_t       width  = 0;
+        uint32_t       height = 0;
+        size_t         stride = 0;   // bytes between rows
+
+        const uint8_t* Row(uint32_t y) const { return data + y * stride; }
+    };
+
+    /**
+     * The downscaled Y planes of one camera frame: level 0 is 1/2 the frame,
+     * level 1 is 1/4, and so on. Immutable once built; hold the shared_ptr
+     * LumaPyramidBuilder hands out for as long as the views are read.
+     */
+    class LumaPyramid {
+    public:
+        uint32_t         LevelCount() const { return static_cast<uint32_t>(levels.size()); }
+        /// Level i is 1 / 2^(i+1) of the source in each direction.
+        const PlaneView& Level(uint32_t index) const { return levels[index]; }
+        int64_t          Timestamp() const { return timestamp; }
+        PyramidFilter    Filter() const { return filter; }
+
+    private:
+        friend class LumaPyramidBuilder;
+        std::vector<uint8_t>   memory;   // all levels, rows padded to ROW_ALIGNMENT
+        std::vector<PlaneView> levels;
+        int64_t                timestamp = 0;
+        PyramidFilter          filter = PyramidFilter::Box;
+    };
+
+    /**
+     * Builds a LumaPyramid from a Y plane once per camera frame, so every
+     * vision consumer (marker detection, blur / exposure checks) reads the
+     * same scaled images instead of rescaling on its own.
+     *
+     * Pyramids come from a pool: Build() reuses one no consumer holds any
+     * more, allocating only when all are in use or the frame size changed.
+     * The levels are written with the SIMD kernels of yuv_convert.h.
+     *
+     * Build() is for one thread at a time; Latest() can be called from any.
+     *
+     * Usage:
+     *   utils::LumaPyramidBuilder builder(4, utils::PyramidFilter::Binomial);
+     *   builder.Build(frame.yPlane, frame.yRowStride, frame.width, frame.height, frame.timestamp);
+     *   ...
+     *   if (auto pyramid = builder.Latest()) {
+     *       const utils::PlaneView& quarter = pyramid->Level(1);
+     *   }
+     */
+    class LumaPyramidBuilder {
+    public:
+        static constexpr uint32_t MAX_LEVELS    = 4;    // 1/2 .. 1/16
+        static constexpr size_t   ROW_ALIGNMENT = 64;   // cache line
+
+        explicit LumaPyramidBuilder(uint32_t levelCount = MAX_LEVELS,
+                                    PyramidFilter filter = PyramidFilter::Box,
+                                    const YuvRowKernels& kernels = BestYuvKernels());
+
+        /// Scales the plane down into a pooled pyramid, which also becomes Latest().
+        std::shared_ptr<const LumaPyramid> Build(const uint8_t* y, size_t stride,
+                                                 uint32_t width, uint32_t height, int64_t timestamp);
+
+        /// The last pyramid built, or nullptr before the first Build().
+        std::shared_ptr<const LumaPyramid> Latest() const;
+
+        /// Pyramids allocated so far (in use + free).
+        uint32_t PoolSize() const { return static_cast<uint32_t>(pool.size()); }
+
+    private:
+        /// A pooled pyramid nobody else references, laid out for width x height.
+        std::shared_ptr<LumaPyramid> Acquire(uint32_t width, uint32_t height);
+        void Downsample(const PlaneView& src, const PlaneView& dst);
+
+        uint32_t             levelCount;
+        PyramidFilter        filter;
+        const YuvRowKernels& kernels;
+        std::vector<std::shared_ptr<LumaPyramid>> pool;
+        std::vector<uint16_t> columnSums;   // Binomial: one row of vertical sums, padded
+
+        mutable std::mutex           latestMutex;
+        std::shared_ptr<LumaPyramid> latest;
+    };
+}
+#endif //KRAKATOA_LUMA_PYRAMID_H
@@ -10,8 +10,8 @@ using namespace io;
 MeshData MeshLoader::Load(const std::string& assetPath) {
     MeshData result;
 
-    // Load raw bytes from APK assets
-    std::vector<uint8_t> fileData = AssetLoader::loadFile(assetPath);
+    // Map raw bytes from APK assets, Assimp parses them in place
+    AssetView fileData = AssetLoader::openView(assetPath);
     if (fileData.empty()) {
         LOGE("MeshLoader: failed to load asset '%s'", assetPath.c_str());
         return result;
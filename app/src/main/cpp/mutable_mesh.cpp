@@ -45,6 +45,13 @@ void graphics::MutableMesh::UpdateMesh(const float* verts, uint32_t vc,
     pendingVertices.assign(verts, verts + vc * 8);
     pendingIndices.assign(idx, idx + ic);
     pendingGeneration++;
+    // Position is the first 3 of the 8 floats of a vertex
+    boundsMin = boundsMax = vc > 0 ? glm::vec3(verts[0], verts[1], verts[2]) : glm::vec3(0.0f);
+    for (uint32_t i = 1; i < vc; ++i) {
+        const glm::vec3 position(verts[i * 8], verts[i * 8 + 1], verts[i * 8 + 2]);
+        boundsMin = glm::min(boundsMin, position);
+        boundsMax = glm::max(boundsMax, position);
+    }
 }
 
 void graphics::MutableMesh::AdvanceRingBuffers() {
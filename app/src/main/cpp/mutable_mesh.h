@@ -4,6 +4,7 @@
 #include "vk_mem_alloc.h"
 #include "mesh.h"
 #include "ring_buffer.h"
+#include <glm/glm.hpp>
 namespace graphics {
     class CommandPoolManager;
     class MutableMesh : public Mesh {
@@ -22,6 +23,9 @@ namespace graphics {
         uint32_t GetVertexCount() const { return vertexCount.Current(); }
         void UpdateMesh(const float* vertices, uint32_t vertexCount,
                         const uint32_t* indices, uint32_t indexCount);
+        /**Model-space bounding box of the positions passed to the last UpdateMesh.*/
+        const glm::vec3& GetBoundsMin() const { return boundsMin; }
+        const glm::vec3& GetBoundsMax() const { return boundsMax; }
     private:
         /**One vertex buffer per frame*/
         utils::RingBuffer<VkBuffer> vertexBuffer;
@@ -49,6 +53,9 @@ namespace graphics {
         std::vector<uint32_t> pendingIndices;
         /**Whenever we update the mesh we increase the generation.*/
         uint64_t pendingGeneration = 0;
+        /**Bounds of pendingVertices*/
+        glm::vec3 boundsMin{0.0f};
+        glm::vec3 boundsMax{0.0f};
         void AdvanceRingBuffers();
         void UpdateCurrentSlotIfPending();
         void UploadToCurrentSlot();
@@ -3,10 +3,13 @@
 #include <cassert>
 #include <android/native_window_jni.h>
 #include <memory>
+#include <atomic>
+#include <algorithm>
+#include <thread>
+#include <mutex>
 #include "android_log.h"
 #include "ar_loader.h"
 #include "vk_context.h"
-#include "swap_chain_render_pass.h"
 #include "pipeline.h"
 #include "pipeline_layout.h"
 #include <unordered_map>
@@ -23,36 +26,276 @@
 #include "frame_timer.h"
 #include "ar_manager.h"
 #include "egl_dummy_context.h"
-#include "offscreen_render_pass.h"
+#include "render_graph.h"
 #include "ar_camera_image.h"
+#include "thread_pool.h"
+#include "luma_pyramid.h"
 #include "mesh.h"
 #include "mutable_mesh.h"
 #include "concatenate.h"
 #include "texture2d.h"
-#include "image_load.h"
+#include "resource_cache.h"
+#include "draw_list.h"
+#include "gpu_timer.h"
+#include "dynamic_resolution.h"
+#include "temporal_upscaler.h"
+#include "damage_region.h"
+#include "prerecorded_draw.h"
 #include <glm/gtc/type_ptr.hpp>
 std::unique_ptr<graphics::VkContext> gVkContext = nullptr;
-std::unique_ptr<graphics::SwapchainRenderPass> gSwapChainRenderPass = nullptr;
-std::unique_ptr<graphics::OffscreenRenderPass> gOffscreenRenderPass = nullptr;
+// The frame's passes and their attachments, compiled for the swapchain size in onSurfaceChanged
+std::unique_ptr<graphics::RenderGraph> gRenderGraph = nullptr;
+graphics::RenderGraph::ResourceId gBackbuffer = 0;
+graphics::RenderGraph::ResourceId gOffscreenColor = 0;
+graphics::RenderGraph::PassId gOffscreenPass = 0;
+graphics::RenderGraph::PassId gCameraBgPass = 0;
+graphics::RenderGraph::PassId gComposePass = 0;
+graphics::RenderGraph::PassId gTemporalResolvePass = graphics::RenderGraph::NONE;
+// Compose as a subpass reading the offscreen color as input attachment (one render pass, the
+// offscreen color never written to memory) or as a separate pass sampling it. Needs
+// compose_input.frag.spv; switched from the UI thread, applied at the start of a frame.
+bool gComposeInSubpass = false;
+std::atomic<bool> gComposeInSubpassRequested{false};
+// GPU time of every graph step, and the offscreen layer's render scale picked from it. The
+// scale only applies with the sampled compose (and compose_scaled.frag.spv): as a subpass the
+// layer shares the backbuffer's render area.
+std::unique_ptr<graphics::GpuTimer> gGpuTimer = nullptr;
+std::unique_ptr<graphics::DynamicResolution> gDynamicResolution = nullptr;
+bool gDynamicResolutionActive = false;
+// Temporal upscaling of the offscreen layer: jittered renders accumulated at full resolution by a
+// compute resolve, which the compose then samples instead of the offscreen color. Sampled compose
+// only, needs taa_resolve.comp.spv; switched from the UI thread like the compose mode.
+bool gTemporalUpscaling = false;
+std::atomic<bool> gTemporalUpscalingRequested{false};
+std::unique_ptr<graphics::TemporalUpscaler> gTemporalUpscaler = nullptr;
+// Frames between two logs of the GPU time per graph step
+constexpr uint64_t GPU_REPORT_FRAMES = 600;
+// Screen bounds of the AR draws: the offscreen and compose passes only shade that rectangle,
+// and are skipped without any. Pixels they shade against full-screen passes, for the log.
+graphics::DamageRegion gDamage;
+struct FillStats {
+    uint64_t fullPixels = 0;
+    uint64_t shadedPixels = 0;
+    uint32_t emptyFrames = 0;
+    uint32_t frames = 0;
+} gFillStats;
 std::unique_ptr<graphics::Pipeline> gUnshadedOpaquePipeline = nullptr;
 std::unique_ptr<graphics::Pipeline> gTransparentPhongPipeline = nullptr;
 std::unique_ptr<graphics::Pipeline> gCameraBgPipeline = nullptr;
 std::unique_ptr<graphics::Pipeline> gComposePipeline = nullptr;
+// The fullscreen draws, kept recorded in secondaries per frame slot; recreated with the pipelines
+std::unique_ptr<graphics::PrerecordedDraw> gCameraBgDraw = nullptr;
+std::unique_ptr<graphics::PrerecordedDraw> gComposeDraw = nullptr;
 std::unordered_map<std::string, VkPipelineLayout> pipelineLayouts;
 std::unordered_map<std::string, VkDescriptorSetLayout> descriptorSetLayouts;
 std::unique_ptr<graphics::CommandPoolManager> gCommandPoolManager = nullptr;
 std::unique_ptr<graphics::FrameSync> gFrameSync = nullptr;
-std::unordered_map<std::string, std::unique_ptr<graphics::Mesh>> gMeshes;
+std::unique_ptr<graphics::ResourceCache> gResourceCache = nullptr;
+std::unordered_map<std::string, graphics::MeshHandle> gMeshes;
 std::unique_ptr<graphics::FrameTimer> gFrameTimer = nullptr;
 std::unique_ptr<ar::ARSessionManager> gArSessionManager = nullptr;
 std::unique_ptr<graphics::ARCameraImage> gCameraImage = nullptr;
-std::unique_ptr<graphics::Texture2D> gGridTexture = nullptr;
+// Worker threads for CPU-heavy per-frame work (camera plane copies, Y pyramid)
+std::unique_ptr<utils::ThreadPool> gWorkerPool = nullptr;
+// Scaled Y planes of the latest camera image, for the vision code: gLumaPyramid->Latest()
+std::unique_ptr<utils::LumaPyramidBuilder> gLumaPyramid = nullptr;
+int64_t gLumaPyramidTimestamp = 0;           // camera image the last build was started for
+std::atomic<bool> gLumaPyramidBusy{false};   // a build is running on a worker
+std::mutex gFrameMutex;   // the UI thread's camera release vs. the render thread's frame
+graphics::TextureHandle gGridTexture;
+// Offscreen pass draws, prepared on the render thread and recorded on the workers
+graphics::DrawList gOffscreenDraws;
 //dummy egl context do deal with arcore bullshit. use it before getting each ar frame.
 ar::EglDummyContext m_eglDummy;
-int gDisplayRotation = 0;
 std::unique_ptr<graphics::Renderable> cameraBgQuad = nullptr;
 std::unique_ptr<graphics::Renderable> composeQuad = nullptr;
 std::unordered_map<int64_t, std::shared_ptr<graphics::Renderable>> gArPlanes;
+// The upscaler reads the offscreen layer as a whole: not with the compose in its render pass
+static bool TemporalUpscalingActive() {
+    return gTemporalUpscaling && !gComposeInSubpass;
+}
+// GPU time per graph step, of the timer's latest results
+static void LogGpuIntervals() {
+    for (const auto& interval : gGpuTimer->GetIntervals()) {
+        LOGI("  GPU %s: %.2f ms", interval.name.c_str(), interval.ms);
+    }
+}
+// Drops the ArImages the renderer still holds: ARCore won't pause or resume with them open.
+// Called under gFrameMutex.
+static void ReleaseCameraImages() {
+    if (gCameraImage) {
+        gCameraImage->ReleaseCameraMemory();
+    }
+    // The pyramid build's copy of its frame holds one too
+    while (gLumaPyramidBusy) {
+        std::this_thread::yield();
+    }
+}
+// Limits this frame's offscreen layer passes to gDamage, or turns them off when it's empty
+static void UpdateDamage() {
+    const bool empty = gDamage.IsEmpty();
+    gRenderGraph->SetEnabled(gOffscreenPass, !empty);
+    gRenderGraph->SetEnabled(gComposePass, !empty);
+    if (gTemporalResolvePass != graphics::RenderGraph::NONE) {
+        gRenderGraph->SetEnabled(gTemporalResolvePass, !empty);
+        if (empty) gTemporalUpscaler->Reset();   // what it holds is of content no longer drawn
+    }
+    auto pixels = [](VkExtent2D extent) { return static_cast<uint64_t>(extent.width) * extent.height; };
+    const VkExtent2D layerArea = gRenderGraph->GetRenderArea(gOffscreenPass);
+    const VkExtent2D screen = gRenderGraph->GetExtent();
+    gFillStats.fullPixels += pixels(layerArea) + pixels(screen);
+    gFillStats.frames++;
+    if (empty) {
+        gFillStats.emptyFrames++;
+        return;
+    }
+    // The upscaler reads the whole layer, so it's drawn whole; the compose shades the rect only.
+    // The layer's margin is wider than the compose's: bilinear taps stay inside what was cleared.
+    const VkRect2D composeRect = gDamage.GetRect(screen, 2);
+    gRenderGraph->SetScissor(gComposePass, composeRect);
+    if (gTemporalUpscaler) {
+        gRenderGraph->ResetScissor(gOffscreenPass);
+        gFillStats.shadedPixels += pixels(layerArea);
+    } else {
+        const VkRect2D layerRect = gDamage.GetRect(layerArea, 4);
+        gRenderGraph->SetScissor(gOffscreenPass, layerRect);
+        gFillStats.shadedPixels += pixels(layerRect.extent);
+    }
+    gFillStats.shadedPixels += pixels(composeRect.extent);
+}
+// Declares the frame: which pass reads and writes what. Order, culling, load/store ops and
+// barriers come out of Compile(), so a new effect is one more AddPass here.
+static void DeclareRenderGraph(bool composeInSubpass, bool temporalUpscaling) {
+    assert(!(composeInSubpass && temporalUpscaling) && "the upscaler reads the whole offscreen layer");
+    using PassContext = graphics::RenderGraph::PassContext;
+    gRenderGraph = std::make_unique<graphics::RenderGraph>(gVkContext->GetDevice(), gVkContext->GetAllocator());
+    auto& graph = *gRenderGraph;
+    gBackbuffer = graph.ImportImage("Backbuffer", gVkContext->GetSwapchainFormat(), VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    const auto camera = graph.ImportExternal("CameraImage");
+    gOffscreenColor = graph.CreateAttachment("OffscreenColor", VK_FORMAT_R8G8B8A8_UNORM);
+    const auto offscreenDepth = graph.CreateAttachment("OffscreenDepth", VK_FORMAT_D24_UNORM_S8_UINT);
+
+    // Finish the camera upload begun in onDrawFrame: waits for the worker band copies,
+    // then records the transfer; a no-op when ARCore has no newer camera image.
+    // After this pass the current image is ready to sample.
+    graph.AddPass("CameraUpload")
+            .Write(camera)
+            .Execute([](PassContext& ctx) {
+                gCameraImage->Update(ctx.GetCommandBuffer(), gArSessionManager->getCameraFrame());
+            });
+    // AR planes: the draw list was prepared in onDrawFrame, the commands are recorded
+    // in secondaries on the workers once the list is long enough
+    gOffscreenPass = graph.AddPass("Offscreen")
+            .ClearColor(gOffscreenColor, {{0.0f, 0.0f, 0.0f, 0.0f}})
+            .ClearDepth(offscreenDepth, {1.0f, 0})
+            .Execute([](PassContext& ctx) {
+                gOffscreenDraws.Record(ctx, *gCommandPoolManager, gWorkerPool.get());
+            })
+            .GetId();
+    // This frame's offscreen layer into the upscaler's history, which the compose reads instead
+    graphics::RenderGraph::ResourceId upscaled = graphics::RenderGraph::NONE;
+    if (temporalUpscaling) {
+        upscaled = graph.ImportExternal("TemporalHistory");
+        gTemporalResolvePass = graph.AddPass("TemporalResolve")
+                .Sample(gOffscreenColor, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT)
+                .Write(upscaled)
+                .Execute([](PassContext& ctx) {
+                    gTemporalUpscaler->Record(ctx.GetCommandBuffer(), gRenderGraph->GetImageView(gOffscreenColor),
+                                              gRenderGraph->GetExtent());
+                })
+                .GetId();
+    } else {
+        gTemporalResolvePass = graphics::RenderGraph::NONE;
+    }
+    // Camera background (fullscreen quad with camera texture). Nothing on the backbuffer
+    // is depth tested, so it has no depth attachment: OffscreenDepth is the frame's only one.
+    gCameraBgPass = graph.AddPass("CameraBackground")
+            .ClearColor(gBackbuffer, {{0.0f, 0.0f, 0.0f, 1.0f}})
+            .Read(camera)
+            .Execute([](PassContext& ctx) {
+                gCameraBgDraw->Execute(ctx, *gCameraBgPipeline, cameraBgQuad.get(), gVkContext->GetFrameIndex());
+            })
+            .GetId();
+    // Composite the offscreen render target (AR planes) over the camera background. Read as
+    // input attachment, it pulls the offscreen and camera passes into one render pass.
+    auto compose = graph.AddPass("Compose").WriteColor(gBackbuffer);
+    if (composeInSubpass) {
+        compose.ReadInput(gOffscreenColor);
+    } else if (temporalUpscaling) {
+        compose.Read(upscaled);
+    } else {
+        compose.Sample(gOffscreenColor);
+    }
+    gComposePass = compose
+            .Execute([](PassContext& ctx) {
+                gComposeDraw->Execute(ctx, *gComposePipeline, composeQuad.get(), gVkContext->GetFrameIndex());
+            })
+            .GetId();
+}
+// Compiles the graph for the swapchain size and builds each pipeline for the render pass and
+// subpass its graph pass was compiled into
+static void CompileRenderGraph() {
+    gRenderGraph->Compile(gVkContext->getSwapchainExtent());
+    gRenderGraph->SetGpuTimer(gGpuTimer.get());
+    // The history is at the new size: starts over
+    gTemporalUpscaler = TemporalUpscalingActive()
+                        ? std::make_unique<graphics::TemporalUpscaler>(gVkContext->GetDevice(),
+                                                                       gVkContext->GetAllocator(),
+                                                                       gRenderGraph->GetExtent())
+                        : nullptr;
+    // The upscaler's output is full size whatever the render area: it needs no compose_scaled.frag
+    gDynamicResolutionActive = !gComposeInSubpass && gGpuTimer->IsSupported() &&
+                               (gTemporalUpscaler || io::AssetLoader::exists("shaders/compose_scaled.frag.spv"));
+    const auto& traffic = gRenderGraph->GetAttachmentTraffic();
+    LOGI("Compose %s: %.1f MiB attachment traffic per frame, dynamic resolution %s, temporal upscaling %s",
+         gComposeInSubpass ? "in subpass (input attachment)" : "in its own pass (sampled)",
+         (traffic.read + traffic.written) / (1024.0 * 1024.0), gDynamicResolutionActive ? "on" : "off",
+         gTemporalUpscaler ? "on" : "off");
+    auto forPass = [](graphics::PipelineConfig config, graphics::RenderGraph::PassId pass) {
+        config.subpass = gRenderGraph->GetSubpass(pass);
+        return config;
+    };
+    gUnshadedOpaquePipeline = std::make_unique<graphics::Pipeline>(gRenderGraph->GetRenderPass(gOffscreenPass),
+                                                                   gVkContext->GetDevice(),
+                                                                   gVkContext->GetAllocator(),
+                                                                   forPass(graphics::UnshadedOpaqueConfig(), gOffscreenPass),
+                                                                   pipelineLayouts["unshaded_opaque"],
+                                                                   descriptorSetLayouts["unshaded_opaque"]);
+    gTransparentPhongPipeline = std::make_unique<graphics::Pipeline>(gRenderGraph->GetRenderPass(gOffscreenPass),
+                                                                      gVkContext->GetDevice(),
+                                                                      gVkContext->GetAllocator(),
+                                                                      forPass(graphics::TransparentPhongConfig(gGridTexture),
+                                                                              gOffscreenPass),
+                                                                      pipelineLayouts["transparent_phong"],
+                                                                      descriptorSetLayouts["transparent_phong"]);
+    gCameraBgPipeline = std::make_unique<graphics::Pipeline>(gRenderGraph->GetRenderPass(gCameraBgPass),
+                                                              gVkContext->GetDevice(),
+                                                              gVkContext->GetAllocator(),
+                                                              forPass(graphics::CameraBackgroundConfig(
+                                                                      gCameraImage.get()), gCameraBgPass),
+                                                              pipelineLayouts["camera_bg"],
+                                                              descriptorSetLayouts["camera_bg"]);
+    const char* composeSetLayout = gComposeInSubpass ? "compose_input" : "compose";
+    const char* composeLayout = gDynamicResolutionActive && !gTemporalUpscaler ? "compose_scaled"
+                                                                               : composeSetLayout;
+    auto composeConfig = gTemporalUpscaler
+            ? graphics::ComposeConfig([] { return gTemporalUpscaler->GetOutputView(); })
+            : graphics::ComposeConfig(gRenderGraph.get(), gOffscreenColor, gComposeInSubpass,
+                                      gDynamicResolutionActive ? gOffscreenPass : graphics::RenderGraph::NONE);
+    gComposePipeline = std::make_unique<graphics::Pipeline>(gRenderGraph->GetRenderPass(gComposePass),
+                                                             gVkContext->GetDevice(),
+                                                             gVkContext->GetAllocator(),
+                                                             forPass(composeConfig, gComposePass),
+                                                             pipelineLayouts[composeLayout],
+                                                             descriptorSetLayouts[composeSetLayout]);
+    // New render passes and pipelines: nothing recorded before is of use. The camera background
+    // keeps one recording per camera image slot, the compose one per upscaler output.
+    const uint32_t graphicsFamily = gVkContext->getQueueFamilies().graphicsFamily.value();
+    gCameraBgDraw = std::make_unique<graphics::PrerecordedDraw>(gVkContext->GetDevice(), graphicsFamily,
+                                                                "CameraBackground", MAX_FRAMES_IN_FLIGHT);
+    gComposeDraw = std::make_unique<graphics::PrerecordedDraw>(gVkContext->GetDevice(), graphicsFamily,
+                                                               "Compose", 2);
+}
 extern "C" JNIEXPORT jstring JNICALL
 Java_dev_geronimodesenvolvimentos_krakatoa_MainActivity_stringFromJNI(
         JNIEnv* env,
@@ -72,6 +315,28 @@ Java_dev_geronimodesenvolvimentos_krakatoa_VulkanSurfaceView_nativeOnSurfaceCrea
     AAssetManager* nativeAssetManager = AAssetManager_fromJava(env, asset_manager);
     assert(nativeAssetManager!= nullptr);//i MUST have the asset loader
     io::AssetLoader::initialize(nativeAssetManager);
+    // Packed assets (pack_assets.py), if the APK ships them; loose files otherwise
+    if (io::AssetLoader::exists("assets.kpak")) {
+        io::AssetLoader::mountArchive("assets.kpak");
+    }
+#ifndef NDEBUG
+    // Debug builds only: files pushed to <external files dir>/ override the APK assets
+    // (adb push, no rebuild). A release build loads nothing it didn't ship with.
+    {
+        jclass activityClass = env->GetObjectClass(activity);
+        jmethodID getExternalFilesDir = env->GetMethodID(activityClass, "getExternalFilesDir",
+                                                         "(Ljava/lang/String;)Ljava/io/File;");
+        jobject dir = env->CallObjectMethod(activity, getExternalFilesDir, nullptr);
+        if (dir != nullptr) {
+            jclass fileClass = env->GetObjectClass(dir);
+            jmethodID getAbsolutePath = env->GetMethodID(fileClass, "getAbsolutePath", "()Ljava/lang/String;");
+            auto path = static_cast<jstring>(env->CallObjectMethod(dir, getAbsolutePath));
+            const char* chars = env->GetStringUTFChars(path, nullptr);
+            io::AssetLoader::setExternalStoragePath(chars);
+            env->ReleaseStringUTFChars(path, chars);
+        }
+    }
+#endif
 
     assert(loadedArcore);//i need arcore.
     // Create vulkan context (instance, physical device, device, semaphores, pipelines)
@@ -82,13 +347,16 @@ Java_dev_geronimodesenvolvimentos_krakatoa_VulkanSurfaceView_nativeOnSurfaceCrea
     bool surfaceOk = gVkContext->CreateSurface(window);
     assert(surfaceOk);
     gVkContext->CreateSwapchain(ANativeWindow_getWidth(window), ANativeWindow_getHeight(window));
-    // Create swap chain render pass
-    gSwapChainRenderPass = std::make_unique<graphics::SwapchainRenderPass>(gVkContext->GetDevice(),
-                                                                           gVkContext->GetAllocator(),
-                                                                           gVkContext->GetSwapchainFormat());
-    gOffscreenRenderPass = std::make_unique<graphics::OffscreenRenderPass>(gVkContext->GetDevice(),
-                                                                           gVkContext->GetAllocator(),
-                                                                           100, 100);
+    // The frame's passes; compiled once the surface size is known
+    gComposeInSubpass = io::AssetLoader::exists("shaders/compose_input.frag.spv");
+    gComposeInSubpassRequested = gComposeInSubpass;
+    if (!gComposeInSubpass) {
+        LOGI("compose_input.frag.spv not packaged, compose samples the offscreen color");
+    }
+    if (!graphics::TemporalUpscaler::IsAvailable()) {
+        LOGI("%s not packaged, temporal upscaling disabled", graphics::TemporalUpscaler::SHADER_PATH);
+    }
+    DeclareRenderGraph(gComposeInSubpass, TemporalUpscalingActive());
     auto unshadedOpaqueDescriptorSetLayout = graphics::DescriptorSetLayoutBuilder(gVkContext->GetDevice())
             .AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
             .Build();
@@ -108,12 +376,30 @@ Java_dev_geronimodesenvolvimentos_krakatoa_VulkanSurfaceView_nativeOnSurfaceCrea
             .AddDescriptorSetLayout(transPhongDescriptorSetLayout)
             .Build();
     pipelineLayouts.insert({"transparent_phong", transPhongPipelineLayout});
-    // Camera background: UBO (binding 0) + Y sampler (binding 1) + UV sampler (binding 2)
-    auto cameraBgDescriptorSetLayout = graphics::DescriptorSetLayoutBuilder(gVkContext->GetDevice())
-            .AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
-            .AddBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
-            .AddBinding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
-            .Build();
+    //camera feed -> vulkan image (ring buffered, CPU upload, no OES). Created before the
+    //camera_bg layout because YCbCr mode bakes its conversion sampler into that layout.
+    gCameraImage = std::make_unique<graphics::ARCameraImage>(gVkContext->GetDevice(),
+                                                              gVkContext->getPhysicalDevice(),
+                                                              gVkContext->GetAllocator(),
+                                                              gVkContext->GetCapabilities(),
+                                                              io::AssetLoader::exists("shaders/camera_bg_ycbcr.frag.spv"));
+    gWorkerPool = std::make_unique<utils::ThreadPool>(utils::ThreadPool::DefaultThreadCount(), "krakatoa-work");
+    gCameraImage->SetWorkerPool(gWorkerPool.get());
+    gLumaPyramid = std::make_unique<utils::LumaPyramidBuilder>(utils::LumaPyramidBuilder::MAX_LEVELS,
+                                                               utils::PyramidFilter::Binomial);
+    // Camera background: UBO (binding 0) + Y sampler (binding 1) + UV sampler (binding 2),
+    // or in YCbCr mode UBO + one immutable-sampler YCbCr texture (binding 1)
+    auto cameraBgLayoutBuilder = graphics::DescriptorSetLayoutBuilder(gVkContext->GetDevice());
+    cameraBgLayoutBuilder.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT);
+    if (gCameraImage->UsesYcbcr()) {
+        cameraBgLayoutBuilder.AddBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT,
+                                         1, gCameraImage->GetYcbcrSampler());
+    } else {
+        cameraBgLayoutBuilder
+                .AddBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+                .AddBinding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);
+    }
+    auto cameraBgDescriptorSetLayout = cameraBgLayoutBuilder.Build();
     descriptorSetLayouts.insert({"camera_bg", cameraBgDescriptorSetLayout});
     auto cameraBgPipelineLayout = graphics::PipelineLayoutBuilder(gVkContext->GetDevice())
             .AddDescriptorSetLayout(cameraBgDescriptorSetLayout)
@@ -128,6 +414,21 @@ Java_dev_geronimodesenvolvimentos_krakatoa_VulkanSurfaceView_nativeOnSurfaceCrea
             .AddDescriptorSetLayout(composeDescriptorSetLayout)
             .Build();
     pipelineLayouts.insert({"compose", composePipelineLayout});
+    // Compose as subpass: the offscreen color as input attachment (binding 0, frag)
+    auto composeInputDescriptorSetLayout = graphics::DescriptorSetLayoutBuilder(gVkContext->GetDevice())
+            .AddBinding(0, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT)
+            .Build();
+    descriptorSetLayouts.insert({"compose_input", composeInputDescriptorSetLayout});
+    auto composeInputPipelineLayout = graphics::PipelineLayoutBuilder(gVkContext->GetDevice())
+            .AddDescriptorSetLayout(composeInputDescriptorSetLayout)
+            .Build();
+    pipelineLayouts.insert({"compose_input", composeInputPipelineLayout});
+    // Compose with dynamic resolution: the compose set layout plus UV scale and clamp (frag push constants)
+    auto composeScaledPipelineLayout = graphics::PipelineLayoutBuilder(gVkContext->GetDevice())
+            .AddDescriptorSetLayout(composeDescriptorSetLayout)
+            .AddPushConstantRange(VK_SHADER_STAGE_FRAGMENT_BIT, 0, 4 * sizeof(float))
+            .Build();
+    pipelineLayouts.insert({"compose_scaled", composeScaledPipelineLayout});
     ANativeWindow_release(window);
     //Creates the command pool manager
     gCommandPoolManager = std::make_unique<graphics::CommandPoolManager>(gVkContext->GetDevice(),
@@ -135,54 +436,32 @@ Java_dev_geronimodesenvolvimentos_krakatoa_VulkanSurfaceView_nativeOnSurfaceCrea
                                                                          gVkContext->getGraphicsQueue(),
                                                                          gVkContext->getComputeQueue(),
                                                                          gVkContext->getTransferQueue());
+    // One recording pool per thread that can record offscreen draws: the workers + this one
+    gCommandPoolManager->CreateRecordingPools(gWorkerPool->Size() + 1);
     //creates the frame sync object
     gFrameSync = std::make_unique<graphics::FrameSync>(gVkContext->GetDevice(), gVkContext->getSwapchainImageCount());
+    gGpuTimer = std::make_unique<graphics::GpuTimer>(gVkContext->GetDevice(),
+                                                     gVkContext->getPhysicalDevice(),
+                                                     gVkContext->getQueueFamilies().graphicsFamily.value());
+    gDynamicResolution = std::make_unique<graphics::DynamicResolution>();
+    //GPU meshes and textures live in the resource cache (deduplicated, budgeted)
+    gResourceCache = std::make_unique<graphics::ResourceCache>(gVkContext->GetDevice(),
+                                                               gVkContext->getPhysicalDevice(),
+                                                               gVkContext->GetAllocator(),
+                                                               *gCommandPoolManager);
     //Load meshes
-    {
-        io::MeshLoader meshLoader;
-        auto meshData = meshLoader.Load("meshes/cube.glb");
-        if (!meshData.vertices.empty() && !meshData.indices.empty()) {
-            gMeshes["cube"] = std::make_unique<graphics::StaticMesh>(
-                    gVkContext->GetDevice(),
-                    gVkContext->GetAllocator(),
-                    *gCommandPoolManager,
-                    meshData.vertices.data(),
-                    meshData.vertexCount,
-                    meshData.indices.data(),
-                    meshData.indexCount,
-                    "cube");
-        }
-        auto quadData = io::MeshLoader::CreateFullscreenQuad();
-        gMeshes["fullscreen_quad"] = std::make_unique<graphics::StaticMesh>(
-                gVkContext->GetDevice(),
-                gVkContext->GetAllocator(),
-                *gCommandPoolManager,
-                quadData.vertices.data(),
-                quadData.vertexCount,
-                quadData.indices.data(),
-                quadData.indexCount,
-                "fullscreen_quad");
-    }
-    // Load textures
-    {
-        std::vector<uint8_t> pixels;
-        VkFormat fmt;
-        int w, h;
-        io::LoadImage("textures/grid.png", pixels, fmt, w, h);
-        gGridTexture = std::make_unique<graphics::Texture2D>(
-                gVkContext->GetDevice(),
-                gVkContext->GetAllocator(),
-                *gCommandPoolManager,
-                pixels,
-                static_cast<uint32_t>(w),
-                static_cast<uint32_t>(h),
-                fmt,
-                "grid");
-    }
+    gMeshes["cube"] = gResourceCache->GetMesh("meshes/cube.glb");
+    gMeshes["fullscreen_quad"] = gResourceCache->GetMesh("fullscreen_quad",
+                                                         io::MeshLoader::CreateFullscreenQuad);
+    // Load textures: prefer a block-compressed KTX2 the GPU can sample, PNG otherwise
+    gGridTexture = gResourceCache->GetTexture({"textures/grid.astc.ktx2",
+                                               "textures/grid.etc2.ktx2",
+                                               "textures/grid.bc3.ktx2",
+                                               "textures/grid.png"});
     cameraBgQuad = std::make_unique<graphics::Renderable>("camera_bg");
-    cameraBgQuad->SetMesh(gMeshes["fullscreen_quad"].get());
+    cameraBgQuad->SetMesh(gMeshes["fullscreen_quad"]);
     composeQuad = std::make_unique<graphics::Renderable>("compose");
-    composeQuad->SetMesh(gMeshes["fullscreen_quad"].get());
+    composeQuad->SetMesh(gMeshes["fullscreen_quad"]);
     //create the frame timer
     gFrameTimer = std::make_unique<graphics::FrameTimer>();
     //dummy egl context to deal with ar session bullshit
@@ -191,10 +470,21 @@ Java_dev_geronimodesenvolvimentos_krakatoa_VulkanSurfaceView_nativeOnSurfaceCrea
     //the ar session manager
     gArSessionManager = std::make_unique<ar::ARSessionManager>();
     gArSessionManager->initialize(env, activity, activity);
+    // Camera plane copies start on the workers as soon as ARCore hands over the image
+    gArSessionManager->setCameraFrameCallback([](const ar::CameraFrame& frame) {
+        gCameraImage->BeginUpload(frame);
+        // Once per new camera image, off the render thread. If the previous build
+        // is still running this image is skipped; consumers keep the older one.
+        if (frame.timestamp != gLumaPyramidTimestamp && !gLumaPyramidBusy.exchange(true)) {
+            gLumaPyramidTimestamp = frame.timestamp;
+            gWorkerPool->Submit([frame] {   // the copy keeps the ArImage alive
+                gLumaPyramid->Build(frame.yPlane, frame.yRowStride, frame.width, frame.height,
+                                    frame.timestamp);
+                gLumaPyramidBusy = false;
+            });
+        }
+    });
     gArSessionManager->onResume();
-    //camera feed -> vulkan image (ring buffered, CPU upload, no OES)
-    gCameraImage = std::make_unique<graphics::ARCameraImage>(gVkContext->GetDevice(),
-                                                              gVkContext->GetAllocator());
 }
 extern "C"
 JNIEXPORT void JNICALL
@@ -204,43 +494,14 @@ Java_dev_geronimodesenvolvimentos_krakatoa_VulkanSurfaceView_nativeOnSurfaceChan
                                                                                     jint height,
                                                                                     jint rotation) {
     vkDeviceWaitIdle(gVkContext->GetDevice());
-    gDisplayRotation = rotation;
     gArSessionManager->onSurfaceChanged(rotation, width, height);
     // Create the resources that rely on screen size
     if (gVkContext->GetSwapchain() == VK_NULL_HANDLE)
         gVkContext->CreateSwapchain(width, height);
     else
         gVkContext->RecreateSwapchain(width, height);
-    gSwapChainRenderPass->Recreate(gVkContext->getSwapchainImageViews(),
-                                  gVkContext->getSwapchainExtent());
-    gOffscreenRenderPass->Resize(gVkContext->getSwapchainExtent().width,
-                                 gVkContext->getSwapchainExtent().height);
-    gUnshadedOpaquePipeline = std::make_unique<graphics::Pipeline>(gOffscreenRenderPass.get(),
-                                                                   gVkContext->GetDevice(),
-                                                                   gVkContext->GetAllocator(),
-                                                                   graphics::UnshadedOpaqueConfig(),
-                                                                   pipelineLayouts["unshaded_opaque"],
-                                                                   descriptorSetLayouts["unshaded_opaque"]);
-    gTransparentPhongPipeline = std::make_unique<graphics::Pipeline>(gOffscreenRenderPass.get(),
-                                                                      gVkContext->GetDevice(),
-                                                                      gVkContext->GetAllocator(),
-                                                                      graphics::TransparentPhongConfig(gGridTexture.get()),
-                                                                      pipelineLayouts["transparent_phong"],
-                                                                      descriptorSetLayouts["transparent_phong"]);
-    gCameraBgPipeline = std::make_unique<graphics::Pipeline>(gSwapChainRenderPass.get(),
-                                                              gVkContext->GetDevice(),
-                                                              gVkContext->GetAllocator(),
-                                                              graphics::CameraBackgroundConfig(
-                                                                      gCameraImage.get(),
-                                                                      &gDisplayRotation),
-                                                              pipelineLayouts["camera_bg"],
-                                                              descriptorSetLayouts["camera_bg"]);
-    gComposePipeline = std::make_unique<graphics::Pipeline>(gSwapChainRenderPass.get(),
-                                                             gVkContext->GetDevice(),
-                                                             gVkContext->GetAllocator(),
-                                                             graphics::ComposeConfig(gOffscreenRenderPass.get()),
-                                                             pipelineLayouts["compose"],
-                                                             descriptorSetLayouts["compose"]);
+    // Attachments at the new size and new render passes: the pipelines are rebuilt for them
+    CompileRenderGraph();
     gFrameSync->RecreateForSwapchain(gVkContext->getSwapchainImageCount());
 }
 extern "C"
@@ -249,25 +510,37 @@ Java_dev_geronimodesenvolvimentos_krakatoa_VulkanSurfaceView_nativeOnSurfaceDest
                                                                                       jobject thiz) {
     vkDeviceWaitIdle(gVkContext->GetDevice());
     gMeshes.clear();
+    gResourceCache->ReleaseUnused();
 }
 extern "C"
 JNIEXPORT void JNICALL
 Java_dev_geronimodesenvolvimentos_krakatoa_VulkanSurfaceView_nativeOnDrawFrame(JNIEnv *env,
                                                                                jobject thiz) {
+    std::lock_guard<std::mutex> lock(gFrameMutex);
 
-    gFrameSync->WaitForCurrentFrame();
-    // Garbage-collect unused uniform buffers AFTER the fence wait guarantees
-    // that command buffers from the oldest in-flight frame are done.
+    // Compose or upscaling mode switched from the UI: new render passes and attachments, like a resize
+    if (gComposeInSubpassRequested != gComposeInSubpass || gTemporalUpscalingRequested != gTemporalUpscaling) {
+        vkDeviceWaitIdle(gVkContext->GetDevice());
+        gComposeInSubpass = gComposeInSubpassRequested;
+        gTemporalUpscaling = gTemporalUpscalingRequested;
+        DeclareRenderGraph(gComposeInSubpass, TemporalUpscalingActive());
+        CompileRenderGraph();
+    }
+    const uint64_t frame = gFrameSync->BeginFrame();
+    const uint64_t completedFrame = gFrameSync->GetCompletedFrame();
+    // Garbage-collect unused uniform buffers AFTER BeginFrame's timeline wait
+    // guarantees that command buffers from the oldest in-flight frame are done.
     // Must NOT run during command buffer recording (would destroy bound resources).
     if (gTransparentPhongPipeline) gTransparentPhongPipeline->CollectGarbage();
     if (gCameraBgPipeline) gCameraBgPipeline->CollectGarbage();
     if (gComposePipeline) gComposePipeline->CollectGarbage();
+    // Resources last used by a completed frame can be evicted if over budget
+    gResourceCache->BeginFrame(frame, completedFrame);
 
     gFrameTimer->Tick();
-    gFrameSync->AdvanceFrame();
     VkSemaphore acquireSem = gFrameSync->GetNextAcquireSemaphore();
     gCommandPoolManager->AdvanceFrame();
-    gCameraImage->AdvanceFrame();
+    gCameraImage->AdvanceFrame(frame, completedFrame);
     for(auto p:gArPlanes){
         //std::unordered_map<int64_t, std::shared_ptr<graphics::Renderable>> gArPlanes;
         ((graphics::MutableMesh*)p.second->GetMesh())->Advance();
@@ -277,16 +550,51 @@ Java_dev_geronimodesenvolvimentos_krakatoa_VulkanSurfaceView_nativeOnDrawFrame(J
     gArSessionManager->onDrawFrame();
 
     uint32_t imageIndex;
-    vkAcquireNextImageKHR(gVkContext->GetDevice(), gVkContext->GetSwapchain(),
-                          UINT64_MAX, acquireSem, VK_NULL_HANDLE, &imageIndex);
-
-    gFrameSync->WaitForImage(imageIndex);
-    gFrameSync->SetImageFence(imageIndex, gFrameSync->GetInFlightFence());
-    gFrameSync->ResetCurrentFence();
+    VkResult acquireResult = vkAcquireNextImageKHR(gVkContext->GetDevice(), gVkContext->GetSwapchain(),
+                                                   UINT64_MAX, acquireSem, VK_NULL_HANDLE, &imageIndex);
+    if (acquireResult != VK_SUCCESS && acquireResult != VK_SUBOPTIMAL_KHR) {
+        // No image (out of date until the surface change arrives): the frame still has to
+        // signal its timeline value
+        LOGW("Frame %llu skipped: acquire failed (%d)", (unsigned long long)frame, acquireResult);
+        gFrameSync->SkipFrame(gVkContext->getGraphicsQueue());
+        gVkContext->Advance();
+        return;
+    }
 
     gCommandPoolManager->BeginFrame();
     VkCommandBuffer cmd = gCommandPoolManager->GetCurrentCommandBuffer();
     const uint32_t frameIndex = gVkContext->GetFrameIndex();
+    // Timestamps of the frame that used this command buffer slot are in: pick the offscreen
+    // layer's size for this frame from them
+    gGpuTimer->BeginFrame(cmd);
+    if (gDynamicResolutionActive) {
+        if (gGpuTimer->HasNewResults()) {
+            gDynamicResolution->Update(gGpuTimer->GetTotalMs());
+            if (gDynamicResolution->GetMetrics().lastDecision != graphics::DynamicResolution::Decision::Hold) {
+                LogGpuIntervals();
+            }
+        }
+        gRenderGraph->SetRenderArea(gOffscreenPass, gDynamicResolution->GetRenderExtent(gRenderGraph->GetExtent()));
+    } else if (gTemporalUpscaler) {
+        gRenderGraph->SetRenderArea(gOffscreenPass, gTemporalUpscaler->GetDefaultRenderExtent());
+    }
+    if (gGpuTimer->HasNewResults() && frame % GPU_REPORT_FRAMES == 0) {
+        LOGI("GPU frame %.2f ms", gGpuTimer->GetTotalMs());
+        LogGpuIntervals();
+    }
+    if (gFillStats.frames == GPU_REPORT_FRAMES) {
+        const double skipped = 1.0 - static_cast<double>(gFillStats.shadedPixels) /
+                                     static_cast<double>(std::max<uint64_t>(gFillStats.fullPixels, 1));
+        LOGI("Damage region: %.0f%% of the AR layer's fill skipped (%.2f of %.2f MPix per frame), %u of %u frames empty",
+             skipped * 100.0, gFillStats.shadedPixels / (gFillStats.frames * 1e6),
+             gFillStats.fullPixels / (gFillStats.frames * 1e6), gFillStats.emptyFrames, gFillStats.frames);
+        gFillStats = {};
+        for (const auto* draw : {gCameraBgDraw.get(), gComposeDraw.get()}) {
+            LOGI("Prerecorded %s: %llu of %llu executions recorded", draw->GetName().c_str(),
+                 static_cast<unsigned long long>(draw->GetRecordCount()),
+                 static_cast<unsigned long long>(draw->GetExecuteCount()));
+        }
+    }
     // Update AR planes
     gArSessionManager->forEachPlane([&](int64_t planeid, const float* modelMat,
             const float* polygon, int polyFloatCount){
@@ -323,13 +631,6 @@ Java_dev_geronimodesenvolvimentos_krakatoa_VulkanSurfaceView_nativeOnDrawFrame(J
         //and data gathering phases, so the drawing will happen later, when i have render passes
         //and pipelines
     });
-    // Upload camera feed (YUV->RGBA) into the ring-buffered Vulkan image.
-    // After this call the current image is in SHADER_READ_ONLY_OPTIMAL, ready to sample.
-    gCameraImage->Update(cmd, gArSessionManager->getCameraFrame());
-    //begin the offscreen render pass
-    gOffscreenRenderPass->setClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-    gOffscreenRenderPass->AdvanceFrame();
-    gOffscreenRenderPass->Begin(cmd, gOffscreenRenderPass->GetFramebuffer(), gOffscreenRenderPass->GetExtent());
     // Gather AR light estimation for Phong shading
     const auto& lightEst = gArSessionManager->getLightEstimate();
     glm::vec4 lightDir(0.0f, -1.0f, -0.5f, 0.0f);
@@ -341,65 +642,54 @@ Java_dev_geronimodesenvolvimentos_krakatoa_VulkanSurfaceView_nativeOnDrawFrame(J
         intensity);
     glm::vec4 ambientColor(0.3f * intensity, 0.3f * intensity, 0.3f * intensity, 1.0f);
 
-    // Draw AR planes into the offscreen render target
+    std::array<float,16> arViewMatrix{};
+    gArSessionManager->getViewMatrix(arViewMatrix.data());
+    glm::mat4 viewMat = glm::make_mat4(arViewMatrix.data());
+    std::array<float,16> arProjMatrix{};
+    gArSessionManager->getProjectionMatrix(0.01f, 100.f, arProjMatrix.data());
+    glm::mat4 projMat = glm::make_mat4(arProjMatrix.data());
+    // Upscaled, the layer is rendered with a different sub-pixel jitter every frame
+    if (gTemporalUpscaler) {
+        projMat = gTemporalUpscaler->BeginFrame(viewMat, projMat, gRenderGraph->GetRenderArea(gOffscreenPass));
+    }
+
+    // Draw AR planes into the offscreen render target: uniforms are written here,
+    // the commands recorded by the graph's Offscreen pass
+    gOffscreenDraws.Clear();
+    gDamage.Clear();
     for (const auto& plane : gArPlanes)
     {
+        auto* mesh = static_cast<graphics::MutableMesh*>(plane.second->GetMesh());
+        if (mesh->GetIndexCount() > 0) {
+            gDamage.AddBox(projMat * viewMat * plane.second->GetTransform().GetWorldMatrix(),
+                           mesh->GetBoundsMin(), mesh->GetBoundsMax());
+        }
         graphics::RDO rdo;
         rdo.Add(graphics::RDO::Keys::MODEL_MAT, plane.second->GetTransform().GetWorldMatrix());
-
-        std::array<float,16> arViewMatrix{};
-        gArSessionManager->getViewMatrix(arViewMatrix.data());
-        glm::mat4 viewMat = glm::make_mat4(arViewMatrix.data());
         rdo.Add(graphics::RDO::Keys::VIEW_MAT, viewMat);
-
-        std::array<float,16> arProjMatrix{};
-        gArSessionManager->getProjectionMatrix(0.01f, 100.f, arProjMatrix.data());
-        glm::mat4 projMat = glm::make_mat4(arProjMatrix.data());
         rdo.Add(graphics::RDO::Keys::PROJ_MAT, projMat);
 
         rdo.Add(graphics::RDO::Keys::LIGHT_DIR, lightDir);
         rdo.Add(graphics::RDO::Keys::LIGHT_COLOR, lightColor);
         rdo.Add(graphics::RDO::Keys::AMBIENT_COLOR, ambientColor);
 
-        gTransparentPhongPipeline->Bind(cmd);
-        gTransparentPhongPipeline->Draw(cmd, &rdo, plane.second.get(), frameIndex);
+        gOffscreenDraws.Add(gTransparentPhongPipeline.get(), &rdo, plane.second.get(), frameIndex);
         auto msg = Concatenate("[arplanes] drew plane ", plane.second->GetId());
         LOGI("%s", msg.c_str());
     }
-    gOffscreenRenderPass->End(cmd);
-    //begin the swap chain render pass
-    gSwapChainRenderPass->setClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    gSwapChainRenderPass->Begin(cmd,
-                                gSwapChainRenderPass->GetFramebuffer(imageIndex),
-                                gVkContext->getSwapchainExtent());
-    // Draw camera background (fullscreen quad with camera texture, depth=1.0)
-    if (gCameraImage->IsValid()) {
-        gCameraBgPipeline->Bind(cmd);
-        gCameraBgPipeline->Draw(cmd, nullptr, cameraBgQuad.get(), frameIndex);
-    }
-    // Composite offscreen render target (AR planes) over the camera background
-    gComposePipeline->Bind(cmd);
-    gComposePipeline->Draw(cmd, nullptr, composeQuad.get(), frameIndex);
-    gSwapChainRenderPass->End(cmd);
+    UpdateDamage();
+    // Camera upload, offscreen pass, camera background and compose (see DeclareRenderGraph)
+    gRenderGraph->SetImageView(gBackbuffer, gVkContext->getSwapchainImageViews()[imageIndex]);
+    gRenderGraph->Execute(cmd);
     gCommandPoolManager->EndFrame();
 
 // Submit
-    VkSemaphore waitSemaphores[] = {acquireSem};
-    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
     VkSemaphore renderFinishedSem = gFrameSync->GetRenderFinishedSemaphore(imageIndex);
-
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores;
-    submitInfo.pWaitDstStageMask = waitStages;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &cmd;
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = &renderFinishedSem;
-
-    vkQueueSubmit(gVkContext->getGraphicsQueue(), 1, &submitInfo,
-                  gFrameSync->GetInFlightFence());
+    if (!gFrameSync->SubmitFrame(gVkContext->getGraphicsQueue(), cmd, acquireSem, renderFinishedSem)) {
+        // renderFinishedSem won't be signalled: nothing to present
+        gVkContext->Advance();
+        return;
+    }
 
 // Present
     VkPresentInfoKHR presentInfo{};
@@ -420,6 +710,8 @@ Java_dev_geronimodesenvolvimentos_krakatoa_VulkanSurfaceView_nativeCleanup(JNIEn
                                                                            jobject thiz) {
     vkDeviceWaitIdle(gVkContext->GetDevice());
     gCameraImage = nullptr;
+    gWorkerPool = nullptr;   // joins the workers: no pyramid build is left running
+    gLumaPyramid = nullptr;
     gArSessionManager.release();
     gMeshes.clear();
     for (const auto& [key, value] : descriptorSetLayouts) {
@@ -430,11 +722,19 @@ Java_dev_geronimodesenvolvimentos_krakatoa_VulkanSurfaceView_nativeCleanup(JNIEn
     {
         vkDestroyPipelineLayout(gVkContext->GetDevice(), value, nullptr);
     }
+    gOffscreenDraws.Clear();
+    gComposeDraw = nullptr;
+    gCameraBgDraw = nullptr;
     gComposePipeline = nullptr;
     gCameraBgPipeline = nullptr;
     gTransparentPhongPipeline = nullptr;
     gUnshadedOpaquePipeline = nullptr;
-    gGridTexture = nullptr;
+    gRenderGraph = nullptr;
+    gGridTexture = {};
+    gResourceCache = nullptr;
+    gTemporalUpscaler = nullptr;
+    gDynamicResolution = nullptr;
+    gGpuTimer = nullptr;
     gCommandPoolManager = nullptr;
     gFrameSync = nullptr;
     gFrameTimer = nullptr;
@@ -457,6 +757,8 @@ Java_dev_geronimodesenvolvimentos_krakatoa_VulkanSurfaceView_nativeOnPause(JNIEn
     if (gFrameTimer) {
         gFrameTimer->Pause();
     }
+    std::lock_guard<std::mutex> lock(gFrameMutex);
+    ReleaseCameraImages();
     gArSessionManager->onPause();
 }
 extern "C"
@@ -504,5 +806,22 @@ JNIEXPORT jboolean JNICALL
 Java_dev_geronimodesenvolvimentos_krakatoa_VulkanSurfaceView_nativeSetResolution(
         JNIEnv *env, jobject thiz, jint index) {
     if (!gArSessionManager) return JNI_FALSE;
+    std::lock_guard<std::mutex> lock(gFrameMutex);
+    ReleaseCameraImages();   // setResolution pauses and resumes the session
     return gArSessionManager->setResolution(index) ? JNI_TRUE : JNI_FALSE;
-}
\ No newline at end of file
+}extern "C"
+JNIEXPORT jboolean JNICALL
+Java_dev_geronimodesenvolvimentos_krakatoa_VulkanSurfaceView_nativeSetComposeInSubpass(
+        JNIEnv *env, jobject thiz, jboolean enabled) {
+    if (enabled && !io::AssetLoader::exists("shaders/compose_input.frag.spv")) return JNI_FALSE;
+    gComposeInSubpassRequested = enabled == JNI_TRUE;
+    return JNI_TRUE;
+}
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_dev_geronimodesenvolvimentos_krakatoa_VulkanSurfaceView_nativeSetTemporalUpscaling(
+        JNIEnv *env, jobject thiz, jboolean enabled) {
+    if (enabled && !graphics::TemporalUpscaler::IsAvailable()) return JNI_FALSE;
+    gTemporalUpscalingRequested = enabled == JNI_TRUE;
+    return JNI_TRUE;
+}
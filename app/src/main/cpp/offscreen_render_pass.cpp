@@ -1,283 +0,0 @@
-#include "offscreen_render_pass.h"
-#include "vk_debug.h"
-#include "android_log.h"
-#include <cassert>
-#include <array>
-using namespace graphics;
-
-OffscreenRenderPass::OffscreenRenderPass(VkDevice device,
-                                         VmaAllocator allocator,
-                                         uint32_t width,
-                                         uint32_t height,
-                                         VkFormat colorFormat,
-                                         VkFormat depthFormat)
-        : allocator(allocator),
-          width(width),
-          height(height),
-          colorFormat(colorFormat),
-          depthFormat(depthFormat),
-          frameResources(MAX_FRAMES_IN_FLIGHT) {
-    this->device = device;
-    this->debugName = "OffscreenRenderPass";
-
-    clearValues.resize(2);
-    clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
-    clearValues[1].depthStencil = {1.0f, 0};
-
-    CreateRenderPass();
-    CreateImages();
-    CreateFramebuffers();
-
-    LOGI("OffscreenRenderPass created (%ux%u, %u frames in flight)",
-         width, height, MAX_FRAMES_IN_FLIGHT);
-}
-
-OffscreenRenderPass::~OffscreenRenderPass() {
-    DestroyFramebuffers();
-    DestroyImages();
-    DestroyRenderPass();
-    LOGI("OffscreenRenderPass destroyed");
-}
-
-void OffscreenRenderPass::AdvanceFrame() {
-    frameResources.Next();
-}
-
-void OffscreenRenderPass::Resize(uint32_t newWidth, uint32_t newHeight) {
-    if (newWidth == width && newHeight == height) return;
-
-    LOGI("OffscreenRenderPass resizing %ux%u -> %ux%u",
-         width, height, newWidth, newHeight);
-
-    width = newWidth;
-    height = newHeight;
-
-    DestroyFramebuffers();
-    DestroyImages();
-    CreateImages();
-    CreateFramebuffers();
-}
-
-void OffscreenRenderPass::CreateRenderPass() {
-    // 0: Color attachment
-    VkAttachmentDescription colorAttachment{};
-    colorAttachment.format = colorFormat;
-    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-    // 1: Depth attachment
-    VkAttachmentDescription depthAttachment{};
-    depthAttachment.format = depthFormat;
-    depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-    std::array<VkAttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
-
-    VkAttachmentReference colorRef{};
-    colorRef.attachment = 0;
-    colorRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    VkAttachmentReference depthRef{};
-    depthRef.attachment = 1;
-    depthRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-    VkSubpassDescription subpass{};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &colorRef;
-    subpass.pDepthStencilAttachment = &depthRef;
-
-    // Dependency 0: EXTERNAL → subpass 0
-    // Wait for previous fragment shader reads (e.g. compose sampling this image
-    // from the prior frame) to finish before we clear and write to the attachment.
-    VkSubpassDependency dependencies[2]{};
-    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependencies[0].dstSubpass = 0;
-    dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
-                              VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    dependencies[0].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
-    dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
-                               VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-    dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-    // Dependency 1: subpass 0 → EXTERNAL
-    // Ensure color attachment writes are visible to the compose pass that
-    // samples this image as a texture in the subsequent swapchain render pass.
-    dependencies[1].srcSubpass = 0;
-    dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
-    dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-    dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-    dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-    VkRenderPassCreateInfo createInfo{};
-    createInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    createInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-    createInfo.pAttachments = attachments.data();
-    createInfo.subpassCount = 1;
-    createInfo.pSubpasses = &subpass;
-    createInfo.dependencyCount = 2;
-    createInfo.pDependencies = dependencies;
-
-    VkResult result = vkCreateRenderPass(device, &createInfo, nullptr, &renderPass);
-    assert(result == VK_SUCCESS);
-    debug::SetRenderPassName(device, renderPass, "OffscreenRenderPass");
-    LOGI("Offscreen VkRenderPass created");
-}
-
-void OffscreenRenderPass::CreateImages() {
-    for (uint32_t i = 0; i < frameResources.Size(); i++) {
-        auto& res = frameResources[i];
-
-        // --- Color image ---
-        VkImageCreateInfo colorImageInfo{};
-        colorImageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-        colorImageInfo.imageType = VK_IMAGE_TYPE_2D;
-        colorImageInfo.format = colorFormat;
-        colorImageInfo.extent = {width, height, 1};
-        colorImageInfo.mipLevels = 1;
-        colorImageInfo.arrayLayers = 1;
-        colorImageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-        colorImageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-        colorImageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
-                               VK_IMAGE_USAGE_SAMPLED_BIT;
-        colorImageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        colorImageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-
-        VmaAllocationCreateInfo colorAllocInfo{};
-        colorAllocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
-
-        VkResult result = vmaCreateImage(allocator, &colorImageInfo, &colorAllocInfo,
-                                         &res.colorImage, &res.colorAllocation, nullptr);
-        assert(result == VK_SUCCESS);
-        debug::SetImageName(device, res.colorImage,
-                             Concatenate("OffscreenColorImage[", i, "]"));
-
-        res.colorImageView = CreateImageView(res.colorImage, colorFormat,
-                                             VK_IMAGE_ASPECT_COLOR_BIT);
-        debug::SetImageViewName(device, res.colorImageView,
-                             Concatenate("OffscreenColorImageView[", i, "]"));
-
-        // --- Depth image ---
-        VkImageCreateInfo depthImageInfo{};
-        depthImageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-        depthImageInfo.imageType = VK_IMAGE_TYPE_2D;
-        depthImageInfo.format = depthFormat;
-        depthImageInfo.extent = {width, height, 1};
-        depthImageInfo.mipLevels = 1;
-        depthImageInfo.arrayLayers = 1;
-        depthImageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-        depthImageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-        depthImageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-        depthImageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        depthImageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-
-        VmaAllocationCreateInfo depthAllocInfo{};
-        depthAllocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
-
-        result = vmaCreateImage(allocator, &depthImageInfo, &depthAllocInfo,
-                                &res.depthImage, &res.depthAllocation, nullptr);
-        assert(result == VK_SUCCESS);
-        debug::SetImageName(device, res.depthImage,
-                             Concatenate("OffscreenDepthImage[", i, "]"));
-
-        res.depthImageView = CreateImageView(res.depthImage, depthFormat,
-                                             VK_IMAGE_ASPECT_DEPTH_BIT);
-        debug::SetImageViewName(device, res.depthImageView,
-                             Concatenate("OffscreenDepthImageView[", i, "]"));
-
-        LOGI("Offscreen frame resources [%u] created (%ux%u)", i, width, height);
-    }
-}
-
-void OffscreenRenderPass::CreateFramebuffers() {
-    for (uint32_t i = 0; i < frameResources.Size(); i++) {
-        auto& res = frameResources[i];
-
-        std::array<VkImageView, 2> attachments = {res.colorImageView, res.depthImageView};
-
-        VkFramebufferCreateInfo fbInfo{};
-        fbInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        fbInfo.renderPass = renderPass;
-        fbInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-        fbInfo.pAttachments = attachments.data();
-        fbInfo.width = width;
-        fbInfo.height = height;
-        fbInfo.layers = 1;
-
-        VkResult result = vkCreateFramebuffer(device, &fbInfo, nullptr, &res.framebuffer);
-        assert(result == VK_SUCCESS);
-        debug::SetFramebufferName(device, res.framebuffer,
-                             Concatenate("OffscreenFramebuffer[", i, "]"));
-    }
-
-    LOGI("Created %u offscreen framebuffers (%ux%u)",
-         frameResources.Size(), width, height);
-}
-
-void OffscreenRenderPass::DestroyImages() {
-    for (uint32_t i = 0; i < frameResources.Size(); i++) {
-        auto& res = frameResources[i];
-
-        if (res.colorImageView != VK_NULL_HANDLE) {
-            vkDestroyImageView(device, res.colorImageView, nullptr);
-            res.colorImageView = VK_NULL_HANDLE;
-        }
-        if (res.colorImage != VK_NULL_HANDLE) {
-            vmaDestroyImage(allocator, res.colorImage, res.colorAllocation);
-            res.colorImage = VK_NULL_HANDLE;
-            res.colorAllocation = VK_NULL_HANDLE;
-        }
-        if (res.depthImageView != VK_NULL_HANDLE) {
-            vkDestroyImageView(device, res.depthImageView, nullptr);
-            res.depthImageView = VK_NULL_HANDLE;
-        }
-        if (res.depthImage != VK_NULL_HANDLE) {
-            vmaDestroyImage(allocator, res.depthImage, res.depthAllocation);
-            res.depthImage = VK_NULL_HANDLE;
-            res.depthAllocation = VK_NULL_HANDLE;
-        }
-    }
-}
-
-void OffscreenRenderPass::DestroyFramebuffers() {
-    for (uint32_t i = 0; i < frameResources.Size(); i++) {
-        auto& res = frameResources[i];
-        if (res.framebuffer != VK_NULL_HANDLE) {
-            vkDestroyFramebuffer(device, res.framebuffer, nullptr);
-            res.framebuffer = VK_NULL_HANDLE;
-        }
-    }
-}
-
-VkImageView OffscreenRenderPass::CreateImageView(VkImage image,
-                                                 VkFormat format,
-                                                 VkImageAspectFlags aspectFlags) {
-    VkImageViewCreateInfo viewInfo{};
-    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-    viewInfo.image = image;
-    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-    viewInfo.format = format;
-    viewInfo.subresourceRange.aspectMask = aspectFlags;
-    viewInfo.subresourceRange.baseMipLevel = 0;
-    viewInfo.subresourceRange.levelCount = 1;
-    viewInfo.subresourceRange.baseArrayLayer = 0;
-    viewInfo.subresourceRange.layerCount = 1;
-
-    VkImageView imageView;
-    VkResult result = vkCreateImageView(device, &viewInfo, nullptr, &imageView);
-    assert(result == VK_SUCCESS);
-    return imageView;
-}
\ No newline at end of file
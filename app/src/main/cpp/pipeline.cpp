@@ -3,6 +3,7 @@
 #include "asset_loader.h"
 #include "vk_debug.h"
 #include "android_log.h"
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <array>
@@ -217,6 +218,8 @@ struct TransparentPhongUniformBuffer {
 // texture is assigned.
 struct TransparentPhongState {
     VkSampler sampler        = VK_NULL_HANDLE;
+    // Texture generation each descriptor set was written with
+    std::unordered_map<VkDescriptorSet, uint64_t> textureGeneration;
     VkImage   placeholderImg = VK_NULL_HANDLE;
     VkImageView placeholderView = VK_NULL_HANDLE;
     VmaAllocation placeholderAlloc = VK_NULL_HANDLE;
@@ -292,7 +295,25 @@ static void createPlaceholderTexture(VkDevice device, VmaAllocator allocator,
     assert(r == VK_SUCCESS);
 }
 
-PipelineConfig graphics::TransparentPhongConfig(Texture2D* texture) {
+/// Point binding 1 of a transparent phong descriptor set at the given view.
+static void writeTransparentPhongTexture(VkDevice device, VkDescriptorSet ds,
+                                         VkSampler sampler, VkImageView view, VkImageLayout layout) {
+    VkDescriptorImageInfo imgInfo{};
+    imgInfo.sampler     = sampler;
+    imgInfo.imageView   = view;
+    imgInfo.imageLayout = layout;
+
+    VkWriteDescriptorSet write{};
+    write.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet          = ds;
+    write.dstBinding      = 1;
+    write.descriptorCount = 1;
+    write.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo      = &imgInfo;
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+}
+
+PipelineConfig graphics::TransparentPhongConfig(TextureHandle texture) {
     PipelineConfig config;
     config.vertexShader   = "transparent_phong.vert";
     config.fragmentShader = "transparent_phong.frag";
@@ -321,25 +342,28 @@ PipelineConfig graphics::TransparentPhongConfig(Texture2D* texture) {
 
     auto state = std::make_shared<TransparentPhongState>();
 
-    config.renderCallback = [state, texture](VkCommandBuffer cmd, RDO* rdo, Renderable* obj,
-                                     Pipeline& pipeline, uint32_t frameIndex) {
+    // Split in prepare + record so the offscreen draw list can be recorded on workers
+    config.prepareCallback = [state, texture](RDO* rdo, Renderable* obj, Pipeline& pipeline,
+                                              uint32_t frameIndex, DrawCommand& out) {
         // -- First-time init: create sampler, optional placeholder, UBO buffers --
         std::shared_ptr<UniformBuffer> uniformBuffer = pipeline.GetUniformBuffer(obj->GetId());
         if (uniformBuffer == nullptr) {
             state->device = pipeline.GetDevice();
             state->alloc  = pipeline.GetAllocator();
-            if (!texture) {
+            Texture2D* tex = texture.Get();
+            if (!tex) {
                 createPlaceholderTexture(pipeline.GetDevice(), pipeline.GetAllocator(), *state);
             } else {
-                // Create sampler for the real texture
+                // Create sampler for the real texture (trilinear if it has mips)
                 VkSamplerCreateInfo samplerInfo{};
                 samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
                 samplerInfo.magFilter    = VK_FILTER_LINEAR;
                 samplerInfo.minFilter    = VK_FILTER_LINEAR;
-                samplerInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+                samplerInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_LINEAR;
                 samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
                 samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
                 samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+                samplerInfo.maxLod       = VK_LOD_CLAMP_NONE;
                 VkResult r = vkCreateSampler(pipeline.GetDevice(), &samplerInfo, nullptr, &state->sampler);
                 assert(r == VK_SUCCESS);
             }
@@ -352,8 +376,8 @@ PipelineConfig graphics::TransparentPhongConfig(Texture2D* texture) {
             ub->id   = obj->GetId();
             ub->deathCounter = 100;
 
-            VkImageView texView = texture ? texture->GetImageView() : state->placeholderView;
-            VkImageLayout texLayout = texture ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+            VkImageView texView = tex ? tex->GetImageView() : state->placeholderView;
+            VkImageLayout texLayout = tex ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
                                               : VK_IMAGE_LAYOUT_GENERAL;
 
             for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
@@ -388,6 +412,7 @@ PipelineConfig graphics::TransparentPhongConfig(Texture2D* texture) {
                 writes[1].pImageInfo      = &imgInfo;
 
                 vkUpdateDescriptorSets(pipeline.GetDevice(), 2, writes, 0, nullptr);
+                state->textureGeneration[ds] = texture.GetGeneration();
             }
             pipeline.AddUniformBuffer(obj->GetId(), ub);
 
@@ -430,16 +455,24 @@ PipelineConfig graphics::TransparentPhongConfig(Texture2D* texture) {
                                uniformBuffer->gpuBufferAllocation.Current(),
                                0, sizeof(data));
 
-            // Bind descriptor set, vertex/index buffers and draw
-            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                    pipeline.GetPipelineLayout(), 0, 1,
-                                    &uniformBuffer->descriptorSets.Current(), 0, nullptr);
+            // The cache may have evicted and reloaded the texture since this set
+            // was written. This slot's previous frame is done, so it's safe to rewrite.
+            // Get() first: it marks the texture used and reloads it if evicted.
+            VkDescriptorSet ds = uniformBuffer->descriptorSets.Current();
+            Texture2D* tex = texture.Get();
+            if (tex && state->sampler != VK_NULL_HANDLE &&
+                state->textureGeneration[ds] != texture.GetGeneration()) {
+                writeTransparentPhongTexture(pipeline.GetDevice(), ds, state->sampler,
+                                             tex->GetImageView(),
+                                             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+                state->textureGeneration[ds] = texture.GetGeneration();
+            }
 
-            VkBuffer vertexBuffers[] = {mesh->GetVertexBuffer()};
-            VkDeviceSize offsets[] = {0};
-            vkCmdBindVertexBuffers(cmd, 0, 1, vertexBuffers, offsets);
-            vkCmdBindIndexBuffer(cmd, mesh->GetIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
-            vkCmdDrawIndexed(cmd, mesh->GetIndexCount(), 1, 0, 0, 0);
+            // Descriptor set, vertex/index buffers: Pipeline::Record binds and draws
+            out.descriptorSet = ds;
+            out.vertexBuffer  = mesh->GetVertexBuffer();
+            out.indexBuffer   = mesh->GetIndexBuffer();
+            out.indexCount    = mesh->GetIndexCount();
         }
 
         // ALWAYS advance ring buffers and keep-alive, even when not drawing.
@@ -449,20 +482,97 @@ PipelineConfig graphics::TransparentPhongConfig(Texture2D* texture) {
         uniformBuffer->gpuBufferAllocation.Next();
         uniformBuffer->mappedData.Next();
         uniformBuffer->descriptorSets.Next();
+        return canDraw;
     };
 
     return config;
 }
 
 // ============================================================
-// Compose (offscreen → swapchain)
+// Descriptor sets of the fullscreen passes
 // ============================================================
 
-#include "offscreen_render_pass.h"
+// The fullscreen passes sample the same few image views frame after frame (the camera image
+// slots, the upscaler's two outputs, a graph attachment): instead of rewriting the frame's set,
+// each frame slot keeps a set per view combination seen, written once. A combination not seen
+// yet takes a new set or the slot's least recently used one: the GPU is done with the slot's
+// sets by the time it is prepared again. The version it is rewritten under tells recordings
+// that bind the set (PrerecordedDraw) they're stale.
+struct BakedDescriptorSets {
+    using Views = std::array<VkImageView, 2>;
+
+    struct Entry {
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        Views    views{};
+        uint64_t version = 0;   // 0 = to be (re)written
+        uint64_t lastUse = 0;
+    };
+
+    BakedDescriptorSets(std::string name, uint32_t setsPerSlot)
+            : name(std::move(name)), setsPerSlot(setsPerSlot) {}
+
+    /// Everything is rewritten on its next use: what the sets point to was recreated
+    void Invalidate() {
+        for (auto& slot : slots) {
+            for (Entry& entry : slot) entry.version = 0;
+        }
+    }
+
+    /// The set of `frameIndex` for `views`; `write` fills it if it doesn't hold them yet
+    const Entry& Get(Pipeline& pipeline, uint32_t frameIndex, const Views& views,
+                     const std::function<void(VkDescriptorSet set)>& write) {
+        static uint64_t nextVersion = 1;   // render thread only
+        std::vector<Entry>& slot = slots[frameIndex];
+        auto found = std::find_if(slot.begin(), slot.end(), [&views](const Entry& entry) {
+            return entry.version != 0 && entry.views == views;
+        });
+        if (found == slot.end()) {
+            // Stale sets first, then the least recently used
+            found = std::min_element(slot.begin(), slot.end(), [](const Entry& a, const Entry& b) {
+                return std::make_pair(a.version != 0, a.lastUse) < std::make_pair(b.version != 0, b.lastUse);
+            });
+            if (slot.size() < setsPerSlot && (found == slot.end() || found->version != 0)) {
+                Entry added;
+                added.set = pipeline.AllocateDescriptorSet();
+                debug::SetDescriptorSetName(pipeline.GetDevice(), added.set,
+                                            Concatenate(name, "DescSet[", frameIndex, "][", slot.size(), "]"));
+                slot.push_back(added);
+                found = slot.end() - 1;
+            }
+            write(found->set);
+            found->views = views;
+            found->version = nextVersion++;
+        }
+        found->lastUse = ++uses;
+        return *found;
+    }
+
+private:
+    std::string name;
+    uint32_t setsPerSlot;
+    std::array<std::vector<Entry>, MAX_FRAMES_IN_FLIGHT> slots;
+    uint64_t uses = 0;
+};
+
+static void FillFullscreenQuad(Renderable* obj, const BakedDescriptorSets::Entry& sets, DrawCommand& out) {
+    Mesh* mesh = obj->GetMesh();
+    assert(mesh != nullptr);
+    out.descriptorSet        = sets.set;
+    out.descriptorSetVersion = sets.version;
+    out.vertexBuffer         = mesh->GetVertexBuffer();
+    out.indexBuffer          = mesh->GetIndexBuffer();
+    out.indexCount           = mesh->GetIndexCount();
+}
+
+// ============================================================
+// Compose (offscreen → swapchain)
+// ============================================================
 
 struct ComposeState {
     VkSampler sampler = VK_NULL_HANDLE;
     VkDevice  device  = VK_NULL_HANDLE;
+    // Two per slot: the upscaler alternates between two outputs
+    BakedDescriptorSets sets{"Compose", 2};
 
     ~ComposeState() {
         if (sampler != VK_NULL_HANDLE)
@@ -471,10 +581,14 @@ struct ComposeState {
     }
 };
 
-PipelineConfig graphics::ComposeConfig(OffscreenRenderPass* offscreenPass) {
+// The compose pipelines differ in the fragment shader, how the image is bound, where its
+// view comes from and whether it pushes constants
+static PipelineConfig MakeComposeConfig(const char* fragmentShader, bool inputAttachment,
+                                        std::function<VkImageView()> imageView,
+                                        std::function<void(DrawCommand&)> pushConstants) {
     PipelineConfig config;
     config.vertexShader   = "compose.vert";
-    config.fragmentShader = "compose.frag";
+    config.fragmentShader = fragmentShader;
 
     // Fullscreen quad over the camera background: no depth test needed
     config.depthTestEnable  = false;
@@ -491,90 +605,109 @@ PipelineConfig graphics::ComposeConfig(OffscreenRenderPass* offscreenPass) {
 
     config.cullMode = VK_CULL_MODE_NONE;
 
+    // An input attachment reads the same pixel only, so the offscreen color can stay in tile memory
+    const VkDescriptorType descriptorType = inputAttachment ? VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT
+                                                            : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
     config.descriptorPoolSizes = {
-        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_DESCRIPTOR_SETS_PER_POOL}
+        {descriptorType, MAX_DESCRIPTOR_SETS_PER_POOL}
     };
 
     auto state = std::make_shared<ComposeState>();
 
-    config.renderCallback = [state, offscreenPass](VkCommandBuffer cmd, RDO* /*rdo*/, Renderable* obj,
-                                                    Pipeline& pipeline, uint32_t frameIndex) {
+    config.prepareCallback = [state, descriptorType, imageView, pushConstants](RDO* /*rdo*/, Renderable* obj,
+                                                                                Pipeline& pipeline, uint32_t frameIndex,
+                                                                                DrawCommand& out) {
         std::shared_ptr<UniformBuffer> ub = pipeline.GetUniformBuffer(obj->GetId());
         if (ub == nullptr) {
             state->device = pipeline.GetDevice();
 
-            // Create sampler
-            VkSamplerCreateInfo samplerInfo{};
-            samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-            samplerInfo.magFilter    = VK_FILTER_LINEAR;
-            samplerInfo.minFilter    = VK_FILTER_LINEAR;
-            samplerInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST;
-            samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-            samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-            samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-            VkResult r = vkCreateSampler(pipeline.GetDevice(), &samplerInfo, nullptr, &state->sampler);
-            assert(r == VK_SUCCESS);
+            // Create sampler (input attachments are read without one). Kept if the
+            // uniform buffer was collected while the compose was skipped
+            if (descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER && state->sampler == VK_NULL_HANDLE) {
+                VkSamplerCreateInfo samplerInfo{};
+                samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+                samplerInfo.magFilter    = VK_FILTER_LINEAR;
+                samplerInfo.minFilter    = VK_FILTER_LINEAR;
+                samplerInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+                samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+                samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+                samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+                VkResult r = vkCreateSampler(pipeline.GetDevice(), &samplerInfo, nullptr, &state->sampler);
+                assert(r == VK_SUCCESS);
+            }
 
+            // Holds nothing but the death counter: the sets are the state's
             ub = std::make_shared<UniformBuffer>();
             ub->size = 0;
             ub->id   = obj->GetId();
             ub->deathCounter = 100;
-
-            // Allocate descriptor sets (one per frame in flight)
-            for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-                ub->descriptorSets.Next() = pipeline.AllocateDescriptorSet();
-            }
-
             pipeline.AddUniformBuffer(obj->GetId(), ub);
-
-            for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-                debug::SetDescriptorSetName(pipeline.GetDevice(), ub->descriptorSets[i],
-                                            Concatenate("ComposeDescSet[", i, "]"));
-            }
         }
 
-        // Update the image binding every frame since the offscreen image is ring-buffered
-        VkDescriptorImageInfo imgInfo{};
-        imgInfo.sampler     = state->sampler;
-        imgInfo.imageView   = offscreenPass->GetColorImageView();
-        imgInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-        VkWriteDescriptorSet write{};
-        write.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        write.dstSet          = ub->descriptorSets.Current();
-        write.dstBinding      = 0;
-        write.descriptorCount = 1;
-        write.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        write.pImageInfo      = &imgInfo;
-
-        vkUpdateDescriptorSets(pipeline.GetDevice(), 1, &write, 0, nullptr);
-
-        // Bind and draw fullscreen quad
-        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                pipeline.GetPipelineLayout(), 0, 1,
-                                &ub->descriptorSets.Current(), 0, nullptr);
-
-        Mesh* mesh = obj->GetMesh();
-        assert(mesh != nullptr);
-        VkBuffer vertexBuffers[] = {mesh->GetVertexBuffer()};
-        VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers(cmd, 0, 1, vertexBuffers, offsets);
-        vkCmdBindIndexBuffer(cmd, mesh->GetIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
-        vkCmdDrawIndexed(cmd, mesh->GetIndexCount(), 1, 0, 0, 0);
-
+        const VkImageView view = imageView();
+        if (view == VK_NULL_HANDLE) return false;
+        const auto& sets = state->sets.Get(pipeline, frameIndex, {view, VK_NULL_HANDLE},
+                                           [&](VkDescriptorSet set) {
+            VkDescriptorImageInfo imgInfo{};
+            imgInfo.sampler     = state->sampler;
+            imgInfo.imageView   = view;
+            imgInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+            VkWriteDescriptorSet write{};
+            write.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet          = set;
+            write.dstBinding      = 0;
+            write.descriptorCount = 1;
+            write.descriptorType  = descriptorType;
+            write.pImageInfo      = &imgInfo;
+
+            vkUpdateDescriptorSets(pipeline.GetDevice(), 1, &write, 0, nullptr);
+        });
+
+        FillFullscreenQuad(obj, sets, out);
+        if (pushConstants) {
+            pushConstants(out);
+        }
         ub->deathCounter++;
-        ub->descriptorSets.Next();
+        return true;
     };
 
     return config;
 }
 
+PipelineConfig graphics::ComposeConfig(RenderGraph* graph, RenderGraph::ResourceId source, bool inputAttachment,
+                                       RenderGraph::PassId scaledPass) {
+    assert(!(inputAttachment && scaledPass != RenderGraph::NONE) && "input attachments are read at the same pixel");
+    auto imageView = [graph, source]() { return graph->GetImageView(source); };
+    if (scaledPass == RenderGraph::NONE) {
+        return MakeComposeConfig(inputAttachment ? "compose_input.frag" : "compose.frag", inputAttachment,
+                                 imageView, nullptr);
+    }
+    return MakeComposeConfig("compose_scaled.frag", false, imageView, [graph, scaledPass](DrawCommand& out) {
+        // The rendered part of the image, and its last texel centers: bilinear
+        // taps must not reach what an earlier, larger render area left outside
+        const VkExtent2D area = graph->GetRenderArea(scaledPass);
+        const VkExtent2D size = graph->GetExtent();
+        out.pushConstants = {
+            float(area.width) / size.width, float(area.height) / size.height,
+            (area.width - 0.5f) / size.width, (area.height - 0.5f) / size.height
+        };
+        out.pushConstantSize = sizeof(out.pushConstants);
+    });
+}
+
+PipelineConfig graphics::ComposeConfig(std::function<VkImageView()> imageView) {
+    return MakeComposeConfig("compose.frag", false, std::move(imageView), nullptr);
+}
+
 // ============================================================
 // Camera background
 // ============================================================
 
+// std140: two vec4s of screen-corner UVs (see camera_bg.vert)
 struct CameraBgUniformBuffer {
-    int32_t displayRotation;
+    float cornersTop[4];      // top-left.xy, top-right.xy
+    float cornersBottom[4];   // bottom-left.xy, bottom-right.xy
 };
 
 // Shared state for the camera background pipeline, destroyed when the
@@ -582,7 +715,9 @@ struct CameraBgUniformBuffer {
 struct CameraBgState {
     VkSampler sampler = VK_NULL_HANDLE;
     VkDevice  device  = VK_NULL_HANDLE;
-    bool      uboBindingsWritten = false;
+    // One per slot and camera image slot
+    BakedDescriptorSets sets{"CameraBg", MAX_FRAMES_IN_FLIGHT};
+    uint64_t cameraGeneration = 0;   // ARCameraImage::GetResourceGeneration the sets were written for
 
     ~CameraBgState() {
         if (sampler != VK_NULL_HANDLE) {
@@ -592,41 +727,44 @@ struct CameraBgState {
     }
 };
 
-PipelineConfig graphics::CameraBackgroundConfig(ARCameraImage* cameraImage,
-                                                 const int* displayRotation) {
+PipelineConfig graphics::CameraBackgroundConfig(ARCameraImage* cameraImage) {
+    // YCbCr mode: one multi-planar image behind an immutable conversion sampler
+    const bool ycbcr = cameraImage->UsesYcbcr();
+
     PipelineConfig config;
     config.vertexShader   = "camera_bg.vert";
-    config.fragmentShader = "camera_bg.frag";
+    config.fragmentShader = ycbcr ? "camera_bg_ycbcr.frag" : "camera_bg.frag";
 
-    // Depth test ALWAYS + write: the quad outputs z=1.0 (far plane),
-    // so everything else drawn later (with depthCompare LESS) will pass.
-    config.depthTestEnable  = true;
-    config.depthWriteEnable = true;
-    config.depthCompareOp   = VK_COMPARE_OP_ALWAYS;
+    // No depth: the quad is drawn first and at the far plane, and the
+    // backbuffer has no depth attachment (the AR layer has its own)
+    config.depthTestEnable  = false;
+    config.depthWriteEnable = false;
 
     config.blendEnable = false;
     config.cullMode    = VK_CULL_MODE_NONE;
 
     config.descriptorPoolSizes = {
         {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,         MAX_DESCRIPTOR_SETS_PER_POOL},
-        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,  MAX_DESCRIPTOR_SETS_PER_POOL * 2}  // Y + UV
+        // Y + UV, or the YCbCr image (which may cost the driver more than one descriptor)
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+         MAX_DESCRIPTOR_SETS_PER_POOL * (ycbcr ? cameraImage->GetYcbcrDescriptorCount() : 2)}
     };
 
     // Shared state captured by the lambda — destroyed when the pipeline dies
     auto state = std::make_shared<CameraBgState>();
 
-    config.renderCallback = [cameraImage, displayRotation, state](
-            VkCommandBuffer cmd, RDO* /*rdo*/, Renderable* obj,
-            Pipeline& pipeline, uint32_t frameIndex) {
+    config.prepareCallback = [cameraImage, state, ycbcr](
+            RDO* /*rdo*/, Renderable* obj, Pipeline& pipeline,
+            uint32_t frameIndex, DrawCommand& out) {
 
-        if (!cameraImage->IsValid()) return;
+        if (!cameraImage->IsValid()) return false;
 
         // -- First-time init: create sampler and UBO buffers --
         std::shared_ptr<UniformBuffer> ub = pipeline.GetUniformBuffer(obj->GetId());
         if (ub == nullptr) {
             state->device = pipeline.GetDevice();
 
-            // Create sampler (shared by Y and UV textures)
+            // Create sampler (shared by Y and UV textures; YCbCr mode uses the immutable one)
             VkSamplerCreateInfo samplerInfo{};
             samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
             samplerInfo.magFilter    = VK_FILTER_LINEAR;
@@ -635,9 +773,11 @@ PipelineConfig graphics::CameraBackgroundConfig(ARCameraImage* cameraImage,
             samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
             samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
             samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-            VkResult r = vkCreateSampler(pipeline.GetDevice(), &samplerInfo,
-                                         nullptr, &state->sampler);
-            assert(r == VK_SUCCESS);
+            if (!ycbcr && state->sampler == VK_NULL_HANDLE) {
+                VkResult r = vkCreateSampler(pipeline.GetDevice(), &samplerInfo,
+                                             nullptr, &state->sampler);
+                assert(r == VK_SUCCESS);
+            }
 
             // Create UBO buffers
             ub = std::make_shared<UniformBuffer>();
@@ -648,101 +788,78 @@ PipelineConfig graphics::CameraBackgroundConfig(ARCameraImage* cameraImage,
             ub->id   = obj->GetId();
             ub->deathCounter = 100;
 
-            // Allocate descriptor sets (one per FIF)
-            for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-                ub->descriptorSets.Next() = pipeline.AllocateDescriptorSet();
-            }
-
             pipeline.AddUniformBuffer(obj->GetId(), ub);
 
             for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
                 debug::SetBufferName(pipeline.GetDevice(), ub->gpuBuffer[i],
                                      Concatenate("CameraBgUBO[", i, "]"));
-                debug::SetDescriptorSetName(pipeline.GetDevice(), ub->descriptorSets[i],
-                                            Concatenate("CameraBgDescSet[", i, "]"));
             }
 
-            state->uboBindingsWritten = false;
+            // New UBO buffers: every set is rewritten
+            state->sets.Invalidate();
         }
-
-        // -- One-time: write UBO bindings for all descriptor sets --
-        if (!state->uboBindingsWritten) {
-            for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-                VkDescriptorBufferInfo bufInfo{};
-                bufInfo.buffer = ub->gpuBuffer[i];
-                bufInfo.offset = 0;
-                bufInfo.range  = sizeof(CameraBgUniformBuffer);
-
-                VkWriteDescriptorSet write{};
-                write.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                write.dstSet          = ub->descriptorSets[i];
-                write.dstBinding      = 0;
-                write.descriptorCount = 1;
-                write.descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-                write.pBufferInfo     = &bufInfo;
-
-                vkUpdateDescriptorSets(pipeline.GetDevice(), 1, &write, 0, nullptr);
-            }
-            state->uboBindingsWritten = true;
+        // Recreated camera images: their views may come back with the old handle values,
+        // so matching views say nothing about what the sets point to
+        if (state->cameraGeneration != cameraImage->GetResourceGeneration()) {
+            state->cameraGeneration = cameraImage->GetResourceGeneration();
+            state->sets.Invalidate();
         }
 
-        // -- Every frame: update Y and UV image bindings for current desc set --
-        {
-            VkDescriptorImageInfo yImgInfo{};
-            yImgInfo.sampler     = state->sampler;
-            yImgInfo.imageView   = cameraImage->GetCurrentYImageView();
-            yImgInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-            VkDescriptorImageInfo uvImgInfo{};
-            uvImgInfo.sampler     = state->sampler;
-            uvImgInfo.imageView   = cameraImage->GetCurrentUVImageView();
-            uvImgInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        // -- The set of this frame slot for the current camera image slot: written
+        // the first time that slot's views are seen, bound as is afterwards --
+        const BakedDescriptorSets::Views views = ycbcr
+                ? BakedDescriptorSets::Views{cameraImage->GetCurrentYcbcrImageView(), VK_NULL_HANDLE}
+                : BakedDescriptorSets::Views{cameraImage->GetCurrentYImageView(),
+                                             cameraImage->GetCurrentUVImageView()};
+        const auto& sets = state->sets.Get(pipeline, frameIndex, views, [&](VkDescriptorSet set) {
+            // Binding 0: this frame slot's UBO
+            VkDescriptorBufferInfo bufInfo{};
+            bufInfo.buffer = ub->gpuBuffer[frameIndex];
+            bufInfo.offset = 0;
+            bufInfo.range  = sizeof(CameraBgUniformBuffer);
+
+            // Bindings 1 (and 2): YCbCr texture (sampler immutable, baked into the
+            // layout), or the Y and UV textures
+            VkDescriptorImageInfo imgInfos[2]{};
+            for (uint32_t i = 0; i < 2; i++) {
+                imgInfos[i].sampler     = ycbcr ? VK_NULL_HANDLE : state->sampler;
+                imgInfos[i].imageView   = views[i];
+                imgInfos[i].imageLayout = cameraImage->GetSampledLayout();
+            }
 
-            VkWriteDescriptorSet writes[2]{};
-            // Binding 1: Y texture
+            VkWriteDescriptorSet writes[3]{};
             writes[0].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            writes[0].dstSet          = ub->descriptorSets.Current();
-            writes[0].dstBinding      = 1;
+            writes[0].dstSet          = set;
+            writes[0].dstBinding      = 0;
             writes[0].descriptorCount = 1;
-            writes[0].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            writes[0].pImageInfo      = &yImgInfo;
-            // Binding 2: UV texture
-            writes[1].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            writes[1].dstSet          = ub->descriptorSets.Current();
-            writes[1].dstBinding      = 2;
-            writes[1].descriptorCount = 1;
-            writes[1].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            writes[1].pImageInfo      = &uvImgInfo;
-
-            vkUpdateDescriptorSets(pipeline.GetDevice(), 2, writes, 0, nullptr);
-        }
+            writes[0].descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            writes[0].pBufferInfo     = &bufInfo;
+            const uint32_t textures = ycbcr ? 1 : 2;
+            for (uint32_t i = 0; i < textures; i++) {
+                writes[1 + i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[1 + i].dstSet          = set;
+                writes[1 + i].dstBinding      = 1 + i;
+                writes[1 + i].descriptorCount = 1;
+                writes[1 + i].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                writes[1 + i].pImageInfo      = &imgInfos[i];
+            }
 
-        // -- Update UBO data (display rotation) --
+            vkUpdateDescriptorSets(pipeline.GetDevice(), 1 + textures, writes, 0, nullptr);
+        });
+
+        // -- Update UBO data (screen corners in the current camera image) --
         CameraBgUniformBuffer data{};
-        data.displayRotation = *displayRotation;
-        memcpy(ub->mappedData.Current(), &data, sizeof(data));
+        const float* uvs = cameraImage->GetDisplayUVs();
+        std::copy(uvs, uvs + 4, data.cornersTop);
+        std::copy(uvs + 4, uvs + 8, data.cornersBottom);
+        memcpy(ub->mappedData[frameIndex], &data, sizeof(data));
         vmaFlushAllocation(pipeline.GetAllocator(),
-                           ub->gpuBufferAllocation.Current(),
+                           ub->gpuBufferAllocation[frameIndex],
                            0, sizeof(data));
 
-        // -- Bind and draw --
-        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                pipeline.GetPipelineLayout(), 0, 1,
-                                &ub->descriptorSets.Current(), 0, nullptr);
-
-        Mesh* mesh = obj->GetMesh();
-        assert(mesh != nullptr);
-        VkBuffer vertexBuffers[] = {mesh->GetVertexBuffer()};
-        VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers(cmd, 0, 1, vertexBuffers, offsets);
-        vkCmdBindIndexBuffer(cmd, mesh->GetIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
-        vkCmdDrawIndexed(cmd, mesh->GetIndexCount(), 1, 0, 0, 0);
-
+        FillFullscreenQuad(obj, sets, out);
         ub->deathCounter++;
-        ub->gpuBuffer.Next();
-        ub->gpuBufferAllocation.Next();
-        ub->mappedData.Next();
-        ub->descriptorSets.Next();
+        return true;
     };
 
     return config;
@@ -752,9 +869,9 @@ PipelineConfig graphics::CameraBackgroundConfig(ARCameraImage* cameraImage,
 // Shader loading
 // ============================================================
 
-static std::vector<uint8_t> LoadShaderBytes(const std::string& name) {
-    auto filePath = Concatenate("shaders/", name, ".spv");
-    auto data = io::AssetLoader::loadFile(filePath);
+static io::AssetView LoadShaderBytes(const std::string& name) {
+    const std::string filePath = "shaders/" + name + ".spv";
+    auto data = io::AssetLoader::openView(filePath);
     if (data.empty()) {
         LOGE("FATAL: Failed to load shader '%s'. The .spv file is missing or unreadable.", filePath.c_str());
         std::abort();
@@ -762,12 +879,21 @@ static std::vector<uint8_t> LoadShaderBytes(const std::string& name) {
     return data;
 }
 
-VkShaderModule Pipeline::CreateShaderModule(const std::vector<uint8_t>& data) {
+VkShaderModule Pipeline::CreateShaderModule(const io::AssetView& data) {
     VkShaderModuleCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
     createInfo.codeSize = data.size();
     createInfo.pCode = reinterpret_cast<const uint32_t*>(data.data());
 
+    // pCode must be 4-byte aligned. zipalign guarantees that for uncompressed
+    // assets, but be safe and copy if the mapping happens to be misaligned.
+    std::vector<uint32_t> aligned;
+    if (reinterpret_cast<uintptr_t>(data.data()) % alignof(uint32_t) != 0) {
+        aligned.resize((data.size() + 3) / 4);
+        memcpy(aligned.data(), data.data(), data.size());
+        createInfo.pCode = aligned.data();
+    }
+
     VkShaderModule shaderModule;
     VkResult result = vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule);
     if (result != VK_SUCCESS) {
@@ -791,8 +917,8 @@ Pipeline::Pipeline(RenderPass* renderPass,
     assert(this->pipelineLayout != VK_NULL_HANDLE);
     assert(this->descriptorSetLayout != VK_NULL_HANDLE);
     // --- Shader stages ---
-    std::vector<uint8_t> vsSrc = LoadShaderBytes(config.vertexShader);
-    std::vector<uint8_t> fsSrc = LoadShaderBytes(config.fragmentShader);
+    io::AssetView vsSrc = LoadShaderBytes(config.vertexShader);
+    io::AssetView fsSrc = LoadShaderBytes(config.fragmentShader);
     VkShaderModule vs = CreateShaderModule(vsSrc);
     VkShaderModule fs = CreateShaderModule(fsSrc);
 
@@ -923,7 +1049,7 @@ Pipeline::Pipeline(RenderPass* renderPass,
     pipelineInfo.pDynamicState = &dynamicState;
     pipelineInfo.layout = pipelineLayout;
     pipelineInfo.renderPass = renderPass->GetRenderPass();
-    pipelineInfo.subpass = 0;
+    pipelineInfo.subpass = config.subpass;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
     VkResult result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1,
@@ -950,6 +1076,7 @@ Pipeline::Pipeline(RenderPass* renderPass,
                                  Concatenate("DescPool:", config.vertexShader, "+", config.fragmentShader));
 
     renderCallback = config.renderCallback;
+    prepareCallback = config.prepareCallback;
     LOGI("Pipeline created (vs=%s, fs=%s)", config.vertexShader.c_str(),
          config.fragmentShader.c_str());
 }
@@ -980,9 +1107,37 @@ void Pipeline::Bind(VkCommandBuffer cmd) const {
 }
 
 void Pipeline::Draw(VkCommandBuffer cmd, RDO *rdo, Renderable *renderable, uint32_t frameIndex) {
+    if (prepareCallback) {
+        DrawCommand draw;
+        if (Prepare(rdo, renderable, frameIndex, draw)) {
+            Record(cmd, draw);
+        }
+        return;
+    }
     renderCallback(cmd, rdo, renderable, *this, frameIndex);
 }
 
+bool Pipeline::Prepare(RDO *rdo, Renderable *renderable, uint32_t frameIndex, DrawCommand &out) {
+    assert(prepareCallback && "pipeline has no prepareCallback");
+    return prepareCallback(rdo, renderable, *this, frameIndex, out);
+}
+
+void Pipeline::Record(VkCommandBuffer cmd, const DrawCommand &draw) const {
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            pipelineLayout, 0, 1,
+                            &draw.descriptorSet, 0, nullptr);
+    if (draw.pushConstantSize > 0) {
+        vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT,
+                           0, draw.pushConstantSize, draw.pushConstants.data());
+    }
+
+    VkBuffer vertexBuffers[] = {draw.vertexBuffer};
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers(cmd, 0, 1, vertexBuffers, offsets);
+    vkCmdBindIndexBuffer(cmd, draw.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+    vkCmdDrawIndexed(cmd, draw.indexCount, 1, 0, 0, 0);
+}
+
 VkDescriptorSet Pipeline::AllocateDescriptorSet() {
     VkDescriptorSetAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
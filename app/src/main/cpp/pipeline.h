@@ -2,10 +2,14 @@
 #define KRAKATOA_PIPELINE_H
 #include <string>
 #include <vector>
+#include <array>
 #include <vulkan/vulkan_core.h>
 #include <functional>
 #include <unordered_map>
 #include "ring_buffer.h"
+#include "asset_view.h"
+#include "resource_cache.h"
+#include "render_graph.h"
 #include <vk_mem_alloc.h>
 
 namespace graphics {
@@ -15,7 +19,23 @@ namespace graphics {
     class Pipeline;
     class ARCameraImage;
     class Texture2D;
-    class OffscreenRenderPass;
+
+    /**
+     * Everything recording one indexed draw needs, resolved up front by a
+     * pipeline's prepareCallback. Recording it only reads these handles, so
+     * it can happen on any thread.
+     */
+    struct DrawCommand {
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        /// New whenever descriptorSet is rewritten (0 = not tracked): recordings of older versions are stale
+        uint64_t descriptorSetVersion = 0;
+        VkBuffer vertexBuffer = VK_NULL_HANDLE;
+        VkBuffer indexBuffer = VK_NULL_HANDLE;
+        uint32_t indexCount = 0;
+        /// Fragment push constants, for layouts that have them
+        std::array<float, 4> pushConstants{};
+        uint32_t pushConstantSize = 0;
+    };
 
     /**
      * Configuration for the variable parts of a graphics pipeline.
@@ -55,11 +75,18 @@ namespace graphics {
         // --- Input assembly ---
         VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
         bool primitiveRestartEnable = false;
+        // --- Subpass of the render pass the pipeline is used in (RenderGraph::GetSubpass)
+        uint32_t subpass = 0;
         // --- Descriptor pool sizes (config-driven, each pipeline declares what it needs) ---
         std::vector<VkDescriptorPoolSize> descriptorPoolSizes;
         // --- Actual drawing, varies between the pipelines bc each pipeline uses different fields and send different data to the shaders
         std::function<void(VkCommandBuffer cmd,
                 RDO* rdo, Renderable* obj, Pipeline& pipeline, uint32_t frameIndex)> renderCallback;
+        // --- Or drawing split in two, so the draw can be recorded on a worker thread:
+        // on the render thread, update uniforms/descriptors and fill the DrawCommand;
+        // return false to skip the draw. Used instead of renderCallback when set.
+        std::function<bool(RDO* rdo, Renderable* obj, Pipeline& pipeline, uint32_t frameIndex,
+                DrawCommand& out)> prepareCallback;
     };
     /**
      * The uniform buffer for an object in a pipeline.
@@ -95,16 +122,16 @@ namespace graphics {
 
     /**
      * Camera background: renders the AR camera feed onto a fullscreen quad.
-     * Depth test ALWAYS + depth write, so it fills the far plane (z=1.0).
-     * No blending, no culling. The vertex shader rotates UVs based on
-     * the display rotation so the landscape camera image appears correct
-     * in portrait/landscape/etc.
+     * No depth test or write: drawn first, into a pass without depth attachment.
+     * No blending, no culling. The vertex shader maps the screen corners to
+     * ARCameraImage::GetDisplayUVs(), which covers display rotation, the
+     * aspect-fill crop and the region of the camera image that was uploaded.
+     * Prepare-only: a descriptor set per frame slot and camera image slot,
+     * written once, so the draw can be kept recorded (PrerecordedDraw).
      *
      * @param cameraImage  pointer to the ARCameraImage (ring-buffered GPU texture)
-     * @param displayRotation  pointer to the current Android display rotation (0-3)
      */
-    PipelineConfig CameraBackgroundConfig(ARCameraImage* cameraImage,
-                                          const int* displayRotation);
+    PipelineConfig CameraBackgroundConfig(ARCameraImage* cameraImage);
 
     /**
      * Transparent Phong: alpha-blended, lit by AR scene lighting.
@@ -115,19 +142,38 @@ namespace graphics {
      * Uses ARCore ambient intensity light estimation: the render callback
      * reads LIGHT_DIR, LIGHT_COLOR and AMBIENT_COLOR from the RDO.
      *
-     * @param texture  Texture to sample. If null, uses a 1x1 white placeholder.
+     * @param texture  Cached texture to sample. If empty, uses a 1x1 white placeholder.
+     *                 Descriptors are refreshed if the cache reloads it.
      */
-    PipelineConfig TransparentPhongConfig(Texture2D* texture);
+    PipelineConfig TransparentPhongConfig(TextureHandle texture);
 
     /**
-     * Compose: alpha-blends the offscreen render pass color attachment over
-     * whatever is already in the swapchain framebuffer.
-     * Uses a fullscreen quad with a single combined image sampler (binding 0).
-     * The offscreen image view is re-bound each frame since it's ring-buffered.
+     * Compose: alpha-blends the offscreen color attachment over whatever is
+     * already in the swapchain framebuffer.
+     * Uses a fullscreen quad with a single combined image sampler (binding 0),
+     * or with `inputAttachment` a subpass input (binding 0, compose_input.frag)
+     * for a compose pass in the same render pass as the offscreen draws.
+     * Prepare-only. Its descriptor set is rewritten only when the image view
+     * changes (the graph recreates it on Compile()).
+     *
+     * With `scaledPass` (dynamic resolution) only the render area of that
+     * pass is composited, stretched over the screen: compose_scaled.frag with
+     * its UV scale and clamp as fragment push constants (2 x vec2).
      *
-     * @param offscreenPass  The offscreen render pass whose color image to composite.
+     * @param graph       The render graph owning the image.
+     * @param source      The graph attachment to composite, sampled (or read as input) by the compose pass.
+     * @param scaledPass  Pass that renders `source` within a render area, or RenderGraph::NONE.
      */
-    PipelineConfig ComposeConfig(OffscreenRenderPass* offscreenPass);
+    PipelineConfig ComposeConfig(RenderGraph* graph, RenderGraph::ResourceId source, bool inputAttachment = false,
+                                 RenderGraph::PassId scaledPass = RenderGraph::NONE);
+
+    /**
+     * Compose of an image that isn't a graph resource (TemporalUpscaler's
+     * output): compose.frag over the whole screen. `imageView` is called per
+     * frame and the image must be in SHADER_READ_ONLY_OPTIMAL by the compose.
+     * Each frame slot keeps a set for each of the two views the upscaler alternates between.
+     */
+    PipelineConfig ComposeConfig(std::function<VkImageView()> imageView);
 
     /**
      * A Vulkan graphics pipeline built from a PipelineConfig.
@@ -164,6 +210,14 @@ namespace graphics {
          * */
         void Draw(VkCommandBuffer cmd, RDO* rdo, Renderable* renderable,
                   uint32_t frameIndex);
+        /**
+         * First half of Draw for pipelines with a prepareCallback. Render thread only.
+         * @return false if there is nothing to draw
+         */
+        bool Prepare(RDO* rdo, Renderable* renderable, uint32_t frameIndex, DrawCommand& out);
+        bool CanPrepare() const { return static_cast<bool>(prepareCallback); }
+        /// Second half: records a prepared draw. Thread safe, one thread per command buffer.
+        void Record(VkCommandBuffer cmd, const DrawCommand& draw) const;
         VkPipeline GetPipeline() const { return pipeline; }
         VkDevice GetDevice() const {return device;}
         VmaAllocator GetAllocator()const {return allocator;}
@@ -190,7 +244,8 @@ namespace graphics {
         VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
         VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
         std::function<void(VkCommandBuffer cmd, RDO* rdo, Renderable* obj, Pipeline& pipeline, uint32_t frameIndex)> renderCallback;
-        VkShaderModule CreateShaderModule(const std::vector<uint8_t>& data);
+        std::function<bool(RDO* rdo, Renderable* obj, Pipeline& pipeline, uint32_t frameIndex, DrawCommand& out)> prepareCallback;
+        VkShaderModule CreateShaderModule(const io::AssetView& data);
         std::unordered_map<uint64_t, std::shared_ptr<UniformBuffer>> uniformBuffers;
     };
 }
@@ -13,6 +13,9 @@ namespace graphics {
      *       .AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
      *       .AddBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
      *       .Build();
+     *
+     * Immutable samplers (required for YCbCr conversion samplers) are passed as
+     * a pointer to `count` samplers that must stay valid until Build().
      */
     class DescriptorSetLayoutBuilder {
     public:
@@ -21,13 +24,14 @@ namespace graphics {
         DescriptorSetLayoutBuilder& AddBinding(uint32_t binding,
                                                VkDescriptorType type,
                                                VkShaderStageFlags stageFlags,
-                                               uint32_t count = 1) {
+                                               uint32_t count = 1,
+                                               const VkSampler* immutableSamplers = nullptr) {
             VkDescriptorSetLayoutBinding b{};
             b.binding = binding;
             b.descriptorType = type;
             b.descriptorCount = count;
             b.stageFlags = stageFlags;
-            b.pImmutableSamplers = nullptr;
+            b.pImmutableSamplers = immutableSamplers;
             bindings.push_back(b);
             return *this;
         }
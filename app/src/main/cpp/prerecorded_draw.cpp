@@ -0,0 +1,107 @@
+#include "prerecorded_draw.h"
+#include "render_pass.h"
+#include "vk_debug.h"
+#include "concatenate.h"
+#include "android_log.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+using namespace graphics;
+
+PrerecordedDraw::PrerecordedDraw(VkDevice device, uint32_t queueFamilyIndex, std::string name,
+                                 uint32_t recordingsPerSlot)
+        : device(device), name(std::move(name)), recordingsPerSlot(recordingsPerSlot) {
+    assert(recordingsPerSlot > 0);
+    // Recordings are re-recorded one at a time: each is reset by its vkBeginCommandBuffer
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = queueFamilyIndex;
+    VkResult result = vkCreateCommandPool(device, &poolInfo, nullptr, &pool);
+    assert(result == VK_SUCCESS);
+    LOGI("PrerecordedDraw %s created", this->name.c_str());
+}
+
+PrerecordedDraw::~PrerecordedDraw() {
+    // Frees the secondaries with it
+    vkDestroyCommandPool(device, pool, nullptr);
+    LOGI("PrerecordedDraw %s destroyed: %llu of %llu executions recorded", name.c_str(),
+         static_cast<unsigned long long>(recordings), static_cast<unsigned long long>(executions));
+}
+
+bool PrerecordedDraw::SameKey(const Key& a, const Key& b) {
+    return a.pipeline == b.pipeline && a.renderPass == b.renderPass && a.subpass == b.subpass &&
+           a.extent.width == b.extent.width && a.extent.height == b.extent.height &&
+           std::memcmp(&a.scissor, &b.scissor, sizeof(VkRect2D)) == 0 &&
+           a.draw.descriptorSet == b.draw.descriptorSet &&
+           a.draw.descriptorSetVersion == b.draw.descriptorSetVersion &&
+           a.draw.vertexBuffer == b.draw.vertexBuffer && a.draw.indexBuffer == b.draw.indexBuffer &&
+           a.draw.indexCount == b.draw.indexCount && a.draw.pushConstantSize == b.draw.pushConstantSize &&
+           a.draw.pushConstants == b.draw.pushConstants;
+}
+
+void PrerecordedDraw::Execute(RenderGraph::PassContext& ctx, Pipeline& pipeline, Renderable* renderable,
+                              uint32_t frameIndex) {
+    ctx.Begin(VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    Key key;
+    if (!pipeline.Prepare(nullptr, renderable, frameIndex, key.draw)) return;
+    key.pipeline = pipeline.GetPipeline();
+    key.renderPass = ctx.GetRenderPass();
+    key.subpass = ctx.GetSubpass();
+    key.extent = ctx.GetExtent();
+    key.scissor = ctx.GetScissor();
+
+    std::vector<Recording>& slot = slots[frameIndex];
+    auto found = std::find_if(slot.begin(), slot.end(), [&key](const Recording& recording) {
+        return SameKey(recording.key, key);
+    });
+    if (found == slot.end()) {
+        if (slot.size() < recordingsPerSlot) {
+            Recording added;
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = pool;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandBufferCount = 1;
+            VkResult result = vkAllocateCommandBuffers(device, &allocInfo, &added.cmd);
+            assert(result == VK_SUCCESS);
+            debug::SetObjectName(device, reinterpret_cast<uint64_t>(added.cmd), VK_OBJECT_TYPE_COMMAND_BUFFER,
+                                 Concatenate(name, "[", frameIndex, "][", slot.size(), "]"));
+            slot.push_back(added);
+            found = slot.end() - 1;
+        } else {
+            found = std::min_element(slot.begin(), slot.end(), [](const Recording& a, const Recording& b) {
+                return a.lastUse < b.lastUse;
+            });
+        }
+        Record(*found, key, pipeline);
+    }
+    found->lastUse = ++executions;
+    vkCmdExecuteCommands(ctx.GetCommandBuffer(), 1, &found->cmd);
+}
+
+void PrerecordedDraw::Record(Recording& recording, const Key& key, const Pipeline& pipeline) {
+    VkCommandBufferInheritanceInfo inheritance{};
+    inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance.renderPass = key.renderPass;
+    inheritance.subpass = key.subpass;
+    inheritance.framebuffer = VK_NULL_HANDLE;   // any swapchain image's
+
+    // Executed again every frame the draw doesn't change: neither one-time nor simultaneous,
+    // as each frame slot has its own
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritance;
+    VkResult result = vkBeginCommandBuffer(recording.cmd, &beginInfo);
+    assert(result == VK_SUCCESS);
+    // Dynamic state is not inherited from the primary
+    RenderPass::SetViewportAndScissor(recording.cmd, key.extent, key.scissor);
+    pipeline.Bind(recording.cmd);
+    pipeline.Record(recording.cmd, key.draw);
+    result = vkEndCommandBuffer(recording.cmd);
+    assert(result == VK_SUCCESS);
+
+    recording.key = key;
+    recordings++;
+}
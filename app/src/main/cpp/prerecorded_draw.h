@@ -0,0 +1,90 @@
+#ifndef KRAKATOA_PRERECORDED_DRAW_H
+#define KRAKATOA_PRERECORDED_DRAW_H
+#include <vulkan/vulkan.h>
+#include <array>
+#include <string>
+#include <vector>
+#include "pipeline.h"
+#include "render_graph.h"
+namespace graphics {
+
+    /**
+     * A draw that is the same frame after frame (the fullscreen passes),
+     * kept recorded in secondary command buffers instead of recorded anew.
+     *
+     * Each frame slot keeps up to `recordingsPerSlot` recordings, one per
+     * distinct draw it has seen (the camera background has one per camera
+     * image slot, the upscaled compose one per output image). Execute()
+     * prepares the draw and looks for the slot's recording of it: same
+     * pipeline, render pass and subpass, viewport and scissor, descriptor
+     * set and version (DrawCommand::descriptorSetVersion), buffers and push
+     * constants. Only a miss records, into the slot's least recently used
+     * secondary, which the GPU is done with since the slot's last frame. In
+     * practice that's after Compile() (swapchain change: new render pass and
+     * pipelines), when the sampled views change (the camera images recreated
+     * for a display rotation: the baked sets are rewritten under a new
+     * version even if a view handle value comes back) and when the scissor
+     * or push constants change (damage region, dynamic resolution).
+     *
+     * The framebuffer is left out of the inheritance: one recording serves
+     * every swapchain image. The secondaries come from the object's own pool,
+     * so destroy it only once the GPU is done with them.
+     *
+     * Usage:
+     *   PrerecordedDraw draw(device, graphicsFamily, "CameraBackground", MAX_FRAMES_IN_FLIGHT);
+     *   // in the pass's RenderGraph callback, instead of ctx.Begin() + pipeline.Draw()
+     *   draw.Execute(ctx, pipeline, quad, frameIndex);
+     */
+    class PrerecordedDraw {
+    public:
+        PrerecordedDraw(VkDevice device, uint32_t queueFamilyIndex, std::string name, uint32_t recordingsPerSlot);
+        ~PrerecordedDraw();
+
+        PrerecordedDraw(const PrerecordedDraw&) = delete;
+        PrerecordedDraw& operator=(const PrerecordedDraw&) = delete;
+
+        /**
+         * Begins the subpass of the graph pass `ctx` belongs to for
+         * secondaries and executes the recording of `pipeline`'s draw of
+         * `renderable`, recording it first if it's new. Executes nothing if
+         * the pipeline has nothing to draw. Passes sharing the subpass must
+         * use secondaries too.
+         *
+         * @param pipeline  a pipeline with a prepareCallback
+         */
+        void Execute(RenderGraph::PassContext& ctx, Pipeline& pipeline, Renderable* renderable, uint32_t frameIndex);
+
+        /// Executions and, of them, the ones that had to record
+        uint64_t GetExecuteCount() const { return executions; }
+        uint64_t GetRecordCount() const { return recordings; }
+        const std::string& GetName() const { return name; }
+
+    private:
+        /// What a recording depends on
+        struct Key {
+            VkPipeline   pipeline = VK_NULL_HANDLE;
+            VkRenderPass renderPass = VK_NULL_HANDLE;
+            uint32_t     subpass = 0;
+            VkExtent2D   extent = {0, 0};
+            VkRect2D     scissor = {};
+            DrawCommand  draw;
+        };
+        struct Recording {
+            VkCommandBuffer cmd = VK_NULL_HANDLE;
+            Key      key;
+            uint64_t lastUse = 0;
+        };
+
+        VkDevice device;
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::string name;
+        uint32_t recordingsPerSlot;
+        std::array<std::vector<Recording>, MAX_FRAMES_IN_FLIGHT> slots;
+        uint64_t executions = 0;
+        uint64_t recordings = 0;
+
+        static bool SameKey(const Key& a, const Key& b);
+        void Record(Recording& recording, const Key& key, const Pipeline& pipeline);
+    };
+}
+#endif //KRAKATOA_PRERECORDED_DRAW_H
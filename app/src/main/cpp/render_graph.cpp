@@ -0,0 +1,1112 @@
+#include "render_graph.h"
+#include "gpu_timer.h"
+#include "vk_debug.h"
+#include "android_log.h"
+#include "concatenate.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+using namespace graphics;
+
+// ============================================================
+// Helpers
+// ============================================================
+
+static bool IsDepthFormat(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_D16_UNORM:
+        case VK_FORMAT_X8_D24_UNORM_PACK32:
+        case VK_FORMAT_D32_SFLOAT:
+        case VK_FORMAT_D16_UNORM_S8_UINT:
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool HasStencil(VkFormat format) {
+    return format == VK_FORMAT_D16_UNORM_S8_UINT ||
+           format == VK_FORMAT_D24_UNORM_S8_UINT ||
+           format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+}
+
+static const char* LayoutName(VkImageLayout layout) {
+    switch (layout) {
+        case VK_IMAGE_LAYOUT_UNDEFINED:                        return "UNDEFINED";
+        case VK_IMAGE_LAYOUT_GENERAL:                          return "GENERAL";
+        case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:         return "COLOR_ATTACHMENT";
+        case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL: return "DEPTH_STENCIL_ATTACHMENT";
+        case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:         return "SHADER_READ_ONLY";
+        case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:                  return "PRESENT_SRC";
+        default:                                               return "OTHER";
+    }
+}
+
+/// Bytes per pixel of the attachment formats the graph sees
+static uint32_t FormatSize(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_D16_UNORM:             return 2;
+        case VK_FORMAT_D16_UNORM_S8_UINT:     return 3;
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:    return 5;
+        case VK_FORMAT_R16G16B16A16_SFLOAT:   return 8;
+        default:                              return 4;   // RGBA8/BGRA8, D24S8, D32, X8D24
+    }
+}
+
+static std::string MiB(VkDeviceSize bytes) {
+    char text[32];
+    snprintf(text, sizeof(text), "%.1f MiB", bytes / (1024.0 * 1024.0));
+    return text;
+}
+
+/// VMA's device-local usage and budget, summed over the heaps
+static void DeviceLocalUsage(VmaAllocator allocator, VkDeviceSize& usage, VkDeviceSize& budget) {
+    const VkPhysicalDeviceMemoryProperties* props = nullptr;
+    vmaGetMemoryProperties(allocator, &props);
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+    vmaGetHeapBudgets(allocator, budgets);
+    usage = 0;
+    budget = 0;
+    for (uint32_t i = 0; i < props->memoryHeapCount; i++) {
+        if (props->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+            usage += budgets[i].usage;
+            budget += budgets[i].budget;
+        }
+    }
+}
+
+static const char* LoadOpName(VkAttachmentLoadOp op) {
+    switch (op) {
+        case VK_ATTACHMENT_LOAD_OP_LOAD:  return "LOAD";
+        case VK_ATTACHMENT_LOAD_OP_CLEAR: return "CLEAR";
+        default:                          return "DONT_CARE";
+    }
+}
+
+// ============================================================
+// Declaration
+// ============================================================
+
+RenderGraph::RenderGraph(VkDevice device, VmaAllocator allocator)
+        : device(device), allocator(allocator) {
+}
+
+RenderGraph::~RenderGraph() {
+    Destroy();
+    LOGI("RenderGraph destroyed");
+}
+
+RenderGraph::ResourceId RenderGraph::AddResource(const std::string& name, ResourceKind kind,
+                                                 VkFormat format, VkImageLayout finalLayout) {
+    Resource resource;
+    resource.name = name;
+    resource.kind = kind;
+    resource.format = format;
+    resource.finalLayout = finalLayout;
+    resources.push_back(resource);
+    return static_cast<ResourceId>(resources.size() - 1);
+}
+
+RenderGraph::ResourceId RenderGraph::CreateAttachment(const std::string& name, VkFormat format) {
+    return AddResource(name, ResourceKind::Attachment, format, VK_IMAGE_LAYOUT_UNDEFINED);
+}
+
+RenderGraph::ResourceId RenderGraph::ImportImage(const std::string& name, VkFormat format,
+                                                 VkImageLayout finalLayout) {
+    return AddResource(name, ResourceKind::Imported, format, finalLayout);
+}
+
+RenderGraph::ResourceId RenderGraph::ImportExternal(const std::string& name) {
+    return AddResource(name, ResourceKind::External, VK_FORMAT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED);
+}
+
+RenderGraph::PassBuilder RenderGraph::AddPass(const std::string& name) {
+    Pass pass;
+    pass.name = name;
+    passes.push_back(std::move(pass));
+    return PassBuilder(*this, static_cast<PassId>(passes.size() - 1));
+}
+
+void RenderGraph::AddUse(PassId pass, const Use& use) {
+    assert(use.resource < resources.size());
+    const ResourceKind kind = resources[use.resource].kind;
+    assert((kind == ResourceKind::External) == (use.type == UseType::External) &&
+           "external resources only take Read()/Write(), images only the typed uses");
+    assert(!(kind == ResourceKind::Imported && (use.type == UseType::Sampled || use.type == UseType::Input)) &&
+           "imported images are render targets: their owner synchronizes other uses");
+    for (const Use& other : passes[pass].uses) {
+        assert(other.resource != use.resource && "a pass uses a resource once");
+        (void)other;
+    }
+    (void)kind;
+    passes[pass].uses.push_back(use);
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::WriteColor(ResourceId id) {
+    graph.AddUse(pass, {id, UseType::Color, true, false, {}, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT});
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::ClearColor(ResourceId id, VkClearColorValue value) {
+    VkClearValue clear{};
+    clear.color = value;
+    graph.AddUse(pass, {id, UseType::Color, true, true, clear, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT});
+    return *this;
+}
+
+static constexpr VkPipelineStageFlags2 DEPTH_STAGES =
+        VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::WriteDepth(ResourceId id) {
+    graph.AddUse(pass, {id, UseType::Depth, true, false, {}, DEPTH_STAGES});
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::ClearDepth(ResourceId id, VkClearDepthStencilValue value) {
+    VkClearValue clear{};
+    clear.depthStencil = value;
+    graph.AddUse(pass, {id, UseType::Depth, true, true, clear, DEPTH_STAGES});
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::ReadInput(ResourceId id) {
+    graph.AddUse(pass, {id, UseType::Input, false, false, {}, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT});
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::Sample(ResourceId id, VkPipelineStageFlags2 stage) {
+    graph.AddUse(pass, {id, UseType::Sampled, false, false, {}, stage});
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::Read(ResourceId id) {
+    graph.AddUse(pass, {id, UseType::External, false, false, {}, VK_PIPELINE_STAGE_2_NONE});
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::Write(ResourceId id) {
+    graph.AddUse(pass, {id, UseType::External, true, false, {}, VK_PIPELINE_STAGE_2_NONE});
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::SideEffects() {
+    graph.passes[pass].sideEffects = true;
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::Execute(ExecuteCallback callback) {
+    graph.passes[pass].execute = std::move(callback);
+    return *this;
+}
+
+// ============================================================
+// Compile
+// ============================================================
+
+VkImageLayout RenderGraph::UseLayout(UseType type) {
+    switch (type) {
+        case UseType::Color: return VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        case UseType::Depth: return VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        default:             return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+}
+
+VkAccessFlags2 RenderGraph::UseAccess(UseType type) {
+    switch (type) {
+        case UseType::Color:   return VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+        case UseType::Depth:   return VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                                      VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        case UseType::Input:   return VK_ACCESS_2_INPUT_ATTACHMENT_READ_BIT;
+        case UseType::Sampled: return VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+        default:               return VK_ACCESS_2_NONE;
+    }
+}
+
+void RenderGraph::Compile(VkExtent2D newExtent) {
+    VkDeviceSize budget = 0;
+    DeviceLocalUsage(allocator, usageBefore[0], budget);
+    Destroy();
+    DeviceLocalUsage(allocator, usageBefore[1], budget);
+    extent = newExtent;
+    for (Pass& pass : passes) {
+        pass.step = NONE;
+        pass.subpass = NONE;
+    }
+
+    Cull();
+    BuildSteps();
+    for (Step& step : steps) step.renderArea = extent;
+    AllocateImages();
+
+    // Two rounds: the first one leaves every allocation and image as the end
+    // of a frame does, so the second one sees what the previous frame left.
+    std::vector<ResourceState> slotStates(memorySlots.size());
+    std::vector<VkImageLayout> layouts(resources.size(), VK_IMAGE_LAYOUT_UNDEFINED);
+    for (int round = 0; round < 2; ++round) {
+        for (uint32_t i = 0; i < steps.size(); ++i) {
+            if (steps[i].graphics) {
+                BuildRenderPass(steps[i], i, slotStates, layouts, round == 1);
+            }
+        }
+    }
+
+    WriteSchedule();
+}
+
+void RenderGraph::Cull() {
+    // Backwards from what leaves the graph. Twice, so a write feeding the next
+    // frame (a resource read before it's written) keeps its pass too.
+    std::vector<bool> needed(resources.size(), false);
+    std::vector<bool> kept(passes.size(), false);
+    for (int round = 0; round < 2; ++round) {
+        for (size_t p = passes.size(); p-- > 0;) {
+            const Pass& pass = passes[p];
+            bool keep = kept[p] || pass.sideEffects;
+            for (const Use& use : pass.uses) {
+                if (use.write && (resources[use.resource].kind != ResourceKind::Attachment || needed[use.resource])) {
+                    keep = true;
+                }
+            }
+            if (!keep) continue;
+            kept[p] = true;
+            for (const Use& use : pass.uses) {
+                // Reads, and writes keeping the contents, need the earlier writers
+                if (!use.write || !use.clear) {
+                    needed[use.resource] = true;
+                }
+            }
+        }
+    }
+    for (size_t p = 0; p < passes.size(); ++p) {
+        passes[p].step = kept[p] ? 0 : NONE;
+    }
+}
+
+void RenderGraph::BuildSteps() {
+    auto attachmentUses = [](const Pass& pass) {
+        std::vector<std::pair<UseType, ResourceId>> list;
+        for (const Use& use : pass.uses) {
+            if (IsAttachment(use.type)) list.emplace_back(use.type, use.resource);
+        }
+        return list;
+    };
+    auto writtenIn = [this](const Step& step, ResourceId resource) {
+        for (PassId p : step.passes) {
+            for (const Use& use : passes[p].uses) {
+                if (use.resource == resource && use.write) return true;
+            }
+        }
+        return false;
+    };
+
+    for (PassId p = 0; p < passes.size(); ++p) {
+        Pass& pass = passes[p];
+        if (pass.step == NONE) continue;
+        const auto uses = attachmentUses(pass);
+
+        if (uses.empty()) {
+            Step step;
+            step.name = pass.name;
+            step.passes.push_back(p);
+            steps.push_back(std::move(step));
+            pass.step = static_cast<uint32_t>(steps.size() - 1);
+            continue;
+        }
+
+        // Merge into the render pass before if this pass continues on its attachments,
+        // doesn't sample anything it wrote (that needs the render pass to end) and
+        // doesn't clear one of them (only the load op clears)
+        if (!steps.empty() && steps.back().graphics) {
+            Step& current = steps.back();
+            bool continues = false;
+            bool samplesOutput = false;
+            bool clearsUsed = false;
+            for (PassId other : current.passes) {
+                for (const Use& theirs : passes[other].uses) {
+                    for (const Use& mine : pass.uses) {
+                        if (mine.resource != theirs.resource) continue;
+                        if (IsAttachment(mine.type) &&
+                            IsAttachment(theirs.type)) continues = true;
+                        if (mine.type == UseType::Sampled && theirs.write) samplesOutput = true;
+                        if (mine.clear) clearsUsed = true;
+                    }
+                }
+            }
+            // Input attachments only exist within a render pass: a pass drawing
+            // the attachment a later pass reads this render pass's output into
+            // joins it as well (the camera background under the input-attachment compose)
+            for (PassId q = p + 1; q < passes.size() && !continues; ++q) {
+                const Pass& later = passes[q];
+                if (later.step == NONE) continue;
+                if (attachmentUses(later).empty()) break;
+                bool readsStep = false;
+                bool sharesMine = false;
+                for (const Use& theirs : later.uses) {
+                    if (theirs.type == UseType::Input && writtenIn(current, theirs.resource)) readsStep = true;
+                    for (const Use& mine : pass.uses) {
+                        if (mine.resource == theirs.resource && IsAttachment(mine.type) &&
+                            IsAttachment(theirs.type)) sharesMine = true;
+                    }
+                }
+                continues = readsStep && sharesMine;
+            }
+            if (continues && !samplesOutput && !clearsUsed) {
+                // The pass that opened the last subpass defines its attachments
+                const uint32_t lastSubpass = current.subpassCount - 1;
+                PassId opener = current.passes.back();
+                for (PassId other : current.passes) {
+                    if (passes[other].subpass == lastSubpass) { opener = other; break; }
+                }
+                // Same color attachments, same or no depth, no input reads:
+                // drawing on in the same subpass
+                const auto theirs = attachmentUses(passes[opener]);
+                auto colors = [](const std::vector<std::pair<UseType, ResourceId>>& list) {
+                    std::vector<ResourceId> ids;
+                    for (const auto& use : list) if (use.first == UseType::Color) ids.push_back(use.second);
+                    return ids;
+                };
+                bool sameSubpass = colors(uses) == colors(theirs);
+                for (const auto& use : uses) {
+                    if (use.first == UseType::Input) sameSubpass = false;
+                    if (use.first == UseType::Depth &&
+                        std::find(theirs.begin(), theirs.end(), use) == theirs.end()) sameSubpass = false;
+                }
+                if (sameSubpass) {
+                    pass.subpass = lastSubpass;
+                } else {
+                    pass.subpass = current.subpassCount++;
+                }
+                current.name += "+" + pass.name;
+                current.passes.push_back(p);
+                pass.step = static_cast<uint32_t>(steps.size() - 1);
+                continue;
+            }
+        }
+
+        Step step;
+        step.name = pass.name;
+        step.graphics = true;
+        step.subpassCount = 1;
+        step.passes.push_back(p);
+        steps.push_back(std::move(step));
+        pass.step = static_cast<uint32_t>(steps.size() - 1);
+        pass.subpass = 0;
+    }
+
+    // Lifetimes, usage, and which attachments carry contents from frame to frame
+    for (uint32_t i = 0; i < steps.size(); ++i) {
+        for (PassId p : steps[i].passes) {
+            for (const Use& use : passes[p].uses) {
+                Resource& resource = resources[use.resource];
+                if (resource.firstStep == NONE) {
+                    resource.firstStep = i;
+                    resource.persistent = resource.kind == ResourceKind::Attachment && !(use.write && use.clear);
+                }
+                resource.lastStep = i;
+                switch (use.type) {
+                    case UseType::Color:   resource.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT; break;
+                    case UseType::Depth:   resource.usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT; break;
+                    case UseType::Input:   resource.usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT; break;
+                    case UseType::Sampled: resource.usage |= VK_IMAGE_USAGE_SAMPLED_BIT; break;
+                    default: break;
+                }
+            }
+        }
+    }
+    // Attachments living within one render pass never need memory: on tilers
+    // they stay in tile memory, backed by lazily allocated memory if any
+    for (Resource& resource : resources) {
+        if (resource.kind != ResourceKind::Attachment || resource.firstStep == NONE) continue;
+        resource.transient = resource.firstStep == resource.lastStep && !resource.persistent &&
+                             (resource.usage & VK_IMAGE_USAGE_SAMPLED_BIT) == 0;
+        if (resource.transient) resource.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+    }
+}
+
+void RenderGraph::AllocateImages() {
+    // Graph attachments by first use: each takes the first allocation nobody uses anymore
+    std::vector<ResourceId> order;
+    for (ResourceId r = 0; r < resources.size(); ++r) {
+        if (resources[r].kind == ResourceKind::Attachment && resources[r].firstStep != NONE) {
+            order.push_back(r);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [this](ResourceId a, ResourceId b) {
+        return resources[a].firstStep < resources[b].firstStep;
+    });
+
+    for (ResourceId r : order) {
+        Resource& resource = resources[r];
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = resource.format;
+        imageInfo.extent = {extent.width, extent.height, 1};
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = resource.usage;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkResult result = vkCreateImage(device, &imageInfo, nullptr, &resource.image);
+        assert(result == VK_SUCCESS);
+        debug::SetImageName(device, resource.image, resource.name);
+
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(device, resource.image, &requirements);
+
+        // Persistent contents can't share: their lifetime is the whole frame
+        resource.memorySlot = NONE;
+        if (!resource.persistent) {
+            for (uint32_t s = 0; s < memorySlots.size(); ++s) {
+                MemorySlot& slot = memorySlots[s];
+                if (slot.lastStep < resource.firstStep && slot.transient == resource.transient &&
+                    (slot.requirements.memoryTypeBits & requirements.memoryTypeBits) != 0) {
+                    resource.memorySlot = s;
+                    break;
+                }
+            }
+        }
+        if (resource.memorySlot == NONE) {
+            memorySlots.emplace_back();
+            memorySlots.back().requirements = requirements;
+            memorySlots.back().transient = resource.transient;
+            resource.memorySlot = static_cast<uint32_t>(memorySlots.size() - 1);
+        }
+        MemorySlot& slot = memorySlots[resource.memorySlot];
+        slot.requirements.size = std::max(slot.requirements.size, requirements.size);
+        slot.requirements.alignment = std::max(slot.requirements.alignment, requirements.alignment);
+        slot.requirements.memoryTypeBits &= requirements.memoryTypeBits;
+        slot.lastStep = resource.persistent ? static_cast<uint32_t>(steps.size()) : resource.lastStep;
+        slot.resources.push_back(r);
+    }
+
+    for (MemorySlot& slot : memorySlots) {
+        VmaAllocationCreateInfo allocInfo{};
+        VkResult result = VK_ERROR_FEATURE_NOT_PRESENT;
+        if (slot.transient) {
+            // Only tilers have a lazily allocated memory type; elsewhere it's ordinary memory
+            allocInfo.usage = VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED;
+            result = vmaAllocateMemory(allocator, &slot.requirements, &allocInfo, &slot.allocation, nullptr);
+            slot.lazy = result == VK_SUCCESS;
+        }
+        if (!slot.lazy) {
+            allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+            result = vmaAllocateMemory(allocator, &slot.requirements, &allocInfo, &slot.allocation, nullptr);
+        }
+        assert(result == VK_SUCCESS);
+        for (ResourceId r : slot.resources) {
+            Resource& resource = resources[r];
+            result = vmaBindImageMemory(allocator, slot.allocation, resource.image);
+            assert(result == VK_SUCCESS);
+
+            VkImageViewCreateInfo viewInfo{};
+            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewInfo.image = resource.image;
+            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.format = resource.format;
+            viewInfo.subresourceRange = {IsDepthFormat(resource.format) ? VK_IMAGE_ASPECT_DEPTH_BIT
+                                                                        : VK_IMAGE_ASPECT_COLOR_BIT,
+                                         0, 1, 0, 1};
+            result = vkCreateImageView(device, &viewInfo, nullptr, &resource.view);
+            assert(result == VK_SUCCESS);
+            debug::SetImageViewName(device, resource.view, Concatenate(resource.name, "View"));
+        }
+    }
+}
+
+const RenderGraph::Use* RenderGraph::NextUse(ResourceId resource, uint32_t stepIndex, bool& nextFrame) const {
+    const uint32_t count = static_cast<uint32_t>(steps.size());
+    for (uint32_t k = 1; k <= count; ++k) {
+        const uint32_t i = (stepIndex + k) % count;
+        for (PassId p : steps[i].passes) {
+            for (const Use& use : passes[p].uses) {
+                if (use.resource == resource) {
+                    nextFrame = stepIndex + k >= count;
+                    return &use;
+                }
+            }
+        }
+    }
+    return nullptr;
+}
+
+void RenderGraph::BuildRenderPass(Step& step, uint32_t stepIndex, std::vector<ResourceState>& slotStates,
+                                  std::vector<VkImageLayout>& layouts, bool record) {
+    // Attachments in order of first use, and what every subpass does with them
+    struct Usage {
+        uint32_t subpass;
+        const Use* use;
+    };
+    std::vector<ResourceId> attached;
+    std::vector<std::vector<Usage>> usages;
+    std::vector<std::vector<const Use*>> subpassUses(step.subpassCount);
+    for (PassId p : step.passes) {
+        const Pass& pass = passes[p];
+        const bool opensSubpass = subpassUses[pass.subpass].empty();
+        for (const Use& use : pass.uses) {
+            if (!IsAttachment(use.type)) continue;
+            auto it = std::find(attached.begin(), attached.end(), use.resource);
+            if (it == attached.end()) {
+                attached.push_back(use.resource);
+                usages.emplace_back();
+                it = attached.end() - 1;
+            }
+            auto& list = usages[it - attached.begin()];
+            if (list.empty() || list.back().subpass != pass.subpass) {
+                list.push_back({pass.subpass, &use});
+            }
+            if (opensSubpass) subpassUses[pass.subpass].push_back(&use);
+        }
+    }
+
+    std::vector<VkAttachmentDescription> descriptions(attached.size());
+    std::vector<VkClearValue> clearValues(attached.size());
+    std::vector<ResourceState> after(attached.size());
+    // Dependencies by (src, dst) subpass, NONE for EXTERNAL; merged per pair
+    struct Dependency {
+        VkPipelineStageFlags2 srcStages = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2        srcAccess = VK_ACCESS_2_NONE;
+        VkPipelineStageFlags2 dstStages = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2        dstAccess = VK_ACCESS_2_NONE;
+    };
+    std::map<std::pair<uint32_t, uint32_t>, Dependency> dependencies;
+    auto addDependency = [&](uint32_t src, uint32_t dst, VkPipelineStageFlags2 srcStages, VkAccessFlags2 srcAccess,
+                             VkPipelineStageFlags2 dstStages, VkAccessFlags2 dstAccess) {
+        Dependency& dep = dependencies[{src, dst}];
+        dep.srcStages |= srcStages;
+        dep.srcAccess |= srcAccess;
+        dep.dstStages |= dstStages;
+        dep.dstAccess |= dstAccess;
+    };
+
+    for (size_t a = 0; a < attached.size(); ++a) {
+        const ResourceId r = attached[a];
+        const Resource& resource = resources[r];
+        const Use& first = *usages[a].front().use;
+        const Usage& last = usages[a].back();
+        const bool depth = IsDepthFormat(resource.format);
+
+        VkAttachmentDescription& desc = descriptions[a];
+        desc.format = resource.format;
+        desc.samples = VK_SAMPLE_COUNT_1_BIT;
+        const bool hasContents = resource.firstStep < stepIndex || resource.persistent;
+        if (first.clear) {
+            desc.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            clearValues[a] = first.clearValue;
+        } else {
+            desc.loadOp = hasContents ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        }
+        desc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        desc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        desc.initialLayout = desc.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD ? layouts[r] : VK_IMAGE_LAYOUT_UNDEFINED;
+
+        bool nextFrame = false;
+        const Use* next = NextUse(r, stepIndex, nextFrame);
+        const bool imported = resource.kind == ResourceKind::Imported;
+        const bool needed = imported || (next != nullptr && (!nextFrame || resource.persistent));
+        desc.storeOp = needed ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        if (next != nullptr && !nextFrame) {
+            desc.finalLayout = UseLayout(next->type);
+        } else if (imported) {
+            desc.finalLayout = resource.finalLayout;
+        } else {
+            desc.finalLayout = UseLayout(last.use->type);
+        }
+
+        // In: from whatever touched the memory last (the previous frame, or an alias)
+        const VkPipelineStageFlags2 firstStages = first.stage;
+        const VkAccessFlags2 firstAccess = UseAccess(first.type);
+        if (imported) {
+            // Only the acquire semaphore, waited on at this stage
+            addDependency(NONE, usages[a].front().subpass, firstStages, VK_ACCESS_2_NONE, firstStages, firstAccess);
+        } else {
+            const ResourceState& previous = slotStates[resource.memorySlot];
+            addDependency(NONE, usages[a].front().subpass,
+                          previous.writeStage | previous.readStages, previous.writeAccess,
+                          firstStages, firstAccess);
+        }
+        // Between the subpasses using it
+        for (size_t u = 1; u < usages[a].size(); ++u) {
+            const Use& src = *usages[a][u - 1].use;
+            const Use& dst = *usages[a][u].use;
+            addDependency(usages[a][u - 1].subpass, usages[a][u].subpass,
+                          src.stage, UseAccess(src.type) & BarrierBatch::WRITE_ACCESS,
+                          dst.stage, UseAccess(dst.type));
+        }
+
+        // Out: to the samplers reading it later this frame, up to its next write
+        ResourceState& state = after[a];
+        state.writeStage = depth ? DEPTH_STAGES : VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+        state.writeAccess = depth ? VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+                                  : VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+        bool written = false;
+        for (uint32_t i = stepIndex + 1; i < steps.size() && !written; ++i) {
+            for (PassId p : steps[i].passes) {
+                for (const Use& use : passes[p].uses) {
+                    if (use.resource != r) continue;
+                    if (use.write || use.type != UseType::Sampled) written = true;
+                    else {
+                        state.readStages |= use.stage;
+                        state.readAccess |= VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+                    }
+                }
+            }
+        }
+        if (state.readStages != VK_PIPELINE_STAGE_2_NONE) {
+            addDependency(last.subpass, NONE, state.writeStage, state.writeAccess,
+                          state.readStages, state.readAccess);
+        }
+        state.layout = desc.finalLayout;
+
+        if (!imported) slotStates[resource.memorySlot] = state;
+        layouts[r] = desc.finalLayout;
+    }
+
+    if (!record) return;
+
+    step.attachments.clear();
+    for (size_t a = 0; a < attached.size(); ++a) {
+        step.attachments.push_back({attached[a], descriptions[a], after[a]});
+    }
+
+    // Subpasses, from the uses of the pass opening each one
+    std::vector<std::vector<VkAttachmentReference>> colorRefs(step.subpassCount);
+    std::vector<std::vector<VkAttachmentReference>> inputRefs(step.subpassCount);
+    std::vector<VkAttachmentReference> depthRefs(step.subpassCount, {VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED});
+    for (uint32_t s = 0; s < step.subpassCount; ++s) {
+        for (const Use* use : subpassUses[s]) {
+            const auto index = static_cast<uint32_t>(
+                    std::find(attached.begin(), attached.end(), use->resource) - attached.begin());
+            const VkAttachmentReference ref{index, UseLayout(use->type)};
+            switch (use->type) {
+                case UseType::Color: colorRefs[s].push_back(ref); break;
+                case UseType::Depth: depthRefs[s] = ref; break;
+                case UseType::Input: inputRefs[s].push_back(ref); break;
+                default: break;
+            }
+        }
+    }
+    // A subpass that doesn't reference an attachment leaves its contents undefined unless it
+    // preserves it: every attachment used both before and after it (the offscreen color across
+    // the camera background subpass, on its way to the compose)
+    std::vector<std::vector<uint32_t>> preserveRefs(step.subpassCount);
+    for (uint32_t s = 0; s < step.subpassCount; ++s) {
+        auto referenced = [&](uint32_t index) {
+            auto has = [index](const std::vector<VkAttachmentReference>& refs) {
+                return std::any_of(refs.begin(), refs.end(),
+                                   [index](const VkAttachmentReference& ref) { return ref.attachment == index; });
+            };
+            return has(colorRefs[s]) || has(inputRefs[s]) || depthRefs[s].attachment == index;
+        };
+        for (size_t a = 0; a < attached.size(); ++a) {
+            const auto index = static_cast<uint32_t>(a);
+            if (usages[a].front().subpass < s && s < usages[a].back().subpass && !referenced(index)) {
+                preserveRefs[s].push_back(index);
+            }
+        }
+    }
+    std::vector<VkSubpassDescription> subpasses(step.subpassCount);
+    for (uint32_t s = 0; s < step.subpassCount; ++s) {
+        VkSubpassDescription& subpass = subpasses[s];
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = static_cast<uint32_t>(colorRefs[s].size());
+        subpass.pColorAttachments = colorRefs[s].data();
+        subpass.inputAttachmentCount = static_cast<uint32_t>(inputRefs[s].size());
+        subpass.pInputAttachments = inputRefs[s].data();
+        subpass.pDepthStencilAttachment = depthRefs[s].attachment != VK_ATTACHMENT_UNUSED ? &depthRefs[s] : nullptr;
+        subpass.preserveAttachmentCount = static_cast<uint32_t>(preserveRefs[s].size());
+        subpass.pPreserveAttachments = preserveRefs[s].data();
+    }
+
+    // vkCreateRenderPass takes 1.0 masks
+    std::vector<VkSubpassDependency> legacyDependencies;
+    for (const auto& [key, dep] : dependencies) {
+        VkSubpassDependency legacy{};
+        legacy.srcSubpass = key.first == NONE ? VK_SUBPASS_EXTERNAL : key.first;
+        legacy.dstSubpass = key.second == NONE ? VK_SUBPASS_EXTERNAL : key.second;
+        legacy.srcStageMask = BarrierBatch::LegacyStages(dep.srcStages);
+        legacy.dstStageMask = BarrierBatch::LegacyStages(dep.dstStages);
+        // Nothing to wait for yet (first frame): still a valid mask
+        if (legacy.srcStageMask == 0) legacy.srcStageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        legacy.srcAccessMask = BarrierBatch::LegacyAccess(dep.srcAccess);
+        legacy.dstAccessMask = BarrierBatch::LegacyAccess(dep.dstAccess);
+        // Between subpasses only the same pixel is involved
+        if (key.first != NONE && key.second != NONE) legacy.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+        legacyDependencies.push_back(legacy);
+    }
+
+    VkRenderPassCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    createInfo.attachmentCount = static_cast<uint32_t>(descriptions.size());
+    createInfo.pAttachments = descriptions.data();
+    createInfo.subpassCount = static_cast<uint32_t>(subpasses.size());
+    createInfo.pSubpasses = subpasses.data();
+    createInfo.dependencyCount = static_cast<uint32_t>(legacyDependencies.size());
+    createInfo.pDependencies = legacyDependencies.data();
+
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkResult result = vkCreateRenderPass(device, &createInfo, nullptr, &renderPass);
+    assert(result == VK_SUCCESS);
+    step.renderPass = std::make_unique<CompiledRenderPass>(device, renderPass, step.name, std::move(clearValues));
+}
+
+void RenderGraph::WriteSchedule() {
+    uint32_t culled = 0;
+    for (const Pass& pass : passes) culled += pass.step == NONE ? 1 : 0;
+
+    schedule = Concatenate("RenderGraph ", extent.width, "x", extent.height, ": ",
+                           passes.size(), " passes, ", culled, " culled, ", steps.size(), " steps\n");
+    for (uint32_t i = 0; i < steps.size(); ++i) {
+        const Step& step = steps[i];
+        if (!step.graphics) {
+            schedule += Concatenate("  [", i, "] ", step.name, "\n");
+            continue;
+        }
+        schedule += Concatenate("  [", i, "] render pass ", step.name, " (", step.subpassCount, " subpasses)\n");
+        for (uint32_t s = 0; s < step.subpassCount; ++s) {
+            schedule += Concatenate("        subpass ", s, ":");
+            for (PassId p : step.passes) {
+                if (passes[p].subpass == s) schedule += " " + passes[p].name;
+            }
+            schedule += "\n";
+        }
+        for (const Attachment& attachment : step.attachments) {
+            const VkAttachmentDescription& d = attachment.description;
+            schedule += Concatenate("        ", resources[attachment.resource].name, " ",
+                                    LoadOpName(d.loadOp), "/",
+                                    d.storeOp == VK_ATTACHMENT_STORE_OP_STORE ? "STORE" : "DONT_CARE", " ",
+                                    LayoutName(d.initialLayout), " -> ", LayoutName(d.finalLayout), "\n");
+        }
+    }
+    for (const Pass& pass : passes) {
+        if (pass.step == NONE) schedule += "  culled: " + pass.name + "\n";
+    }
+    VkDeviceSize total = 0;
+    VkDeviceSize lazy = 0;
+    for (uint32_t s = 0; s < memorySlots.size(); ++s) {
+        const MemorySlot& slot = memorySlots[s];
+        const char* kind = slot.lazy ? ", lazy" : slot.transient ? ", transient, no lazy memory" : "";
+        schedule += Concatenate("  memory ", s, " (", MiB(slot.requirements.size), kind, "):");
+        for (ResourceId r : slot.resources) schedule += " " + resources[r].name;
+        schedule += "\n";
+        (slot.lazy ? lazy : total) += slot.requirements.size;
+    }
+    schedule += Concatenate("  attachment memory: ", MiB(total), " + ", MiB(lazy), " lazily allocated\n");
+    // Lazily allocated memory counts at full size here: VMA doesn't know what the driver committed
+    VkDeviceSize usage = 0;
+    VkDeviceSize budget = 0;
+    DeviceLocalUsage(allocator, usage, budget);
+    schedule += Concatenate("  VMA device-local usage: ", MiB(usageBefore[0]), " before, ",
+                            MiB(usageBefore[1]), " without attachments, ", MiB(usage), " after (budget ",
+                            MiB(budget), ")\n");
+
+    // What the load/store ops and the samplers move through memory every frame
+    traffic = {};
+    for (const Step& step : steps) {
+        for (const Attachment& attachment : step.attachments) {
+            const VkDeviceSize size = ImageSize(attachment.resource);
+            if (attachment.description.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD) traffic.read += size;
+            if (attachment.description.storeOp == VK_ATTACHMENT_STORE_OP_STORE) traffic.written += size;
+        }
+        for (PassId p : step.passes) {
+            for (const Use& use : passes[p].uses) {
+                if (use.type == UseType::Sampled) traffic.read += ImageSize(use.resource);
+            }
+        }
+    }
+    schedule += Concatenate("  attachment traffic: ", MiB(traffic.read + traffic.written), "/frame (",
+                            MiB(traffic.read), " read, ", MiB(traffic.written), " written)\n");
+
+    // One line per log call: logcat truncates long messages
+    size_t begin = 0;
+    while (begin < schedule.size()) {
+        const size_t end = schedule.find('\n', begin);
+        LOGI("%s", schedule.substr(begin, end - begin).c_str());
+        begin = end + 1;
+    }
+}
+
+void RenderGraph::Destroy() {
+    for (Step& step : steps) {
+        for (const auto& [views, framebuffer] : step.framebuffers) {
+            vkDestroyFramebuffer(device, framebuffer, nullptr);
+        }
+    }
+    steps.clear();   // destroys the render passes
+    for (Resource& resource : resources) {
+        if (resource.kind == ResourceKind::Attachment) {
+            if (resource.view != VK_NULL_HANDLE) vkDestroyImageView(device, resource.view, nullptr);
+            if (resource.image != VK_NULL_HANDLE) vkDestroyImage(device, resource.image, nullptr);
+            resource.view = VK_NULL_HANDLE;
+            resource.image = VK_NULL_HANDLE;
+        }
+        resource.usage = 0;
+        resource.firstStep = NONE;
+        resource.lastStep = NONE;
+        resource.persistent = false;
+        resource.transient = false;
+        resource.memorySlot = NONE;
+        resource.state = {};
+    }
+    for (MemorySlot& slot : memorySlots) {
+        if (slot.allocation != VK_NULL_HANDLE) vmaFreeMemory(allocator, slot.allocation);
+    }
+    memorySlots.clear();
+}
+
+RenderGraph::CompiledRenderPass::CompiledRenderPass(VkDevice device, VkRenderPass renderPass,
+                                                     const std::string& name,
+                                                     std::vector<VkClearValue> clearValues) {
+    this->device = device;
+    this->renderPass = renderPass;
+    this->debugName = name;
+    this->clearValues = std::move(clearValues);
+    debug::SetRenderPassName(device, renderPass, name);
+}
+
+RenderGraph::CompiledRenderPass::~CompiledRenderPass() {
+    DestroyRenderPass();
+}
+
+RenderPass* RenderGraph::GetRenderPass(PassId pass) const {
+    const uint32_t step = passes[pass].step;
+    return step == NONE ? nullptr : steps[step].renderPass.get();
+}
+
+uint32_t RenderGraph::GetSubpass(PassId pass) const {
+    return passes[pass].subpass;
+}
+
+// ============================================================
+// Execute
+// ============================================================
+
+void RenderGraph::SetRenderArea(PassId pass, VkExtent2D area) {
+    const uint32_t step = passes[pass].step;
+    assert(step != NONE && steps[step].graphics && "render area of a culled or non-graphics pass");
+    assert(area.width > 0 && area.height > 0 && area.width <= extent.width && area.height <= extent.height);
+    steps[step].renderArea = area;
+}
+
+VkExtent2D RenderGraph::GetRenderArea(PassId pass) const {
+    const uint32_t step = passes[pass].step;
+    return step == NONE ? extent : steps[step].renderArea;
+}
+
+void RenderGraph::SetScissor(PassId pass, VkRect2D rect) {
+    assert(passes[pass].step == NONE || steps[passes[pass].step].graphics);
+    passes[pass].scissored = true;
+    passes[pass].scissor = rect;
+}
+
+void RenderGraph::ResetScissor(PassId pass) {
+    passes[pass].scissored = false;
+}
+
+void RenderGraph::SetEnabled(PassId pass, bool enabled) {
+    passes[pass].enabled = enabled;
+}
+
+VkRect2D RenderGraph::PassScissor(const Pass& pass, const Step& step) const {
+    const VkRect2D full = {{0, 0}, step.renderArea};
+    if (!pass.scissored) return full;
+    // Clipped to the render area, which may have shrunk since
+    const int32_t x0 = std::clamp<int32_t>(pass.scissor.offset.x, 0, step.renderArea.width);
+    const int32_t y0 = std::clamp<int32_t>(pass.scissor.offset.y, 0, step.renderArea.height);
+    const int32_t x1 = std::clamp<int32_t>(pass.scissor.offset.x + static_cast<int32_t>(pass.scissor.extent.width),
+                                           x0, step.renderArea.width);
+    const int32_t y1 = std::clamp<int32_t>(pass.scissor.offset.y + static_cast<int32_t>(pass.scissor.extent.height),
+                                           y0, step.renderArea.height);
+    return {{x0, y0}, {static_cast<uint32_t>(x1 - x0), static_cast<uint32_t>(y1 - y0)}};
+}
+
+VkRect2D RenderGraph::StepArea(const Step& step) const {
+    bool any = false;
+    int32_t x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    for (PassId p : step.passes) {
+        const Pass& pass = passes[p];
+        if (!pass.enabled) continue;
+        const VkRect2D rect = PassScissor(pass, step);
+        const int32_t rx1 = rect.offset.x + static_cast<int32_t>(rect.extent.width);
+        const int32_t ry1 = rect.offset.y + static_cast<int32_t>(rect.extent.height);
+        x0 = any ? std::min(x0, rect.offset.x) : rect.offset.x;
+        y0 = any ? std::min(y0, rect.offset.y) : rect.offset.y;
+        x1 = any ? std::max(x1, rx1) : rx1;
+        y1 = any ? std::max(y1, ry1) : ry1;
+        any = true;
+    }
+    // Vulkan wants a non-empty render area: a step without any would have been skipped
+    if (!any || x1 <= x0 || y1 <= y0) return {{0, 0}, step.renderArea};
+    return {{x0, y0}, {static_cast<uint32_t>(x1 - x0), static_cast<uint32_t>(y1 - y0)}};
+}
+
+void RenderGraph::SetImageView(ResourceId id, VkImageView view) {
+    assert(resources[id].kind == ResourceKind::Imported);
+    resources[id].view = view;
+}
+
+VkDeviceSize RenderGraph::ImageSize(ResourceId id) const {
+    return VkDeviceSize(extent.width) * extent.height * FormatSize(resources[id].format);
+}
+
+VkImageSubresourceRange RenderGraph::FullRange(ResourceId id) const {
+    const VkFormat format = resources[id].format;
+    VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+    if (IsDepthFormat(format)) {
+        aspect = VK_IMAGE_ASPECT_DEPTH_BIT | (HasStencil(format) ? VK_IMAGE_ASPECT_STENCIL_BIT : 0);
+    }
+    return {aspect, 0, 1, 0, 1};
+}
+
+VkFramebuffer RenderGraph::GetFramebuffer(Step& step) {
+    std::vector<VkImageView> views;
+    for (const Attachment& attachment : step.attachments) {
+        const VkImageView view = resources[attachment.resource].view;
+        assert(view != VK_NULL_HANDLE && "imported image not bound: SetImageView()");
+        views.push_back(view);
+    }
+    // One per swapchain image when an imported image is attached, cached until Compile()
+    auto it = step.framebuffers.find(views);
+    if (it != step.framebuffers.end()) return it->second;
+
+    VkFramebufferCreateInfo fbInfo{};
+    fbInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    fbInfo.renderPass = step.renderPass->GetRenderPass();
+    fbInfo.attachmentCount = static_cast<uint32_t>(views.size());
+    fbInfo.pAttachments = views.data();
+    fbInfo.width = extent.width;
+    fbInfo.height = extent.height;
+    fbInfo.layers = 1;
+
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    VkResult result = vkCreateFramebuffer(device, &fbInfo, nullptr, &framebuffer);
+    assert(result == VK_SUCCESS);
+    debug::SetFramebufferName(device, framebuffer,
+                              Concatenate(step.name, "Framebuffer[", step.framebuffers.size(), "]"));
+    step.framebuffers.emplace(std::move(views), framebuffer);
+    return framebuffer;
+}
+
+void RenderGraph::Execute(VkCommandBuffer cmd) {
+    for (uint32_t i = 0; i < steps.size(); ++i) {
+        Step& step = steps[i];
+        const bool enabled = std::any_of(step.passes.begin(), step.passes.end(),
+                                         [this](PassId p) { return passes[p].enabled; });
+        if (!enabled) continue;   // nothing recorded: every attachment keeps its state
+
+        // Normally a no-op: the render pass dependencies already cover these.
+        // Left for sampled reads of persistent images and the first frame
+        // after Compile(), when LOADed images are still UNDEFINED.
+        for (PassId p : step.passes) {
+            if (!passes[p].enabled) continue;
+            for (const Use& use : passes[p].uses) {
+                Resource& resource = resources[use.resource];
+                if (use.type == UseType::Sampled && resource.kind == ResourceKind::Attachment) {
+                    barriers.UseImage(resource.image, FullRange(use.resource), resource.state, use.stage,
+                                      VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+                }
+            }
+        }
+        for (const Attachment& attachment : step.attachments) {
+            Resource& resource = resources[attachment.resource];
+            const VkAttachmentDescription& d = attachment.description;
+            if (resource.kind == ResourceKind::Attachment && d.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD &&
+                resource.state.layout != d.initialLayout) {
+                barriers.UseImage(resource.image, FullRange(attachment.resource), resource.state,
+                                  attachment.after.writeStage, attachment.after.writeAccess, d.initialLayout, true);
+            }
+        }
+        barriers.Flush(cmd);
+
+        PassContext ctx;
+        ctx.graph = this;
+        ctx.cmd = cmd;
+        ctx.step = i;
+        if (!step.graphics) {
+            const Pass& pass = passes[step.passes.front()];
+            debug::BeginLabel(cmd, pass.name);
+            if (pass.execute) pass.execute(ctx);
+            debug::EndLabel(cmd);
+            if (gpuTimer) gpuTimer->Split(cmd, step.name);
+            continue;
+        }
+
+        ctx.framebuffer = GetFramebuffer(step);
+        ctx.extent = step.renderArea;
+        ctx.area = StepArea(step);
+        openSubpass = NONE;
+        for (PassId p : step.passes) {
+            const Pass& pass = passes[p];
+            ctx.subpass = pass.subpass;
+            ctx.scissor = PassScissor(pass, step);
+            if (pass.enabled && pass.execute) pass.execute(ctx);
+            if (openSubpass != pass.subpass) BeginSubpass(ctx, VK_SUBPASS_CONTENTS_INLINE);
+        }
+        FinishRenderPass(step, cmd);
+        if (gpuTimer) gpuTimer->Split(cmd, step.name);
+    }
+}
+
+void RenderGraph::BeginSubpass(PassContext& ctx, VkSubpassContents contents) {
+    assert(ctx.subpass != NONE && "Begin() is for graphics passes");
+    Step& step = steps[ctx.step];
+    if (openSubpass == ctx.subpass) {
+        assert(contents == openContents && "passes sharing a subpass need the same contents");
+        // The second pass of a subpass may draw in another part of it
+        if (contents == VK_SUBPASS_CONTENTS_INLINE && std::memcmp(&openScissor, &ctx.scissor, sizeof(VkRect2D)) != 0) {
+            vkCmdSetScissor(ctx.cmd, 0, 1, &ctx.scissor);
+            openScissor = ctx.scissor;
+        }
+        return;
+    }
+    assert(openSubpass == NONE || openSubpass < ctx.subpass);
+    if (openSubpass == NONE) {
+        step.renderPass->Begin(ctx.cmd, ctx.framebuffer, ctx.extent, ctx.area,
+                               ctx.subpass == 0 ? contents : VK_SUBPASS_CONTENTS_INLINE);
+        if (ctx.subpass == 0 && contents == VK_SUBPASS_CONTENTS_INLINE) {
+            vkCmdSetScissor(ctx.cmd, 0, 1, &ctx.scissor);
+        }
+        openSubpass = 0;
+    }
+    while (openSubpass < ctx.subpass) {
+        ++openSubpass;
+        const VkSubpassContents subpassContents = openSubpass == ctx.subpass ? contents
+                                                                             : VK_SUBPASS_CONTENTS_INLINE;
+        vkCmdNextSubpass(ctx.cmd, subpassContents);
+        if (subpassContents == VK_SUBPASS_CONTENTS_INLINE) {
+            RenderPass::SetViewportAndScissor(ctx.cmd, ctx.extent, ctx.scissor);
+        }
+    }
+    openContents = contents;
+    openScissor = ctx.scissor;
+}
+
+void RenderGraph::FinishRenderPass(Step& step, VkCommandBuffer cmd) {
+    while (openSubpass + 1 < step.subpassCount) {
+        ++openSubpass;
+        vkCmdNextSubpass(cmd, VK_SUBPASS_CONTENTS_INLINE);
+    }
+    step.renderPass->End(cmd);
+    for (const Attachment& attachment : step.attachments) {
+        resources[attachment.resource].state = attachment.after;
+    }
+    openSubpass = NONE;
+}
+
+VkRenderPass RenderGraph::PassContext::GetRenderPass() const {
+    return graph->steps[step].renderPass->GetRenderPass();
+}
+
+uint32_t RenderGraph::PassContext::GetSubpass() const {
+    return subpass;
+}
+
+void RenderGraph::PassContext::Begin(VkSubpassContents contents) {
+    graph->BeginSubpass(*this, contents);
+}
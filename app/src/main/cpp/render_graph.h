@@ -0,0 +1,345 @@
+#ifndef KRAKATOA_RENDER_GRAPH_H
+#define KRAKATOA_RENDER_GRAPH_H
+#include <vulkan/vulkan.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "vk_mem_alloc.h"
+#include "render_pass.h"
+#include "barrier_batch.h"
+namespace graphics {
+    class GpuTimer;
+
+    /**
+     * The frame as a list of passes that declare which named resources they
+     * read and write; Compile() turns it into render passes, framebuffers,
+     * images and synchronization, Execute() records it.
+     *
+     * Resources are either attachments the graph owns (created at the graph
+     * extent, one instance shared by all frames in flight: the frames are
+     * ordered on the graphics queue and the dependencies cover the overlap),
+     * images imported from outside for the graph to render into (the
+     * swapchain image, bound every frame with SetImageView), or external
+     * resources whose owner synchronizes them (the camera image), declared
+     * only to order and keep passes.
+     *
+     * Compile():
+     *  - culls passes whose writes nobody reads: a pass is kept if it writes
+     *    an imported resource, is marked SideEffects(), or writes something a
+     *    kept pass reads after it;
+     *  - merges consecutive graphics passes that continue on the same
+     *    attachments into one VkRenderPass: a pass drawing to exactly the
+     *    attachments of the previous one shares its subpass, one reading them
+     *    as input attachments gets the next subpass. A pass on other
+     *    attachments joins too when a later pass on its attachments reads this
+     *    render pass's output as input attachment. A pass that samples
+     *    something written in the current render pass starts a new one;
+     *  - picks load/store ops from first and next use (CLEAR when asked,
+     *    LOAD when the contents are needed, DONT_CARE otherwise; STORE only
+     *    if something reads the attachment later, this frame or the next),
+     *    the initial/final layouts, and the subpass dependencies from the
+     *    previous use of each attachment, the previous frame's included;
+     *  - aliases graph attachments whose lifetimes within the frame don't
+     *    overlap onto one allocation;
+     *  - makes attachments used by a single render pass (and not carried to
+     *    the next frame) transient, in lazily allocated memory where the
+     *    device has it: on tilers they never leave tile memory;
+     *  - logs the compiled schedule with the attachment memory, VMA's
+     *    device-local usage before and after, and the bytes the load/store
+     *    ops and samplers move per frame (also available from GetSchedule()
+     *    and GetAttachmentTraffic()).
+     *
+     * Passes run in the order they were added. Their callbacks record the
+     * commands; graphics passes call PassContext::Begin() first, once the
+     * subpass contents are known (inline or secondary command buffers).
+     * A render pass can be limited to the top-left part of its attachments
+     * with SetRenderArea() (dynamic resolution), a pass's drawing to a
+     * rectangle of that with SetScissor() (damage regions), and passes with
+     * nothing to draw turned off with SetEnabled(). With a GpuTimer every
+     * step's GPU time is measured.
+     *
+     * Usage:
+     *   RenderGraph graph(device, allocator);
+     *   auto backbuffer = graph.ImportImage("Backbuffer", swapchainFormat, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+     *   auto color = graph.CreateAttachment("OffscreenColor", VK_FORMAT_R8G8B8A8_UNORM);
+     *   graph.AddPass("Offscreen").ClearColor(color, {}).Execute([](auto& ctx) { ... });
+     *   graph.AddPass("Compose").WriteColor(backbuffer).Sample(color)
+     *        .Execute([](auto& ctx) { ctx.Begin(); ... });
+     *   graph.Compile(extent);                 // and again after every resize
+     *   ... create pipelines with GetRenderPass(pass) / GetSubpass(pass)
+     *   // per frame
+     *   graph.SetImageView(backbuffer, swapchainViews[imageIndex]);
+     *   graph.Execute(cmd);
+     */
+    class RenderGraph {
+    public:
+        using ResourceId = uint32_t;
+        using PassId = uint32_t;
+        static constexpr uint32_t NONE = ~0u;
+
+        /// Estimated attachment bytes moved through memory per frame: LOAD and sampling read, STORE writes
+        struct Traffic {
+            VkDeviceSize read = 0;
+            VkDeviceSize written = 0;
+        };
+
+        /// What a pass callback records into.
+        class PassContext {
+        public:
+            VkCommandBuffer GetCommandBuffer() const { return cmd; }
+            /// Render pass, subpass and framebuffer of a graphics pass, for secondaries' inheritance
+            VkRenderPass    GetRenderPass()  const;
+            uint32_t        GetSubpass()     const;
+            VkFramebuffer   GetFramebuffer() const { return framebuffer; }
+            /// Render area (from the origin): set the viewport to it
+            VkExtent2D      GetExtent()      const { return extent; }
+            /// Part of the render area the pass draws in (SetScissor): set the scissor to it
+            VkRect2D        GetScissor()     const { return scissor; }
+
+            /**
+             * Starts this pass's subpass (beginning the render pass if it's
+             * the first). With SECONDARY_COMMAND_BUFFERS contents only
+             * vkCmdExecuteCommands may follow. Passes sharing a subpass must
+             * agree on the contents; the second Begin() is then a no-op.
+             * A graphics pass that doesn't call it gets an empty inline subpass.
+             */
+            void Begin(VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+
+        private:
+            friend class RenderGraph;
+            RenderGraph* graph = nullptr;
+            VkCommandBuffer cmd = VK_NULL_HANDLE;
+            VkFramebuffer framebuffer = VK_NULL_HANDLE;
+            VkExtent2D extent = {0, 0};
+            VkRect2D scissor = {};
+            VkRect2D area = {};     // of the render pass: the union of its passes' scissors
+            uint32_t step = NONE;
+            uint32_t subpass = NONE;
+        };
+        using ExecuteCallback = std::function<void(PassContext& ctx)>;
+
+        /// Declares a pass's resources. Every call returns the builder for chaining.
+        class PassBuilder {
+        public:
+            /// Color attachment, keeping its contents (DONT_CARE if it has none yet)
+            PassBuilder& WriteColor(ResourceId id);
+            /// Color attachment cleared before this pass
+            PassBuilder& ClearColor(ResourceId id, VkClearColorValue value);
+            PassBuilder& WriteDepth(ResourceId id);
+            PassBuilder& ClearDepth(ResourceId id, VkClearDepthStencilValue value);
+            /// Reads an attachment of an earlier pass at the same pixel (subpassInput)
+            PassBuilder& ReadInput(ResourceId id);
+            /// Samples a graph image written before, in SHADER_READ_ONLY_OPTIMAL
+            PassBuilder& Sample(ResourceId id, VkPipelineStageFlags2 stage = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT);
+            /// Ordering only, for external resources: the owner records its own barriers
+            PassBuilder& Read(ResourceId id);
+            PassBuilder& Write(ResourceId id);
+            /// Never culled, even if nothing reads its writes
+            PassBuilder& SideEffects();
+            PassBuilder& Execute(ExecuteCallback callback);
+
+            PassId GetId() const { return pass; }
+
+        private:
+            friend class RenderGraph;
+            PassBuilder(RenderGraph& graph, PassId pass) : graph(graph), pass(pass) {}
+            RenderGraph& graph;
+            PassId pass;
+        };
+
+        RenderGraph(VkDevice device, VmaAllocator allocator);
+        ~RenderGraph();
+
+        RenderGraph(const RenderGraph&) = delete;
+        RenderGraph& operator=(const RenderGraph&) = delete;
+
+        /// Graph-owned image, usable as attachment, input attachment and sampled image.
+        ResourceId CreateAttachment(const std::string& name, VkFormat format);
+        /// Image from outside rendered into by the graph; left in `finalLayout`. Bind with SetImageView().
+        ResourceId ImportImage(const std::string& name, VkFormat format, VkImageLayout finalLayout);
+        /// Resource synchronized by its owner, only declared with Read()/Write().
+        ResourceId ImportExternal(const std::string& name);
+
+        PassBuilder AddPass(const std::string& name);
+
+        /**
+         * Builds the schedule, images and render passes for `extent`. Call
+         * after the device is idle, and recreate pipelines afterwards: the
+         * VkRenderPass objects are new.
+         */
+        void Compile(VkExtent2D extent);
+
+        /// This frame's view of an imported image (the acquired swapchain image)
+        void SetImageView(ResourceId id, VkImageView view);
+
+        /**
+         * Renders the render pass `pass` was compiled into only within `area`
+         * from the origin, this frame and the next ones, until Compile().
+         * Contents outside it are left alone (or undefined, for transient or
+         * DONT_CARE attachments).
+         */
+        void SetRenderArea(PassId pass, VkExtent2D area);
+        VkExtent2D GetRenderArea(PassId pass) const;
+
+        /**
+         * Limits what `pass` draws to `rect` of its render area, this frame
+         * and the next ones, until ResetScissor() or Compile(). A render pass
+         * whose passes all have one begins over their union only: its clears
+         * and stores don't touch anything outside either.
+         */
+        void SetScissor(PassId pass, VkRect2D rect);
+        void ResetScissor(PassId pass);
+
+        /**
+         * A disabled pass isn't recorded: no callback, no barriers for it
+         * (a subpass of it is left empty). A step whose passes are all
+         * disabled is skipped, its attachments keeping their contents. For
+         * passes with nothing to draw this frame; until enabled again.
+         */
+        void SetEnabled(PassId pass, bool enabled);
+
+        /// Times every step with `timer` (null: no timing). Its BeginFrame() is the caller's.
+        void SetGpuTimer(GpuTimer* timer) { gpuTimer = timer; }
+
+        /// Records the compiled schedule.
+        void Execute(VkCommandBuffer cmd);
+
+        /// Render pass and subpass a compiled pass draws in (null/NONE if culled or not graphics)
+        RenderPass* GetRenderPass(PassId pass) const;
+        uint32_t GetSubpass(PassId pass) const;
+        bool IsCulled(PassId pass) const { return passes[pass].step == NONE; }
+
+        /// View of a graph-owned image, valid until the next Compile()
+        VkImageView GetImageView(ResourceId id) const { return resources[id].view; }
+        VkExtent2D GetExtent() const { return extent; }
+        /// Human readable compiled schedule
+        const std::string& GetSchedule() const { return schedule; }
+        const Traffic& GetAttachmentTraffic() const { return traffic; }
+
+    private:
+        enum class ResourceKind { Attachment, Imported, External };
+        enum class UseType { Color, Depth, Input, Sampled, External };
+
+        struct Use {
+            ResourceId resource;
+            UseType type;
+            bool write;
+            bool clear;
+            VkClearValue clearValue;
+            VkPipelineStageFlags2 stage;
+        };
+
+        struct Resource {
+            std::string name;
+            ResourceKind kind;
+            VkFormat format = VK_FORMAT_UNDEFINED;
+            VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;   // imported
+            // Compiled
+            VkImageUsageFlags usage = 0;
+            uint32_t firstStep = NONE;
+            uint32_t lastStep = NONE;
+            bool persistent = false;      // read before written: contents carry over frames
+            bool transient = false;       // only within one render pass: never loaded nor stored
+            uint32_t memorySlot = NONE;
+            VkImage image = VK_NULL_HANDLE;
+            VkImageView view = VK_NULL_HANDLE;
+            ResourceState state;          // at record time
+        };
+
+        struct Pass {
+            std::string name;
+            std::vector<Use> uses;
+            bool sideEffects = false;
+            ExecuteCallback execute;
+            // Per frame
+            bool enabled = true;
+            bool scissored = false;
+            VkRect2D scissor = {};
+            // Compiled
+            uint32_t step = NONE;
+            uint32_t subpass = NONE;
+        };
+
+        /// Render pass of a compiled step, shared with the pipelines drawing in it
+        class CompiledRenderPass : public RenderPass {
+        public:
+            CompiledRenderPass(VkDevice device, VkRenderPass renderPass, const std::string& name,
+                               std::vector<VkClearValue> clearValues);
+            ~CompiledRenderPass() override;
+        };
+
+        struct Attachment {
+            ResourceId resource;
+            VkAttachmentDescription description;
+            ResourceState after;          // state once the render pass ends
+        };
+
+        /// One render pass (or one non-graphics pass) of the schedule
+        struct Step {
+            std::string name;
+            std::vector<PassId> passes;
+            bool graphics = false;
+            std::vector<Attachment> attachments;
+            uint32_t subpassCount = 0;
+            VkExtent2D renderArea = {0, 0};
+            std::unique_ptr<CompiledRenderPass> renderPass;
+            std::map<std::vector<VkImageView>, VkFramebuffer> framebuffers;
+        };
+
+        struct MemorySlot {
+            VmaAllocation allocation = VK_NULL_HANDLE;
+            VkMemoryRequirements requirements{};
+            uint32_t lastStep = NONE;
+            std::vector<ResourceId> resources;
+            bool transient = false;       // holds transient attachments only
+            bool lazy = false;            // got lazily allocated memory
+        };
+
+        VkDevice device;
+        VmaAllocator allocator;
+        VkExtent2D extent = {0, 0};
+
+        std::vector<Resource> resources;
+        std::vector<Pass> passes;
+        std::vector<Step> steps;
+        std::vector<MemorySlot> memorySlots;
+        std::string schedule;
+        Traffic traffic;
+        VkDeviceSize usageBefore[2] = {0, 0};   // VMA device-local usage before Compile() and once the old attachments are freed
+        BarrierBatch barriers;
+        GpuTimer* gpuTimer = nullptr;
+
+        // Recording state, for PassContext::Begin
+        uint32_t openSubpass = NONE;
+        VkSubpassContents openContents = VK_SUBPASS_CONTENTS_INLINE;
+        VkRect2D openScissor = {};
+
+        ResourceId AddResource(const std::string& name, ResourceKind kind, VkFormat format, VkImageLayout finalLayout);
+        void AddUse(PassId pass, const Use& use);
+
+        void Cull();
+        void BuildSteps();
+        void BuildRenderPass(Step& step, uint32_t stepIndex, std::vector<ResourceState>& slotStates,
+                             std::vector<VkImageLayout>& layouts, bool record);
+        void AllocateImages();
+        void WriteSchedule();
+        void Destroy();
+
+        VkFramebuffer GetFramebuffer(Step& step);
+        VkRect2D PassScissor(const Pass& pass, const Step& step) const;
+        VkRect2D StepArea(const Step& step) const;
+        void BeginSubpass(PassContext& ctx, VkSubpassContents contents);
+        void FinishRenderPass(Step& step, VkCommandBuffer cmd);
+
+        /// Next use of `resource` after step `stepIndex`, wrapping to the next frame
+        const Use* NextUse(ResourceId resource, uint32_t stepIndex, bool& nextFrame) const;
+        VkImageSubresourceRange FullRange(ResourceId id) const;
+        VkDeviceSize ImageSize(ResourceId id) const;
+        static bool IsAttachment(UseType type) { return type != UseType::Sampled && type != UseType::External; }
+        static VkImageLayout UseLayout(UseType type);
+        static VkAccessFlags2 UseAccess(UseType type);
+    };
+}
+#endif //KRAKATOA_RENDER_GRAPH_H
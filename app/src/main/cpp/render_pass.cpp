@@ -6,7 +6,16 @@ using namespace graphics;
 
 void RenderPass::Begin(VkCommandBuffer cmd,
                        VkFramebuffer framebuffer,
-                       VkExtent2D extent) {
+                       VkExtent2D extent,
+                       VkSubpassContents contents) {
+    Begin(cmd, framebuffer, extent, {{0, 0}, extent}, contents);
+}
+
+void RenderPass::Begin(VkCommandBuffer cmd,
+                       VkFramebuffer framebuffer,
+                       VkExtent2D extent,
+                       VkRect2D area,
+                       VkSubpassContents contents) {
     if (!debugName.empty()) {
         debug::BeginLabel(cmd, debugName);
     }
@@ -15,14 +24,23 @@ void RenderPass::Begin(VkCommandBuffer cmd,
     beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     beginInfo.renderPass = renderPass;
     beginInfo.framebuffer = framebuffer;
-    beginInfo.renderArea.offset = {0, 0};
-    beginInfo.renderArea.extent = extent;
+    beginInfo.renderArea = area;
     beginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
     beginInfo.pClearValues = clearValues.data();
 
-    vkCmdBeginRenderPass(cmd, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(cmd, &beginInfo, contents);
+
+    if (contents == VK_SUBPASS_CONTENTS_INLINE) {
+        SetViewportAndScissor(cmd, extent, area);
+    }
+}
+
+void RenderPass::SetViewportAndScissor(VkCommandBuffer cmd, VkExtent2D extent) {
+    SetViewportAndScissor(cmd, extent, {{0, 0}, extent});
+}
 
-    // Set dynamic viewport and scissor to match extent
+void RenderPass::SetViewportAndScissor(VkCommandBuffer cmd, VkExtent2D extent, VkRect2D scissor) {
+    // Set dynamic viewport to match extent, scissor to what may be drawn
     VkViewport viewport{};
     viewport.x = 0.0f;
     viewport.y = 0.0f;
@@ -32,9 +50,6 @@ void RenderPass::Begin(VkCommandBuffer cmd,
     viewport.maxDepth = 1.0f;
     vkCmdSetViewport(cmd, 0, 1, &viewport);
 
-    VkRect2D scissor{};
-    scissor.offset = {0, 0};
-    scissor.extent = extent;
     vkCmdSetScissor(cmd, 0, 1, &scissor);
 }
 
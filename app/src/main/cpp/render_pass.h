@@ -9,11 +9,29 @@ namespace graphics {
     public:
         virtual ~RenderPass() = default;
 
+        /**
+         * Begins the pass over `area` (rendering and load/store ops stay
+         * inside it) and, for inline contents, sets the viewport to extent
+         * and the scissor to area. With SECONDARY_COMMAND_BUFFERS contents
+         * only vkCmdExecuteCommands may follow: each secondary sets its own.
+         */
         void Begin(VkCommandBuffer cmd,
                    VkFramebuffer framebuffer,
-                   VkExtent2D extent);
+                   VkExtent2D extent,
+                   VkRect2D area,
+                   VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+        /// Begin() over the whole extent
+        void Begin(VkCommandBuffer cmd,
+                   VkFramebuffer framebuffer,
+                   VkExtent2D extent,
+                   VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
         void End(VkCommandBuffer cmd);
 
+        /// Full-extent viewport and scissor (dynamic state in every pipeline)
+        static void SetViewportAndScissor(VkCommandBuffer cmd, VkExtent2D extent);
+        /// Full-extent viewport, drawing clipped to `scissor`
+        static void SetViewportAndScissor(VkCommandBuffer cmd, VkExtent2D extent, VkRect2D scissor);
+
         VkRenderPass GetRenderPass() const { return renderPass; }
         void setClearColor(float r, float g, float b, float a) {
             clearValues[0].color = {{r, g, b, a}};
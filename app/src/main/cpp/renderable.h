@@ -3,6 +3,7 @@
 #include <string>
 #include "transform.h"
 #include "mesh.h"
+#include "resource_cache.h"
 namespace graphics {
     class StaticMesh;
     class MutableMesh;
@@ -12,16 +13,24 @@ namespace graphics {
         int64_t id;
         Transform* transform;
         Mesh* mesh = nullptr;
+        MeshHandle meshHandle;
         bool ownsMesh = false;
     public:
         Transform& GetTransform(){return *transform;}
         int64_t GetId()const{return id;}
         const std::string& GetMeshId()const{return meshId;}
         void SetMesh(Mesh* m, bool _ownsMesh = false){
+            meshHandle = {};
             mesh = m;
             this->ownsMesh = _ownsMesh;
         }
-        Mesh* GetMesh()const{return mesh;}
+        /// Cached mesh: resolved on every GetMesh() so eviction/reload is invisible.
+        void SetMesh(const MeshHandle& handle){
+            meshHandle = handle;
+            mesh = nullptr;
+            this->ownsMesh = false;
+        }
+        Mesh* GetMesh()const{return meshHandle ? meshHandle.Get() : mesh;}
         Renderable(const std::string& meshId);
         Renderable(int16_t id);
         ~Renderable();
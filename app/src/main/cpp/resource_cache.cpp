@@ -0,0 +1,302 @@
+#include "resource_cache.h"
+#include "static_mesh.h"
+#include "command_pool_manager.h"
+#include "asset_loader.h"
+#include "asset_archive.h"
+#include "ktx2_loader.h"
+#include "texture_transcoder.h"
+#include "image_load.h"
+#include "android_log.h"
+#include <algorithm>
+#include <cassert>
+using namespace graphics;
+
+namespace {
+    bool EndsWith(const std::string& s, const std::string& suffix) {
+        return s.size() >= suffix.size() &&
+               s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    uint64_t HashMeshData(const io::MeshData& data) {
+        const uint64_t v = io::Fnv1a64(data.vertices.data(), data.vertices.size() * sizeof(float));
+        const uint64_t i = io::Fnv1a64(data.indices.data(), data.indices.size() * sizeof(uint32_t));
+        return v ^ (i * 0x9E3779B97F4A7C15ull);
+    }
+}
+
+ResourceCache::ResourceCache(VkDevice device,
+                             VkPhysicalDevice physicalDevice,
+                             VmaAllocator allocator,
+                             CommandPoolManager& cmdManager)
+        : device(device), physicalDevice(physicalDevice), allocator(allocator), cmdManager(cmdManager) {
+}
+
+ResourceCache::~ResourceCache() {
+    // Handles may outlive the cache (renderables destroyed later); make sure
+    // their GPU memory goes now, while the allocator still exists.
+    for (auto& [key, entry] : byKey) {
+        Evict(*entry);
+        entry->cache = nullptr;
+    }
+    LOGI("ResourceCache destroyed");
+}
+
+// ============================================================
+// Lookup
+// ============================================================
+
+std::shared_ptr<detail::CacheEntry> ResourceCache::Intern(const std::string& key,
+                                                          uint64_t contentHash,
+                                                          std::function<void(detail::CacheEntry&)> load) {
+    auto it = byKey.find(key);
+    if (it != byKey.end()) {
+        return it->second;
+    }
+    auto same = byContent.find(contentHash);
+    if (same != byContent.end()) {
+        if (auto existing = same->second.lock()) {
+            LOGI("ResourceCache: '%s' has the same content as '%s', sharing it",
+                 key.c_str(), existing->key.c_str());
+            byKey[key] = existing;
+            return existing;
+        }
+    }
+    auto entry = std::make_shared<detail::CacheEntry>();
+    entry->key = key;
+    entry->contentHash = contentHash;
+    entry->load = std::move(load);
+    entry->cache = this;
+    byKey[key] = entry;
+    byContent[contentHash] = entry;
+    Touch(*entry);
+    return entry;
+}
+
+MeshHandle ResourceCache::GetMesh(const std::string& path) {
+    auto it = byKey.find(path);
+    if (it != byKey.end()) {
+        return MeshHandle(it->second);
+    }
+    io::AssetView bytes = io::AssetLoader::openView(path);
+    if (!bytes) {
+        LOGE("ResourceCache: mesh '%s' not found", path.c_str());
+        return {};
+    }
+    const uint64_t hash = io::Fnv1a64(bytes.data(), bytes.size());
+    return MeshHandle(Intern(path, hash, [this, path](detail::CacheEntry& entry) {
+        io::MeshLoader loader;
+        io::MeshData data = loader.Load(path);
+        if (data.vertexCount > 0) {
+            entry.mesh = CreateMesh(data, path);
+        }
+    }));
+}
+
+MeshHandle ResourceCache::GetMesh(const std::string& key, const std::function<io::MeshData()>& generator) {
+    auto it = byKey.find(key);
+    if (it != byKey.end()) {
+        return MeshHandle(it->second);
+    }
+    const uint64_t hash = HashMeshData(generator());
+    return MeshHandle(Intern(key, hash, [this, key, generator](detail::CacheEntry& entry) {
+        entry.mesh = CreateMesh(generator(), key);
+    }));
+}
+
+TextureHandle ResourceCache::GetTexture(const std::string& path) {
+    auto it = byKey.find(path);
+    if (it != byKey.end()) {
+        return TextureHandle(it->second);
+    }
+    io::AssetView bytes = io::AssetLoader::openView(path);
+    if (!bytes) {
+        LOGE("ResourceCache: texture '%s' not found", path.c_str());
+        return {};
+    }
+    const uint64_t hash = io::Fnv1a64(bytes.data(), bytes.size());
+    return TextureHandle(Intern(path, hash, [this, path](detail::CacheEntry& entry) {
+        if (EndsWith(path, ".ktx2")) {
+            io::Ktx2Texture ktx;
+            if (!io::LoadKtx2(path, ktx)) {
+                return;
+            }
+            if (!io::IsFormatSampleable(physicalDevice, ktx.format)) {
+                io::Ktx2Texture decoded;
+                if (!io::TranscodeToRGBA8(ktx, decoded)) {
+                    return;
+                }
+                ktx = std::move(decoded);
+            }
+            entry.texture = std::make_unique<Texture2D>(device, allocator, cmdManager,
+                                                        ktx.data, ktx.levels, ktx.format, path);
+        } else {
+            std::vector<uint8_t> pixels;
+            VkFormat format;
+            int w, h;
+            io::LoadImage(path, pixels, format, w, h);
+            entry.texture = std::make_unique<Texture2D>(device, allocator, cmdManager, pixels,
+                                                        static_cast<uint32_t>(w),
+                                                        static_cast<uint32_t>(h),
+                                                        format, path);
+        }
+    }));
+}
+
+TextureHandle ResourceCache::GetTexture(const std::vector<std::string>& candidates) {
+    // Native block format > CPU-transcodable block format > plain image
+    std::string transcodable;
+    std::string plain;
+    for (const auto& path : candidates) {
+        if (!io::AssetLoader::exists(path)) {
+            continue;
+        }
+        if (!EndsWith(path, ".ktx2")) {
+            if (plain.empty()) plain = path;
+            continue;
+        }
+        VkFormat format;
+        if (!io::PeekKtx2Format(path, format)) {
+            continue;
+        }
+        if (io::IsFormatSampleable(physicalDevice, format)) {
+            return GetTexture(path);
+        }
+        if (transcodable.empty() && io::CanTranscodeToRGBA8(format)) {
+            transcodable = path;
+        }
+    }
+    if (!transcodable.empty()) {
+        return GetTexture(transcodable);
+    }
+    if (!plain.empty()) {
+        return GetTexture(plain);
+    }
+    LOGE("ResourceCache: no usable texture among %zu candidates", candidates.size());
+    return {};
+}
+
+// ============================================================
+// Residency
+// ============================================================
+
+std::unique_ptr<Mesh> ResourceCache::CreateMesh(const io::MeshData& data, const std::string& name) {
+    return std::make_unique<StaticMesh>(device, allocator, cmdManager,
+                                        data.vertices.data(), data.vertexCount,
+                                        data.indices.data(), data.indexCount, name);
+}
+
+void ResourceCache::Load(detail::CacheEntry& entry) {
+    entry.load(entry);
+    entry.generation++;
+    entry.gpuBytes = 0;
+    if (entry.mesh) {
+        entry.gpuBytes = static_cast<VkDeviceSize>(entry.mesh->GetVertexCount()) * 8 * sizeof(float) +
+                         static_cast<VkDeviceSize>(entry.mesh->GetIndexCount()) * sizeof(uint32_t);
+    }
+    if (entry.texture) {
+        VkMemoryRequirements req{};
+        vkGetImageMemoryRequirements(device, entry.texture->GetImage(), &req);
+        entry.gpuBytes = req.size;
+    }
+    if (!entry.IsResident()) {
+        // Don't retry every frame; a broken asset stays broken.
+        entry.failed = true;
+        LOGE("ResourceCache: failed to load '%s'", entry.key.c_str());
+    }
+}
+
+void ResourceCache::Touch(detail::CacheEntry& entry) {
+    entry.lastUsedFrame = frameNumber;
+    if (!entry.IsResident() && !entry.failed) {
+        if (entry.generation > 0) {
+            LOGI("ResourceCache: reloading evicted '%s'", entry.key.c_str());
+        }
+        Load(entry);
+    }
+}
+
+void ResourceCache::Evict(detail::CacheEntry& entry) {
+    entry.mesh.reset();
+    entry.texture.reset();
+}
+
+VkDeviceSize ResourceCache::GetResidentBytes() const {
+    VkDeviceSize total = 0;
+    for (const auto& [key, entry] : byContent) {
+        if (auto e = entry.lock(); e && e->IsResident()) {
+            total += e->gpuBytes;
+        }
+    }
+    return total;
+}
+
+bool ResourceCache::OverBudget() const {
+    const VkPhysicalDeviceMemoryProperties* props = nullptr;
+    vmaGetMemoryProperties(allocator, &props);
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+    vmaGetHeapBudgets(allocator, budgets);
+
+    VkDeviceSize usage = 0;
+    VkDeviceSize limit = 0;
+    for (uint32_t i = 0; i < props->memoryHeapCount; i++) {
+        if (props->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+            usage += budgets[i].usage;
+            limit += budgets[i].budget;
+        }
+    }
+    if (budget != 0) {
+        limit = budget;
+    }
+    return usage > limit;
+}
+
+void ResourceCache::BeginFrame(uint64_t frame, uint64_t completedFrame) {
+    frameNumber = frame;
+    if (!OverBudget()) {
+        return;
+    }
+    // Only resources no in-flight frame can still reference are candidates:
+    // last used by a frame the GPU has finished.
+    std::vector<detail::CacheEntry*> candidates;
+    for (auto& [hash, weak] : byContent) {
+        auto entry = weak.lock();
+        if (entry && entry->IsResident() &&
+            entry->lastUsedFrame <= completedFrame) {
+            candidates.push_back(entry.get());
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const detail::CacheEntry* a, const detail::CacheEntry* b) {
+                  return a->lastUsedFrame < b->lastUsedFrame;
+              });
+    for (detail::CacheEntry* entry : candidates) {
+        if (!OverBudget()) {
+            break;
+        }
+        LOGI("ResourceCache: over budget, evicting '%s' (%llu bytes, unused for %llu frames)",
+             entry->key.c_str(), (unsigned long long)entry->gpuBytes,
+             (unsigned long long)(frameNumber - entry->lastUsedFrame));
+        Evict(*entry);
+    }
+}
+
+void ResourceCache::ReleaseUnused() {
+    // An entry is unused when the only references are the cache's own keys.
+    std::unordered_map<detail::CacheEntry*, long> keyRefs;
+    for (auto& [key, entry] : byKey) {
+        keyRefs[entry.get()]++;
+    }
+    for (auto it = byKey.begin(); it != byKey.end();) {
+        detail::CacheEntry* entry = it->second.get();
+        if (it->second.use_count() == keyRefs[entry]) {
+            Evict(*entry);
+            it = byKey.erase(it);
+            keyRefs[entry]--;
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = byContent.begin(); it != byContent.end();) {
+        it = it->second.expired() ? byContent.erase(it) : std::next(it);
+    }
+}
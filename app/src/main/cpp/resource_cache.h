@@ -0,0 +1,169 @@
+#ifndef KRAKATOA_RESOURCE_CACHE_H
+#define KRAKATOA_RESOURCE_CACHE_H
+#include <vulkan/vulkan.h>
+#include "vk_mem_alloc.h"
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+#include <type_traits>
+#include <unordered_map>
+#include "mesh.h"
+#include "texture2d.h"
+#include "mesh_loader.h"
+namespace graphics {
+    class CommandPoolManager;
+    class ResourceCache;
+
+    namespace detail {
+        /// One cached resource. Shared between the cache and every handle to it.
+        struct CacheEntry {
+            std::string key;
+            uint64_t contentHash = 0;
+            std::unique_ptr<Mesh> mesh;
+            std::unique_ptr<Texture2D> texture;
+            std::function<void(CacheEntry&)> load;
+            VkDeviceSize gpuBytes = 0;
+            uint64_t lastUsedFrame = 0;
+            uint64_t generation = 0;
+            ResourceCache* cache = nullptr;
+            bool failed = false;
+
+            bool IsResident() const { return mesh || texture; }
+        };
+    }
+
+    /**
+     * Ref-counted handle to a cached mesh or texture.
+     *
+     * Get() marks the resource as used this frame and, if the cache evicted it
+     * under memory pressure, reloads it first, so holders never see it go away.
+     * Anything that caches Vulkan handles taken from the resource (descriptor
+     * sets, image views) should compare GetGeneration() to know when to refresh.
+     */
+    template<typename T>
+    class ResourceHandle {
+    public:
+        ResourceHandle() = default;
+
+        T* Get() const;
+        T* operator->() const { return Get(); }
+        explicit operator bool() const { return entry != nullptr; }
+
+        /// Bumped every time the resource is (re)loaded.
+        uint64_t GetGeneration() const { return entry ? entry->generation : 0; }
+        const std::string& GetKey() const { return entry->key; }
+
+    private:
+        friend class ResourceCache;
+        explicit ResourceHandle(std::shared_ptr<detail::CacheEntry> e) : entry(std::move(e)) {}
+        std::shared_ptr<detail::CacheEntry> entry;
+    };
+
+    using MeshHandle    = ResourceHandle<Mesh>;
+    using TextureHandle = ResourceHandle<Texture2D>;
+
+    /**
+     * Owns the GPU meshes and textures loaded from assets.
+     *
+     * - Keyed by asset path: asking twice for the same path returns the same entry.
+     * - Deduplicated by content: two paths with byte-identical files (or two
+     *   generators producing identical vertex data) share one GPU resource.
+     * - Budgeted: when device-local VMA usage goes over the budget, the least
+     *   recently used resources that no in-flight frame can reference are
+     *   destroyed. Handles to them reload transparently on the next Get().
+     *
+     * Not thread safe: use it from the render thread.
+     *
+     * Usage:
+     *   ResourceCache cache(device, physicalDevice, allocator, cmdManager);
+     *   cache.SetBudget(256ull << 20);
+     *   MeshHandle cube = cache.GetMesh("meshes/cube.glb");
+     *   TextureHandle grid = cache.GetTexture({"textures/grid.etc2.ktx2", "textures/grid.png"});
+     *   // every frame, after FrameSync::BeginFrame:
+     *   cache.BeginFrame(frame, frameSync.GetCompletedFrame());
+     */
+    class ResourceCache {
+    public:
+        ResourceCache(VkDevice device,
+                      VkPhysicalDevice physicalDevice,
+                      VmaAllocator allocator,
+                      CommandPoolManager& cmdManager);
+        ~ResourceCache();
+
+        ResourceCache(const ResourceCache&) = delete;
+        ResourceCache& operator=(const ResourceCache&) = delete;
+
+        /// Mesh from a glTF/GLB asset.
+        MeshHandle GetMesh(const std::string& path);
+
+        /// Procedural mesh. The generator runs again if the mesh is evicted.
+        MeshHandle GetMesh(const std::string& key, const std::function<io::MeshData()>& generator);
+
+        /// Texture from a KTX2 (native or CPU-transcoded) or PNG/JPG asset.
+        TextureHandle GetTexture(const std::string& path);
+
+        /**
+         * Texture from the first usable candidate: a KTX2 whose format the
+         * device samples, then a KTX2 the CPU can transcode, then anything else
+         * that exists (PNG/JPG).
+         */
+        TextureHandle GetTexture(const std::vector<std::string>& candidates);
+
+        /**
+         * Device-local bytes the cache tries to stay under. 0 (the default)
+         * means the budget VMA reports for the heaps.
+         */
+        void SetBudget(VkDeviceSize bytes) { budget = bytes; }
+
+        /**
+         * Advance the LRU clock and evict if over budget, before recording.
+         * @param frame           FrameSync's number for the frame being recorded
+         * @param completedFrame  last frame the GPU finished; only resources not
+         *                        used since then can be evicted
+         */
+        void BeginFrame(uint64_t frame, uint64_t completedFrame);
+
+        /// Drops every entry nobody holds a handle to.
+        void ReleaseUnused();
+
+        VkDeviceSize GetResidentBytes() const;
+
+    private:
+        template<typename T> friend class ResourceHandle;
+
+        void Touch(detail::CacheEntry& entry);
+        void Load(detail::CacheEntry& entry);
+        std::shared_ptr<detail::CacheEntry> Intern(const std::string& key,
+                                                   uint64_t contentHash,
+                                                   std::function<void(detail::CacheEntry&)> load);
+        std::unique_ptr<Mesh> CreateMesh(const io::MeshData& data, const std::string& name);
+        void Evict(detail::CacheEntry& entry);
+        bool OverBudget() const;
+
+        VkDevice device;
+        VkPhysicalDevice physicalDevice;
+        VmaAllocator allocator;
+        CommandPoolManager& cmdManager;
+
+        std::unordered_map<std::string, std::shared_ptr<detail::CacheEntry>> byKey;
+        std::unordered_map<uint64_t, std::weak_ptr<detail::CacheEntry>> byContent;
+
+        VkDeviceSize budget = 0;
+        uint64_t frameNumber = 0;
+    };
+
+    template<typename T>
+    T* ResourceHandle<T>::Get() const {
+        if (!entry || !entry->cache) {
+            return nullptr;
+        }
+        entry->cache->Touch(*entry);
+        if constexpr (std::is_same_v<T, Texture2D>) {
+            return entry->texture.get();
+        } else {
+            return entry->mesh.get();
+        }
+    }
+}
+#endif //KRAKATOA_RESOURCE_CACHE_H
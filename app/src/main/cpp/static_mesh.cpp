@@ -64,13 +64,13 @@ StaticMesh::StaticMesh(VkDevice device,
                                  Concatenate(name, ":VertexBuffer"));
         }
 
-        // Upload via transfer queue with ownership transfer
+        // Upload via transfer queue with ownership transfer; staging goes when it is done
         cmdManager.UploadBuffer(stagingBuffer, vertexBuffer, vertexSize,
                                 VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-                                VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
-
-        // Destroy staging
-        vmaDestroyBuffer(allocator, stagingBuffer, stagingAlloc);
+                                VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+                                [allocator, stagingBuffer, stagingAlloc] {
+                                    vmaDestroyBuffer(allocator, stagingBuffer, stagingAlloc);
+                                });
     }
 
     // --- Index buffer ---
@@ -115,13 +115,13 @@ StaticMesh::StaticMesh(VkDevice device,
                                  Concatenate(name, ":IndexBuffer"));
         }
 
-        // Upload via transfer queue with ownership transfer
+        // Upload via transfer queue with ownership transfer; staging goes when it is done
         cmdManager.UploadBuffer(stagingBuffer, indexBuffer, indexSize,
                                 VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-                                VK_ACCESS_INDEX_READ_BIT);
-
-        // Destroy staging
-        vmaDestroyBuffer(allocator, stagingBuffer, stagingAlloc);
+                                VK_ACCESS_INDEX_READ_BIT,
+                                [allocator, stagingBuffer, stagingAlloc] {
+                                    vmaDestroyBuffer(allocator, stagingBuffer, stagingAlloc);
+                                });
     }
 
     LOGI("StaticMesh created: %u vertices, %u indices (vb=%zu bytes, ib=%zu bytes)",
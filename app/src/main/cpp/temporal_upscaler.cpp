@@ -0,0 +1,269 @@
+#include "temporal_upscaler.h"
+#include "pipeline_layout.h"
+#include "asset_loader.h"
+#include "vk_debug.h"
+#include "concatenate.h"
+#include "android_log.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+using namespace graphics;
+
+namespace {
+    // Radical inverse of `index` in `base`: a low-discrepancy sequence in [0, 1)
+    float Halton(uint32_t index, uint32_t base) {
+        float result = 0.0f;
+        float fraction = 1.0f;
+        while (index > 0) {
+            fraction /= static_cast<float>(base);
+            result += fraction * static_cast<float>(index % base);
+            index /= base;
+        }
+        return result;
+    }
+}
+
+bool TemporalUpscaler::IsAvailable() {
+    return io::AssetLoader::exists(SHADER_PATH);
+}
+
+TemporalUpscaler::TemporalUpscaler(VkDevice device, VmaAllocator allocator, VkExtent2D outputSize)
+        : TemporalUpscaler(device, allocator, outputSize, Settings{}) {
+}
+
+TemporalUpscaler::TemporalUpscaler(VkDevice device, VmaAllocator allocator, VkExtent2D outputSize,
+                                   const Settings& settings)
+        : device(device), allocator(allocator), extent(outputSize), settings(settings) {
+    assert(extent.width > 0 && extent.height > 0);
+    assert(settings.historyWeight >= 0.0f && settings.historyWeight < 1.0f);
+    CreatePipeline();
+    CreateOutputs();
+    LOGI("TemporalUpscaler created (%ux%u)", extent.width, extent.height);
+}
+
+TemporalUpscaler::~TemporalUpscaler() {
+    for (Output& output : outputs) {
+        if (output.view != VK_NULL_HANDLE) vkDestroyImageView(device, output.view, nullptr);
+        if (output.image != VK_NULL_HANDLE) vmaDestroyImage(allocator, output.image, output.allocation);
+    }
+    // Destroying the pool frees the descriptor sets
+    vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+    vkDestroyPipeline(device, pipeline, nullptr);
+    vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+    vkDestroySampler(device, sampler, nullptr);
+    LOGI("TemporalUpscaler destroyed");
+}
+
+VkExtent2D TemporalUpscaler::GetDefaultRenderExtent() const {
+    auto scaled = [this](uint32_t size) {
+        return std::clamp(static_cast<uint32_t>(size * settings.renderScale), 1u, size);
+    };
+    return {scaled(extent.width), scaled(extent.height)};
+}
+
+// ============================================================
+// Creation
+// ============================================================
+
+void TemporalUpscaler::CreatePipeline() {
+    // Bilinear: the layer is read between its texels, at the jittered positions
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter    = VK_FILTER_LINEAR;
+    samplerInfo.minFilter    = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    VkResult result = vkCreateSampler(device, &samplerInfo, nullptr, &sampler);
+    assert(result == VK_SUCCESS);
+
+    // Layer sampler (binding 0) + history sampler (binding 1) + output (binding 2)
+    descriptorSetLayout = DescriptorSetLayoutBuilder(device)
+            .AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .AddBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .AddBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
+            .Build();
+    pipelineLayout = PipelineLayoutBuilder(device)
+            .AddDescriptorSetLayout(descriptorSetLayout)
+            .AddPushConstantRange(VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants))
+            .Build();
+
+    io::AssetView code = io::AssetLoader::openView(SHADER_PATH);
+    if (code.empty()) {
+        LOGE("FATAL: Failed to load shader '%s'. The .spv file is missing or unreadable.", SHADER_PATH);
+        std::abort();
+    }
+    // pCode must be 4-byte aligned; copying is cheap next to pipeline creation
+    std::vector<uint32_t> aligned((code.size() + 3) / 4);
+    memcpy(aligned.data(), code.data(), code.size());
+    VkShaderModuleCreateInfo moduleInfo{};
+    moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleInfo.codeSize = code.size();
+    moduleInfo.pCode = aligned.data();
+    VkShaderModule module;
+    result = vkCreateShaderModule(device, &moduleInfo, nullptr, &module);
+    assert(result == VK_SUCCESS);
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = module;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = pipelineLayout;
+    result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+    assert(result == VK_SUCCESS);
+    debug::SetPipelineName(device, pipeline, "Pipeline:taa_resolve.comp");
+    vkDestroyShaderModule(device, module, nullptr);
+}
+
+void TemporalUpscaler::CreateOutputs() {
+    VkDescriptorPoolSize poolSizes[] = {
+            {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2 * descriptorSets.Size()},
+            {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, descriptorSets.Size()},
+    };
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = descriptorSets.Size();
+    poolInfo.poolSizeCount = 2;
+    poolInfo.pPoolSizes = poolSizes;
+    VkResult result = vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool);
+    assert(result == VK_SUCCESS);
+    debug::SetDescriptorPoolName(device, descriptorPool, "DescPool:taa_resolve.comp");
+    for (uint32_t i = 0; i < descriptorSets.Size(); ++i) {
+        VkDescriptorSetAllocateInfo setInfo{};
+        setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        setInfo.descriptorPool = descriptorPool;
+        setInfo.descriptorSetCount = 1;
+        setInfo.pSetLayouts = &descriptorSetLayout;
+        result = vkAllocateDescriptorSets(device, &setInfo, &descriptorSets[i]);
+        assert(result == VK_SUCCESS);
+        debug::SetDescriptorSetName(device, descriptorSets[i], Concatenate("TaaSet_", i));
+    }
+
+    for (uint32_t i = 0; i < 2; ++i) {
+        Output& output = outputs[i];
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType     = VK_IMAGE_TYPE_2D;
+        imageInfo.format        = VK_FORMAT_R8G8B8A8_UNORM;
+        imageInfo.extent        = {extent.width, extent.height, 1};
+        imageInfo.mipLevels     = 1;
+        imageInfo.arrayLayers   = 1;
+        imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage         = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        VmaAllocationCreateInfo allocInfo{};
+        allocInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+        result = vmaCreateImage(allocator, &imageInfo, &allocInfo, &output.image, &output.allocation, nullptr);
+        assert(result == VK_SUCCESS);
+        debug::SetImageName(device, output.image, Concatenate("TaaHistory_", i));
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType    = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image    = output.image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format   = VK_FORMAT_R8G8B8A8_UNORM;
+        viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+        result = vkCreateImageView(device, &viewInfo, nullptr, &output.view);
+        assert(result == VK_SUCCESS);
+        debug::SetImageViewName(device, output.view, Concatenate("TaaHistoryView_", i));
+    }
+}
+
+// ============================================================
+// Per frame
+// ============================================================
+
+glm::mat4 TemporalUpscaler::BeginFrame(const glm::mat4& view, const glm::mat4& proj, VkExtent2D area) {
+    assert(area.width > 0 && area.height > 0);
+    renderArea = area;
+    const glm::mat4 viewProj = proj * view;
+    // Unjittered both ways: the resolve undoes the jitter before reprojecting
+    reprojection = hasPrevious ? previousViewProj * glm::inverse(viewProj) : glm::mat4(1.0f);
+    previousViewProj = viewProj;
+    hasPrevious = true;
+    const glm::vec4 clip = proj * glm::vec4(0.0f, 0.0f, -settings.reprojectionDepth, 1.0f);
+    reprojectionDepthNdc = clip.z / clip.w;
+
+    // Halton from index 1: index 0 is the pixel corner in both bases
+    phase = (phase + 1) % JITTER_PHASES;
+    jitter = glm::vec2((Halton(phase + 1, 2) - 0.5f) * 2.0f / static_cast<float>(area.width),
+                       (Halton(phase + 1, 3) - 0.5f) * 2.0f / static_cast<float>(area.height));
+    // Moves clip space xy by jitter * w: the whole image by `jitter` in NDC
+    return glm::translate(glm::mat4(1.0f), glm::vec3(jitter, 0.0f)) * proj;
+}
+
+void TemporalUpscaler::Record(VkCommandBuffer cmd, VkImageView layer, VkExtent2D layerSize) {
+    assert(renderArea.width > 0 && "BeginFrame() first");
+    const VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    const uint32_t target = hasHistory ? 1 - written : 0;
+    Output& output = outputs[target];
+    Output& history = outputs[1 - target];
+    // Whatever the output held was the history of the previous resolve: discard it.
+    // Without history the other image is sampled with weight 0, but it needs a valid layout.
+    barriers.UseImage(output.image, range, output.state,
+                      VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                      VK_IMAGE_LAYOUT_GENERAL, true);
+    barriers.UseImage(history.image, range, history.state,
+                      VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, !hasHistory);
+    barriers.Flush(cmd);
+
+    // The set's last user was a frame at least MAX_FRAMES_IN_FLIGHT back
+    VkDescriptorSet set = descriptorSets.Next();
+    VkDescriptorImageInfo imageInfos[3]{};
+    imageInfos[0] = {sampler, layer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    imageInfos[1] = {sampler, history.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    imageInfos[2] = {VK_NULL_HANDLE, output.view, VK_IMAGE_LAYOUT_GENERAL};
+    VkWriteDescriptorSet writes[3]{};
+    for (uint32_t i = 0; i < 3; ++i) {
+        writes[i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet          = set;
+        writes[i].dstBinding      = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType  = i < 2 ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+                                          : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[i].pImageInfo      = &imageInfos[i];
+    }
+    vkUpdateDescriptorSets(device, 3, writes, 0, nullptr);
+
+    PushConstants push{};
+    memcpy(push.reprojection, glm::value_ptr(reprojection), sizeof(push.reprojection));
+    // Content meant for NDC p was rendered at p + jitter, half that in UV
+    push.jitterUV[0] = jitter.x * 0.5f;
+    push.jitterUV[1] = jitter.y * 0.5f;
+    push.uvScale[0] = static_cast<float>(renderArea.width) / layerSize.width;
+    push.uvScale[1] = static_cast<float>(renderArea.height) / layerSize.height;
+    push.uvMax[0] = (renderArea.width - 0.5f) / layerSize.width;
+    push.uvMax[1] = (renderArea.height - 0.5f) / layerSize.height;
+    push.texelSize[0] = 1.0f / layerSize.width;
+    push.texelSize[1] = 1.0f / layerSize.height;
+    push.reprojectionDepth = reprojectionDepthNdc;
+    push.historyWeight = hasHistory ? settings.historyWeight : 0.0f;
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &set, 0, nullptr);
+    vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+    vkCmdDispatch(cmd,
+                  (extent.width + LOCAL_SIZE - 1) / LOCAL_SIZE,
+                  (extent.height + LOCAL_SIZE - 1) / LOCAL_SIZE,
+                  1);
+
+    // Sampled by the compose pass this frame and as history by the next resolve
+    barriers.UseImage(output.image, range, output.state,
+                      VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    barriers.Flush(cmd);
+    written = target;
+    hasHistory = true;
+}
@@ -0,0 +1,137 @@
+#ifndef KRAKATOA_TEMPORAL_UPSCALER_H
+#define KRAKATOA_TEMPORAL_UPSCALER_H
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include "vk_mem_alloc.h"
+#include "ring_buffer.h"
+#include "barrier_batch.h"
+namespace graphics {
+
+    /**
+     * Temporal upscaling of a layer rendered below screen resolution.
+     *
+     * Every frame the layer is rendered with its projection shifted by a
+     * sub-pixel jitter (Halton 2,3), so successive frames sample different
+     * points of each screen pixel. The resolve (taa_resolve.comp) reprojects
+     * the previous full-resolution result with the view/projection change,
+     * clamps it to the 3x3 neighborhood of this frame's samples (what moved
+     * or disoccluded doesn't ghost) and blends this frame in: a layer at half
+     * the resolution per axis converges to close to native within a few frames.
+     *
+     * There are no motion vectors: the AR planes are alpha blended and don't
+     * write depth, so the history is reprojected as if everything were
+     * `reprojectionDepth` meters away. The error of that for geometry closer
+     * or farther is left to the neighborhood clamp.
+     *
+     * The output ping-pongs between two full-resolution RGBA8 images: one is
+     * written while the other is the history. After Record() the output is in
+     * SHADER_READ_ONLY layout for fragment shaders. Everything is on the
+     * graphics queue, in the frame's command buffer.
+     *
+     * Needs shaders/taa_resolve.comp.spv (see IsAvailable).
+     *
+     * Usage:
+     *   TemporalUpscaler upscaler(device, allocator, swapchainExtent);
+     *   // per frame, before preparing the layer's draws
+     *   glm::mat4 jittered = upscaler.BeginFrame(view, proj, renderArea);
+     *   ... render the layer with `jittered`, into the top-left renderArea of `layer`
+     *   upscaler.Record(cmd, layerView, layerSize);   // layer in SHADER_READ_ONLY
+     *   ... sample upscaler.GetOutputView()
+     */
+    class TemporalUpscaler {
+    public:
+        static constexpr const char* SHADER_PATH = "shaders/taa_resolve.comp.spv";
+        /// Work group size of taa_resolve.comp
+        static constexpr uint32_t LOCAL_SIZE = 8;
+        /// Length of the jitter sequence
+        static constexpr uint32_t JITTER_PHASES = 16;
+
+        struct Settings {
+            float historyWeight = 0.9f;      // share of the history in the output
+            float reprojectionDepth = 1.5f;  // meters, assumed for every pixel when reprojecting
+            float renderScale = 0.5f;        // per axis, when nothing else picks the render area
+        };
+
+        /// Whether the compute shader is packaged.
+        static bool IsAvailable();
+
+        TemporalUpscaler(VkDevice device, VmaAllocator allocator, VkExtent2D outputSize);
+        TemporalUpscaler(VkDevice device, VmaAllocator allocator, VkExtent2D outputSize, const Settings& settings);
+        ~TemporalUpscaler();
+
+        TemporalUpscaler(const TemporalUpscaler&) = delete;
+        TemporalUpscaler& operator=(const TemporalUpscaler&) = delete;
+
+        /**
+         * Starts a frame: advances the jitter and keeps `view`/`proj` for the
+         * reprojection of the next frame.
+         * @param renderArea  size the layer is rendered at this frame
+         * @return `proj` with this frame's jitter, to render the layer with
+         */
+        glm::mat4 BeginFrame(const glm::mat4& view, const glm::mat4& proj, VkExtent2D renderArea);
+
+        /**
+         * Records the resolve of this frame's layer into the next output.
+         * Outside render passes.
+         * @param layer      the layer, sampled in SHADER_READ_ONLY_OPTIMAL, rendered in its top-left render area
+         * @param layerSize  size of the image behind `layer`
+         */
+        void Record(VkCommandBuffer cmd, VkImageView layer, VkExtent2D layerSize);
+
+        /// Drops the history (the layer was skipped): the next Record() starts over from its frame.
+        void Reset() { hasHistory = false; }
+
+        /// Output of the last Record(); VK_NULL_HANDLE before the first one.
+        VkImageView GetOutputView() const { return hasHistory ? outputs[written].view : VK_NULL_HANDLE; }
+        VkExtent2D  GetExtent() const { return extent; }
+        /// renderScale of the output size, for when the render area isn't picked elsewhere
+        VkExtent2D  GetDefaultRenderExtent() const;
+
+    private:
+        struct Output {
+            VkImage       image = VK_NULL_HANDLE;
+            VmaAllocation allocation = VK_NULL_HANDLE;
+            VkImageView   view = VK_NULL_HANDLE;
+            ResourceState state;
+        };
+        /// Must match taa_resolve.comp
+        struct PushConstants {
+            float reprojection[16];   // this frame's NDC -> previous frame's clip space
+            float jitterUV[2];        // this frame's jitter in screen UV
+            float uvScale[2];         // render area / layer size
+            float uvMax[2];           // last texel centers of the render area
+            float texelSize[2];       // 1 / layer size
+            float reprojectionDepth;  // NDC depth of Settings::reprojectionDepth
+            float historyWeight;      // 0 without history
+        };
+
+        VkDevice device;
+        VmaAllocator allocator;
+        VkExtent2D extent;
+        Settings settings;
+
+        VkSampler sampler = VK_NULL_HANDLE;
+        VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+        utils::RingBuffer<VkDescriptorSet> descriptorSets;   // rewritten per frame, one per frame in flight
+        Output outputs[2];
+        uint32_t written = 0;    // outputs[written] is the latest result
+        bool hasHistory = false;
+        BarrierBatch barriers;
+
+        // The frame begun by BeginFrame()
+        uint32_t phase = 0;
+        glm::vec2 jitter{0.0f};   // NDC
+        VkExtent2D renderArea{};
+        glm::mat4 reprojection{1.0f};
+        float reprojectionDepthNdc = 0.0f;
+        glm::mat4 previousViewProj{1.0f};
+        bool hasPrevious = false;
+
+        void CreatePipeline();
+        void CreateOutputs();
+    };
+}
+#endif //KRAKATOA_TEMPORAL_UPSCALER_H
@@ -15,7 +15,23 @@ Texture2D::Texture2D(VkDevice device,
                      uint32_t height,
                      VkFormat format,
                      const std::string& name)
-        : device(device), allocator(allocator), format(format), width(width), height(height) {
+        : Texture2D(device, allocator, cmdManager, pixels,
+                    std::vector<MipLevel>{MipLevel{0, width, height}}, format, name) {
+}
+
+Texture2D::Texture2D(VkDevice device,
+                     VmaAllocator allocator,
+                     CommandPoolManager& cmdManager,
+                     const std::vector<uint8_t>& pixels,
+                     const std::vector<MipLevel>& levels,
+                     VkFormat format,
+                     const std::string& name)
+        : device(device), allocator(allocator), format(format) {
+
+    assert(!levels.empty());
+    width     = levels[0].width;
+    height    = levels[0].height;
+    mipLevels = static_cast<uint32_t>(levels.size());
 
     const VkDeviceSize imageSize = static_cast<VkDeviceSize>(pixels.size());
     assert(imageSize > 0);
@@ -49,7 +65,7 @@ Texture2D::Texture2D(VkDevice device,
     imgInfo.imageType     = VK_IMAGE_TYPE_2D;
     imgInfo.format        = format;
     imgInfo.extent        = {width, height, 1};
-    imgInfo.mipLevels     = 1;
+    imgInfo.mipLevels     = mipLevels;
     imgInfo.arrayLayers   = 1;
     imgInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
     imgInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
@@ -64,12 +80,24 @@ Texture2D::Texture2D(VkDevice device,
                             &image, &allocation, nullptr);
     assert(result == VK_SUCCESS);
 
-    // --- Upload via transfer queue with layout transition ---
-    cmdManager.UploadImage(stagingBuffer, image, width, height,
-                           VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-    // Destroy staging
-    vmaDestroyBuffer(allocator, stagingBuffer, stagingAlloc);
+    // --- Upload via transfer queue with layout transition, one region per mip ---
+    std::vector<VkBufferImageCopy> regions(levels.size());
+    for (uint32_t i = 0; i < mipLevels; i++) {
+        VkBufferImageCopy& region = regions[i];
+        region = {};
+        region.bufferOffset = levels[i].offset;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = i;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = {levels[i].width, levels[i].height, 1};
+    }
+    // Staging is destroyed once the upload is done
+    cmdManager.UploadImage(stagingBuffer, image, regions, mipLevels,
+                           VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                           [allocator, stagingBuffer, stagingAlloc] {
+                               vmaDestroyBuffer(allocator, stagingBuffer, stagingAlloc);
+                           });
 
     // --- Image view ---
     VkImageViewCreateInfo viewInfo{};
@@ -79,7 +107,7 @@ Texture2D::Texture2D(VkDevice device,
     viewInfo.format     = format;
     viewInfo.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
     viewInfo.subresourceRange.baseMipLevel   = 0;
-    viewInfo.subresourceRange.levelCount     = 1;
+    viewInfo.subresourceRange.levelCount     = mipLevels;
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount     = 1;
     result = vkCreateImageView(device, &viewInfo, nullptr, &imageView);
@@ -91,8 +119,8 @@ Texture2D::Texture2D(VkDevice device,
         debug::SetImageViewName(device, imageView, Concatenate(name, ":ImageView"));
     }
 
-    LOGI("Texture2D created: %ux%u format=%d (%zu bytes) name='%s'",
-         width, height, format, (size_t)imageSize, name.c_str());
+    LOGI("Texture2D created: %ux%u format=%d mips=%u (%zu bytes) name='%s'",
+         width, height, format, mipLevels, (size_t)imageSize, name.c_str());
 }
 
 Texture2D::~Texture2D() {
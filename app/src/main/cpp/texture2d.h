@@ -8,6 +8,13 @@
 namespace graphics {
     class CommandPoolManager;
 
+    /// One level of a mip chain inside a packed pixel blob.
+    struct MipLevel {
+        VkDeviceSize offset = 0;
+        uint32_t     width  = 0;
+        uint32_t     height = 0;
+    };
+
     /**
      * GPU-resident 2D texture. Holds a Vulkan image, image view and metadata.
      * CPU-side pixel data is discarded after upload.
@@ -38,6 +45,23 @@ namespace graphics {
                   VkFormat format,
                   const std::string& name = "");
 
+        /**
+         * Create a texture with a pre-built mip chain, e.g. from a KTX2 file.
+         * Works for block-compressed formats too: the levels are copied as-is.
+         *
+         * @param data    All levels packed in one blob
+         * @param levels  Offset and size of each level, largest first
+         * @param format  Vulkan format of every level
+         * @param name    Debug name for this texture
+         */
+        Texture2D(VkDevice device,
+                  VmaAllocator allocator,
+                  CommandPoolManager& cmdManager,
+                  const std::vector<uint8_t>& data,
+                  const std::vector<MipLevel>& levels,
+                  VkFormat format,
+                  const std::string& name = "");
+
         ~Texture2D();
 
         Texture2D(const Texture2D&) = delete;
@@ -48,6 +72,7 @@ namespace graphics {
         VkFormat    GetFormat()    const { return format; }
         uint32_t    GetWidth()     const { return width; }
         uint32_t    GetHeight()    const { return height; }
+        uint32_t    GetMipLevels() const { return mipLevels; }
 
     private:
         VkDevice     device;
@@ -60,6 +85,7 @@ namespace graphics {
         VkFormat format;
         uint32_t width  = 0;
         uint32_t height = 0;
+        uint32_t mipLevels = 1;
     };
 }
 #endif //KRAKATOA_TEXTURE2D_H
@@ -0,0 +1,338 @@
+#include "texture_transcoder.h"
+#include "android_log.h"
+#include <algorithm>
+#include <cstring>
+
+namespace io {
+    namespace {
+        enum class BlockCodec { None, BC1, BC1A, BC3, ETC2_RGB, ETC2_RGBA };
+
+        struct CodecInfo {
+            BlockCodec codec;
+            bool srgb;
+        };
+
+        CodecInfo GetCodec(VkFormat format) {
+            switch (format) {
+                case VK_FORMAT_BC1_RGB_UNORM_BLOCK:       return {BlockCodec::BC1, false};
+                case VK_FORMAT_BC1_RGB_SRGB_BLOCK:        return {BlockCodec::BC1, true};
+                case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:      return {BlockCodec::BC1A, false};
+                case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:       return {BlockCodec::BC1A, true};
+                case VK_FORMAT_BC3_UNORM_BLOCK:           return {BlockCodec::BC3, false};
+                case VK_FORMAT_BC3_SRGB_BLOCK:            return {BlockCodec::BC3, true};
+                case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:   return {BlockCodec::ETC2_RGB, false};
+                case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:    return {BlockCodec::ETC2_RGB, true};
+                case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK: return {BlockCodec::ETC2_RGBA, false};
+                case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:  return {BlockCodec::ETC2_RGBA, true};
+                default:                                  return {BlockCodec::None, false};
+            }
+        }
+
+        size_t BlockBytes(BlockCodec codec) {
+            return (codec == BlockCodec::BC3 || codec == BlockCodec::ETC2_RGBA) ? 16 : 8;
+        }
+
+        inline uint8_t Clamp255(int v) {
+            return static_cast<uint8_t>(std::min(255, std::max(0, v)));
+        }
+
+        inline uint8_t Extend4(uint32_t v) { return static_cast<uint8_t>((v << 4) | v); }
+        inline uint8_t Extend5(uint32_t v) { return static_cast<uint8_t>((v << 3) | (v >> 2)); }
+        inline uint8_t Extend6(uint32_t v) { return static_cast<uint8_t>((v << 2) | (v >> 4)); }
+        inline uint8_t Extend7(uint32_t v) { return static_cast<uint8_t>((v << 1) | (v >> 6)); }
+
+        // ============================================================
+        // BC1 / BC3
+        // ============================================================
+
+        /// Decodes a BC1 color block into 16 RGBA texels (row-major).
+        /// forceFourColor is set for the color half of BC3, which never uses
+        /// the 3-color + transparent mode.
+        void DecodeBC1(const uint8_t* block, uint8_t* rgba, bool allowAlpha, bool forceFourColor) {
+            const uint32_t c0 = block[0] | (block[1] << 8);
+            const uint32_t c1 = block[2] | (block[3] << 8);
+            uint8_t palette[4][4];
+            palette[0][0] = Extend5((c0 >> 11) & 31);
+            palette[0][1] = Extend6((c0 >> 5) & 63);
+            palette[0][2] = Extend5(c0 & 31);
+            palette[0][3] = 255;
+            palette[1][0] = Extend5((c1 >> 11) & 31);
+            palette[1][1] = Extend6((c1 >> 5) & 63);
+            palette[1][2] = Extend5(c1 & 31);
+            palette[1][3] = 255;
+            if (c0 > c1 || forceFourColor) {
+                for (int ch = 0; ch < 3; ch++) {
+                    palette[2][ch] = static_cast<uint8_t>((2 * palette[0][ch] + palette[1][ch]) / 3);
+                    palette[3][ch] = static_cast<uint8_t>((palette[0][ch] + 2 * palette[1][ch]) / 3);
+                }
+                palette[2][3] = 255;
+                palette[3][3] = 255;
+            } else {
+                for (int ch = 0; ch < 3; ch++) {
+                    palette[2][ch] = static_cast<uint8_t>((palette[0][ch] + palette[1][ch]) / 2);
+                    palette[3][ch] = 0;
+                }
+                palette[2][3] = 255;
+                palette[3][3] = allowAlpha ? 0 : 255;
+            }
+            const uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) |
+                                     (static_cast<uint32_t>(block[7]) << 24);
+            for (int i = 0; i < 16; i++) {
+                memcpy(rgba + i * 4, palette[(indices >> (2 * i)) & 3], 4);
+            }
+        }
+
+        /// Decodes the 8-byte BC3 (BC4-style) alpha half into the A channel.
+        void DecodeBC3Alpha(const uint8_t* block, uint8_t* rgba) {
+            const int a0 = block[0];
+            const int a1 = block[1];
+            uint8_t palette[8];
+            palette[0] = static_cast<uint8_t>(a0);
+            palette[1] = static_cast<uint8_t>(a1);
+            if (a0 > a1) {
+                for (int i = 1; i < 7; i++) {
+                    palette[i + 1] = static_cast<uint8_t>(((7 - i) * a0 + i * a1) / 7);
+                }
+            } else {
+                for (int i = 1; i < 5; i++) {
+                    palette[i + 1] = static_cast<uint8_t>(((5 - i) * a0 + i * a1) / 5);
+                }
+                palette[6] = 0;
+                palette[7] = 255;
+            }
+            uint64_t bits = 0;
+            for (int i = 0; i < 6; i++) {
+                bits |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+            }
+            for (int i = 0; i < 16; i++) {
+                rgba[i * 4 + 3] = palette[(bits >> (3 * i)) & 7];
+            }
+        }
+
+        // ============================================================
+        // ETC2 / EAC
+        // ============================================================
+
+        const int ETC1_MODIFIERS[8][2] = {
+            {2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}
+        };
+        const int ETC2_DISTANCES[8] = {3, 6, 11, 16, 23, 32, 41, 64};
+        const int EAC_MODIFIERS[16][8] = {
+            {-3, -6, -9, -15, 2, 5, 8, 14}, {-3, -7, -10, -13, 2, 6, 9, 12},
+            {-2, -5, -8, -13, 1, 4, 7, 12}, {-2, -4, -6, -13, 1, 3, 5, 12},
+            {-3, -6, -8, -12, 2, 5, 7, 11}, {-3, -7, -9, -11, 2, 6, 8, 10},
+            {-4, -7, -8, -11, 3, 6, 7, 10}, {-3, -5, -8, -11, 2, 4, 7, 10},
+            {-2, -6, -8, -10, 1, 5, 7, 9},  {-2, -5, -8, -10, 1, 4, 7, 9},
+            {-2, -4, -8, -10, 1, 3, 7, 9},  {-2, -5, -7, -10, 1, 4, 6, 9},
+            {-3, -4, -7, -10, 2, 3, 6, 9},  {-1, -2, -3, -10, 0, 1, 2, 9},
+            {-4, -6, -8, -9, 3, 5, 7, 8},   {-3, -5, -7, -9, 2, 4, 6, 8}
+        };
+
+        inline void Put(uint8_t* rgba, int x, int y, int r, int g, int b) {
+            uint8_t* p = rgba + (y * 4 + x) * 4;
+            p[0] = Clamp255(r);
+            p[1] = Clamp255(g);
+            p[2] = Clamp255(b);
+            p[3] = 255;
+        }
+
+        /// Pixel indices are stored column-major: bit (x * 4 + y).
+        inline int PixelIndex(const uint8_t* block, int x, int y) {
+            const uint32_t msbs = (block[4] << 8) | block[5];
+            const uint32_t lsbs = (block[6] << 8) | block[7];
+            const int bit = x * 4 + y;
+            return static_cast<int>((((msbs >> bit) & 1) << 1) | ((lsbs >> bit) & 1));
+        }
+
+        void DecodeETC2Paint(const uint8_t* block, uint8_t* rgba, const int paint[4][3]) {
+            for (int x = 0; x < 4; x++) {
+                for (int y = 0; y < 4; y++) {
+                    const int* c = paint[PixelIndex(block, x, y)];
+                    Put(rgba, x, y, c[0], c[1], c[2]);
+                }
+            }
+        }
+
+        void DecodeETC2RGB(const uint8_t* block, uint8_t* rgba) {
+            const bool diff = (block[3] & 2) != 0;
+            const bool flip = (block[3] & 1) != 0;
+            int base[2][3];
+
+            if (diff) {
+                const int r = block[0] >> 3, g = block[1] >> 3, b = block[2] >> 3;
+                const int dr = static_cast<int8_t>(block[0] << 5) >> 5;
+                const int dg = static_cast<int8_t>(block[1] << 5) >> 5;
+                const int db = static_cast<int8_t>(block[2] << 5) >> 5;
+
+                if (r + dr < 0 || r + dr > 31) {
+                    // T mode
+                    const uint32_t r1 = (((block[0] >> 3) & 3) << 2) | (block[0] & 3);
+                    const int c1[3] = {Extend4(r1), Extend4(block[1] >> 4), Extend4(block[1] & 15)};
+                    const int c2[3] = {Extend4(block[2] >> 4), Extend4(block[2] & 15), Extend4(block[3] >> 4)};
+                    const int d = ETC2_DISTANCES[(((block[3] >> 2) & 3) << 1) | (block[3] & 1)];
+                    const int paint[4][3] = {
+                        {c1[0], c1[1], c1[2]},
+                        {c2[0] + d, c2[1] + d, c2[2] + d},
+                        {c2[0], c2[1], c2[2]},
+                        {c2[0] - d, c2[1] - d, c2[2] - d}
+                    };
+                    DecodeETC2Paint(block, rgba, paint);
+                    return;
+                }
+                if (g + dg < 0 || g + dg > 31) {
+                    // H mode
+                    const uint32_t r1 = (block[0] >> 3) & 15;
+                    const uint32_t g1 = ((block[0] & 7) << 1) | ((block[1] >> 4) & 1);
+                    const uint32_t b1 = (block[1] & 8) | ((block[1] & 3) << 1) | (block[2] >> 7);
+                    const uint32_t r2 = (block[2] >> 3) & 15;
+                    const uint32_t g2 = ((block[2] & 7) << 1) | (block[3] >> 7);
+                    const uint32_t b2 = (block[3] >> 3) & 15;
+                    const uint32_t order = ((r1 << 8) | (g1 << 4) | b1) >= ((r2 << 8) | (g2 << 4) | b2) ? 1 : 0;
+                    const int d = ETC2_DISTANCES[(((block[3] >> 2) & 1) << 2) | ((block[3] & 1) << 1) | order];
+                    const int c1[3] = {Extend4(r1), Extend4(g1), Extend4(b1)};
+                    const int c2[3] = {Extend4(r2), Extend4(g2), Extend4(b2)};
+                    const int paint[4][3] = {
+                        {c1[0] + d, c1[1] + d, c1[2] + d},
+                        {c1[0] - d, c1[1] - d, c1[2] - d},
+                        {c2[0] + d, c2[1] + d, c2[2] + d},
+                        {c2[0] - d, c2[1] - d, c2[2] - d}
+                    };
+                    DecodeETC2Paint(block, rgba, paint);
+                    return;
+                }
+                if (b + db < 0 || b + db > 31) {
+                    // Planar mode
+                    const int ro = Extend6((block[0] >> 1) & 63);
+                    const int go = Extend7(((block[0] & 1) << 6) | ((block[1] >> 1) & 63));
+                    const int bo = Extend6(((block[1] & 1) << 5) | (((block[2] >> 3) & 3) << 3) |
+                                           ((block[2] & 3) << 1) | (block[3] >> 7));
+                    const int rh = Extend6((((block[3] >> 2) & 31) << 1) | (block[3] & 1));
+                    const int gh = Extend7(block[4] >> 1);
+                    const int bh = Extend6(((block[4] & 1) << 5) | (block[5] >> 3));
+                    const int rv = Extend6(((block[5] & 7) << 3) | (block[6] >> 5));
+                    const int gv = Extend7(((block[6] & 31) << 2) | (block[7] >> 6));
+                    const int bv = Extend6(block[7] & 63);
+                    for (int y = 0; y < 4; y++) {
+                        for (int x = 0; x < 4; x++) {
+                            Put(rgba, x, y,
+                                (x * (rh - ro) + y * (rv - ro) + 4 * ro + 2) >> 2,
+                                (x * (gh - go) + y * (gv - go) + 4 * go + 2) >> 2,
+                                (x * (bh - bo) + y * (bv - bo) + 4 * bo + 2) >> 2);
+                        }
+                    }
+                    return;
+                }
+                // Differential mode
+                base[0][0] = Extend5(r);      base[0][1] = Extend5(g);      base[0][2] = Extend5(b);
+                base[1][0] = Extend5(r + dr); base[1][1] = Extend5(g + dg); base[1][2] = Extend5(b + db);
+            } else {
+                // Individual mode
+                base[0][0] = Extend4(block[0] >> 4); base[1][0] = Extend4(block[0] & 15);
+                base[0][1] = Extend4(block[1] >> 4); base[1][1] = Extend4(block[1] & 15);
+                base[0][2] = Extend4(block[2] >> 4); base[1][2] = Extend4(block[2] & 15);
+            }
+
+            const int table[2] = {(block[3] >> 5) & 7, (block[3] >> 2) & 7};
+            for (int x = 0; x < 4; x++) {
+                for (int y = 0; y < 4; y++) {
+                    const int sub = flip ? (y >= 2) : (x >= 2);
+                    const int idx = PixelIndex(block, x, y);
+                    int mod = ETC1_MODIFIERS[table[sub]][idx & 1];
+                    if (idx & 2) {
+                        mod = -mod;
+                    }
+                    Put(rgba, x, y, base[sub][0] + mod, base[sub][1] + mod, base[sub][2] + mod);
+                }
+            }
+        }
+
+        void DecodeEACAlpha(const uint8_t* block, uint8_t* rgba) {
+            const int base = block[0];
+            const int multiplier = block[1] >> 4;
+            const int* modifiers = EAC_MODIFIERS[block[1] & 15];
+            uint64_t bits = 0;
+            for (int i = 0; i < 6; i++) {
+                bits = (bits << 8) | block[2 + i];
+            }
+            for (int x = 0; x < 4; x++) {
+                for (int y = 0; y < 4; y++) {
+                    const int idx = static_cast<int>((bits >> (45 - 3 * (x * 4 + y))) & 7);
+                    rgba[(y * 4 + x) * 4 + 3] = Clamp255(base + modifiers[idx] * multiplier);
+                }
+            }
+        }
+
+        void DecodeBlock(BlockCodec codec, const uint8_t* block, uint8_t* rgba) {
+            switch (codec) {
+                case BlockCodec::BC1:
+                    DecodeBC1(block, rgba, false, false);
+                    break;
+                case BlockCodec::BC1A:
+                    DecodeBC1(block, rgba, true, false);
+                    break;
+                case BlockCodec::BC3:
+                    DecodeBC1(block + 8, rgba, false, true);
+                    DecodeBC3Alpha(block, rgba);
+                    break;
+                case BlockCodec::ETC2_RGB:
+                    DecodeETC2RGB(block, rgba);
+                    break;
+                case BlockCodec::ETC2_RGBA:
+                    DecodeETC2RGB(block + 8, rgba);
+                    DecodeEACAlpha(block, rgba);
+                    break;
+                case BlockCodec::None:
+                    break;
+            }
+        }
+    }
+
+    bool CanTranscodeToRGBA8(VkFormat format) {
+        return GetCodec(format).codec != BlockCodec::None;
+    }
+
+    bool TranscodeToRGBA8(const Ktx2Texture& src, Ktx2Texture& dst) {
+        const CodecInfo info = GetCodec(src.format);
+        if (info.codec == BlockCodec::None) {
+            LOGE("Transcoder: format %d not supported", src.format);
+            return false;
+        }
+        const size_t blockBytes = BlockBytes(info.codec);
+
+        size_t total = 0;
+        for (const auto& level : src.levels) {
+            total += static_cast<size_t>(level.width) * level.height * 4;
+        }
+        dst.format = info.srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+        dst.width  = src.width;
+        dst.height = src.height;
+        dst.data.assign(total, 0);
+        dst.levels.clear();
+
+        size_t dstOffset = 0;
+        uint8_t texels[16 * 4];
+        for (const auto& level : src.levels) {
+            const uint32_t blocksX = (level.width + 3) / 4;
+            const uint32_t blocksY = (level.height + 3) / 4;
+            const uint8_t* blocks = src.data.data() + level.offset;
+            uint8_t* out = dst.data.data() + dstOffset;
+            for (uint32_t by = 0; by < blocksY; by++) {
+                for (uint32_t bx = 0; bx < blocksX; bx++) {
+                    DecodeBlock(info.codec, blocks + (by * blocksX + bx) * blockBytes, texels);
+                    // Edge blocks of small mips hang over the image; clip them.
+                    const uint32_t w = std::min(4u, level.width - bx * 4);
+                    const uint32_t h = std::min(4u, level.height - by * 4);
+                    for (uint32_t y = 0; y < h; y++) {
+                        memcpy(out + ((by * 4 + y) * level.width + bx * 4) * 4,
+                               texels + y * 16, w * 4);
+                    }
+                }
+            }
+            graphics::MipLevel decoded = level;
+            decoded.offset = dstOffset;
+            dst.levels.push_back(decoded);
+            dstOffset += static_cast<size_t>(level.width) * level.height * 4;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef KRAKATOA_TEXTURE_TRANSCODER_H
+#define KRAKATOA_TEXTURE_TRANSCODER_H
+#include <vulkan/vulkan.h>
+#include "ktx2_loader.h"
+namespace io {
+    /**
+     * CPU fallback for block-compressed textures the GPU can't sample.
+     * Decodes BC1, BC3, ETC2 RGB8 and ETC2 RGBA8 (EAC alpha) to R8G8B8A8, keeping
+     * the sRGB-ness of the source format. ASTC is not handled; ship an ETC2 or
+     * BC variant next to it if you need a fallback.
+     */
+    bool CanTranscodeToRGBA8(VkFormat format);
+
+    /**
+     * Decodes every mip level of src into dst (tightly packed RGBA8, 4-byte
+     * aligned levels). dst.format becomes R8G8B8A8_UNORM or R8G8B8A8_SRGB.
+     * @return false if the format is not one CanTranscodeToRGBA8 accepts
+     */
+    bool TranscodeToRGBA8(const Ktx2Texture& src, Ktx2Texture& dst);
+}
+#endif //KRAKATOA_TEXTURE_TRANSCODER_H
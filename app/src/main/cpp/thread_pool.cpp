@@ -0,0 +1,90 @@
+#include "thread_pool.h"
+#include "android_log.h"
+#include <algorithm>
+#include <cassert>
+#include <pthread.h>
+using namespace utils;
+
+// ============================================================
+// Latch
+// ============================================================
+
+void Latch::Reset(uint32_t newCount) {
+    std::lock_guard<std::mutex> lock(mutex);
+    assert(count == 0 && "Latch re-armed while jobs are still counting down");
+    count = newCount;
+}
+
+void Latch::CountDown() {
+    std::lock_guard<std::mutex> lock(mutex);
+    assert(count > 0);
+    if (--count == 0) {
+        done.notify_all();
+    }
+}
+
+void Latch::Wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return count == 0; });
+}
+
+bool Latch::IsDone() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return count == 0;
+}
+
+// ============================================================
+// Thread pool
+// ============================================================
+
+ThreadPool::ThreadPool(uint32_t threadCount, const char* name) {
+    assert(threadCount > 0);
+    threads.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i) {
+        threads.emplace_back([this] { Run(); });
+        // Linux caps thread names at 15 characters
+        const std::string threadName = (std::string(name) + "-" + std::to_string(i)).substr(0, 15);
+        pthread_setname_np(threads.back().native_handle(), threadName.c_str());
+    }
+    LOGI("ThreadPool %s: %u threads", name, threadCount);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+uint32_t ThreadPool::DefaultThreadCount() {
+    const uint32_t cores = std::max(1u, std::thread::hardware_concurrency());
+    return std::clamp(cores - 1, 1u, 4u);
+}
+
+void ThreadPool::Run() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping && jobs.empty()) {
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef KRAKATOA_THREAD_POOL_H
+#define KRAKATOA_THREAD_POOL_H
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+namespace utils {
+    /**
+     * Counts down from a number of jobs; Wait() blocks until they all ran.
+     * A C++17 stand-in for std::latch that can be re-armed with Reset().
+     */
+    class Latch {
+    public:
+        explicit Latch(uint32_t count = 0) : count(count) {}
+
+        Latch(const Latch&) = delete;
+        Latch& operator=(const Latch&) = delete;
+
+        /// Re-arm. Only call once the previous count reached zero.
+        void Reset(uint32_t newCount);
+        void CountDown();
+        void Wait();
+        bool IsDone();
+
+    private:
+        std::mutex              mutex;
+        std::condition_variable done;
+        uint32_t                count;
+    };
+
+    /**
+     * Fixed set of worker threads draining one FIFO job queue.
+     *
+     * Usage:
+     *   utils::ThreadPool pool(utils::ThreadPool::DefaultThreadCount(), "worker");
+     *   utils::Latch latch(bands);
+     *   for (uint32_t i = 0; i < bands; ++i)
+     *       pool.Submit([&, i] { CopyBand(i); latch.CountDown(); });
+     *   ...other work...
+     *   latch.Wait();
+     */
+    class ThreadPool {
+    public:
+        /// @param name  thread name prefix, shows up in systrace / perfetto
+        ThreadPool(uint32_t threadCount, const char* name);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        void Submit(std::function<void()> job);
+        uint32_t Size() const { return static_cast<uint32_t>(threads.size()); }
+
+        /// One thread per core, minus the render thread, at most 4.
+        static uint32_t DefaultThreadCount();
+
+    private:
+        void Run();
+
+        std::vector<std::thread>          threads;
+        std::deque<std::function<void()>> jobs;
+        std::mutex                        mutex;
+        std::condition_variable           wake;
+        bool                              stopping = false;
+    };
+}
+#endif //KRAKATOA_THREAD_POOL_H
@@ -0,0 +1,74 @@
+#include "timeline_semaphore.h"
+#include "vk_debug.h"
+#include <algorithm>
+#include <cassert>
+using namespace graphics;
+
+TimelineSemaphore::TimelineSemaphore(VkDevice device, const std::string& name, uint64_t initialValue)
+        : device(device), completed(initialValue) {
+    VkSemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = initialValue;
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+
+    VkResult result = vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore);
+    assert(result == VK_SUCCESS);
+    debug::SetSemaphoreName(device, semaphore, name);
+
+    // Whichever name the driver exposes: VkContext enabled one or the other
+    waitSemaphores = reinterpret_cast<PFN_vkWaitSemaphores>(
+            vkGetDeviceProcAddr(device, "vkWaitSemaphores"));
+    getSemaphoreCounterValue = reinterpret_cast<PFN_vkGetSemaphoreCounterValue>(
+            vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValue"));
+    signalSemaphore = reinterpret_cast<PFN_vkSignalSemaphore>(
+            vkGetDeviceProcAddr(device, "vkSignalSemaphore"));
+    if (waitSemaphores == nullptr || getSemaphoreCounterValue == nullptr || signalSemaphore == nullptr) {
+        waitSemaphores = reinterpret_cast<PFN_vkWaitSemaphores>(
+                vkGetDeviceProcAddr(device, "vkWaitSemaphoresKHR"));
+        getSemaphoreCounterValue = reinterpret_cast<PFN_vkGetSemaphoreCounterValue>(
+                vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR"));
+        signalSemaphore = reinterpret_cast<PFN_vkSignalSemaphore>(
+                vkGetDeviceProcAddr(device, "vkSignalSemaphoreKHR"));
+    }
+    assert(waitSemaphores != nullptr && getSemaphoreCounterValue != nullptr && signalSemaphore != nullptr);
+}
+
+TimelineSemaphore::~TimelineSemaphore() {
+    vkDestroySemaphore(device, semaphore, nullptr);
+}
+
+uint64_t TimelineSemaphore::GetCompletedValue() {
+    uint64_t value = 0;
+    VkResult result = getSemaphoreCounterValue(device, semaphore, &value);
+    assert(result == VK_SUCCESS);
+    completed = std::max(completed, value);
+    return completed;
+}
+
+void TimelineSemaphore::Wait(uint64_t value) {
+    if (value <= completed) {
+        return;
+    }
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &semaphore;
+    waitInfo.pValues = &value;
+    VkResult result = waitSemaphores(device, &waitInfo, UINT64_MAX);
+    assert(result == VK_SUCCESS);
+    completed = std::max(completed, value);
+}
+
+void TimelineSemaphore::Signal(uint64_t value) {
+    VkSemaphoreSignalInfo signalInfo{};
+    signalInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO;
+    signalInfo.semaphore = semaphore;
+    signalInfo.value = value;
+    VkResult result = signalSemaphore(device, &signalInfo);
+    assert(result == VK_SUCCESS);
+    completed = std::max(completed, value);
+}
@@ -0,0 +1,53 @@
+#ifndef KRAKATOA_TIMELINE_SEMAPHORE_H
+#define KRAKATOA_TIMELINE_SEMAPHORE_H
+#include <vulkan/vulkan.h>
+#include <string>
+namespace graphics {
+
+    /**
+     * A timeline semaphore plus the host-side calls on it. Submits signal
+     * increasing values; the host asks how far the GPU got or blocks until a
+     * value is reached. The completed value is cached and only grows, so
+     * repeated checks against old values don't touch the driver.
+     *
+     * VkContext requires timeline semaphores (core 1.2, or the KHR extension
+     * on 1.1), so the entry points are looked up under either name.
+     *
+     * Usage:
+     *   TimelineSemaphore timeline(device, "UploadTimeline");
+     *   // submit with VkTimelineSemaphoreSubmitInfo signalling `value`
+     *   if (!timeline.IsReached(value)) timeline.Wait(value);
+     */
+    class TimelineSemaphore {
+    public:
+        TimelineSemaphore(VkDevice device, const std::string& name, uint64_t initialValue = 0);
+        ~TimelineSemaphore();
+
+        TimelineSemaphore(const TimelineSemaphore&) = delete;
+        TimelineSemaphore& operator=(const TimelineSemaphore&) = delete;
+
+        VkSemaphore Get() const { return semaphore; }
+
+        /// Latest value the GPU signalled. Queries the semaphore.
+        uint64_t GetCompletedValue();
+
+        bool IsReached(uint64_t value) { return value <= completed || value <= GetCompletedValue(); }
+
+        /// Blocks until the semaphore reaches `value`. Only for values already submitted.
+        void Wait(uint64_t value);
+
+        /// Sets the semaphore to `value` from the host, for a value no submit will signal
+        void Signal(uint64_t value);
+
+    private:
+        VkDevice device;
+        VkSemaphore semaphore = VK_NULL_HANDLE;
+        uint64_t completed = 0;   // last value read back, never goes down
+
+        // Core 1.2 entry points, or the VK_KHR_timeline_semaphore ones on 1.1
+        PFN_vkWaitSemaphores           waitSemaphores = nullptr;
+        PFN_vkGetSemaphoreCounterValue getSemaphoreCounterValue = nullptr;
+        PFN_vkSignalSemaphore          signalSemaphore = nullptr;
+    };
+}
+#endif //KRAKATOA_TIMELINE_SEMAPHORE_H
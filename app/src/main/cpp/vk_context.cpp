@@ -1,9 +1,12 @@
 #include "vk_context.h"
 #include "vk_debug.h"
+#include "barrier_batch.h"
 #include "android_log.h"
 #include <cassert>
 #include <set>
 #include <map>
+#include <algorithm>
+#include <cstring>
 using namespace graphics;
 void fillApplicationInfo(VkApplicationInfo& info);
 static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
@@ -90,9 +93,31 @@ bool VkContext::createInstance() {
         LOGE("Validation layers requested but not available");
         assert(false);
     }
+    // Synchronization validation: reports hazards the barriers (BarrierBatch) miss
+    uint32_t layerExtensionCount = 0;
+    vkEnumerateInstanceExtensionProperties("VK_LAYER_KHRONOS_validation", &layerExtensionCount, nullptr);
+    std::vector<VkExtensionProperties> layerExtensions(layerExtensionCount);
+    vkEnumerateInstanceExtensionProperties("VK_LAYER_KHRONOS_validation", &layerExtensionCount,
+                                           layerExtensions.data());
+    const bool validationFeatures = std::any_of(layerExtensions.begin(), layerExtensions.end(),
+                                                [](const VkExtensionProperties& e) {
+        return strcmp(e.extensionName, VK_EXT_VALIDATION_FEATURES_EXTENSION_NAME) == 0;
+    });
+    const VkValidationFeatureEnableEXT enabledValidation[] = {
+            VK_VALIDATION_FEATURE_ENABLE_SYNCHRONIZATION_VALIDATION_EXT
+    };
+    VkValidationFeaturesEXT validationFeaturesInfo{};
+    validationFeaturesInfo.sType = VK_STRUCTURE_TYPE_VALIDATION_FEATURES_EXT;
+    validationFeaturesInfo.enabledValidationFeatureCount = 1;
+    validationFeaturesInfo.pEnabledValidationFeatures = enabledValidation;
+    if (validationFeatures) {
+        extensions.push_back(VK_EXT_VALIDATION_FEATURES_EXTENSION_NAME);
+        LOGI("  - %s (synchronization validation)", VK_EXT_VALIDATION_FEATURES_EXTENSION_NAME);
+    }
     // Instance create info
     VkInstanceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    createInfo.pNext = validationFeatures ? &validationFeaturesInfo : nullptr;
     createInfo.pApplicationInfo = &appInfo;
     createInfo.enabledLayerCount = static_cast<uint32_t>(layers.size());
     createInfo.ppEnabledLayerNames = layers.data();
@@ -193,6 +218,13 @@ std::vector<const char*> VkContext::getRequiredDeviceExtensions() {
     };
 }
 
+std::vector<const char*> VkContext::getOptionalDeviceExtensions() {
+    return {
+            VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME,
+            VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME
+    };
+}
+
 bool VkContext::pickPhysicalDevice() {
     uint32_t deviceCount = 0;
     vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
@@ -232,8 +264,43 @@ bool VkContext::pickPhysicalDevice() {
 bool VkContext::isDeviceSuitable(VkPhysicalDevice dev) {
     QueueFamilyIndices indices = findQueueFamilies(dev);
     bool extensionsSupported = checkDeviceExtensionSupport(dev);
+    bool timelineSupported = checkTimelineSemaphoreSupport(dev);
 
-    return indices.isComplete() && extensionsSupported;
+    return indices.isComplete() && extensionsSupported && timelineSupported;
+}
+
+bool VkContext::checkTimelineSemaphoreSupport(VkPhysicalDevice dev) {
+    // Core in 1.2; VK_KHR_timeline_semaphore on 1.1 drivers. FrameSync is built on it.
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(dev, &deviceProperties);
+    if (deviceProperties.apiVersion < VK_API_VERSION_1_1) {
+        LOGE("Timeline semaphores need Vulkan 1.1 or later");
+        return false;
+    }
+    if (deviceProperties.apiVersion < VK_API_VERSION_1_2) {
+        uint32_t count = 0;
+        vkEnumerateDeviceExtensionProperties(dev, nullptr, &count, nullptr);
+        std::vector<VkExtensionProperties> available(count);
+        vkEnumerateDeviceExtensionProperties(dev, nullptr, &count, available.data());
+        const bool hasExtension = std::any_of(available.begin(), available.end(), [](const VkExtensionProperties& e) {
+            return strcmp(e.extensionName, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) == 0;
+        });
+        if (!hasExtension) {
+            LOGE("Missing required device extension: %s", VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+            return false;
+        }
+    }
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    VkPhysicalDeviceFeatures2 features2{};
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features2.pNext = &timelineFeatures;
+    vkGetPhysicalDeviceFeatures2(dev, &features2);
+    if (!timelineFeatures.timelineSemaphore) {
+        LOGE("Device does not support timeline semaphores");
+        return false;
+    }
+    return true;
 }
 
 QueueFamilyIndices VkContext::findQueueFamilies(VkPhysicalDevice dev) {
@@ -415,6 +482,113 @@ bool VkContext::createLogicalDevice() {
     VkPhysicalDeviceFeatures deviceFeatures{};
     auto extensions = getRequiredDeviceExtensions();
 
+    // Enable whichever optional extensions this device has
+    uint32_t availableCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &availableCount, nullptr);
+    std::vector<VkExtensionProperties> available(availableCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &availableCount, available.data());
+    auto hasExtension = [&](const char* name) {
+        return std::any_of(available.begin(), available.end(), [&](const VkExtensionProperties& e) {
+            return strcmp(e.extensionName, name) == 0;
+        });
+    };
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+    const bool vulkan13 = deviceProperties.apiVersion >= VK_API_VERSION_1_3;
+
+    // Optional features, chained into the create info when present
+    VkPhysicalDeviceHostImageCopyFeaturesEXT hostImageCopyFeatures{};
+    hostImageCopyFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT;
+    VkPhysicalDeviceSamplerYcbcrConversionFeatures ycbcrFeatures{};
+    ycbcrFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SAMPLER_YCBCR_CONVERSION_FEATURES;
+    VkPhysicalDeviceSynchronization2Features sync2Features{};
+    sync2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES;
+    void* featureChain = nullptr;
+    auto chainFeature = [&](auto& features) {
+        features.pNext = featureChain;
+        featureChain = &features;
+    };
+    // Queries one feature struct on its own, so the chain only holds what we enable
+    auto queryFeature = [&](auto& features) {
+        VkPhysicalDeviceFeatures2 features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &features;
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+        features.pNext = nullptr;
+    };
+
+    // Required (isDeviceSuitable checked it): FrameSync's GPU timeline
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    timelineFeatures.timelineSemaphore = VK_TRUE;
+    chainFeature(timelineFeatures);
+    if (deviceProperties.apiVersion < VK_API_VERSION_1_2) {
+        extensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+    }
+
+    capabilities = {};
+    if (deviceProperties.apiVersion >= VK_API_VERSION_1_1) {
+        queryFeature(ycbcrFeatures);
+        if (ycbcrFeatures.samplerYcbcrConversion) {
+            chainFeature(ycbcrFeatures);
+            capabilities.samplerYcbcrConversion = true;
+        }
+    }
+    // BarrierBatch merges into vkCmdPipelineBarrier without it
+    const bool sync2Extension = !vulkan13 && hasExtension(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+    if (vulkan13 || sync2Extension) {
+        queryFeature(sync2Features);
+        if (sync2Features.synchronization2) {
+            chainFeature(sync2Features);
+            capabilities.synchronization2 = true;
+            if (sync2Extension) {
+                extensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+            }
+        }
+    }
+    for (const char* optional : getOptionalDeviceExtensions()) {
+        if (!hasExtension(optional)) {
+            continue;
+        }
+        if (strcmp(optional, VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME) == 0) {
+            // Needs copy_commands2/format_feature_flags2, which are core in 1.3
+            if (!vulkan13) {
+                continue;
+            }
+            queryFeature(hostImageCopyFeatures);
+            if (!hostImageCopyFeatures.hostImageCopy) {
+                continue;
+            }
+            chainFeature(hostImageCopyFeatures);
+            capabilities.hostImageCopy = true;
+
+            // Which layouts host copies may write: prefer copying straight into the sampled layout
+            VkPhysicalDeviceHostImageCopyPropertiesEXT copyProps{};
+            copyProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_PROPERTIES_EXT;
+            VkPhysicalDeviceProperties2 props2{};
+            props2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+            props2.pNext = &copyProps;
+            vkGetPhysicalDeviceProperties2(physicalDevice, &props2);
+            std::vector<VkImageLayout> dstLayouts(copyProps.copyDstLayoutCount);
+            copyProps.pCopyDstLayouts = dstLayouts.data();
+            vkGetPhysicalDeviceProperties2(physicalDevice, &props2);
+            capabilities.hostImageCopyToShaderReadOnly =
+                    std::find(dstLayouts.begin(), dstLayouts.end(),
+                              VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) != dstLayouts.end();
+        }
+        extensions.push_back(optional);
+    }
+    if (hasExtension(VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME)) {
+        VkPhysicalDeviceExternalMemoryHostPropertiesEXT hostProps{};
+        hostProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT;
+        VkPhysicalDeviceProperties2 props2{};
+        props2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        props2.pNext = &hostProps;
+        vkGetPhysicalDeviceProperties2(physicalDevice, &props2);
+        capabilities.externalMemoryHost = true;
+        capabilities.minImportedHostPointerAlignment = hostProps.minImportedHostPointerAlignment;
+    }
+
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
@@ -422,6 +596,7 @@ bool VkContext::createLogicalDevice() {
     createInfo.pEnabledFeatures = &deviceFeatures;
     createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
     createInfo.ppEnabledExtensionNames = extensions.data();
+    createInfo.pNext = featureChain;
 
     VkResult result = vkCreateDevice(physicalDevice, &createInfo, nullptr, &device);
     if (result != VK_SUCCESS) {
@@ -429,6 +604,8 @@ bool VkContext::createLogicalDevice() {
         return false;
     }
 
+    BarrierBatch::Initialize(device, capabilities.synchronization2);
+
     // Get queues
     vkGetDeviceQueue(device, indices.graphicsFamily.value(),
                      indices.graphicsQueueIndex, &graphicsQueue);
@@ -457,6 +634,15 @@ bool VkContext::createLogicalDevice() {
     LOGI("Capabilities:");
     LOGI("  Async Compute : %s", asyncCompute ? "YES" : "NO");
     LOGI("  Async Transfer: %s", asyncTransfer ? "YES" : "NO");
+    LOGI("  Host Memory Import: %s (alignment %llu)",
+         capabilities.externalMemoryHost ? "YES" : "NO",
+         (unsigned long long)capabilities.minImportedHostPointerAlignment);
+    LOGI("  Host Image Copy  : %s%s", capabilities.hostImageCopy ? "YES" : "NO",
+         capabilities.hostImageCopyToShaderReadOnly ? " (to SHADER_READ_ONLY)" : "");
+    LOGI("  YCbCr Sampling   : %s", capabilities.samplerYcbcrConversion ? "YES" : "NO");
+    LOGI("  Synchronization2 : %s", capabilities.synchronization2 ? "YES" : "NO");
+    LOGI("  Timeline Semaphores: YES (%s)",
+         deviceProperties.apiVersion >= VK_API_VERSION_1_2 ? "core" : VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
     LOGI("========================================");
 
     queueFamilies = indices;
@@ -15,6 +15,24 @@ namespace graphics {
         std::vector<VkPresentModeKHR> presentModes;
     };
 
+    /**
+     * Optional device extensions/features. Probed when the logical device is
+     * created and enabled if present; code that can use them checks these
+     * flags and keeps a fallback path.
+     */
+    struct DeviceCapabilities {
+        // VK_EXT_external_memory_host: import host pointers as VkDeviceMemory
+        bool externalMemoryHost = false;
+        VkDeviceSize minImportedHostPointerAlignment = 0;
+        // VK_EXT_host_image_copy: CPU copies straight into optimal-tiled images
+        bool hostImageCopy = false;
+        bool hostImageCopyToShaderReadOnly = false;  // else copy/sample in GENERAL
+        // samplerYcbcrConversion feature (core in 1.1): multi-planar YUV sampling
+        bool samplerYcbcrConversion = false;
+        // synchronization2 (core in 1.3, else VK_KHR_synchronization2): vkCmdPipelineBarrier2
+        bool synchronization2 = false;
+    };
+
     class VkContext {
     public:
         VkContext();
@@ -34,6 +52,7 @@ namespace graphics {
         QueueFamilyIndices getQueueFamilies() const { return queueFamilies; }
         VkSurfaceKHR getSurface() const { return surface; }
         VmaAllocator GetAllocator() const { return allocator; }
+        const DeviceCapabilities& GetCapabilities() const { return capabilities; }
 
         // Swapchain accessors
         VkSwapchainKHR GetSwapchain() const { return swapchain; }
@@ -63,6 +82,7 @@ namespace graphics {
         VkQueue computeQueue = VK_NULL_HANDLE;
         VkQueue transferQueue = VK_NULL_HANDLE;
         QueueFamilyIndices queueFamilies;
+        DeviceCapabilities capabilities;
 
         // Swapchain
         VkSwapchainKHR swapchain = VK_NULL_HANDLE;
@@ -79,10 +99,12 @@ namespace graphics {
         std::vector<const char*> getRequiredExtensions();
         std::vector<const char*> getRequiredLayers();
         std::vector<const char*> getRequiredDeviceExtensions();
+        std::vector<const char*> getOptionalDeviceExtensions();
         bool checkValidationLayerSupport();
         bool isDeviceSuitable(VkPhysicalDevice device);
         QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
         bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+        bool checkTimelineSemaphoreSupport(VkPhysicalDevice device);
         bool setupDebugMessenger();
         void destroyDebugMessenger();
 
@@ -0,0 +1,811 @@
+#include "yuv_convert.h"
+#include <cstring>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+using namespace utils;
+
+namespace {
+    // ============================================================
+    // Scalar reference
+    // ============================================================
+
+    void InterleaveScalar(uint8_t* dst, const uint8_t* u, const uint8_t* v, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            dst[2 * i]     = u[i];
+            dst[2 * i + 1] = v[i];
+        }
+    }
+
+    void SwapPairsScalar(uint8_t* dst, const uint8_t* vu, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            const uint8_t cr = vu[2 * i];
+            dst[2 * i]     = vu[2 * i + 1];
+            dst[2 * i + 1] = cr;
+        }
+    }
+
+    void DownsampleLumaScalar(uint8_t* dst, const uint8_t* row0, const uint8_t* row1, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            dst[i] = static_cast<uint8_t>((row0[2 * i] + row0[2 * i + 1] +
+                                           row1[2 * i] + row1[2 * i + 1] + 2) >> 2);
+        }
+    }
+
+    void DownsampleChromaScalar(uint8_t* dst, const uint8_t* row0, const uint8_t* row1, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t c = 0; c < 2; ++c) {
+                dst[2 * i + c] = static_cast<uint8_t>((row0[4 * i + c] + row0[4 * i + 2 + c] +
+                                                       row1[4 * i + c] + row1[4 * i + 2 + c] + 2) >> 2);
+            }
+        }
+    }
+
+    void BinomialColumnsScalar(uint16_t* dst, const uint8_t* r0, const uint8_t* r1,
+                               const uint8_t* r2, const uint8_t* r3, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            dst[i] = static_cast<uint16_t>(r0[i] + 3 * (r1[i] + r2[i]) + r3[i]);
+        }
+    }
+
+    void BinomialRowScalar(uint8_t* dst, const uint16_t* src, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            const uint32_t sum = src[2 * i - 1] + 3u * (src[2 * i] + src[2 * i + 1]) + src[2 * i + 2];
+            dst[i] = static_cast<uint8_t>((sum + 32) >> 6);
+        }
+    }
+
+    inline uint8_t ClampShifted(int32_t sum) {
+        const int32_t value = sum >> 13;   // arithmetic: rounds towards -inf like the SIMD shifts
+        return static_cast<uint8_t>(value < 0 ? 0 : value > 255 ? 255 : value);
+    }
+
+    inline void YuvPixelScalar(uint8_t* dst, uint8_t y, uint8_t cb, uint8_t cr,
+                               const YuvToRgbCoefficients& c) {
+        const int32_t luma = c.yScale * (y - c.yOffset) + 4096;
+        for (int ch = 0; ch < 3; ++ch) {
+            dst[ch] = ClampShifted(luma + c.u[ch] * (cb - 128) + c.v[ch] * (cr - 128));
+        }
+        dst[3] = 255;
+    }
+
+    void Yuv420ToRgbaScalar(uint8_t* dst, const uint8_t* y, const uint8_t* uv, size_t n,
+                            const YuvToRgbCoefficients& c) {
+        for (size_t i = 0; i < n; ++i) {
+            YuvPixelScalar(dst + 4 * i, y[i], uv[i & ~size_t(1)], uv[i | 1], c);
+        }
+    }
+
+    void Yuv444ToRgbaScalar(uint8_t* dst, const uint8_t* y, const uint8_t* uv, size_t n,
+                            const YuvToRgbCoefficients& c) {
+        for (size_t i = 0; i < n; ++i) {
+            YuvPixelScalar(dst + 4 * i, y[i], uv[2 * i], uv[2 * i + 1], c);
+        }
+    }
+
+    void RgbaToRgbScalar(uint8_t* dst, const uint8_t* src, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            dst[3 * i]     = src[4 * i];
+            dst[3 * i + 1] = src[4 * i + 1];
+            dst[3 * i + 2] = src[4 * i + 2];
+        }
+    }
+
+    const YuvRowKernels SCALAR{"scalar", InterleaveScalar, SwapPairsScalar,
+                               DownsampleLumaScalar, DownsampleChromaScalar,
+                               BinomialColumnsScalar, BinomialRowScalar,
+                               Yuv420ToRgbaScalar, Yuv444ToRgbaScalar, RgbaToRgbScalar};
+
+    // ============================================================
+    // NEON (arm64, always present)
+    // ============================================================
+#if defined(__ARM_NEON)
+    void InterleaveNeon(uint8_t* dst, const uint8_t* u, const uint8_t* v, size_t n) {
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            uint8x16x2_t uv;
+            uv.val[0] = vld1q_u8(u + i);
+            uv.val[1] = vld1q_u8(v + i);
+            vst2q_u8(dst + 2 * i, uv);
+        }
+        InterleaveScalar(dst + 2 * i, u + i, v + i, n - i);
+    }
+
+    void SwapPairsNeon(uint8_t* dst, const uint8_t* vu, size_t n) {
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const uint8x16_t a = vld1q_u8(vu + 2 * i);
+            const uint8x16_t b = vld1q_u8(vu + 2 * i + 16);
+            vst1q_u8(dst + 2 * i,      vrev16q_u8(a));
+            vst1q_u8(dst + 2 * i + 16, vrev16q_u8(b));
+        }
+        SwapPairsScalar(dst + 2 * i, vu + 2 * i, n - i);
+    }
+
+    void DownsampleLumaNeon(uint8_t* dst, const uint8_t* row0, const uint8_t* row1, size_t n) {
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            // Pairwise widening adds of both rows, then a rounding narrow by 4
+            uint16x8_t lo = vpaddlq_u8(vld1q_u8(row0 + 2 * i));
+            uint16x8_t hi = vpaddlq_u8(vld1q_u8(row0 + 2 * i + 16));
+            lo = vpadalq_u8(lo, vld1q_u8(row1 + 2 * i));
+            hi = vpadalq_u8(hi, vld1q_u8(row1 + 2 * i + 16));
+            vst1q_u8(dst + i, vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2)));
+        }
+        DownsampleLumaScalar(dst + i, row0 + 2 * i, row1 + 2 * i, n - i);
+    }
+
+    void DownsampleChromaNeon(uint8_t* dst, const uint8_t* row0, const uint8_t* row1, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            // De-interleave Cb and Cr, then the same as luma on each
+            const uint8x16x2_t a = vld2q_u8(row0 + 4 * i);
+            const uint8x16x2_t b = vld2q_u8(row1 + 4 * i);
+            const uint16x8_t cb = vpadalq_u8(vpaddlq_u8(a.val[0]), b.val[0]);
+            const uint16x8_t cr = vpadalq_u8(vpaddlq_u8(a.val[1]), b.val[1]);
+            uint8x8x2_t out;
+            out.val[0] = vrshrn_n_u16(cb, 2);
+            out.val[1] = vrshrn_n_u16(cr, 2);
+            vst2_u8(dst + 2 * i, out);
+        }
+        DownsampleChromaScalar(dst + 2 * i, row0 + 4 * i, row1 + 4 * i, n - i);
+    }
+
+    void BinomialColumnsNeon(uint16_t* dst, const uint8_t* r0, const uint8_t* r1,
+                             const uint8_t* r2, const uint8_t* r3, size_t n) {
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const uint8x16_t a = vld1q_u8(r0 + i), b = vld1q_u8(r1 + i);
+            const uint8x16_t c = vld1q_u8(r2 + i), d = vld1q_u8(r3 + i);
+            const uint16x8_t lo = vmlaq_n_u16(vaddl_u8(vget_low_u8(a), vget_low_u8(d)),
+                                              vaddl_u8(vget_low_u8(b), vget_low_u8(c)), 3);
+            const uint16x8_t hi = vmlaq_n_u16(vaddl_high_u8(a, d), vaddl_high_u8(b, c), 3);
+            vst1q_u16(dst + i,     lo);
+            vst1q_u16(dst + i + 8, hi);
+        }
+        BinomialColumnsScalar(dst + i, r0 + i, r1 + i, r2 + i, r3 + i, n - i);
+    }
+
+    void BinomialRowNeon(uint8_t* dst, const uint16_t* src, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            // De-interleaving loads at three offsets line up src[2i-1], src[2i], src[2i+1], src[2i+2]
+            const uint16x8x2_t mid   = vld2q_u16(src + 2 * i);       // 2i, 2i+1
+            const uint16x8x2_t left  = vld2q_u16(src + 2 * i - 1);   // 2i-1
+            const uint16x8x2_t right = vld2q_u16(src + 2 * i + 1);   // 2i+2 in val[1]
+            const uint16x8_t sum = vmlaq_n_u16(vaddq_u16(left.val[0], right.val[1]),
+                                               vaddq_u16(mid.val[0], mid.val[1]), 3);
+            vst1_u8(dst + i, vrshrn_n_u16(sum, 6));
+        }
+        BinomialRowScalar(dst + i, src + 2 * i, n - i);
+    }
+
+    /// One output channel of 8 pixels: luma terms plus the chroma terms, shifted and clamped to u8.
+    inline uint8x8_t RgbChannelNeon(int32x4_t lumaLo, int32x4_t lumaHi, int32x4_t chromaLo, int32x4_t chromaHi) {
+        // vqshrn: arithmetic shift (like the scalar >> 13) with saturation to s16
+        const int16x8_t sum = vcombine_s16(vqshrn_n_s32(vaddq_s32(lumaLo, chromaLo), 13),
+                                           vqshrn_n_s32(vaddq_s32(lumaHi, chromaHi), 13));
+        return vqmovun_s16(sum);
+    }
+
+    /// u[c] * Cb' + v[c] * Cr' of 4 pixels
+    inline int32x4_t ChromaTermNeon(int16x4_t cb, int16x4_t cr, const YuvToRgbCoefficients& c, int ch) {
+        return vmlal_n_s16(vmull_n_s16(cb, c.u[ch]), cr, c.v[ch]);
+    }
+
+    /// yScale * (Y - yOffset) + 4096 of 16 pixels, as 4 x 4 i32 lanes
+    inline void LumaTermsNeon(uint8x16_t y, const YuvToRgbCoefficients& c, int32x4_t out[4]) {
+        const uint8x16_t offset = vdupq_n_u8(static_cast<uint8_t>(c.yOffset));
+        // The u16 wrap-around of Y < yOffset reads back as the right negative s16
+        const int16x8_t lo = vreinterpretq_s16_u16(vsubl_u8(vget_low_u8(y), vget_low_u8(offset)));
+        const int16x8_t hi = vreinterpretq_s16_u16(vsubl_high_u8(y, offset));
+        const int32x4_t round = vdupq_n_s32(4096);
+        out[0] = vmlal_n_s16(round, vget_low_s16(lo),  c.yScale);
+        out[1] = vmlal_n_s16(round, vget_high_s16(lo), c.yScale);
+        out[2] = vmlal_n_s16(round, vget_low_s16(hi),  c.yScale);
+        out[3] = vmlal_n_s16(round, vget_high_s16(hi), c.yScale);
+    }
+
+    inline int16x8_t CenteredChromaNeon(uint8x8_t x) {
+        return vreinterpretq_s16_u16(vsubl_u8(x, vdup_n_u8(128)));
+    }
+
+    void Yuv420ToRgbaNeon(uint8_t* dst, const uint8_t* y, const uint8_t* uv, size_t n,
+                          const YuvToRgbCoefficients& c) {
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            int32x4_t luma[4];
+            LumaTermsNeon(vld1q_u8(y + i), c, luma);
+            // 8 CbCr pairs; the chroma terms are worked out per pair, then doubled up
+            const uint8x8x2_t pairs = vld2_u8(uv + i);
+            const int16x8_t cb = CenteredChromaNeon(pairs.val[0]);
+            const int16x8_t cr = CenteredChromaNeon(pairs.val[1]);
+            uint8x16x4_t out;
+            for (int ch = 0; ch < 3; ++ch) {
+                const int32x4_t lo = ChromaTermNeon(vget_low_s16(cb),  vget_low_s16(cr),  c, ch);
+                const int32x4_t hi = ChromaTermNeon(vget_high_s16(cb), vget_high_s16(cr), c, ch);
+                out.val[ch] = vcombine_u8(RgbChannelNeon(luma[0], luma[1], vzip1q_s32(lo, lo), vzip2q_s32(lo, lo)),
+                                          RgbChannelNeon(luma[2], luma[3], vzip1q_s32(hi, hi), vzip2q_s32(hi, hi)));
+            }
+            out.val[3] = vdupq_n_u8(255);
+            vst4q_u8(dst + 4 * i, out);
+        }
+        Yuv420ToRgbaScalar(dst + 4 * i, y + i, uv + i, n - i, c);
+    }
+
+    void Yuv444ToRgbaNeon(uint8_t* dst, const uint8_t* y, const uint8_t* uv, size_t n,
+                          const YuvToRgbCoefficients& c) {
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            int32x4_t luma[4];
+            LumaTermsNeon(vld1q_u8(y + i), c, luma);
+            const uint8x16x2_t pairs = vld2q_u8(uv + 2 * i);
+            const int16x8_t cbLo = CenteredChromaNeon(vget_low_u8(pairs.val[0]));
+            const int16x8_t cbHi = CenteredChromaNeon(vget_high_u8(pairs.val[0]));
+            const int16x8_t crLo = CenteredChromaNeon(vget_low_u8(pairs.val[1]));
+            const int16x8_t crHi = CenteredChromaNeon(vget_high_u8(pairs.val[1]));
+            uint8x16x4_t out;
+            for (int ch = 0; ch < 3; ++ch) {
+                out.val[ch] = vcombine_u8(
+                        RgbChannelNeon(luma[0], luma[1],
+                                       ChromaTermNeon(vget_low_s16(cbLo),  vget_low_s16(crLo),  c, ch),
+                                       ChromaTermNeon(vget_high_s16(cbLo), vget_high_s16(crLo), c, ch)),
+                        RgbChannelNeon(luma[2], luma[3],
+                                       ChromaTermNeon(vget_low_s16(cbHi),  vget_low_s16(crHi),  c, ch),
+                                       ChromaTermNeon(vget_high_s16(cbHi), vget_high_s16(crHi), c, ch)));
+            }
+            out.val[3] = vdupq_n_u8(255);
+            vst4q_u8(dst + 4 * i, out);
+        }
+        Yuv444ToRgbaScalar(dst + 4 * i, y + i, uv + 2 * i, n - i, c);
+    }
+
+    void RgbaToRgbNeon(uint8_t* dst, const uint8_t* src, size_t n) {
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const uint8x16x4_t rgba = vld4q_u8(src + 4 * i);
+            uint8x16x3_t rgb;
+            rgb.val[0] = rgba.val[0];
+            rgb.val[1] = rgba.val[1];
+            rgb.val[2] = rgba.val[2];
+            vst3q_u8(dst + 3 * i, rgb);
+        }
+        RgbaToRgbScalar(dst + 3 * i, src + 4 * i, n - i);
+    }
+
+    const YuvRowKernels NEON{"neon", InterleaveNeon, SwapPairsNeon,
+                             DownsampleLumaNeon, DownsampleChromaNeon,
+                             BinomialColumnsNeon, BinomialRowNeon,
+                             Yuv420ToRgbaNeon, Yuv444ToRgbaNeon, RgbaToRgbNeon};
+#endif
+
+    // ============================================================
+    // SSE2 (x86-64 baseline) and AVX2 (runtime detected)
+    // ============================================================
+#if defined(__x86_64__) || defined(__i386__)
+    void InterleaveSse2(uint8_t* dst, const uint8_t* u, const uint8_t* v, size_t n) {
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(u + i));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i),      _mm_unpacklo_epi8(a, b));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i + 16), _mm_unpackhi_epi8(a, b));
+        }
+        InterleaveScalar(dst + 2 * i, u + i, v + i, n - i);
+    }
+
+    void SwapPairsSse2(uint8_t* dst, const uint8_t* vu, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            // Byte swap inside each 16-bit lane
+            const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(vu + 2 * i));
+            const __m128i y = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i), y);
+        }
+        SwapPairsScalar(dst + 2 * i, vu + 2 * i, n - i);
+    }
+
+    /// Sum of each horizontal byte pair of two rows, as 8 u16 lanes.
+    inline __m128i PairSumsSse2(const uint8_t* row0, const uint8_t* row1) {
+        const __m128i mask = _mm_set1_epi16(0x00FF);
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1));
+        return _mm_add_epi16(_mm_add_epi16(_mm_and_si128(a, mask), _mm_srli_epi16(a, 8)),
+                             _mm_add_epi16(_mm_and_si128(b, mask), _mm_srli_epi16(b, 8)));
+    }
+
+    void DownsampleLumaSse2(uint8_t* dst, const uint8_t* row0, const uint8_t* row1, size_t n) {
+        const __m128i two = _mm_set1_epi16(2);
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const __m128i lo = _mm_srli_epi16(_mm_add_epi16(PairSumsSse2(row0 + 2 * i, row1 + 2 * i), two), 2);
+            const __m128i hi = _mm_srli_epi16(_mm_add_epi16(PairSumsSse2(row0 + 2 * i + 16, row1 + 2 * i + 16), two), 2);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+        }
+        DownsampleLumaScalar(dst + i, row0 + 2 * i, row1 + 2 * i, n - i);
+    }
+
+    /// Cb and Cr sums of 4 output pairs (16 input bytes of each row), as 4 i32 lanes each.
+    inline void ChromaSumsSse2(const uint8_t* row0, const uint8_t* row1, __m128i& cb, __m128i& cr) {
+        const __m128i mask = _mm_set1_epi16(0x00FF);
+        const __m128i ones = _mm_set1_epi16(1);
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1));
+        // u16 lanes of Cb (low bytes) / Cr (high bytes), both rows summed
+        const __m128i cb16 = _mm_add_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask));
+        const __m128i cr16 = _mm_add_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+        // Adjacent lanes are horizontally neighbouring samples
+        cb = _mm_madd_epi16(cb16, ones);
+        cr = _mm_madd_epi16(cr16, ones);
+    }
+
+    void DownsampleChromaSse2(uint8_t* dst, const uint8_t* row0, const uint8_t* row1, size_t n) {
+        const __m128i two = _mm_set1_epi32(2);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m128i cbA, crA, cbB, crB;
+            ChromaSumsSse2(row0 + 4 * i,      row1 + 4 * i,      cbA, crA);
+            ChromaSumsSse2(row0 + 4 * i + 16, row1 + 4 * i + 16, cbB, crB);
+            const __m128i cb = _mm_packs_epi32(_mm_srli_epi32(_mm_add_epi32(cbA, two), 2),
+                                               _mm_srli_epi32(_mm_add_epi32(cbB, two), 2));
+            const __m128i cr = _mm_packs_epi32(_mm_srli_epi32(_mm_add_epi32(crA, two), 2),
+                                               _mm_srli_epi32(_mm_add_epi32(crB, two), 2));
+            // Little endian u16 lanes of Cb | Cr << 8 are the interleaved pairs
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i), _mm_or_si128(cb, _mm_slli_epi16(cr, 8)));
+        }
+        DownsampleChromaScalar(dst + 2 * i, row0 + 4 * i, row1 + 4 * i, n - i);
+    }
+
+    void BinomialColumnsSse2(uint16_t* dst, const uint8_t* r0, const uint8_t* r1,
+                             const uint8_t* r2, const uint8_t* r3, size_t n) {
+        const __m128i zero = _mm_setzero_si128();
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r0 + i));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + i));
+            const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r2 + i));
+            const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r3 + i));
+            const __m128i outerLo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(d, zero));
+            const __m128i outerHi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(d, zero));
+            const __m128i innerLo = _mm_add_epi16(_mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(c, zero));
+            const __m128i innerHi = _mm_add_epi16(_mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(c, zero));
+            // 3x = x + 2x
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                             _mm_add_epi16(outerLo, _mm_add_epi16(innerLo, _mm_slli_epi16(innerLo, 1))));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8),
+                             _mm_add_epi16(outerHi, _mm_add_epi16(innerHi, _mm_slli_epi16(innerHi, 1))));
+        }
+        BinomialColumnsScalar(dst + i, r0 + i, r1 + i, r2 + i, r3 + i, n - i);
+    }
+
+    /// 4 outputs as i32 lanes: madd pairs (src[2i-1], src[2i]) by (1, 3) and (src[2i+1], src[2i+2]) by (3, 1).
+    /// Column sums are at most 8 * 255, so the signed 16-bit multiply is exact.
+    inline __m128i BinomialQuadSse2(const uint16_t* src) {
+        const __m128i left  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src - 1));
+        const __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 1));
+        return _mm_add_epi32(_mm_madd_epi16(left,  _mm_set1_epi32(0x00030001)),
+                             _mm_madd_epi16(right, _mm_set1_epi32(0x00010003)));
+    }
+
+    void BinomialRowSse2(uint8_t* dst, const uint16_t* src, size_t n) {
+        const __m128i round = _mm_set1_epi32(32);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            const __m128i lo = _mm_srli_epi32(_mm_add_epi32(BinomialQuadSse2(src + 2 * i), round), 6);
+            const __m128i hi = _mm_srli_epi32(_mm_add_epi32(BinomialQuadSse2(src + 2 * i + 8), round), 6);
+            const __m128i words = _mm_packs_epi32(lo, hi);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(words, words));
+        }
+        BinomialRowScalar(dst + i, src + 2 * i, n - i);
+    }
+
+    /// The coefficient table as madd operands: (Y', 1) pairs by (yScale, 4096) and
+    /// (Cb', Cr') pairs by (u[c], v[c]), one i32 lane per pixel.
+    struct RgbCoefficientsSse2 {
+        __m128i luma;
+        __m128i chroma[3];
+        __m128i yOffset;
+
+        explicit RgbCoefficientsSse2(const YuvToRgbCoefficients& c)
+            : luma(_mm_set1_epi32(static_cast<int32_t>(4096u << 16 | static_cast<uint16_t>(c.yScale)))),
+              yOffset(_mm_set1_epi16(c.yOffset)) {
+            for (int ch = 0; ch < 3; ++ch) {
+                chroma[ch] = _mm_set1_epi32(static_cast<int32_t>(static_cast<uint32_t>(static_cast<uint16_t>(c.v[ch])) << 16 |
+                                                                 static_cast<uint16_t>(c.u[ch])));
+            }
+        }
+    };
+
+    /// Channel ch of 4 pixels as i32 lanes: yPairs holds (Y', 1), cbcr the pixels' (Cb', Cr')
+    inline __m128i RgbQuadSse2(__m128i yPairs, __m128i cbcr, const RgbCoefficientsSse2& k, int ch) {
+        return _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yPairs, k.luma),
+                                            _mm_madd_epi16(cbcr, k.chroma[ch])), 13);
+    }
+
+    /**
+     * Writes 16 RGBA pixels. y holds the 16 luma bytes; cbcr[q] the (Cb', Cr')
+     * s16 pairs of pixels 4q .. 4q + 3, one per i32 lane.
+     */
+    inline void Rgba16Sse2(uint8_t* dst, __m128i y, const __m128i cbcr[4], const RgbCoefficientsSse2& k) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i ones = _mm_set1_epi16(1);
+        const __m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(y, zero), k.yOffset);
+        const __m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(y, zero), k.yOffset);
+        const __m128i yPairs[4] = {_mm_unpacklo_epi16(lo, ones), _mm_unpackhi_epi16(lo, ones),
+                                   _mm_unpacklo_epi16(hi, ones), _mm_unpackhi_epi16(hi, ones)};
+        __m128i channel[3];
+        for (int ch = 0; ch < 3; ++ch) {
+            // packs then packus: saturate to s16, then clamp to 0..255 like the scalar kernel
+            const __m128i a = _mm_packs_epi32(RgbQuadSse2(yPairs[0], cbcr[0], k, ch), RgbQuadSse2(yPairs[1], cbcr[1], k, ch));
+            const __m128i b = _mm_packs_epi32(RgbQuadSse2(yPairs[2], cbcr[2], k, ch), RgbQuadSse2(yPairs[3], cbcr[3], k, ch));
+            channel[ch] = _mm_packus_epi16(a, b);
+        }
+        const __m128i alpha = _mm_set1_epi8(static_cast<char>(0xFF));
+        const __m128i c01Lo = _mm_unpacklo_epi8(channel[0], channel[1]);
+        const __m128i c01Hi = _mm_unpackhi_epi8(channel[0], channel[1]);
+        const __m128i c2aLo = _mm_unpacklo_epi8(channel[2], alpha);
+        const __m128i c2aHi = _mm_unpackhi_epi8(channel[2], alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),      _mm_unpacklo_epi16(c01Lo, c2aLo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16), _mm_unpackhi_epi16(c01Lo, c2aLo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 32), _mm_unpacklo_epi16(c01Hi, c2aHi));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 48), _mm_unpackhi_epi16(c01Hi, c2aHi));
+    }
+
+    /// 8 CbCr pairs as s16 lanes, minus 128
+    inline void CenteredChromaSse2(const uint8_t* uv, __m128i& lo, __m128i& hi) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(uv));
+        const __m128i bias = _mm_set1_epi16(128);
+        lo = _mm_sub_epi16(_mm_unpacklo_epi8(x, _mm_setzero_si128()), bias);
+        hi = _mm_sub_epi16(_mm_unpackhi_epi8(x, _mm_setzero_si128()), bias);
+    }
+
+    void Yuv420ToRgbaSse2(uint8_t* dst, const uint8_t* y, const uint8_t* uv, size_t n,
+                          const YuvToRgbCoefficients& c) {
+        const RgbCoefficientsSse2 k(c);
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            __m128i lo, hi;
+            CenteredChromaSse2(uv + i, lo, hi);
+            // A (Cb', Cr') pair is one i32 lane: doubling each lane gives every pixel its pair
+            const __m128i cbcr[4] = {_mm_unpacklo_epi32(lo, lo), _mm_unpackhi_epi32(lo, lo),
+                                     _mm_unpacklo_epi32(hi, hi), _mm_unpackhi_epi32(hi, hi)};
+            Rgba16Sse2(dst + 4 * i, _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i)), cbcr, k);
+        }
+        Yuv420ToRgbaScalar(dst + 4 * i, y + i, uv + i, n - i, c);
+    }
+
+    void Yuv444ToRgbaSse2(uint8_t* dst, const uint8_t* y, const uint8_t* uv, size_t n,
+                          const YuvToRgbCoefficients& c) {
+        const RgbCoefficientsSse2 k(c);
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            __m128i cbcr[4];
+            CenteredChromaSse2(uv + 2 * i,      cbcr[0], cbcr[1]);
+            CenteredChromaSse2(uv + 2 * i + 16, cbcr[2], cbcr[3]);
+            Rgba16Sse2(dst + 4 * i, _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i)), cbcr, k);
+        }
+        Yuv444ToRgbaScalar(dst + 4 * i, y + i, uv + 2 * i, n - i, c);
+    }
+
+    const YuvRowKernels SSE2{"sse2", InterleaveSse2, SwapPairsSse2,
+                             DownsampleLumaSse2, DownsampleChromaSse2,
+                             BinomialColumnsSse2, BinomialRowSse2,
+                             Yuv420ToRgbaSse2, Yuv444ToRgbaSse2,
+                             RgbaToRgbScalar};   // no byte shuffle before SSSE3
+
+    __attribute__((target("avx2")))
+    void InterleaveAvx2(uint8_t* dst, const uint8_t* u, const uint8_t* v, size_t n) {
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(u + i));
+            const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i));
+            // unpack works per 128-bit lane; permute puts the halves back in order
+            const __m256i lo = _mm256_unpacklo_epi8(a, b);
+            const __m256i hi = _mm256_unpackhi_epi8(a, b);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 2 * i),
+                                _mm256_permute2x128_si256(lo, hi, 0x20));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 2 * i + 32),
+                                _mm256_permute2x128_si256(lo, hi, 0x31));
+        }
+        InterleaveSse2(dst + 2 * i, u + i, v + i, n - i);
+    }
+
+    __attribute__((target("avx2")))
+    void SwapPairsAvx2(uint8_t* dst, const uint8_t* vu, size_t n) {
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(vu + 2 * i));
+            const __m256i y = _mm256_or_si256(_mm256_slli_epi16(x, 8), _mm256_srli_epi16(x, 8));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 2 * i), y);
+        }
+        SwapPairsSse2(dst + 2 * i, vu + 2 * i, n - i);
+    }
+
+    /// Rounded 2x2 averages of 32 bytes of two rows, as 16 u16 lanes.
+    __attribute__((target("avx2"), always_inline))
+    inline __m256i BoxAverageAvx2(const uint8_t* row0, const uint8_t* row1) {
+        const __m256i mask = _mm256_set1_epi16(0x00FF);
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1));
+        const __m256i s = _mm256_add_epi16(
+                _mm256_add_epi16(_mm256_and_si256(a, mask), _mm256_srli_epi16(a, 8)),
+                _mm256_add_epi16(_mm256_and_si256(b, mask), _mm256_srli_epi16(b, 8)));
+        return _mm256_srli_epi16(_mm256_add_epi16(s, _mm256_set1_epi16(2)), 2);
+    }
+
+    __attribute__((target("avx2")))
+    void DownsampleLumaAvx2(uint8_t* dst, const uint8_t* row0, const uint8_t* row1, size_t n) {
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            const __m256i lo = BoxAverageAvx2(row0 + 2 * i, row1 + 2 * i);
+            const __m256i hi = BoxAverageAvx2(row0 + 2 * i + 32, row1 + 2 * i + 32);
+            // packus works per 128-bit lane: restore the order of the 64-bit quarters
+            const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), packed);
+        }
+        DownsampleLumaSse2(dst + i, row0 + 2 * i, row1 + 2 * i, n - i);
+    }
+
+    __attribute__((target("avx2")))
+    void BinomialColumnsAvx2(uint16_t* dst, const uint8_t* r0, const uint8_t* r1,
+                             const uint8_t* r2, const uint8_t* r3, size_t n) {
+        auto load = [](const uint8_t* p) {
+            return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        };
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const __m256i outer = _mm256_add_epi16(_mm256_cvtepu8_epi16(load(r0 + i)),
+                                                   _mm256_cvtepu8_epi16(load(r3 + i)));
+            const __m256i inner = _mm256_add_epi16(_mm256_cvtepu8_epi16(load(r1 + i)),
+                                                   _mm256_cvtepu8_epi16(load(r2 + i)));
+            const __m256i sum = _mm256_add_epi16(outer, _mm256_add_epi16(inner, _mm256_slli_epi16(inner, 1)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), sum);
+        }
+        BinomialColumnsSse2(dst + i, r0 + i, r1 + i, r2 + i, r3 + i, n - i);
+    }
+
+    /// Channel ch of 8 pixels (two 128-bit lanes of 4) as i32 lanes, like RgbQuadSse2
+    __attribute__((target("avx2"), always_inline))
+    inline __m256i RgbOctAvx2(__m256i yPairs, __m256i cbcr, __m256i luma, __m256i chroma) {
+        return _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yPairs, luma),
+                                                  _mm256_madd_epi16(cbcr, chroma)), 13);
+    }
+
+    /**
+     * Writes 32 RGBA pixels. y holds the 32 luma bytes. unpack works per
+     * 128-bit lane, so pixel groups come in lane order: cbcr[0] holds the
+     * (Cb', Cr') pairs of pixels 0-3 | 8-11, cbcr[1] 4-7 | 12-15, cbcr[2] and
+     * cbcr[3] the same for pixels 16-31.
+     */
+    __attribute__((target("avx2"), always_inline))
+    inline void Rgba32Avx2(uint8_t* dst, const uint8_t* y, const __m256i cbcr[4], const YuvToRgbCoefficients& c) {
+        const __m256i ones = _mm256_set1_epi16(1);
+        const __m256i offset = _mm256_set1_epi16(c.yOffset);
+        const __m256i luma = _mm256_set1_epi32(static_cast<int32_t>(4096u << 16 | static_cast<uint16_t>(c.yScale)));
+        // Zero-extending 16 bytes keeps pixels 0-7 | 8-15 in lane order
+        const __m256i lo = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y))), offset);
+        const __m256i hi = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + 16))), offset);
+        const __m256i yPairs[4] = {_mm256_unpacklo_epi16(lo, ones), _mm256_unpackhi_epi16(lo, ones),
+                                   _mm256_unpacklo_epi16(hi, ones), _mm256_unpackhi_epi16(hi, ones)};
+        __m256i channel[3];
+        for (int ch = 0; ch < 3; ++ch) {
+            const __m256i chroma = _mm256_set1_epi32(static_cast<int32_t>(
+                    static_cast<uint32_t>(static_cast<uint16_t>(c.v[ch])) << 16 | static_cast<uint16_t>(c.u[ch])));
+            // packs puts pixels 0-7 | 8-15 back in order; packus leaves 0-7, 16-23 | 8-15, 24-31
+            const __m256i a = _mm256_packs_epi32(RgbOctAvx2(yPairs[0], cbcr[0], luma, chroma),
+                                                 RgbOctAvx2(yPairs[1], cbcr[1], luma, chroma));
+            const __m256i b = _mm256_packs_epi32(RgbOctAvx2(yPairs[2], cbcr[2], luma, chroma),
+                                                 RgbOctAvx2(yPairs[3], cbcr[3], luma, chroma));
+            channel[ch] = _mm256_packus_epi16(a, b);
+        }
+        const __m256i alpha = _mm256_set1_epi8(static_cast<char>(0xFF));
+        // Low unpacks hold pixels 0-7 | 8-15, high ones 16-23 | 24-31
+        const __m256i c01Lo = _mm256_unpacklo_epi8(channel[0], channel[1]);
+        const __m256i c01Hi = _mm256_unpackhi_epi8(channel[0], channel[1]);
+        const __m256i c2aLo = _mm256_unpacklo_epi8(channel[2], alpha);
+        const __m256i c2aHi = _mm256_unpackhi_epi8(channel[2], alpha);
+        const __m256i p0 = _mm256_unpacklo_epi16(c01Lo, c2aLo);   // 0-3   | 8-11
+        const __m256i p1 = _mm256_unpackhi_epi16(c01Lo, c2aLo);   // 4-7   | 12-15
+        const __m256i p2 = _mm256_unpacklo_epi16(c01Hi, c2aHi);   // 16-19 | 24-27
+        const __m256i p3 = _mm256_unpackhi_epi16(c01Hi, c2aHi);   // 20-23 | 28-31
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst),      _mm256_permute2x128_si256(p0, p1, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 32), _mm256_permute2x128_si256(p0, p1, 0x31));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 64), _mm256_permute2x128_si256(p2, p3, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 96), _mm256_permute2x128_si256(p2, p3, 0x31));
+    }
+
+    /// 16 bytes of CbCr pairs as s16 lanes minus 128: pairs 0-3 | 4-7
+    __attribute__((target("avx2"), always_inline))
+    inline __m256i CenteredChromaAvx2(const uint8_t* uv) {
+        return _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(uv))),
+                                _mm256_set1_epi16(128));
+    }
+
+    __attribute__((target("avx2")))
+    void Yuv420ToRgbaAvx2(uint8_t* dst, const uint8_t* y, const uint8_t* uv, size_t n,
+                          const YuvToRgbCoefficients& c) {
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            // Pairs 0-3 | 4-7 doubled up are pixels 0-3 | 8-11 and 4-7 | 12-15
+            const __m256i a = CenteredChromaAvx2(uv + i);
+            const __m256i b = CenteredChromaAvx2(uv + i + 16);
+            const __m256i cbcr[4] = {_mm256_unpacklo_epi32(a, a), _mm256_unpackhi_epi32(a, a),
+                                     _mm256_unpacklo_epi32(b, b), _mm256_unpackhi_epi32(b, b)};
+            Rgba32Avx2(dst + 4 * i, y + i, cbcr, c);
+        }
+        Yuv420ToRgbaSse2(dst + 4 * i, y + i, uv + i, n - i, c);
+    }
+
+    __attribute__((target("avx2")))
+    void Yuv444ToRgbaAvx2(uint8_t* dst, const uint8_t* y, const uint8_t* uv, size_t n,
+                          const YuvToRgbCoefficients& c) {
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            __m256i cbcr[4];
+            for (int half = 0; half < 2; ++half) {
+                // Pairs 0-3 | 4-7 and 8-11 | 12-15, regrouped as 0-3 | 8-11 and 4-7 | 12-15
+                const __m256i a = CenteredChromaAvx2(uv + 2 * i + 32 * half);
+                const __m256i b = CenteredChromaAvx2(uv + 2 * i + 32 * half + 16);
+                cbcr[2 * half]     = _mm256_permute2x128_si256(a, b, 0x20);
+                cbcr[2 * half + 1] = _mm256_permute2x128_si256(a, b, 0x31);
+            }
+            Rgba32Avx2(dst + 4 * i, y + i, cbcr, c);
+        }
+        Yuv444ToRgbaSse2(dst + 4 * i, y + i, uv + 2 * i, n - i, c);
+    }
+
+    __attribute__((target("avx2")))
+    void RgbaToRgbAvx2(uint8_t* dst, const uint8_t* src, size_t n) {
+        // pshufb packs 4 pixels into the low 12 bytes; each 16-byte store is
+        // overlapped by the next one, so stop while 16 bytes still fit
+        const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 4) {
+            const __m128i rgba = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 3 * i), _mm_shuffle_epi8(rgba, pack));
+        }
+        RgbaToRgbScalar(dst + 3 * i, src + 4 * i, n - i);
+    }
+
+    // Chroma and the binomial row are shuffle-bound on x86; SSE2 is as fast as it gets here
+    const YuvRowKernels AVX2{"avx2", InterleaveAvx2, SwapPairsAvx2,
+                             DownsampleLumaAvx2, DownsampleChromaSse2,
+                             BinomialColumnsAvx2, BinomialRowSse2,
+                             Yuv420ToRgbaAvx2, Yuv444ToRgbaAvx2, RgbaToRgbAvx2};
+
+    bool HasAvx2() {
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        return avx2;
+    }
+#endif
+}
+
+// ============================================================
+// Layout detection
+// ============================================================
+
+const char* utils::ChromaLayoutName(ChromaLayout layout) {
+    switch (layout) {
+        case ChromaLayout::NV12:    return "NV12";
+        case ChromaLayout::NV21:    return "NV21";
+        case ChromaLayout::I420:    return "I420";
+        case ChromaLayout::Strided: return "strided";
+    }
+    return "?";
+}
+
+ChromaLayout utils::DetectChromaLayout(const uint8_t* u, const uint8_t* v, int32_t pixelStride) {
+    if (pixelStride == 1) {
+        return ChromaLayout::I420;
+    }
+    if (pixelStride == 2 && v == u + 1) {
+        return ChromaLayout::NV12;
+    }
+    if (pixelStride == 2 && u == v + 1) {
+        return ChromaLayout::NV21;
+    }
+    return ChromaLayout::Strided;
+}
+
+// ============================================================
+// Kernel selection
+// ============================================================
+
+const YuvRowKernels& utils::ScalarYuvKernels() {
+    return SCALAR;
+}
+
+const YuvRowKernels& utils::BestYuvKernels() {
+#if defined(__ARM_NEON)
+    return NEON;
+#elif defined(__x86_64__) || defined(__i386__)
+    return HasAvx2() ? AVX2 : SSE2;
+#else
+    return SCALAR;
+#endif
+}
+
+std::vector<const YuvRowKernels*> utils::AvailableYuvKernels() {
+    std::vector<const YuvRowKernels*> kernels{&SCALAR};
+#if defined(__ARM_NEON)
+    kernels.push_back(&NEON);
+#elif defined(__x86_64__) || defined(__i386__)
+    kernels.push_back(&SSE2);
+    if (HasAvx2()) {
+        kernels.push_back(&AVX2);
+    }
+#endif
+    return kernels;
+}
+
+// ============================================================
+// Plane conversion
+// ============================================================
+
+void utils::CopyPlane(uint8_t* dst, size_t dstStride, const uint8_t* src, size_t srcStride,
+                      size_t rowBytes, size_t rows) {
+    if (rows == 0) {
+        return;
+    }
+    if (dstStride == srcStride) {
+        // The last row only needs its pixels: the camera doesn't pad it
+        memcpy(dst, src, (rows - 1) * srcStride + rowBytes);
+        return;
+    }
+    for (size_t row = 0; row < rows; ++row) {
+        memcpy(dst + row * dstStride, src + row * srcStride, rowBytes);
+    }
+}
+
+void utils::ConvertChromaToNv12(uint8_t* dst, size_t dstStride, const ChromaPlanes& src,
+                                uint32_t chromaWidth, uint32_t chromaHeight,
+                                const YuvRowKernels& kernels) {
+    switch (src.layout) {
+        case ChromaLayout::NV12:
+            CopyPlane(dst, dstStride, src.u, src.uRowStride, chromaWidth * 2u, chromaHeight);
+            return;
+        case ChromaLayout::NV21:
+            for (uint32_t row = 0; row < chromaHeight; ++row) {
+                kernels.swapPairs(dst + row * dstStride, src.v + static_cast<size_t>(row) * src.vRowStride,
+                                  chromaWidth);
+            }
+            return;
+        case ChromaLayout::I420:
+            for (uint32_t row = 0; row < chromaHeight; ++row) {
+                kernels.interleave(dst + row * dstStride,
+                                   src.u + static_cast<size_t>(row) * src.uRowStride,
+                                   src.v + static_cast<size_t>(row) * src.vRowStride,
+                                   chromaWidth);
+            }
+            return;
+        case ChromaLayout::Strided:
+            for (uint32_t row = 0; row < chromaHeight; ++row) {
+                const uint8_t* u = src.u + static_cast<size_t>(row) * src.uRowStride;
+                const uint8_t* v = src.v + static_cast<size_t>(row) * src.vRowStride;
+                uint8_t* out = dst + row * dstStride;
+                for (uint32_t i = 0; i < chromaWidth; ++i) {
+                    out[2 * i]     = u[static_cast<size_t>(i) * src.pixelStride];
+                    out[2 * i + 1] = v[static_cast<size_t>(i) * src.pixelStride];
+                }
+            }
+            return;
+    }
+}
+
+void utils::Downsample2xLuma(uint8_t* dst, size_t dstStride, const uint8_t* src, size_t srcStride,
+                             uint32_t dstWidth, uint32_t dstHeight, const YuvRowKernels& kernels) {
+    for (uint32_t row = 0; row < dstHeight; ++row) {
+        const uint8_t* row0 = src + static_cast<size_t>(row) * 2 * srcStride;
+        kernels.downsampleLuma(dst + row * dstStride, row0, row0 + srcStride, dstWidth);
+    }
+}
+
+void utils::Downsample2xChroma(uint8_t* dst, size_t dstStride, const uint8_t* src, size_t srcStride,
+                               uint32_t dstWidth, uint32_t dstHeight, const YuvRowKernels& kernels) {
+    for (uint32_t row = 0; row < dstHeight; ++row) {
+        const uint8_t* row0 = src + static_cast<size_t>(row) * 2 * srcStride;
+        kernels.downsampleChroma(dst + row * dstStride, row0, row0 + srcStride, dstWidth);
+    }
+}
@@ -0,0 +1,122 @@
+#ifndef KRAKATOA_YUV_CONVERT_H
+#define KRAKATOA_YUV_CONVERT_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+namespace utils {
+    /**
+     * How the two chroma planes of a YUV_420_888 camera image sit in memory.
+     * The GPU images (and the YCbCr sampler) always want NV12: one half-res
+     * plane of interleaved Cb,Cr byte pairs.
+     */
+    enum class ChromaLayout : uint8_t {
+        NV12,     ///< interleaved, Cb first: U plane == V plane - 1, pixel stride 2
+        NV21,     ///< interleaved, Cr first: V plane == U plane - 1, pixel stride 2
+        I420,     ///< two separate planes, pixel stride 1
+        Strided   ///< anything else: gathered one sample at a time
+    };
+
+    const char* ChromaLayoutName(ChromaLayout layout);
+
+    /// Classifies planes 1 (U) and 2 (V) of a YUV_420_888 image.
+    ChromaLayout DetectChromaLayout(const uint8_t* u, const uint8_t* v, int32_t pixelStride);
+
+    /// The chroma planes of one camera frame, as the camera reports them.
+    struct ChromaPlanes {
+        const uint8_t* u = nullptr;
+        const uint8_t* v = nullptr;
+        int32_t uRowStride  = 0;
+        int32_t vRowStride  = 0;
+        int32_t pixelStride = 0;
+        ChromaLayout layout = ChromaLayout::NV12;
+    };
+
+    /**
+     * Fixed-point YCbCr -> RGB, 13 fractional bits. Output channel c is
+     *   clamp((yScale * (Y - yOffset) + u[c] * (Cb - 128) + v[c] * (Cr - 128) + 4096) >> 13)
+     * Every coefficient fits in 16 bits, so the SIMD kernels multiply in
+     * 16-bit lanes, sum in 32-bit ones and match the scalar kernels exactly.
+     * Channel order lives in the table: swapping rows 0 and 2 gives BGR.
+     * See MakeYuvToRgbCoefficients (yuv_rgb.h).
+     */
+    struct YuvToRgbCoefficients {
+        int16_t yScale;
+        int16_t yOffset;
+        int16_t u[3];
+        int16_t v[3];
+    };
+
+    /**
+     * Row kernels behind ConvertChromaToNv12, the downsamplers, the luma
+     * pyramid and the RGB converter. For the chroma kernels `n` counts chroma
+     * samples, so each call writes 2n bytes. Rows of any length and alignment
+     * are fine.
+     */
+    struct YuvRowKernels {
+        const char* name;
+        /// I420 -> NV12: dst[2i] = u[i], dst[2i+1] = v[i]
+        void (*interleave)(uint8_t* dst, const uint8_t* u, const uint8_t* v, size_t n);
+        /// NV21 -> NV12: swaps every byte pair of vu
+        void (*swapPairs)(uint8_t* dst, const uint8_t* vu, size_t n);
+        /// 2x2 box filter of R8 rows: dst[i] = avg of row0/row1 bytes 2i, 2i+1 (rounded)
+        void (*downsampleLuma)(uint8_t* dst, const uint8_t* row0, const uint8_t* row1, size_t n);
+        /// 2x2 box filter of interleaved CbCr rows: n output pairs from 2n input pairs per row
+        void (*downsampleChroma)(uint8_t* dst, const uint8_t* row0, const uint8_t* row1, size_t n);
+        /// Binomial [1 3 3 1] down the columns of 4 R8 rows: dst[i] = r0 + 3 r1 + 3 r2 + r3
+        void (*binomialColumns)(uint16_t* dst, const uint8_t* r0, const uint8_t* r1,
+                                const uint8_t* r2, const uint8_t* r3, size_t n);
+        /// Binomial [1 3 3 1] along a column-sum row, halving it and dividing by 64 (rounded):
+        /// dst[i] from src[2i-1 .. 2i+2], so src[-1] and src[2n] must be readable
+        void (*binomialRow)(uint8_t* dst, const uint16_t* src, size_t n);
+        /// n pixels of 4 bytes (channels 0..2, then 255) from a Y row and an NV12 row:
+        /// CbCr pair i colours pixels 2i and 2i + 1
+        void (*yuv420ToRgba)(uint8_t* dst, const uint8_t* y, const uint8_t* uv, size_t n,
+                             const YuvToRgbCoefficients& coefficients);
+        /// Same with one CbCr pair per pixel (chroma already at luma resolution)
+        void (*yuv444ToRgba)(uint8_t* dst, const uint8_t* y, const uint8_t* uv, size_t n,
+                             const YuvToRgbCoefficients& coefficients);
+        /// Drops every fourth byte: n 4-byte pixels to n 3-byte pixels
+        void (*rgbaToRgb)(uint8_t* dst, const uint8_t* src, size_t n);
+    };
+
+    /// Plain C++; the reference the SIMD kernels are checked against.
+    const YuvRowKernels& ScalarYuvKernels();
+
+    /// Fastest kernels this CPU runs: NEON on arm64, AVX2 or SSE2 on x86-64.
+    const YuvRowKernels& BestYuvKernels();
+
+    /// Every kernel set this CPU runs, scalar first. For benchmarks and checks.
+    std::vector<const YuvRowKernels*> AvailableYuvKernels();
+
+    /**
+     * Copies `rows` rows of `rowBytes` between pitched buffers. When the
+     * pitches match, one memcpy covers the whole span, padding included.
+     */
+    void CopyPlane(uint8_t* dst, size_t dstStride, const uint8_t* src, size_t srcStride,
+                   size_t rowBytes, size_t rows);
+
+    /**
+     * Writes the chroma of a frame as NV12 rows of `dstStride` bytes, whatever
+     * layout the camera delivered it in. Writes straight into mapped memory
+     * (staging buffers, linear images), so no intermediate copy is needed.
+     * @param chromaWidth   samples per chroma row (image width / 2)
+     * @param chromaHeight  chroma rows (image height / 2)
+     */
+    void ConvertChromaToNv12(uint8_t* dst, size_t dstStride, const ChromaPlanes& src,
+                             uint32_t chromaWidth, uint32_t chromaHeight,
+                             const YuvRowKernels& kernels = BestYuvKernels());
+
+    /**
+     * Halves an R8 plane with a 2x2 box filter, (a + b + c + d + 2) / 4.
+     * Reads 2 * dstWidth x 2 * dstHeight pixels of src.
+     */
+    void Downsample2xLuma(uint8_t* dst, size_t dstStride, const uint8_t* src, size_t srcStride,
+                          uint32_t dstWidth, uint32_t dstHeight,
+                          const YuvRowKernels& kernels = BestYuvKernels());
+
+    /// Same for an NV12 chroma plane; dstWidth counts CbCr pairs.
+    void Downsample2xChroma(uint8_t* dst, size_t dstStride, const uint8_t* src, size_t srcStride,
+                            uint32_t dstWidth, uint32_t dstHeight,
+                            const YuvRowKernels& kernels = BestYuvKernels());
+}
+#endif //KRAKATOA_YUV_CONVERT_H
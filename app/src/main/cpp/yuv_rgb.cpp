@@ -0,0 +1,311 @@
+#include "yuv_rgb.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <utility>
+#include <vector>
+using namespace utils;
+
+namespace {
+    /// Rows converted together before a 90/270 rotation writes them out as short runs of columns
+    constexpr uint32_t TILE_ROWS = 16;
+    /// Bands smaller than this (source bytes) aren't worth a thread hop
+    constexpr uint64_t MIN_BAND_BYTES = 256 * 1024;
+
+    struct Geometry {
+        uint32_t outWidth;    // before rotation
+        uint32_t outHeight;
+        uint32_t bpp;
+    };
+
+    Geometry MakeGeometry(const YuvImage& src, const RgbConvertOptions& options) {
+        return {src.width / options.downscale, src.height / options.downscale, BytesPerPixel(options.format)};
+    }
+
+    /**
+     * Produces output rows (in source orientation) one at a time. Owns the
+     * scratch rows of one band, so every band gets its own.
+     */
+    class RowConverter {
+    public:
+        RowConverter(const YuvImage& src, const RgbConvertOptions& options, const Geometry& geometry,
+                     const YuvRowKernels& kernels)
+            : src(src), kernels(kernels), geometry(geometry), scale(options.downscale),
+              chromaWidth((src.width + 1) / 2),
+              coefficients(MakeYuvToRgbCoefficients(options.matrix, options.range, options.format)) {
+            const size_t reduced = static_cast<size_t>(std::max(scale / 2, 1u)) * (src.width / 2 + 1);
+            lumaPing.resize(reduced);
+            lumaPong.resize(reduced);
+            chromaPing.resize(reduced * 2);
+            chromaPong.resize(reduced * 2);
+            if (src.chroma.layout != ChromaLayout::NV12) {
+                nv12Rows.resize(static_cast<size_t>(std::max(scale / 2, 1u)) * chromaWidth * 2);
+            }
+            if (geometry.bpp != 4) {
+                rgba.resize(static_cast<size_t>(geometry.outWidth) * 4);
+            }
+        }
+
+        /// Writes output row `row` to `out` (outWidth pixels in the requested format).
+        void Convert(uint32_t row, uint8_t* out) {
+            const uint8_t* y  = LumaRow(row);
+            const uint8_t* uv = ChromaRow(row);
+            uint8_t* target = geometry.bpp == 4 ? out : rgba.data();
+            if (scale == 1) {
+                kernels.yuv420ToRgba(target, y, uv, geometry.outWidth, coefficients);
+            } else {
+                kernels.yuv444ToRgba(target, y, uv, geometry.outWidth, coefficients);
+            }
+            if (geometry.bpp == 3) {
+                kernels.rgbaToRgb(out, rgba.data(), geometry.outWidth);
+            }
+        }
+
+    private:
+        const uint8_t* LumaRow(uint32_t row) {
+            const uint8_t* rows[8] = {};
+            for (uint32_t i = 0; i < scale; ++i) {
+                rows[i] = src.y + static_cast<size_t>(row * scale + i) * src.yRowStride;
+            }
+            return Reduce(rows, scale, src.width, false, lumaPing.data(), lumaPong.data());
+        }
+
+        /// The NV12 row(s) feeding output row `row`, box-filtered down to one
+        const uint8_t* ChromaRow(uint32_t row) {
+            if (scale == 1) {
+                // Two output rows share each chroma row; don't normalize it twice
+                if (row / 2 != cachedChromaRow) {
+                    cachedChromaRow = row / 2;
+                    cachedChroma = Nv12Row(cachedChromaRow, nv12Rows.data());
+                }
+                return cachedChroma;
+            }
+            const uint32_t count = scale / 2;
+            const uint8_t* rows[4] = {};
+            for (uint32_t i = 0; i < count; ++i) {
+                rows[i] = Nv12Row(row * count + i, nv12Rows.data() + static_cast<size_t>(i) * chromaWidth * 2);
+            }
+            return Reduce(rows, count, chromaWidth, true, chromaPing.data(), chromaPong.data());
+        }
+
+        /// Chroma row `row` as NV12: the camera memory itself when it already is
+        const uint8_t* Nv12Row(uint32_t row, uint8_t* scratch) {
+            ChromaPlanes planes = src.chroma;
+            planes.u += static_cast<size_t>(row) * planes.uRowStride;
+            planes.v += static_cast<size_t>(row) * planes.vRowStride;
+            if (planes.layout == ChromaLayout::NV12) {
+                return planes.u;
+            }
+            ConvertChromaToNv12(scratch, 0, planes, chromaWidth, 1, kernels);
+            return scratch;
+        }
+
+        /**
+         * Halves `count` rows of `width` samples (bytes, or CbCr pairs) down to
+         * one with the 2x2 box kernels, ping-ponging between two scratch rows.
+         */
+        const uint8_t* Reduce(const uint8_t** rows, uint32_t count, uint32_t width, bool chroma,
+                              uint8_t* ping, uint8_t* pong) const {
+            const size_t sampleBytes = chroma ? 2 : 1;
+            while (count > 1) {
+                width /= 2;
+                count /= 2;
+                for (uint32_t i = 0; i < count; ++i) {
+                    uint8_t* dst = ping + i * width * sampleBytes;
+                    if (chroma) {
+                        kernels.downsampleChroma(dst, rows[2 * i], rows[2 * i + 1], width);
+                    } else {
+                        kernels.downsampleLuma(dst, rows[2 * i], rows[2 * i + 1], width);
+                    }
+                    rows[i] = dst;
+                }
+                std::swap(ping, pong);
+            }
+            return rows[0];
+        }
+
+        const YuvImage&       src;
+        const YuvRowKernels&  kernels;
+        const Geometry        geometry;
+        const uint32_t        scale;
+        const uint32_t        chromaWidth;
+        const YuvToRgbCoefficients coefficients;
+        std::vector<uint8_t>  lumaPing, lumaPong, chromaPing, chromaPong, nv12Rows, rgba;
+        uint32_t              cachedChromaRow = UINT32_MAX;
+        const uint8_t*        cachedChroma = nullptr;
+    };
+
+    template <size_t Bpp>
+    void ReverseRow(uint8_t* dst, const uint8_t* src, uint32_t width) {
+        for (uint32_t x = 0; x < width; ++x) {
+            memcpy(dst + static_cast<size_t>(width - 1 - x) * Bpp, src + static_cast<size_t>(x) * Bpp, Bpp);
+        }
+    }
+
+    /**
+     * Writes `rows` converted rows starting at source row y0 to their rotated
+     * place. Each output row gets one contiguous run of `rows` pixels.
+     */
+    template <size_t Bpp>
+    void TransposeTile(uint8_t* dst, size_t dstStride, const uint8_t* tile, uint32_t y0, uint32_t rows,
+                       const Geometry& geometry, ImageRotation rotation) {
+        const size_t tileStride = static_cast<size_t>(geometry.outWidth) * Bpp;
+        for (uint32_t x = 0; x < geometry.outWidth; ++x) {
+            const uint8_t* column = tile + static_cast<size_t>(x) * Bpp;
+            if (rotation == ImageRotation::Cw90) {
+                // (x, y) -> (outHeight - 1 - y, x): the tile's rows land right to left
+                uint8_t* out = dst + x * dstStride + static_cast<size_t>(geometry.outHeight - y0 - rows) * Bpp;
+                for (uint32_t i = 0; i < rows; ++i) {
+                    memcpy(out + static_cast<size_t>(i) * Bpp, column + (rows - 1 - i) * tileStride, Bpp);
+                }
+            } else {
+                // Cw270: (x, y) -> (y, outWidth - 1 - x)
+                uint8_t* out = dst + (geometry.outWidth - 1 - x) * dstStride + static_cast<size_t>(y0) * Bpp;
+                for (uint32_t i = 0; i < rows; ++i) {
+                    memcpy(out + static_cast<size_t>(i) * Bpp, column + i * tileStride, Bpp);
+                }
+            }
+        }
+    }
+
+    template <size_t Bpp>
+    void ConvertBand(uint8_t* dst, size_t dstStride, const YuvImage& src, const RgbConvertOptions& options,
+                     const Geometry& geometry, const YuvRowKernels& kernels, uint32_t rowBegin, uint32_t rowEnd) {
+        RowConverter converter(src, options, geometry, kernels);
+        const size_t rowBytes = static_cast<size_t>(geometry.outWidth) * Bpp;
+        switch (options.rotation) {
+            case ImageRotation::None:
+                for (uint32_t row = rowBegin; row < rowEnd; ++row) {
+                    converter.Convert(row, dst + row * dstStride);
+                }
+                return;
+            case ImageRotation::Cw180: {
+                std::vector<uint8_t> line(rowBytes);
+                for (uint32_t row = rowBegin; row < rowEnd; ++row) {
+                    converter.Convert(row, line.data());
+                    ReverseRow<Bpp>(dst + (geometry.outHeight - 1 - row) * dstStride, line.data(), geometry.outWidth);
+                }
+                return;
+            }
+            case ImageRotation::Cw90:
+            case ImageRotation::Cw270: {
+                std::vector<uint8_t> tile(rowBytes * TILE_ROWS);
+                for (uint32_t y0 = rowBegin; y0 < rowEnd; y0 += TILE_ROWS) {
+                    const uint32_t rows = std::min(TILE_ROWS, rowEnd - y0);
+                    for (uint32_t i = 0; i < rows; ++i) {
+                        converter.Convert(y0 + i, tile.data() + i * rowBytes);
+                    }
+                    TransposeTile<Bpp>(dst, dstStride, tile.data(), y0, rows, geometry, options.rotation);
+                }
+                return;
+            }
+        }
+    }
+}
+
+// ============================================================
+// Coefficients and geometry
+// ============================================================
+
+uint32_t utils::BytesPerPixel(RgbFormat format) {
+    return format == RgbFormat::RGB8 ? 3 : 4;
+}
+
+YuvToRgbCoefficients utils::MakeYuvToRgbCoefficients(YuvMatrix matrix, YuvRange range, RgbFormat format) {
+    const double kr = matrix == YuvMatrix::BT601 ? 0.299 : 0.2126;
+    const double kb = matrix == YuvMatrix::BT601 ? 0.114 : 0.0722;
+    const double kg = 1.0 - kr - kb;
+    const bool full = range == YuvRange::Full;
+    const double yScale = full ? 1.0 : 255.0 / 219.0;
+    const double cScale = full ? 1.0 : 255.0 / 224.0;
+    auto fixed = [](double x) { return static_cast<int16_t>(std::lround(x * 8192.0)); };
+
+    YuvToRgbCoefficients c{};
+    c.yScale  = fixed(yScale);
+    c.yOffset = full ? 0 : 16;
+    // R = Y' + 2 (1 - kr) Cr, B = Y' + 2 (1 - kb) Cb, G from Y = kr R + kg G + kb B
+    c.u[0] = 0;
+    c.v[0] = fixed(2.0 * (1.0 - kr) * cScale);
+    c.u[1] = fixed(-2.0 * kb * (1.0 - kb) / kg * cScale);
+    c.v[1] = fixed(-2.0 * kr * (1.0 - kr) / kg * cScale);
+    c.u[2] = fixed(2.0 * (1.0 - kb) * cScale);
+    c.v[2] = 0;
+    if (format == RgbFormat::BGRA8) {
+        std::swap(c.u[0], c.u[2]);
+        std::swap(c.v[0], c.v[2]);
+    }
+    return c;
+}
+
+ImageRotation utils::RotationFromDisplayCorners(const float corners[8]) {
+    // Direction of the screen's top edge (top-left -> top-right) in the image
+    const float dx = corners[2] - corners[0];
+    const float dy = corners[3] - corners[1];
+    if (std::fabs(dx) >= std::fabs(dy)) {
+        return dx >= 0.0f ? ImageRotation::None : ImageRotation::Cw180;
+    }
+    // Screen x running up the image means the image is turned a quarter clockwise
+    return dy < 0.0f ? ImageRotation::Cw90 : ImageRotation::Cw270;
+}
+
+void utils::RgbOutputSize(uint32_t width, uint32_t height, const RgbConvertOptions& options,
+                          uint32_t& outWidth, uint32_t& outHeight) {
+    outWidth  = width / options.downscale;
+    outHeight = height / options.downscale;
+    if (options.rotation == ImageRotation::Cw90 || options.rotation == ImageRotation::Cw270) {
+        std::swap(outWidth, outHeight);
+    }
+}
+
+// ============================================================
+// Conversion
+// ============================================================
+
+void utils::ConvertYuvToRgb(uint8_t* dst, size_t dstStride, const YuvImage& src,
+                            const RgbConvertOptions& options, ThreadPool* pool,
+                            const YuvRowKernels& kernels) {
+    assert(options.downscale == 1 || options.downscale == 2 ||
+           options.downscale == 4 || options.downscale == 8);
+    const Geometry geometry = MakeGeometry(src, options);
+    if (geometry.outWidth == 0 || geometry.outHeight == 0) {
+        return;
+    }
+    uint32_t outWidth, outHeight;
+    RgbOutputSize(src.width, src.height, options, outWidth, outHeight);
+    assert(dstStride >= static_cast<size_t>(outWidth) * geometry.bpp);
+
+    auto band = [&](uint32_t rowBegin, uint32_t rowEnd) {
+        if (geometry.bpp == 3) {
+            ConvertBand<3>(dst, dstStride, src, options, geometry, kernels, rowBegin, rowEnd);
+        } else {
+            ConvertBand<4>(dst, dstStride, src, options, geometry, kernels, rowBegin, rowEnd);
+        }
+    };
+
+    uint32_t bands = 1;
+    if (pool != nullptr) {
+        // The calling thread takes a band too
+        const uint64_t sourceBytes = static_cast<uint64_t>(src.width) * src.height * 3 / 2;
+        bands = static_cast<uint32_t>(std::clamp<uint64_t>(sourceBytes / MIN_BAND_BYTES, 1, pool->Size() + 1));
+    }
+    if (bands == 1) {
+        band(0, geometry.outHeight);
+        return;
+    }
+    // Even row boundaries keep each chroma row inside one band at full size
+    const uint32_t rowPairs = geometry.outHeight / 2;
+    auto bandBegin = [&](uint32_t i) {
+        return i == bands ? geometry.outHeight : 2 * (rowPairs * i / bands);
+    };
+    Latch done(bands - 1);
+    for (uint32_t i = 1; i < bands; ++i) {
+        pool->Submit([&, i] {
+            band(bandBegin(i), bandBegin(i + 1));
+            done.CountDown();
+        });
+    }
+    band(bandBegin(0), bandBegin(1));
+    done.Wait();
+}
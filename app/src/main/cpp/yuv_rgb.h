@@ -0,0 +1,85 @@
+#ifndef KRAKATOA_YUV_RGB_H
+#define KRAKATOA_YUV_RGB_H
+#include "yuv_convert.h"
+#include <cstddef>
+#include <cstdint>
+namespace utils {
+    class ThreadPool;
+
+    enum class RgbFormat : uint8_t {
+        RGBA8,   ///< 4 bytes per pixel, alpha 255 (Bitmap ARGB_8888, GL/Vulkan RGBA8)
+        BGRA8,   ///< 4 bytes per pixel, alpha 255 (Windows/DirectX-style, some encoders)
+        RGB8     ///< 3 bytes per pixel, packed (most ML model inputs)
+    };
+
+    /// YCbCr -> RGB matrix. The camera background samples BT.601 full range.
+    enum class YuvMatrix : uint8_t { BT601, BT709 };
+
+    /// Full: Y and CbCr use 0..255. Limited ("video"): Y 16..235, CbCr 16..240.
+    enum class YuvRange : uint8_t { Full, Limited };
+
+    /// Clockwise rotation applied to the converted image.
+    enum class ImageRotation : uint8_t { None, Cw90, Cw180, Cw270 };
+
+    uint32_t BytesPerPixel(RgbFormat format);
+
+    /// The fixed-point table the row kernels run on, channels in `format` order.
+    YuvToRgbCoefficients MakeYuvToRgbCoefficients(YuvMatrix matrix, YuvRange range, RgbFormat format);
+
+    /**
+     * The rotation that turns a camera image upright on screen, from where
+     * the screen corners land in it (ar::CameraFrame::displayCorners: TL, TR,
+     * BL, BR as x, y pairs). Follows the screen's top edge, so it is right
+     * for any display rotation and either camera.
+     */
+    ImageRotation RotationFromDisplayCorners(const float corners[8]);
+
+    /// A YUV 4:2:0 image as the camera hands it over.
+    struct YuvImage {
+        const uint8_t* y = nullptr;
+        int32_t yRowStride = 0;
+        ChromaPlanes chroma;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    struct RgbConvertOptions {
+        RgbFormat format = RgbFormat::RGBA8;
+        YuvMatrix matrix = YuvMatrix::BT601;
+        YuvRange range = YuvRange::Full;
+        /// 1, 2, 4 or 8: box-filters the YUV planes by that much before converting
+        uint32_t downscale = 1;
+        ImageRotation rotation = ImageRotation::None;
+    };
+
+    /// Width and height of the converted image: downscaled, then rotated.
+    void RgbOutputSize(uint32_t width, uint32_t height, const RgbConvertOptions& options,
+                       uint32_t& outWidth, uint32_t& outHeight);
+
+    /**
+     * Converts a YUV 4:2:0 image (any ChromaLayout) to packed RGB in one pass
+     * over the source: chroma normalization, box downscale, colour conversion
+     * and rotation all happen row by row in small per-band scratch buffers.
+     * The result is bit-exact whatever kernels and thread count run it.
+     *
+     * Chroma is taken nearest-neighbour at full size; from downscale 2 on it is
+     * box-filtered to the output size like luma, so every pixel gets its own.
+     *
+     * Usage:
+     *   utils::RgbConvertOptions options;
+     *   options.downscale = 4;
+     *   options.rotation  = utils::RotationFromDisplayCorners(frame.displayCorners);
+     *   uint32_t w, h;
+     *   utils::RgbOutputSize(image.width, image.height, options, w, h);
+     *   std::vector<uint8_t> pixels(size_t(w) * h * 4);
+     *   utils::ConvertYuvToRgb(pixels.data(), w * 4, image, options, &workerPool);
+     *
+     * @param dstStride  bytes between output rows, at least width * BytesPerPixel
+     * @param pool       when given, row bands also run on its threads; the call
+     *                   still returns only once the whole image is written
+     */
+    void ConvertYuvToRgb(uint8_t* dst, size_t dstStride, const YuvImage& src,
+                         const RgbConvertOptions& options, ThreadPool* pool = nullptr,
+                         const YuvRowKernels& kernels = BestYuvKernels());
+}
+#endif //KRAKATOA_YUV_RGB_H
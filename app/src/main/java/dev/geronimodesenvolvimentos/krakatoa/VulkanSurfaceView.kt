@@ -123,6 +123,16 @@ class VulkanSurfaceView(context: Context,var assetManager: AssetManager,var acti
     /// [index] corresponds to the list returned by [getAvailableResolutions].
     fun setResolution(index: Int): Boolean = nativeSetResolution(index)
 
+    /// Compose the AR layer in a subpass of the offscreen render pass (input attachment, no
+    /// offscreen color round trip through memory) or in its own pass. Applied on the next frame;
+    /// false if the subpass shader isn't packaged.
+    fun setComposeInSubpass(enabled: Boolean): Boolean = nativeSetComposeInSubpass(enabled)
+
+    /// Render the AR layer below screen resolution and upscale it temporally (jittered frames
+    /// accumulated in a full-resolution history). Only while the compose isn't in a subpass;
+    /// applied on the next frame; false if the resolve shader isn't packaged.
+    fun setTemporalUpscaling(enabled: Boolean): Boolean = nativeSetTemporalUpscaling(enabled)
+
     private external fun nativeOnSurfaceCreated(surface: Surface, assetManager: AssetManager, activity: Activity)
     private external fun nativeOnSurfaceChanged(width: Int, height: Int, rotation: Int)
     private external fun nativeOnSurfaceDestroyed()
@@ -135,4 +145,6 @@ class VulkanSurfaceView(context: Context,var assetManager: AssetManager,var acti
     private external fun nativeGetAvailableResolutions(): IntArray?
     private external fun nativeGetCurrentResolutionIndex(): Int
     private external fun nativeSetResolution(index: Int): Boolean
+    private external fun nativeSetComposeInSubpass(enabled: Boolean): Boolean
+    private external fun nativeSetTemporalUpscaling(enabled: Boolean): Boolean
 }
\ No newline at end of file
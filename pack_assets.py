@@ -0,0 +1,207 @@
+#!/usr/bin/env python3
+"""Pack the app assets into one archive (assets.kpak) read by io::AssetArchive.
+
+Layout (little endian, see asset_archive.h):
+    header   64 bytes   magic "KPAK", version, counts and table offsets
+    buckets  u32[n]     open addressing table, entry index + 1 (0 = empty),
+                        probed linearly from fnv1a64(path) & (n - 1)
+    entries  40 bytes   hash, data offset, stored size, size, name offset,
+                        name length, compression (0 = none, 1 = LZ4 block)
+    names    utf-8      entry paths, not terminated
+    data     blobs      each aligned to 64 bytes
+
+Usage:
+    python3 pack_assets.py [--lz4] [-o app/src/main/assets/assets.kpak]
+                           [app/src/main/assets/shaders ...]
+
+Paths inside the archive are relative to app/src/main/assets, the same
+strings the native code passes to AssetLoader (e.g. "shaders/compose.vert.spv").
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+ASSETS_DIR = os.path.join(SCRIPT_DIR, "app", "src", "main", "assets")
+DEFAULT_INPUTS = ["shaders", "meshes", "textures"]
+SKIP_EXTENSIONS = {".py", ".glsl", ".kpak"}
+SKIP_NAMES = {".gitkeep"}
+
+MAGIC = b"KPAK"
+VERSION = 1
+HEADER_FORMAT = "<4sIIIQQQQ16x"
+ENTRY_FORMAT = "<QQQQIHBx"
+DATA_ALIGNMENT = 64
+
+COMPRESSION_NONE = 0
+COMPRESSION_LZ4 = 1
+
+
+def fnv1a64(data):
+    h = 0xCBF29CE484222325
+    for b in data:
+        h ^= b
+        h = (h * 0x100000001B3) & 0xFFFFFFFFFFFFFFFF
+    return h
+
+
+# ============================================================
+# LZ4 block format (greedy, hash chain of length 1)
+# ============================================================
+
+LZ4_MIN_MATCH = 4
+LZ4_LAST_LITERALS = 5
+LZ4_MFLIMIT = 12
+LZ4_MAX_OFFSET = 65535
+
+
+def _lz4_length(out, n):
+    while n >= 255:
+        out.append(255)
+        n -= 255
+    out.append(n)
+
+
+def _lz4_sequence(out, literals, match_len, offset):
+    lit_len = len(literals)
+    token = (min(lit_len, 15) << 4)
+    if match_len:
+        token |= min(match_len - LZ4_MIN_MATCH, 15)
+    out.append(token)
+    if lit_len >= 15:
+        _lz4_length(out, lit_len - 15)
+    out += literals
+    if match_len:
+        out += struct.pack("<H", offset)
+        if match_len - LZ4_MIN_MATCH >= 15:
+            _lz4_length(out, match_len - LZ4_MIN_MATCH - 15)
+
+
+def lz4_compress(src):
+    out = bytearray()
+    n = len(src)
+    table = {}
+    anchor = 0
+    i = 0
+    match_limit = n - LZ4_MFLIMIT
+    while i < match_limit:
+        key = src[i:i + LZ4_MIN_MATCH]
+        candidate = table.get(key)
+        table[key] = i
+        if candidate is None or i - candidate > LZ4_MAX_OFFSET:
+            i += 1
+            continue
+        length = LZ4_MIN_MATCH
+        end = n - LZ4_LAST_LITERALS
+        while i + length < end and src[candidate + length] == src[i + length]:
+            length += 1
+        _lz4_sequence(out, src[anchor:i], length, i - candidate)
+        i += length
+        anchor = i
+    _lz4_sequence(out, src[anchor:], 0, 0)
+    return bytes(out)
+
+
+# ============================================================
+# Archive
+# ============================================================
+
+def collect(inputs):
+    files = []
+    for item in inputs:
+        root = item if os.path.isabs(item) else os.path.join(ASSETS_DIR, item)
+        if os.path.isfile(root):
+            files.append(root)
+            continue
+        for dirpath, _, names in os.walk(root):
+            for name in names:
+                if name in SKIP_NAMES or os.path.splitext(name)[1] in SKIP_EXTENSIONS:
+                    continue
+                files.append(os.path.join(dirpath, name))
+    paths = sorted({os.path.relpath(f, ASSETS_DIR).replace(os.sep, "/") for f in files})
+    return paths
+
+
+def align(value, alignment):
+    return (value + alignment - 1) & ~(alignment - 1)
+
+
+def pack(paths, output, use_lz4):
+    bucket_count = 1
+    while bucket_count < len(paths) * 2:
+        bucket_count *= 2
+
+    header_size = struct.calcsize(HEADER_FORMAT)
+    entry_size = struct.calcsize(ENTRY_FORMAT)
+    buckets_offset = header_size
+    entries_offset = buckets_offset + 4 * bucket_count
+    names_offset = entries_offset + entry_size * len(paths)
+
+    names = bytearray()
+    blobs = []
+    for path in paths:
+        with open(os.path.join(ASSETS_DIR, path), "rb") as f:
+            raw = f.read()
+        stored, compression = raw, COMPRESSION_NONE
+        if use_lz4 and raw:
+            packed = lz4_compress(raw)
+            # Only worth a decompression at load time if it saves a real amount.
+            if len(packed) < len(raw) * 0.9:
+                stored, compression = packed, COMPRESSION_LZ4
+        blobs.append((path, raw, stored, compression, len(names)))
+        names += path.encode("utf-8")
+
+    data_offset = align(names_offset + len(names), DATA_ALIGNMENT)
+    entries = []
+    buckets = [0] * bucket_count
+    blob_data = bytearray()
+    for index, (path, raw, stored, compression, name_offset) in enumerate(blobs):
+        offset = data_offset + len(blob_data)
+        blob_data += stored
+        blob_data += b"\0" * (align(len(blob_data), DATA_ALIGNMENT) - len(blob_data))
+        h = fnv1a64(path.encode("utf-8"))
+        entries.append(struct.pack(ENTRY_FORMAT, h, offset, len(stored), len(raw),
+                                   name_offset, len(path.encode("utf-8")), compression))
+        slot = h & (bucket_count - 1)
+        while buckets[slot] != 0:
+            slot = (slot + 1) & (bucket_count - 1)
+        buckets[slot] = index + 1
+
+    with open(output, "wb") as f:
+        f.write(struct.pack(HEADER_FORMAT, MAGIC, VERSION, len(paths), bucket_count,
+                            buckets_offset, entries_offset, names_offset, len(names)))
+        f.write(struct.pack("<%dI" % bucket_count, *buckets))
+        f.write(b"".join(entries))
+        f.write(names)
+        f.write(b"\0" * (data_offset - f.tell()))
+        f.write(blob_data)
+
+    raw_total = sum(len(b[1]) for b in blobs)
+    stored_total = sum(len(b[2]) for b in blobs)
+    lz4_count = sum(1 for b in blobs if b[3] == COMPRESSION_LZ4)
+    print(f"  {len(paths)} files, {raw_total} -> {stored_total} bytes "
+          f"({lz4_count} LZ4), archive {os.path.getsize(output)} bytes")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("inputs", nargs="*", default=DEFAULT_INPUTS,
+                        help="files or directories, relative to app/src/main/assets")
+    parser.add_argument("-o", "--output", default=os.path.join(ASSETS_DIR, "assets.kpak"))
+    parser.add_argument("--lz4", action="store_true", help="LZ4-compress files that shrink")
+    args = parser.parse_args()
+
+    paths = collect(args.inputs)
+    if not paths:
+        print("No files to pack.")
+        sys.exit(1)
+    for path in paths:
+        print(f"  {path}")
+    pack(paths, args.output, args.lz4)
+    print(f"OK: wrote {args.output}")
+
+
+if __name__ == "__main__":
+    main()